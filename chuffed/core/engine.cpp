@@ -951,6 +951,15 @@ RESULT Engine::search(const std::string& problemLabel) {
 							if (done) {
 								return RES_GUN;
 							}
+							if (fzn->lns) {
+								// The next neighbourhood gets the whole conflict limit. It may end without a
+								// conflict, so the time limit is checked here too
+								nof_conflicts = conflictC + getRestartLimit(starts);
+								if (so.time_out > duration(0) && chuffed_clock::now() > time_out) {
+									(*output_stream) << "% Time limit exceeded!\n";
+									return RES_UNK;
+								}
+							}
 							continue;
 						}
 					}
@@ -1045,6 +1054,13 @@ RESULT Engine::search(const std::string& problemLabel) {
 				if (!constrain()) {
 					return RES_GUN;
 				}
+				if (fzn != nullptr && fzn->lns) {
+					nof_conflicts = conflictC + getRestartLimit(starts);
+					if (so.time_out > duration(0) && chuffed_clock::now() > time_out) {
+						(*output_stream) << "% Time limit exceeded!\n";
+						return RES_UNK;
+					}
+				}
 				continue;
 			}
 
@@ -262,6 +262,8 @@ class Problem {
 public:
 	virtual void print(std::ostream&) = 0;
 	virtual void restrict_learnable(){};
+	/// Print statistics of the problem itself, e.g. how long it took to read
+	virtual void printStats() {}
 };
 
 #endif
@@ -22,7 +22,7 @@ void Engine::init() {
 
 	if (so.lazy) {
 		for (int i = 0; i < vars.size(); i++) {
-			if (vars[i]->getMax() - vars[i]->getMin() <= so.eager_limit) {
+			if (vars[i]->getMax() - vars[i]->getMin() <= so.eager_limit && !vars[i]->prefer_lazy) {
 				vars[i]->specialiseToEL();
 			} else {
 				if (so.verbosity >= 2) {
@@ -206,11 +206,35 @@ void printLongHelp(int& argc, char**& argv, const std::string& fileExt) {
 				 "  --print-sol [on|off], --no-print-sol\n"
 				 "     Print solutions (default "
 			<< (def.print_sol ? "on" : "off")
+			<< ").\n"
+				 "  --stream-solutions [on|off], --no-stream-solutions\n"
+				 "     Optimisation problems: print every improving solution as soon as it is\n"
+				 "     found instead of only the last one at exit, so an interrupted or killed\n"
+				 "     run keeps what it found (default "
+			<< (def.stream_solutions ? "on" : "off")
 			<< ").\n"
 				 "  --prop-fifo [on|off], --no-prop-fifo\n"
 				 "     Use FIFO (first in, first out) queues for propagation executions instead\n"
 				 "     of LIFO (last in, first out) queues (default "
 			<< (def.prop_fifo ? "on" : "off")
+			<< ").\n"
+				 "  --save-model <file>\n"
+				 "     Write the parsed model to <file>, so later runs can skip parsing it.\n"
+				 "  --load-model <file>\n"
+				 "     Solve the model written by --save-model to <file> instead of reading a\n"
+				 "     FlatZinc model. The options given with it apply as usual.\n"
+				 "  --presolve [on|off], --no-presolve\n"
+				 "     Simplify the model before creating its variables: propagate the bounds of\n"
+				 "     linear constraints, fix and merge variables, tighten coefficients, drop\n"
+				 "     implied, dominated and duplicate constraints, and replace variables defined\n"
+				 "     by an equation over two variables with views (default "
+			<< (def.presolve ? "on" : "off")
+			<< ").\n"
+				 "  --detect-globals [on|off], --no-detect-globals\n"
+				 "     Replace cliques of int_ne by all_different, linear constraints over\n"
+				 "     bool2int variables by Boolean sums, and add disjunctive constraints over\n"
+				 "     tasks that pairwise must not overlap (default "
+			<< (def.detect_globals ? "on" : "off")
 			<< ").\n"
 				 "\n"
 				 "More Search Options:\n"
@@ -256,6 +280,25 @@ void printLongHelp(int& argc, char**& argv, const std::string& fileExt) {
 				 "solution so far. If not possible, "
 				 "     value selection is the user-defined one. (default "
 			<< (def.sbps ? "on" : "off")
+			<< ").\n"
+				 "  --lns [on|off], --no-lns\n"
+				 "     Optimisation problems: large neighbourhood search. Once a solution is\n"
+				 "     found, each restart fixes a random part of the output variables to their\n"
+				 "     values in the best solution, and the part left free grows or shrinks with\n"
+				 "     how often the neighbourhoods are searched completely (default "
+			<< (def.lns ? "on" : "off")
+			<< ").\n"
+				 "  --lns-conflicts <n>\n"
+				 "     The number of conflicts after which an LNS neighbourhood is given up, used\n"
+				 "     as a constant restart sequence (default "
+			<< def.lns_conflicts
+			<< ").\n"
+				 "  --lns-structure [on|off], --no-lns-structure\n"
+				 "     Also relax the tasks in a time window of a cumulative or disjunctive\n"
+				 "     constraint, a segment of a circuit, or some rows of regular constraints,\n"
+				 "     and choose between these neighbourhoods and random ones by how often each\n"
+				 "     improves the solution (default "
+			<< (def.lns_structure ? "on" : "off")
 			<< ").\n"
 				 "\n"
 				 "Learning Options:\n"
@@ -285,6 +328,17 @@ void printLongHelp(int& argc, char**& argv, const std::string& fileExt) {
 			<< ").\n"
 				 "     The Boolean variables' representation for Integer variables with larger\n"
 				 "     domain size will be created on demand (lazily).\n"
+				 "  --encoding-analysis [on|off], --no-encoding-analysis\n"
+				 "     Also create the representation lazily for the Integer variables whose\n"
+				 "     constraints only read their bounds, whatever their domain size (default "
+			<< (def.encoding_analysis ? "on" : "off")
+			<< ").\n"
+				 "  --element-clause-limit <n>\n"
+				 "     The maximal array size for which an element constraint over a constant\n"
+				 "     array is decomposed into clauses (default "
+			<< def.element_clause_limit
+			<< ").\n"
+				 "     Larger arrays use a propagator with residual supports instead.\n"
 				 "  --sat-var-limit <n>\n"
 				 "     The maximal number of Boolean variables (default "
 			<< def.sat_var_limit
@@ -368,6 +422,9 @@ void printLongHelp(int& argc, char**& argv, const std::string& fileExt) {
 				 "     Use the MDD propagator if possible (default "
 			<< (def.mdd ? "on" : "off")
 			<< ").\n"
+				 "  --mdd-cache <dir>\n"
+				 "     Keep the MDDs compiled for regular, table and cost_regular constraints in\n"
+				 "     <dir>, and reuse them in later runs.\n"
 				 "  --mip [on|off], --no-mip\n"
 				 "     Use the MIP propagator if possible (default "
 			<< (def.mip ? "on" : "off")
@@ -464,6 +521,8 @@ void parseOptions(int& argc, char**& argv, std::string* fileArg, const std::stri
 			so.verbosity = intBuffer;
 		} else if (cop.getBool("--print-sol", boolBuffer)) {
 			so.print_sol = boolBuffer;
+		} else if (cop.getBool("--stream-solutions", boolBuffer)) {
+			so.stream_solutions = boolBuffer;
 		} else if (cop.get("--restart", &stringBuffer)) {
 			if (stringBuffer == "chuffed") {
 				so.restart_type = CHUFFED_DEFAULT;
@@ -505,8 +564,22 @@ void parseOptions(int& argc, char**& argv, std::string* fileArg, const std::stri
 			so.sat_polarity = intBuffer;
 		} else if (cop.getBool("--sbps", boolBuffer)) {
 			so.sbps = boolBuffer;
+		} else if (cop.getBool("--lns", boolBuffer)) {
+			so.lns = boolBuffer;
+		} else if (cop.get("--lns-conflicts", &intBuffer)) {
+			so.lns_conflicts = intBuffer;
+		} else if (cop.getBool("--lns-structure", boolBuffer)) {
+			so.lns_structure = boolBuffer;
 		} else if (cop.getBool("--prop-fifo", boolBuffer)) {
 			so.prop_fifo = boolBuffer;
+		} else if (cop.get("--save-model", &stringBuffer)) {
+			so.save_model = stringBuffer;
+		} else if (cop.get("--load-model", &stringBuffer)) {
+			so.load_model = stringBuffer;
+		} else if (cop.getBool("--presolve", boolBuffer)) {
+			so.presolve = boolBuffer;
+		} else if (cop.getBool("--detect-globals", boolBuffer)) {
+			so.detect_globals = boolBuffer;
 		} else if (cop.getBool("--disj-edge-find", boolBuffer)) {
 			so.disj_edge_find = boolBuffer;
 		} else if (cop.getBool("--disj-set-bp", boolBuffer)) {
@@ -561,6 +634,10 @@ void parseOptions(int& argc, char**& argv, std::string* fileArg, const std::stri
 			so.assump_int = boolBuffer;
 		} else if (cop.get("--eager-limit", &intBuffer)) {
 			so.eager_limit = intBuffer;
+		} else if (cop.getBool("--encoding-analysis", boolBuffer)) {
+			so.encoding_analysis = boolBuffer;
+		} else if (cop.get("--element-clause-limit", &intBuffer)) {
+			so.element_clause_limit = intBuffer;
 		} else if (cop.get("--sat-var-limit", &intBuffer)) {
 			so.sat_var_limit = intBuffer;
 		} else if (cop.get("--n-of-learnts", &intBuffer)) {
@@ -571,6 +648,8 @@ void parseOptions(int& argc, char**& argv, std::string* fileArg, const std::stri
 			so.lang_ext_linear = boolBuffer;
 		} else if (cop.getBool("--mdd", boolBuffer)) {
 			so.mdd = boolBuffer;
+		} else if (cop.get("--mdd-cache", &stringBuffer)) {
+			so.mdd_cache = stringBuffer;
 		} else if (cop.getBool("--mip", boolBuffer)) {
 			so.mip = boolBuffer;
 		} else if (cop.getBool("--mip-branch", boolBuffer)) {
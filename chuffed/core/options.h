@@ -23,12 +23,17 @@ public:
 	int rnd_seed{0};                            // Random seed
 	int verbosity{0};                           // Verbosity
 	bool print_sol{true};                       // Print solutions
+	bool stream_solutions{false};               // Print improving solutions as they are found
 	unsigned int restart_scale{1000000000};     // How many conflicts before restart
 	bool restart_scale_override{true};          // Restart scale set from CLI
 	double restart_base{1.5};                   // How is the restart limit scaled (geometric)
 	bool restart_base_override{true};           // Restart base set from CLI
 	RestartType restart_type{CHUFFED_DEFAULT};  // How is the restart limit computed
 	bool restart_type_override{true};           // Restart type set from CLI
+	std::string save_model;                     // File to write the parsed model to, if any
+	std::string load_model;                     // File to read a saved model from, if any
+	bool presolve{false};                       // Simplify the model before creating its variables
+	bool detect_globals{false};                 // Replace decomposed constraints by globals
 
 	// Search options
 	bool toggle_vsids{false};   // Alternate between search ann/vsids
@@ -37,7 +42,10 @@ public:
 			1000000000};  // Switch from search ann to vsids after a given number of conflicts
 	int sat_polarity{
 			0};            // Polarity of bool var to choose (0 = default, 1 = same, 2 = anti, 3 = random)
-	bool sbps{false};  // Use Solution-based phase saving
+	bool sbps{false};          // Use Solution-based phase saving
+	bool lns{false};           // Fix a random part of the incumbent at each restart
+	int lns_conflicts{500};    // Conflicts before an LNS neighbourhood is given up
+	bool lns_structure{true};  // Also derive LNS neighbourhoods from the global constraints
 
 	// Propagator options
 	bool prop_fifo{false};  // Propagators are queued in FIFO, otherwise LIFO
@@ -86,6 +94,8 @@ public:
 	bool bin_clause_opt{true};  // Should length-2 learnt clauses be optimised?
 
 	int eager_limit{1000};          // Max var range before we use lazy lit generation
+	bool encoding_analysis{false};  // Use lazy lits for vars whose constraints only read bounds
+	int element_clause_limit{1000};  // Max array size before array_int_element uses a propagator
 	int sat_var_limit{2000000};     // Max number of sat vars before turning off lazy clause
 	int nof_learnts{100000};        // Learnt clause no. limit
 	int learnts_mlimit{500000000};  // Learnt clause mem limit
@@ -94,7 +104,8 @@ public:
 	bool lang_ext_linear{false};
 
 	// MDD options
-	bool mdd{false};  // Use MDD propagator
+	bool mdd{false};        // Use MDD propagator
+	std::string mdd_cache;  // Directory of compiled MDDs kept between runs, none if empty
 
 	// MIP options
 	bool mip{false};         // Use MIP propagator
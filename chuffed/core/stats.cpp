@@ -33,6 +33,9 @@ void Engine::printStats() {
 	printf("%%%%%%mzn-stat: peakMem=%.2f\n", memUsed());
 	printf("%%%%%%mzn-stat: time=%.3f\n", to_sec(total_time));
 	printf("%%%%%%mzn-stat: initTime=%.3f\n", to_sec(init_time));
+	if (problem != nullptr) {
+		problem->printStats();
+	}
 	printf("%%%%%%mzn-stat: solveTime=%.3f\n", to_sec(search_time));
 
 	// Chuffed specific statistics
@@ -23,6 +23,7 @@
 #ifndef ast_h
 #define ast_h
 
+#include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <string>
@@ -58,6 +59,61 @@ public:
 	};
 };
 
+/**
+ * \brief Bump allocator for the nodes of one constraint item
+ *
+ * While an arena is current, new nodes are carved out of its blocks and deleting them only runs
+ * their destructors. The parser makes one current for each constraint item and resets it once the
+ * constraint has been posted, so the blocks are reused by the next constraint.
+ */
+class Arena {
+private:
+	static const size_t BLOCK_SIZE = 1 << 16;
+	std::vector<char*> blocks;
+	/// Block being filled, and the bytes used in it
+	size_t block{static_cast<size_t>(-1)};
+	size_t used{BLOCK_SIZE};
+
+public:
+	/// The arena new nodes are allocated from, if any
+	static Arena* current;
+
+	Arena() = default;
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	~Arena() {
+		for (char* b : blocks) {
+			delete[] b;
+		}
+	}
+
+	void* alloc(size_t size) {
+		size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+		if (used + size > BLOCK_SIZE) {
+			if (++block == blocks.size()) {
+				blocks.push_back(new char[BLOCK_SIZE]);
+			}
+			used = 0;
+		}
+		void* p = blocks[block] + used;
+		used += size;
+		return p;
+	}
+	bool owns(const void* p) const {
+		for (char* b : blocks) {
+			if (p >= b && p < b + BLOCK_SIZE) {
+				return true;
+			}
+		}
+		return false;
+	}
+	/// Make all the blocks available again; every node taken from them must have been deleted
+	void reset() {
+		block = static_cast<size_t>(-1);
+		used = BLOCK_SIZE;
+	}
+};
+
 /**
  * \brief A node in a FlatZinc abstract syntax tree
  */
@@ -66,6 +122,16 @@ public:
 	/// Destructor
 	virtual ~Node();
 
+	/// Allocate from the current Arena, if there is one
+	static void* operator new(size_t size) {
+		return Arena::current != nullptr ? Arena::current->alloc(size) : ::operator new(size);
+	}
+	static void operator delete(void* p) {
+		if (Arena::current == nullptr || !Arena::current->owns(p)) {
+			::operator delete(p);
+		}
+	}
+
 	/// Append \a n to an array node
 	void append(Node* n);
 
@@ -39,18 +39,27 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <ostream>
 #include <random>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 namespace FlatZinc {
 
 FlatZincSpace* s;
 
+AST::Arena* AST::Arena::current = nullptr;
+
 VarBranch ann2ivarsel(AST::Node* ann) {
 	if (auto* s = dynamic_cast<AST::Atom*>(ann)) {
 		if (s->id == "input_order") {
@@ -156,7 +165,15 @@ void FlatZincSpace::newIntVar(IntVarSpec* vs, const std::string& name) {
 		considerIntroduced = true;
 	}
 	if (vs->alias) {
+		auto view = iv_views.find(vs->i);
+		if (view != iv_views.end()) {
+			const IntViewDef d = view->second;
+			iv_views.emplace(intVarCount, d);
+		}
 		iv[intVarCount++] = iv[vs->i];
+	} else if (vs->view_var >= 0) {
+		iv_views.emplace(intVarCount, IntViewDef{vs->view_var, vs->view_a, vs->view_b});
+		iv[intVarCount++] = nullptr;
 	} else {
 		IntVar* v = nullptr;
 		if (vs->assigned) {
@@ -199,6 +216,46 @@ void FlatZincSpace::newIntVar(IntVarSpec* vs, const std::string& name) {
 	iv_introduced[intVarCount - 1] = considerIntroduced;
 }
 
+IntVar* FlatZincSpace::intVar(int i) {
+	if (iv[i] != nullptr) {
+		return iv[i];
+	}
+	const IntViewDef d = iv_views.at(i);
+	IntVar* x = iv[d.x];
+	const int64_t y0 = static_cast<int64_t>(d.a) * x->getMin() + d.b;
+	const int64_t y1 = static_cast<int64_t>(d.a) * x->getMax() + d.b;
+	IntVar* y = ::newIntVar(static_cast<int>(std::min(y0, y1)), static_cast<int>(std::max(y0, y1)));
+	if (so.exclude_introduced && iv_introduced[i]) {
+		y->should_be_learnable = false;
+	}
+	if (!so.decide_introduced && iv_introduced[i]) {
+		y->should_be_decidable = false;
+	}
+	// y - a*x = b
+	vec<int> a;
+	a.push(1);
+	a.push(-d.a);
+	vec<IntVar*> xs;
+	xs.push(y);
+	xs.push(x);
+	int_linear(a, xs, IRT_EQ, d.b);
+	// The aliases of the view share its variable
+	for (const auto& v : iv_views) {
+		if (v.second.x == d.x && v.second.a == d.a && v.second.b == d.b) {
+			iv[v.first] = y;
+		}
+	}
+	return y;
+}
+
+int64_t FlatZincSpace::intVal(int i) const {
+	if (iv[i] != nullptr) {
+		return iv[i]->getVal();
+	}
+	const IntViewDef& d = iv_views.at(i);
+	return static_cast<int64_t>(d.a) * iv[d.x]->getVal() + d.b;
+}
+
 void FlatZincSpace::newBoolVar(BoolVarSpec* vs) {
 	// Resizing of the vectors if required
 	if (boolVarCount == bv.size()) {
@@ -281,8 +338,13 @@ void FlatZincSpace::newSetVar(SetVarSpec* /*unused*/) {
 }
 
 void FlatZincSpace::postConstraint(const ConExpr& ce, AST::Node* ann) {
+	const time_point start = chuffed_clock::now();
+	if (so.encoding_analysis) {
+		s->noteLitNeeds(ce);
+	}
 	try {
 		registry().post(ce, ann);
+		s->parse_stats.post_time += chuffed_clock::now() - start;
 	} catch (AST::TypeError& e) {
 		throw FlatZinc::Error("Type error", e.what());
 	} catch (std::exception& e) {
@@ -290,6 +352,77 @@ void FlatZincSpace::postConstraint(const ConExpr& ce, AST::Node* ann) {
 	}
 }
 
+// The constraints whose propagators only read and set the bounds of their integer variables.
+// Any other constraint is taken to need the value literals as well.
+static const std::unordered_set<std::string> bounds_constraints = {
+		"int_eq", "int_le", "int_lt", "int_ge", "int_gt", "int_le_reif", "int_lt_reif", "int_ge_reif",
+		"int_gt_reif", "int_le_imp", "int_lt_imp", "int_ge_imp", "int_gt_imp", "int_lin_eq",
+		"int_lin_le", "int_lin_lt", "int_lin_ge", "int_lin_gt", "int_lin_le_reif", "int_lin_lt_reif",
+		"int_lin_ge_reif", "int_lin_gt_reif", "int_plus", "int_minus", "int_times", "int_div",
+		"int_min", "int_max", "int_abs", "int_negate", "array_int_minimum", "array_int_maximum",
+		"increasing_int"};
+
+void FlatZincSpace::noteLitNeeds(const ConExpr& ce) {
+	int needs = bounds_constraints.count(ce.id) != 0 ? LN_BOUNDS : LN_VALUES;
+	// Against a constant, (in)equality is expressed with the two bounds literals
+	if ((ce.id == "int_eq_reif" || ce.id == "int_ne_reif" || ce.id == "int_eq_imp" ||
+			 ce.id == "int_ne_imp") &&
+			(ce[0]->isInt() || ce[1]->isInt())) {
+		needs = LN_BOUNDS;
+	}
+	noteLitNeeds(ce.args, needs);
+}
+
+void FlatZincSpace::noteLitNeeds(AST::Node* n, int needs) {
+	if (auto* a = dynamic_cast<AST::Array*>(n)) {
+		for (auto* e : a->a) {
+			noteLitNeeds(e, needs);
+		}
+	} else if (auto* x = dynamic_cast<AST::IntVar*>(n)) {
+		if (iv[x->i] != nullptr) {
+			iv_lit_needs[iv[x->i]] |= needs;
+		}
+	}
+}
+
+void FlatZincSpace::chooseEncodings() {
+	// LDSB and the MIP propagator work on the value literals of any variable
+	if (!so.encoding_analysis || !so.lazy || so.ldsb || so.mip) {
+		return;
+	}
+	// Assumptions on the restart status are made of value literals. The search learns much better
+	// over the eager literals of the variables it branches on, so only the introduced variables,
+	// which the default search fixes last if at all, are considered.
+	if (restart_status >= 0) {
+		iv_lit_needs[iv[restart_status]] |= LN_VALUES;
+	}
+	for (int i = 0; i < intVarCount; i++) {
+		if (iv[i] != nullptr && !iv_introduced[i]) {
+			iv_lit_needs[iv[i]] |= LN_VALUES;
+		}
+	}
+	if (engine.opt_var != nullptr) {
+		iv_lit_needs[engine.opt_var] |= LN_VALUES;
+	}
+	for (const auto& n : iv_lit_needs) {
+		IntVar* x = n.first;
+		if (n.second != LN_BOUNDS) {
+			continue;
+		}
+		encoding_stats.bounds_only++;
+		// Variables with holes in their domain, or already given their literals, keep them
+		const int64_t range = static_cast<int64_t>(x->getMax()) - x->getMin();
+		if (x->getType() != INT_VAR || x->vals != nullptr || x->isFixed() || range > so.eager_limit) {
+			continue;
+		}
+		x->prefer_lazy = true;
+		encoding_stats.lazy++;
+		// The eager representation has range + 1 value and range + 2 bounds literals, the lazy one
+		// starts with a single literal
+		encoding_stats.literals_saved += 2 * range + 2;
+	}
+}
+
 // Parsing the 'int_search' annotation and setting up the branching for it
 void FlatZincSpace::parseSolveAnnIntSearch(AST::Node* elemAnn, BranchGroup* branching,
 																					 int& nbNonEmptySearchAnnotations) {
@@ -305,13 +438,19 @@ void FlatZincSpace::parseSolveAnnIntSearch(AST::Node* elemAnn, BranchGroup* bran
 			if (i->isInt()) {
 				continue;
 			}
-			IntVar* v = iv[i->getIntVar()];
+			IntVar* v = intVar(i->getIntVar());
 			// Removal of fixed variables
 			if (v->isFixed()) {
 				continue;
 			}
 			va.push(v);
 		}
+		if (so.encoding_analysis) {
+			// The search decides on their values
+			for (int i = 0; i < va.size(); i++) {
+				iv_lit_needs[static_cast<IntVar*>(va[i])] |= LN_VALUES;
+			}
+		}
 		branching->add(createBranch(va, ann2ivarsel(args->a[1]), ann2ivalsel(args->a[2])));
 		if (auto* s = dynamic_cast<AST::String*>(args->a[3])) {
 			if (s->s == "all") {
@@ -370,7 +509,7 @@ void FlatZincSpace::parseSolveAnnPrioritySearch(AST::Node* elemAnn, BranchGroup*
 				const int value = i->getInt();
 				v = getConstant(value);
 			} else {
-				v = iv[i->getIntVar()];
+				v = intVar(i->getIntVar());
 			}
 			va.push(v);
 		}
@@ -420,7 +559,7 @@ void FlatZincSpace::parseSolveAnnWarmStart(AST::Node* elemAnn, BranchGroup* bran
 		}
 		const int sz = std::min(vars->a.size(), vals->a.size());
 		for (int ii = 0; ii < sz; ii++) {
-			IntVar* x(iv[vars->a[ii]->getIntVar()]);
+			IntVar* x(intVar(vars->a[ii]->getIntVar()));
 			const int k(vals->a[ii]->getInt());
 			switch (x->getType()) {
 				case INT_VAR_EL:
@@ -562,7 +701,7 @@ void FlatZincSpace::fixAllSearch() {
 			continue;
 		}
 		IntVar* v = iv[i];
-		if (v->isFixed()) {
+		if (v == nullptr || v->isFixed()) {
 			continue;
 		}
 		va.push(v);
@@ -578,7 +717,7 @@ void FlatZincSpace::fixAllSearch() {
 			continue;
 		}
 		IntVar* v = iv[i];
-		if (v->isFixed()) {
+		if (v == nullptr || v->isFixed()) {
 			continue;
 		}
 		va.push(v);
@@ -601,19 +740,23 @@ void FlatZincSpace::solve(AST::Array* ann) {
 
 void FlatZincSpace::minimize(int var, AST::Array* ann) {
 	parseSolveAnn(ann);
-	optimize(iv[var], OPT_MIN);
+	optimize(intVar(var), OPT_MIN);
+	initLns();
 	fixAllSearch();
 }
 
 void FlatZincSpace::maximize(int var, AST::Array* ann) {
 	parseSolveAnn(ann);
-	optimize(iv[var], OPT_MAX);
+	optimize(intVar(var), OPT_MAX);
+	initLns();
 	fixAllSearch();
 }
 
 void FlatZincSpace::setOutputElem(AST::Node* ai) const {
 	if (ai->isIntVar()) {
-		output_var(iv[ai->getIntVar()]);
+		// A view is fixed with the variable it views
+		const int i = ai->getIntVar();
+		output_var(iv[i] != nullptr ? iv[i] : iv[iv_views.at(i).x]);
 	} else if (ai->isBoolVar()) {
 		output_var(new BoolView(bv[ai->getBoolVar()]));
 	}
@@ -645,7 +788,7 @@ void FlatZincSpace::printElem(AST::Node* ai, std::ostream& out) const {
 	if (ai->isInt(k)) {
 		out << k;
 	} else if (ai->isIntVar()) {
-		out << iv[ai->getIntVar()]->getVal();
+		out << intVal(ai->getIntVar());
 	} else if (ai->isBoolVar()) {
 		if (bv[ai->getBoolVar()].isTrue()) {
 			out << "true";
@@ -691,12 +834,207 @@ void FlatZincSpace::printElem(AST::Node* ai, std::ostream& out) const {
 	}
 }
 
+void FlatZincSpace::printItem(AST::Node* ai, std::ostream& out) const {
+		if (ai->isArray()) {
+			AST::Array* aia = ai->getArray();
+			const int size = aia->a.size();
+			out << "[";
+			for (int j = 0; j < size; j++) {
+				printElem(aia->a[j], out);
+				if (j < size - 1) {
+					out << ", ";
+				}
+			}
+			out << "]";
+		} else if (ai->isCall("ifthenelse")) {
+			AST::Array* aia = ai->getCall("ifthenelse")->getArgs(3);
+			if (aia->a[0]->isBool()) {
+				if (aia->a[0]->getBool()) {
+					printElem(aia->a[1], out);
+				} else {
+					printElem(aia->a[2], out);
+				}
+			} else if (aia->a[0]->isBoolVar()) {
+				const BoolView b = bv[aia->a[0]->getBoolVar()];
+				if (b.isTrue()) {
+					printElem(aia->a[1], out);
+				} else if (b.isFalse()) {
+					printElem(aia->a[2], out);
+				} else {
+					std::cerr << "% Error: Condition not fixed." << '\n';
+				}
+			} else {
+				std::cerr << "% Error: Condition not Boolean." << '\n';
+			}
+		} else {
+			printElem(ai, out);
+		}
+}
+
+// Append the decimal form of v to buf, two digits at a time
+static void appendInt(std::string& buf, int64_t v) {
+	static const char digits[] =
+			"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+			"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+			"8081828384858687888990919293949596979899";
+	char tmp[20];
+	char* end = tmp + sizeof(tmp);
+	char* p = end;
+	uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+	while (u >= 100) {
+		const unsigned r = static_cast<unsigned>(u % 100) * 2;
+		u /= 100;
+		*--p = digits[r + 1];
+		*--p = digits[r];
+	}
+	if (u >= 10) {
+		const unsigned r = static_cast<unsigned>(u) * 2;
+		*--p = digits[r + 1];
+		*--p = digits[r];
+	} else {
+		*--p = static_cast<char>('0' + u);
+	}
+	if (v < 0) {
+		buf.push_back('-');
+	}
+	buf.append(p, end - p);
+}
+
+void FlatZincSpace::compileElem(AST::Node* ai) {
+	OutputStep step(0, OK_NONE, ai);
+	if (ai->isIntVar()) {
+		const int i = ai->getIntVar();
+		step.kind = OK_INT;
+		if (iv[i] != nullptr) {
+			step.x = iv[i];
+		} else {
+			// Read the view's root rather than materialising it
+			const IntViewDef& d = iv_views.at(i);
+			step.x = iv[d.x];
+			step.a = d.a;
+			step.b = d.b;
+		}
+	} else if (ai->isBoolVar()) {
+		step.kind = OK_BOOL;
+		step.var = ai->getBoolVar();
+	} else {
+		// Constants and strings are rendered once
+		std::ostringstream ss;
+		printElem(ai, ss);
+		output_text += ss.str();
+		return;
+	}
+	step.text_end = static_cast<int>(output_text.size());
+	output_plan.push_back(step);
+}
+
+void FlatZincSpace::compileOutput() {
+	output_compiled = true;
+	if (output == nullptr) {
+		return;
+	}
+	for (auto* ai : output->a) {
+		if (ai->isArray()) {
+			AST::Array* aia = ai->getArray();
+			output_text += "[";
+			for (int j = 0; j < aia->a.size(); j++) {
+				if (j > 0) {
+					output_text += ", ";
+				}
+				compileElem(aia->a[j]);
+			}
+			output_text += "]";
+		} else if (ai->isCall("ifthenelse")) {
+			// Which branch is printed is only known once the condition is fixed
+			output_plan.emplace_back(static_cast<int>(output_text.size()), OK_ITEM, ai);
+		} else {
+			compileElem(ai);
+		}
+	}
+	// The text after the last variable
+	output_plan.emplace_back(static_cast<int>(output_text.size()), OK_NONE, nullptr);
+}
+
+void FlatZincSpace::print(std::ostream& out) {
+	if (!output_compiled) {
+		compileOutput();
+	}
+	output_line.clear();
+	int text = 0;
+	for (const auto& step : output_plan) {
+		output_line.append(output_text, text, step.text_end - text);
+		text = step.text_end;
+		switch (step.kind) {
+			case OK_INT:
+				appendInt(output_line, static_cast<int64_t>(step.a) * step.x->getVal() + step.b);
+				break;
+			case OK_BOOL: {
+				const BoolView& b = bv[step.var];
+				if (b.isTrue()) {
+					output_line += "true";
+				} else if (b.isFalse()) {
+					output_line += "false";
+				} else {
+					output_line += "false..true";
+				}
+				break;
+			}
+			case OK_ITEM: {
+				std::ostringstream ss;
+				printItem(step.item, ss);
+				output_line += ss.str();
+				break;
+			}
+			case OK_NONE:
+				break;
+		}
+	}
+	out.write(output_line.data(), static_cast<std::streamsize>(output_line.size()));
+}
+
 void FlatZincSpace::storeSolution() {
 	solution_found = true;
 	if (!enable_store_solution) {
 		return;
 	}
 
+	if (lns) {
+		if (lns_int.empty() && lns_bool.empty()) {
+			// The output variables but the objective, views of the same variable counted once, then
+			// the variables of the structures that are not among them
+			std::unordered_map<IntVar*, int> pos;
+			pos.emplace(engine.opt_var, -1);
+			for (int i = 0; i < engine.outputs.size(); i++) {
+				Var* v = (Var*)engine.outputs[i];
+				if (v->getType() == BOOL_VAR) {
+					lns_bool.push_back(*(BoolView*)engine.outputs[i]);
+				} else if (pos.emplace((IntVar*)engine.outputs[i], static_cast<int>(lns_int.size()))
+											 .second) {
+					lns_int.push_back((IntVar*)engine.outputs[i]);
+				}
+			}
+			lns_outputs = static_cast<int>(lns_int.size());
+			for (auto& st : lns_structures) {
+				st.var.clear();
+				for (IntVar* x : st.x) {
+					auto p = pos.emplace(x, static_cast<int>(lns_int.size()));
+					if (p.second) {
+						lns_int.push_back(x);
+					}
+					st.var.push_back(p.first->second);
+				}
+			}
+			lns_int_val.resize(lns_int.size());
+			lns_bool_val.resize(lns_bool.size());
+		}
+		for (size_t i = 0; i < lns_int.size(); i++) {
+			lns_int_val[i] = lns_int[i]->getVal();
+		}
+		for (size_t i = 0; i < lns_bool.size(); i++) {
+			lns_bool_val[i] = lns_bool[i].isTrue();
+		}
+	}
+
 	for (auto& i : int_sol) {
 		i[1] = iv[i[0]]->getVal();
 	}
@@ -773,8 +1111,331 @@ bool FlatZincSpace::onRestart(Engine* e) {
 		assume_bool_val(bv[std::get<2>(i)], std::get<1>(i));
 	}
 
+	if (lns && solution_found) {
+		nextNeighbourhood(e);
+	}
+
 	new_solution = false;
 	return false;
 }
 
+void FlatZincSpace::lnsStructure(LnsKind kind, vec<IntVar*>& x, int offset) {
+	if (!so.lns || !so.lns_structure) {
+		return;
+	}
+	std::vector<IntVar*> xs;
+	for (int i = 0; i < x.size(); i++) {
+		xs.push_back(x[i]);
+	}
+	lns_structures.emplace_back(kind, std::move(xs), offset);
+}
+
+void FlatZincSpace::initLns() {
+	if (!so.lns) {
+		return;
+	}
+	if (enable_on_restart) {
+		std::cerr << "% Warning: --lns ignored, the model defines its own restart behaviour\n";
+		return;
+	}
+	if (!so.lazy) {
+		std::cerr << "% Warning: --lns ignored, it needs lazy clause generation\n";
+		return;
+	}
+	lns = true;
+	enable_on_restart = true;
+	enable_store_solution = true;
+	// A neighbourhood lasts until it is searched completely or the conflict limit is reached
+	so.restart_type = CONSTANT;
+	so.restart_scale = static_cast<unsigned int>(so.lns_conflicts);
+
+	// A structured generator needs something to relax and something to fix
+	int tasks = 0;
+	int nodes = 0;
+	int rows = 0;
+	for (const auto& st : lns_structures) {
+		if (st.kind == LNS_WINDOW) {
+			tasks += static_cast<int>(st.x.size());
+		} else if (st.kind == LNS_SEGMENT) {
+			nodes = std::max(nodes, static_cast<int>(st.x.size()));
+		} else if (st.kind == LNS_ROW) {
+			rows++;
+		}
+	}
+	lns_generators.emplace_back(LNS_RANDOM);
+	if (tasks >= 2) {
+		lns_generators.emplace_back(LNS_WINDOW);
+	}
+	if (nodes >= 3) {
+		lns_generators.emplace_back(LNS_SEGMENT);
+	}
+	if (rows >= 2) {
+		lns_generators.emplace_back(LNS_ROW);
+	}
+}
+
+int FlatZincSpace::selectGenerator() {
+	// Upper confidence bound of the improvement rate (UCB1), once each generator has been tried
+	int total = 0;
+	for (size_t i = 0; i < lns_generators.size(); i++) {
+		if (lns_generators[i].neighbourhoods == 0) {
+			return static_cast<int>(i);
+		}
+		total += lns_generators[i].neighbourhoods;
+	}
+	int best = 0;
+	double best_score = -1.0;
+	for (size_t i = 0; i < lns_generators.size(); i++) {
+		const LnsGenerator& g = lns_generators[i];
+		const double score = static_cast<double>(g.improved) / g.neighbourhoods +
+												 std::sqrt(2.0 * std::log(static_cast<double>(total)) / g.neighbourhoods);
+		if (score > best_score) {
+			best = static_cast<int>(i);
+			best_score = score;
+		}
+	}
+	return best;
+}
+
+void FlatZincSpace::nextNeighbourhood(Engine* e) {
+	// Neighbourhoods searched completely are too small, those given up are too large: resize them
+	// so that both happen about as often
+	if (lns_stats.neighbourhoods > 0) {
+		LnsGenerator& g = lns_generators[lns_current];
+		if (new_solution) {
+			g.improved++;
+			lns_stats.improved++;
+		} else if (e->conflicts - lns_start < so.lns_conflicts) {
+			g.exhausted++;
+			lns_stats.exhausted++;
+			g.relax = std::min(0.95, g.relax * 1.2);
+		} else {
+			g.relax = std::max(0.01, g.relax / 1.2);
+		}
+	}
+	lns_stats.neighbourhoods++;
+	lns_start = e->conflicts;
+	lns_current = selectGenerator();
+	LnsGenerator& g = lns_generators[lns_current];
+	g.neighbourhoods++;
+
+	auto assume_int_val = [&](IntVar* iv, int v) {
+		if (iv->getType() == INT_VAR_LL) {
+			e->assumptions.push(toInt(iv->getLit(v, LR_GE)));
+			e->assumptions.push(toInt(iv->getLit(v, LR_LE)));
+		} else {
+			e->assumptions.push(toInt(iv->getLit(v, LR_EQ)));
+		}
+	};
+
+	if (g.kind == LNS_RANDOM) {
+		std::uniform_real_distribution<double> rnd_relax(0.0, 1.0);
+		for (int i = 0; i < lns_outputs; i++) {
+			if (rnd_relax(engine.rnd) >= g.relax) {
+				assume_int_val(lns_int[i], lns_int_val[i]);
+			}
+		}
+		for (size_t i = 0; i < lns_bool.size(); i++) {
+			if (rnd_relax(engine.rnd) >= g.relax) {
+				e->assumptions.push(toInt(lns_bool_val[i] ? lns_bool[i] : ~lns_bool[i]));
+			}
+		}
+		return;
+	}
+
+	// A structured neighbourhood relaxes a part of the constraints of its kind and fixes the rest
+	// of their variables, leaving the variables outside them free
+	std::vector<int> sts;
+	for (size_t i = 0; i < lns_structures.size(); i++) {
+		if (lns_structures[i].kind == g.kind) {
+			sts.push_back(static_cast<int>(i));
+		}
+	}
+	auto part = [&](int n) {
+		return std::min(n, std::max(1, static_cast<int>(std::lround(g.relax * n))));
+	};
+	// 0: not decided, 1: relaxed, 2: fixed or bounded
+	std::vector<char> state(lns_int.size(), 0);
+	if (g.kind == LNS_WINDOW) {
+		// The tasks starting in the time window spanned by some consecutive tasks of one constraint.
+		// The tasks after the window may start earlier, so that the schedule can shrink.
+		std::uniform_int_distribution<size_t> rnd_st(0, sts.size() - 1);
+		const LnsStructure& st = lns_structures[sts[rnd_st(engine.rnd)]];
+		std::vector<int> starts;
+		for (const int v : st.var) {
+			if (v >= 0) {
+				starts.push_back(lns_int_val[v]);
+			}
+		}
+		if (starts.empty()) {
+			return;
+		}
+		std::sort(starts.begin(), starts.end());
+		const int k = part(static_cast<int>(starts.size()));
+		std::uniform_int_distribution<int> rnd_first(0, static_cast<int>(starts.size()) - k);
+		const int first = rnd_first(engine.rnd);
+		const int t0 = starts[first];
+		const int t1 = starts[first + k - 1];
+		for (const int s : sts) {
+			for (const int v : lns_structures[s].var) {
+				if (v >= 0 && lns_int_val[v] >= t0 && state[v] == 0) {
+					state[v] = lns_int_val[v] <= t1 ? 1 : 2;
+					if (state[v] == 2) {
+						e->assumptions.push(toInt(lns_int[v]->getLit(lns_int_val[v], LR_LE)));
+					}
+				}
+			}
+		}
+	} else if (g.kind == LNS_SEGMENT) {
+		// The successors of a path through the tour of one circuit. A closed (sub)tour continues
+		// with the next node not on the path.
+		std::vector<int> circuits;
+		for (const int s : sts) {
+			if (lns_structures[s].x.size() >= 3) {
+				circuits.push_back(s);
+			}
+		}
+		std::uniform_int_distribution<size_t> rnd_st(0, circuits.size() - 1);
+		const LnsStructure& st = lns_structures[circuits[rnd_st(engine.rnd)]];
+		const int n = static_cast<int>(st.x.size());
+		const int k = part(n);
+		std::vector<bool> on_path(n, false);
+		std::uniform_int_distribution<int> rnd_node(0, n - 1);
+		int cur = rnd_node(engine.rnd);
+		for (int j = 0; j < k; j++) {
+			while (on_path[cur]) {
+				cur = (cur + 1) % n;
+			}
+			on_path[cur] = true;
+			const int v = st.var[cur];
+			if (v < 0) {
+				continue;
+			}
+			state[v] = 1;
+			const int next = lns_int_val[v] - st.offset;
+			if (next >= 0 && next < n) {
+				cur = next;
+			}
+		}
+	} else {
+		// Some of the rows, relaxed completely
+		std::shuffle(sts.begin(), sts.end(), engine.rnd);
+		const int k = std::min(part(static_cast<int>(sts.size())), static_cast<int>(sts.size()) - 1);
+		for (int j = 0; j < k; j++) {
+			for (const int v : lns_structures[sts[j]].var) {
+				if (v >= 0) {
+					state[v] = 1;
+				}
+			}
+		}
+	}
+	for (const int s : sts) {
+		for (const int v : lns_structures[s].var) {
+			if (v >= 0 && state[v] == 0) {
+				state[v] = 2;
+				assume_int_val(lns_int[v], lns_int_val[v]);
+			}
+		}
+	}
+}
+
+void FlatZincSpace::printStats() {
+	auto secs = [](chuffed_clock::duration d) { return std::chrono::duration<double>(d).count(); };
+	printf("%%%%%%mzn-stat: parseTime=%.3f\n", secs(parse_stats.read_time + parse_stats.parse_time));
+	printf("%%%%%%mzn-stat: parseReadTime=%.3f\n", secs(parse_stats.read_time));
+	printf("%%%%%%mzn-stat: parseVarTime=%.3f\n", secs(parse_stats.var_time));
+	printf("%%%%%%mzn-stat: parsePostTime=%.3f\n", secs(parse_stats.post_time));
+	printf("%%%%%%mzn-stat: parseSymbols=%d\n", parse_stats.symbols);
+	if (so.presolve) {
+		printf("%%%%%%mzn-stat: presolveTime=%.3f\n", secs(presolve_stats.time));
+		printf("%%%%%%mzn-stat: presolveIntVars=%d\n", presolve_stats.int_vars);
+		printf("%%%%%%mzn-stat: presolveBoolVars=%d\n", presolve_stats.bool_vars);
+		printf("%%%%%%mzn-stat: presolveConstraints=%d\n", presolve_stats.constraints);
+		printf("%%%%%%mzn-stat: presolveBounds=%d\n", presolve_stats.bounds);
+		printf("%%%%%%mzn-stat: presolveCoefficients=%d\n", presolve_stats.coefficients);
+		printf("%%%%%%mzn-stat: presolveViews=%d\n", presolve_stats.views);
+		printf("%%%%%%mzn-stat: presolveInfeasible=%d\n", static_cast<int>(presolve_stats.infeasible));
+	}
+	if (so.detect_globals) {
+		printf("%%%%%%mzn-stat: structureTime=%.3f\n", secs(structure_stats.time));
+		printf("%%%%%%mzn-stat: structureAllDifferent=%d\n", structure_stats.all_different);
+		printf("%%%%%%mzn-stat: structureBoolSums=%d\n", structure_stats.bool_sums);
+		printf("%%%%%%mzn-stat: structureDisjunctive=%d\n", structure_stats.disjunctive);
+		printf("%%%%%%mzn-stat: structureConstraints=%d\n", structure_stats.constraints);
+	}
+	if (lns) {
+		printf("%%%%%%mzn-stat: lnsNeighbourhoods=%d\n", lns_stats.neighbourhoods);
+		printf("%%%%%%mzn-stat: lnsImproved=%d\n", lns_stats.improved);
+		printf("%%%%%%mzn-stat: lnsExhausted=%d\n", lns_stats.exhausted);
+		static const char* const kind_name[] = {"Random", "Window", "Segment", "Row"};
+		for (const auto& g : lns_generators) {
+			printf("%%%%%%mzn-stat: lns%sNeighbourhoods=%d\n", kind_name[g.kind], g.neighbourhoods);
+			printf("%%%%%%mzn-stat: lns%sImproved=%d\n", kind_name[g.kind], g.improved);
+			printf("%%%%%%mzn-stat: lns%sRelax=%.3f\n", kind_name[g.kind], g.relax);
+		}
+	}
+	if (so.encoding_analysis) {
+		printf("%%%%%%mzn-stat: encodingBoundsOnly=%d\n", encoding_stats.bounds_only);
+		printf("%%%%%%mzn-stat: encodingLazy=%d\n", encoding_stats.lazy);
+		printf("%%%%%%mzn-stat: encodingLiteralsSaved=%lld\n",
+					 static_cast<long long>(encoding_stats.literals_saved));
+	}
+}
+
+// FNV-1a
+size_t SymbolPool::hash(const char* key, size_t len) {
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < len; i++) {
+		h = (h ^ static_cast<unsigned char>(key[i])) * 1099511628211ULL;
+	}
+	return static_cast<size_t>(h ^ (h >> 32));
+}
+
+size_t SymbolPool::slotOf(const char* key, size_t len, size_t h) const {
+	const size_t mask = slots.size() - 1;
+	size_t i = h & mask;
+	while (slots[i] != -1) {
+		const int id = slots[i];
+		if (hashes[id] == h && strncmp(name(id), key, len) == 0 && name(id)[len] == '\0') {
+			break;
+		}
+		i = (i + 1) & mask;
+	}
+	return i;
+}
+
+void SymbolPool::grow() {
+	slots.assign(2 * slots.size(), -1);
+	const size_t mask = slots.size() - 1;
+	for (int id = 0; id < size(); id++) {
+		size_t i = hashes[id] & mask;
+		while (slots[i] != -1) {
+			i = (i + 1) & mask;
+		}
+		slots[i] = id;
+	}
+}
+
+int SymbolPool::intern(const char* key, size_t len) {
+	const size_t h = hash(key, len);
+	const size_t i = slotOf(key, len, h);
+	if (slots[i] != -1) {
+		return slots[i];
+	}
+	const int id = size();
+	slots[i] = id;
+	start.push_back(chars.size());
+	hashes.push_back(h);
+	chars.insert(chars.end(), key, key + len);
+	chars.push_back('\0');
+	if (2 * start.size() > slots.size()) {
+		grow();
+	}
+	return id;
+}
+
+int SymbolPool::lookup(const char* key, size_t len) const {
+	return slots[slotOf(key, len, hash(key, len))];
+}
+
 }  // namespace FlatZinc
@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <ostream>
@@ -108,6 +109,11 @@ public:
 class IntVarSpec : public VarSpec {
 public:
 	Option<AST::SetLit*> domain;
+	// whether it is the view view_a*x+view_b of the variable x = view_var (-1=no), set by the
+	// presolver; such a variable has no domain of its own
+	int view_var{-1};
+	int view_a{1};
+	int view_b{0};
 	IntVarSpec(const Option<AST::SetLit*>& d, bool output, bool introduced, bool looks = false)
 			: VarSpec(output, introduced, looks) {
 		alias = false;
@@ -270,22 +276,111 @@ private:
 /// Return global registry object
 Registry& registry();
 
+/// Interned identifiers: every distinct name is stored once and known by a dense id
+class SymbolPool {
+private:
+	/// The names, each terminated by a NUL
+	std::vector<char> chars;
+	/// Offset of each name in \a chars
+	std::vector<size_t> start;
+	/// Hash of each name
+	std::vector<size_t> hashes;
+	/// Open-addressing index of the names, -1 for an empty slot
+	std::vector<int> slots;
+
+	size_t slotOf(const char* key, size_t len, size_t h) const;
+	void grow();
+
+public:
+	SymbolPool() : slots(64, -1) {}
+	/// Return the id of \a key, adding it if it is new
+	int intern(const char* key, size_t len);
+	/// Return the id of \a key, or -1 if it has never been interned
+	int lookup(const char* key, size_t len) const;
+	/// Return the name of symbol \a id
+	const char* name(int id) const { return &chars[start[id]]; }
+	/// Return the hash of symbol \a id
+	size_t hash(int id) const { return hashes[id]; }
+	/// Number of distinct names
+	int size() const { return static_cast<int>(start.size()); }
+
+	static size_t hash(const char* key, size_t len);
+};
+
 /// Symbol table mapping identifiers (strings) to values
+///
+/// Open addressing over the ids of a SymbolPool shared by all the tables of a parser, so a name
+/// is stored once however many tables it appears in.
 template <class Val>
 class SymbolTable {
 private:
-	std::map<std::string, Val> m;
+	SymbolPool& pool;
+	/// Symbol id and value of the entries
+	std::vector<std::pair<int, Val>> entries;
+	/// Index into the entries, -1 for an empty slot
+	std::vector<int> slots;
+
+	size_t slotOf(int id) const {
+		const size_t mask = slots.size() - 1;
+		size_t i = pool.hash(id) & mask;
+		while (slots[i] != -1 && entries[slots[i]].first != id) {
+			i = (i + 1) & mask;
+		}
+		return i;
+	}
+	void grow() {
+		slots.assign(2 * slots.size(), -1);
+		for (int e = 0; e < static_cast<int>(entries.size()); e++) {
+			slots[slotOf(entries[e].first)] = e;
+		}
+	}
 
 public:
+	explicit SymbolTable(SymbolPool& pool0) : pool(pool0), slots(16, -1) {}
 	/// Insert \a val with \a key
-	void put(const std::string& key, const Val& val) { m[key] = val; }
+	void put(const char* key, size_t len, const Val& val) {
+		const int id = pool.intern(key, len);
+		const size_t i = slotOf(id);
+		if (slots[i] != -1) {
+			entries[slots[i]].second = val;
+			return;
+		}
+		slots[i] = static_cast<int>(entries.size());
+		entries.emplace_back(id, val);
+		if (2 * entries.size() > slots.size()) {
+			grow();
+		}
+	}
+	void put(const char* key, const Val& val) { put(key, strlen(key), val); }
+	void put(const std::string& key, const Val& val) { put(key.data(), key.size(), val); }
+	/// Return the value of \a key (or of the symbol with that id), or nullptr if it does not exist
+	///
+	/// The pointer is invalidated by the next put.
+	const Val* find(int id) const {
+		if (id == -1 || entries.empty()) {
+			return nullptr;
+		}
+		const int e = slots[slotOf(id)];
+		return e == -1 ? nullptr : &entries[e].second;
+	}
+	const Val* find(const char* key, size_t len) const { return find(pool.lookup(key, len)); }
+	const Val* find(const char* key) const { return find(key, strlen(key)); }
+	const Val* find(const std::string& key) const { return find(key.data(), key.size()); }
 	/// Return whether \a key exists, and set \a val if it does exist
+	bool get(const char* key, Val& val) const {
+		const Val* v = find(key);
+		if (v == nullptr) {
+			return false;
+		}
+		val = *v;
+		return true;
+	}
 	bool get(const std::string& key, Val& val) const {
-		typename std::map<std::string, Val>::const_iterator i = m.find(key);
-		if (i == m.end()) {
+		const Val* v = find(key);
+		if (v == nullptr) {
 			return false;
 		}
-		val = i->second;
+		val = *v;
 		return true;
 	}
 };
@@ -301,6 +396,18 @@ public:
 	vec<IntVar*> iv;
 	/// Indicates whether an integer variable is introduced by mzn2fzn
 	std::vector<bool> iv_introduced;
+	/// The view a*x+b of variable x that an integer variable is, for the variables the presolver
+	/// made views. These have no IntVar until intVar() needs one, and iv holds nullptr for them.
+	struct IntViewDef {
+		int x;
+		int a;
+		int b;
+	};
+	std::unordered_map<int, IntViewDef> iv_views;
+	/// The kinds of literals the constraints read of each integer variable, collected with
+	/// --encoding-analysis
+	enum LitNeeds { LN_BOUNDS = 1, LN_VALUES = 2 };
+	std::unordered_map<IntVar*, int> iv_lit_needs;
 	/// The Boolean variables
 	vec<BoolView> bv;
 	/// Indicates whether a Boolean variable is introduced by mzn2fzn
@@ -309,6 +416,82 @@ public:
 	vec<BoolView> assumptions;
 
 	AST::Array* output{nullptr};
+	/// The output item compiled on first use: the text around the variables is rendered once, and
+	/// each variable is resolved to the solver variable it reads. Step i prints the text from the
+	/// end of step i - 1 to text_end, then its value.
+	enum OutputKind { OK_NONE, OK_INT, OK_BOOL, OK_ITEM };
+	struct OutputStep {
+		int text_end;
+		OutputKind kind;
+		/// OK_INT prints a * x + b, OK_BOOL the Boolean variable var, OK_ITEM prints item as is
+		IntVar* x;
+		int a;
+		int b;
+		int var;
+		AST::Node* item;
+		OutputStep(int text_end0, OutputKind kind0, AST::Node* item0)
+				: text_end(text_end0), kind(kind0), x(nullptr), a(1), b(0), var(-1), item(item0) {}
+	};
+	std::vector<OutputStep> output_plan;
+	std::string output_text;
+	bool output_compiled{false};
+	/// Where a solution is put together before being written at once
+	std::string output_line;
+
+	/// Where the time to read the model went, reported with the statistics
+	struct ParseStats {
+		/// Opening and mapping (or reading) the file
+		chuffed_clock::duration read_time{0};
+		/// Parsing, including creating the variables and posting the constraints
+		chuffed_clock::duration parse_time{0};
+		/// Creating the variables
+		chuffed_clock::duration var_time{0};
+		/// Posting the constraints
+		chuffed_clock::duration post_time{0};
+		/// Distinct identifiers in the model
+		int symbols{0};
+	} parse_stats;
+
+	/// What --presolve took out of the model, reported with the statistics
+	struct PresolveStats {
+		chuffed_clock::duration time{0};
+		/// Variables fixed, or made aliases of equal ones
+		int int_vars{0};
+		int bool_vars{0};
+		/// Constraints dropped as implied, dominated or duplicated
+		int constraints{0};
+		/// Variables created with tighter domains
+		int bounds{0};
+		/// Linear constraints whose coefficients were reduced
+		int coefficients{0};
+		/// Variables made affine views of others, and so not created
+		int views{0};
+		/// Whether the model was found infeasible, and so left unchanged
+		bool infeasible{false};
+	} presolve_stats;
+
+	/// What --detect-globals found in the model, reported with the statistics
+	struct StructureStats {
+		chuffed_clock::duration time{0};
+		/// all_different constraints posted for cliques of int_ne
+		int all_different{0};
+		/// Linear constraints rewritten as Boolean sums
+		int bool_sums{0};
+		/// disjunctive constraints posted for cliques of non-overlapping tasks
+		int disjunctive{0};
+		/// Constraints the globals replaced
+		int constraints{0};
+	} structure_stats;
+
+	/// What --encoding-analysis chose, reported with the statistics
+	struct EncodingStats {
+		/// Integer variables whose constraints only read their bounds
+		int bounds_only{0};
+		/// Of these, the variables given lazy literals although their domain is small
+		int lazy{0};
+		/// Literals the eager representation of those variables would have created up front
+		int64_t literals_saved{0};
+	} encoding_stats;
 
 	// === Experimental `on_restart` support ===
 	// Index of the status() variable
@@ -343,6 +526,66 @@ public:
 	// Whether onRestart() should be called
 	bool enable_on_restart = false;
 
+	// Native large neighbourhood search (--lns), built on the same restart hooks
+	// Whether it is used: the model is an optimisation problem without on_restart neighbourhoods
+	bool lns = false;
+	// The variables fixed by the neighbourhoods, and their values in the best solution: first the
+	// output variables, then the variables of the structures below that are not output
+	std::vector<IntVar*> lns_int;
+	std::vector<int> lns_int_val;
+	int lns_outputs = 0;
+	std::vector<BoolView> lns_bool;
+	std::vector<bool> lns_bool_val;
+	// The kinds of neighbourhoods. The random one fixes each output variable with the same
+	// probability, the others relax a part of a global constraint and fix the rest of it.
+	enum LnsKind { LNS_RANDOM, LNS_WINDOW, LNS_SEGMENT, LNS_ROW };
+	// A global constraint the neighbourhoods of a kind are derived from, recorded when it is
+	// posted: the start times of a cumulative or disjunctive constraint (LNS_WINDOW), the
+	// successors of a circuit (LNS_SEGMENT), or the sequence of a regular constraint (LNS_ROW)
+	struct LnsStructure {
+		LnsKind kind;
+		std::vector<IntVar*> x;
+		// The positions of x in lns_int
+		std::vector<int> var;
+		int offset;
+		LnsStructure(LnsKind kind0, std::vector<IntVar*> x0, int offset0)
+				: kind(kind0), x(std::move(x0)), offset(offset0) {}
+	};
+	std::vector<LnsStructure> lns_structures;
+	// The neighbourhood generators, one per kind that the model has a structure for, and the
+	// statistics the next one is chosen by
+	struct LnsGenerator {
+		LnsKind kind;
+		// The part of the variables (or tasks, nodes, rows) left free by its next neighbourhood
+		double relax{0.2};
+		int neighbourhoods{0};
+		/// Neighbourhoods in which a better solution was found
+		int improved{0};
+		/// Neighbourhoods searched completely without finding one
+		int exhausted{0};
+		explicit LnsGenerator(LnsKind kind0) : kind(kind0) {}
+	};
+	std::vector<LnsGenerator> lns_generators;
+	// The generator of the current neighbourhood
+	int lns_current = 0;
+	// The number of conflicts when the current neighbourhood was started
+	long long int lns_start = 0;
+	struct LnsStats {
+		int neighbourhoods{0};
+		/// Neighbourhoods in which a better solution was found
+		int improved{0};
+		/// Neighbourhoods searched completely without finding one
+		int exhausted{0};
+	} lns_stats;
+	// Record a global constraint for the structured neighbourhoods, if they are used
+	void lnsStructure(LnsKind kind, vec<IntVar*>& x, int offset = 0);
+	// Set up LNS for the optimisation of the objective, if asked for
+	void initLns();
+	// Choose the generator of the next neighbourhood
+	int selectGenerator();
+	// Push the assumptions fixing the next neighbourhood
+	void nextNeighbourhood(Engine* e);
+
 	// === End `on_restart` ===
 
 	/// Construct problem with given number of variables
@@ -358,6 +601,11 @@ public:
 
 	/// Create new integer variable from specification
 	void newIntVar(IntVarSpec* vs, const std::string& name);
+	/// Return integer variable \a i, creating the variable of a view (and the constraint linking
+	/// it to the variable it views) the first time
+	IntVar* intVar(int i);
+	/// Return the value of integer variable \a i, which must be fixed
+	int64_t intVal(int i) const;
 	/// Create new Boolean variable from specification
 	void newBoolVar(BoolVarSpec* vs);
 	/// Create new set variable from specification
@@ -365,6 +613,11 @@ public:
 
 	/// Post a constraint specified by \a ce
 	static void postConstraint(const ConExpr& ce, AST::Node* annotation);
+	/// Record the kinds of literals constraint \a ce reads of its integer variables
+	void noteLitNeeds(const ConExpr& ce);
+	void noteLitNeeds(AST::Node* n, int needs);
+	/// Give lazy literals to the integer variables whose constraints only read their bounds
+	void chooseEncodings();
 
 	/// Post the solve item
 	void solve(AST::Array* annotation);
@@ -378,49 +631,15 @@ public:
 	void setOutput() const;
 
 	void printElem(AST::Node* ai, std::ostream& out = std::cout) const;
+	/// Print one item of the output, an element or an array or ifthenelse of elements
+	void printItem(AST::Node* ai, std::ostream& out) const;
+	/// Build output_plan from the output item
+	void compileOutput();
+	void compileElem(AST::Node* ai);
 	// Needed by the profiler
-	void print(std::ostream& out) override {
-		if (output == nullptr) {
-			return;
-		}
-		for (auto* ai : output->a) {
-			if (ai->isArray()) {
-				AST::Array* aia = ai->getArray();
-				const int size = aia->a.size();
-				out << "[";
-				for (int j = 0; j < size; j++) {
-					printElem(aia->a[j], out);
-					if (j < size - 1) {
-						out << ", ";
-					}
-				}
-				out << "]";
-			} else if (ai->isCall("ifthenelse")) {
-				AST::Array* aia = ai->getCall("ifthenelse")->getArgs(3);
-				if (aia->a[0]->isBool()) {
-					if (aia->a[0]->getBool()) {
-						printElem(aia->a[1], out);
-					} else {
-						printElem(aia->a[2], out);
-					}
-				} else if (aia->a[0]->isBoolVar()) {
-					const BoolView b = bv[aia->a[0]->getBoolVar()];
-					if (b.isTrue()) {
-						printElem(aia->a[1], out);
-					} else if (b.isFalse()) {
-						printElem(aia->a[2], out);
-					} else {
-						std::cerr << "% Error: Condition not fixed." << '\n';
-					}
-				} else {
-					std::cerr << "% Error: Condition not Boolean." << '\n';
-				}
-			} else {
-				printElem(ai, out);
-			}
-		}
-	};
+	void print(std::ostream& out) override;
 	void printStream(std::ostream& out);
+	void printStats() override;
 
 	// Needed by the profiler
 	void printDomains(std::ostream& out = std::cout) {
@@ -433,6 +652,9 @@ public:
 			}
 
 			IntVar* var = iv[i];
+			if (var == nullptr) {
+				continue;
+			}
 			const std::string varName = intVarString[var];
 
 			if (varName.empty() || varName.find(so.filter_domains) == std::string::npos) {
@@ -533,6 +755,8 @@ private:
 
 extern FlatZincSpace* s;
 
+class SnapshotWriter;
+
 using intvartype = std::pair<std::string, Option<std::vector<int>*>>;
 using varspec = std::pair<std::string, VarSpec*>;
 
@@ -542,29 +766,39 @@ public:
 	ParserState(const std::string& b, std::ostream& err0)
 			: buf(b.c_str()), pos(0), length(b.size()), fg(nullptr), hadError(false), err(err0) {}
 
-	ParserState(const char* buf0, int length0, std::ostream& err0)
+	ParserState(const char* buf0, size_t length0, std::ostream& err0)
 			: buf(buf0), pos(0), length(length0), fg(nullptr), hadError(false), err(err0) {}
 
 	void* yyscanner;
 	const char* buf;
-	unsigned int pos, length;
+	size_t pos, length;
 	FlatZinc::FlatZincSpace* fg;
 	std::vector<std::pair<std::string, AST::Node*>> _output;
 
-	SymbolTable<int> intvarTable;
-	SymbolTable<int> boolvarTable;
-	SymbolTable<int> floatvarTable;
-	SymbolTable<int> setvarTable;
-	SymbolTable<std::vector<int>> intvararrays;
-	SymbolTable<std::vector<int>> boolvararrays;
-	SymbolTable<std::vector<int>> floatvararrays;
-	SymbolTable<std::vector<int>> setvararrays;
-	SymbolTable<std::vector<int>> intvalarrays;
-	SymbolTable<std::vector<int>> boolvalarrays;
-	SymbolTable<int> intvals;
-	SymbolTable<bool> boolvals;
-	SymbolTable<AST::SetLit> setvals;
-	SymbolTable<std::vector<AST::SetLit>> setvalarrays;
+	/// The identifiers of all the symbol tables
+	SymbolPool symbols;
+	/// Where the nodes of the constraint being parsed are allocated
+	AST::Arena arena;
+	/// Records what is parsed, for --save-model
+	SnapshotWriter* snapshot{nullptr};
+	/// Whether constraint items are kept back in deferred for --presolve or --detect-globals, until
+	/// all are read
+	bool presolving{false};
+	std::vector<std::pair<ConExpr*, AST::Node*>> deferred;
+	SymbolTable<int> intvarTable{symbols};
+	SymbolTable<int> boolvarTable{symbols};
+	SymbolTable<int> floatvarTable{symbols};
+	SymbolTable<int> setvarTable{symbols};
+	SymbolTable<std::vector<int>> intvararrays{symbols};
+	SymbolTable<std::vector<int>> boolvararrays{symbols};
+	SymbolTable<std::vector<int>> floatvararrays{symbols};
+	SymbolTable<std::vector<int>> setvararrays{symbols};
+	SymbolTable<std::vector<int>> intvalarrays{symbols};
+	SymbolTable<std::vector<int>> boolvalarrays{symbols};
+	SymbolTable<int> intvals{symbols};
+	SymbolTable<bool> boolvals{symbols};
+	SymbolTable<AST::SetLit> setvals{symbols};
+	SymbolTable<std::vector<AST::SetLit>> setvalarrays{symbols};
 
 	std::vector<varspec> intvars;
 	std::vector<varspec> boolvars;
@@ -587,10 +821,16 @@ public:
 		if (pos >= length) {
 			return 0;
 		}
-		const int num = std::min(length - pos, lexBufSize);
+		const size_t num = std::min(length - pos, static_cast<size_t>(lexBufSize));
 		memcpy(lexBuf, buf + pos, num);
 		pos += num;
-		return num;
+		return static_cast<int>(num);
+	}
+
+	/// Stop allocating nodes from the arena, whose nodes must all have been deleted by now
+	void endConstraint() {
+		AST::Arena::current = nullptr;
+		arena.reset();
 	}
 
 	void output(const std::string& x, AST::Node* n) { _output.emplace_back(x, n); }
@@ -643,6 +883,8 @@ public:
 
 void solve(const std::string& filename, std::ostream& err = std::cerr);
 void solve(std::istream& is, std::ostream& err = std::cerr);
+/// Set up the model saved by --save-model in \a filename
+void loadModel(const std::string& filename, std::ostream& err = std::cerr);
 
 }  // namespace FlatZinc
 
@@ -130,7 +130,9 @@ int main(int argc, char** argv) {
 			std::exit(EXIT_FAILURE);
 		}
 
-		if (filename.empty()) {
+		if (!so.load_model.empty()) {
+			FlatZinc::loadModel(so.load_model);
+		} else if (filename.empty()) {
 			FlatZinc::solve(std::cin, std::cerr);
 		} else {
 			FlatZinc::solve(filename);
@@ -145,7 +147,7 @@ int main(int argc, char** argv) {
 #endif
 
 		engine.set_assumptions(FlatZinc::s->assumptions);
-		if (engine.opt_var != nullptr && so.nof_solutions != 0) {
+		if (engine.opt_var != nullptr && so.nof_solutions != 0 && !so.stream_solutions) {
 			engine.setOutputStream(output_buffer);
 			engine.solve(FlatZinc::s, commandLine);
 			std::cout << output_buffer.str();
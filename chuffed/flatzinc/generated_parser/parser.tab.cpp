@@ -75,10 +75,15 @@
 #include <fstream>
 #include <sstream>
 
+#include "chuffed/core/options.h"
 #include <chuffed/flatzinc/flatzinc.h>
+#include "chuffed/flatzinc/presolve.h"
+#include "chuffed/flatzinc/structure.h"
+#include "chuffed/flatzinc/snapshot.h"
 #include <chuffed/flatzinc/generated_parser/parser.tab.h>
 
 #ifdef HAVE_MMAP
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <fcntl.h>
@@ -92,7 +97,9 @@ int yyparse(void*);
 int yylex(YYSTYPE*, void* scanner);
 int yylex_init (void** scanner);
 int yylex_destroy (void* scanner);
+struct yy_buffer_state* yy_scan_buffer (char* base, size_t size, void* scanner);
 int yyget_lineno (void* scanner);
+void yyset_lineno (int line_number, void* scanner);
 void yyset_extra (void* user_defined ,void* yyscanner );
 
 extern int yydebug;
@@ -122,23 +129,24 @@ void yyassert(ParserState* pp, bool cond, const char* str)
  *
  */
 
-AST::Node* getArrayElement(ParserState* pp, std::string id, unsigned int offset) {
-    if (offset > 0) {
-        std::vector<int> tmp;
-        if (pp->intvararrays.get(id, tmp) && offset<= tmp.size())
-            return new AST::IntVar(tmp[offset-1]);
-        if (pp->boolvararrays.get(id, tmp) && offset<= tmp.size())
-            return new AST::BoolVar(tmp[offset-1]);
-        if (pp->setvararrays.get(id, tmp) && offset<= tmp.size())
-            return new AST::SetVar(tmp[offset-1]);
-
-        if (pp->intvalarrays.get(id, tmp) && offset<= tmp.size())
-            return new AST::IntLit(tmp[offset-1]);
-        if (pp->boolvalarrays.get(id, tmp) && offset<= tmp.size())
-            return new AST::BoolLit(tmp[offset-1]);
-        std::vector<AST::SetLit> tmpS;
-        if (pp->setvalarrays.get(id, tmpS) && offset<= tmpS.size())
-            return new AST::SetLit(tmpS[offset-1]);      
+AST::Node* getArrayElement(ParserState* pp, const char* id, unsigned int offset) {
+    const int sym = pp->symbols.lookup(id, strlen(id));
+    if (offset > 0 && sym != -1) {
+        const std::vector<int>* tmp;
+        if ((tmp = pp->intvararrays.find(sym)) && offset<= tmp->size())
+            return new AST::IntVar((*tmp)[offset-1]);
+        if ((tmp = pp->boolvararrays.find(sym)) && offset<= tmp->size())
+            return new AST::BoolVar((*tmp)[offset-1]);
+        if ((tmp = pp->setvararrays.find(sym)) && offset<= tmp->size())
+            return new AST::SetVar((*tmp)[offset-1]);
+
+        if ((tmp = pp->intvalarrays.find(sym)) && offset<= tmp->size())
+            return new AST::IntLit((*tmp)[offset-1]);
+        if ((tmp = pp->boolvalarrays.find(sym)) && offset<= tmp->size())
+            return new AST::BoolLit((*tmp)[offset-1]);
+        const std::vector<AST::SetLit>* tmpS;
+        if ((tmpS = pp->setvalarrays.find(sym)) && offset<= tmpS->size())
+            return new AST::SetLit((*tmpS)[offset-1]);
     }
 
     pp->err << "Error: array access to " << id << " invalid"
@@ -147,14 +155,15 @@ AST::Node* getArrayElement(ParserState* pp, std::string id, unsigned int offset)
     pp->hadError = true;
     return new AST::IntVar(0); // keep things consistent
 }
-AST::Node* getVarRefArg(ParserState* pp, std::string id, bool annotation = false) {
-    int tmp;
-    if (pp->intvarTable.get(id, tmp))
-        return new AST::IntVar(tmp);
-    if (pp->boolvarTable.get(id, tmp))
-        return new AST::BoolVar(tmp);
-    if (pp->setvarTable.get(id, tmp))
-        return new AST::SetVar(tmp);
+AST::Node* getVarRefArg(ParserState* pp, const char* id, bool annotation = false) {
+    const int sym = pp->symbols.lookup(id, strlen(id));
+    const int* tmp;
+    if ((tmp = pp->intvarTable.find(sym)))
+        return new AST::IntVar(*tmp);
+    if ((tmp = pp->boolvarTable.find(sym)))
+        return new AST::BoolVar(*tmp);
+    if ((tmp = pp->setvarTable.find(sym)))
+        return new AST::SetVar(*tmp);
     if (annotation)
         return new AST::Atom(id);
     pp->err << "Error: undefined variable " << id
@@ -181,6 +190,9 @@ void addDomainConstraint(
  */
 
 void initfg(ParserState* pp) {
+    const time_point start = chuffed_clock::now();
+    if (pp->snapshot != nullptr)
+        pp->snapshot->vars(*pp);
 #if EXPOSE_INT_LITS
     static struct {
         const char *int_CMP_reif;
@@ -283,6 +295,8 @@ void initfg(ParserState* pp) {
             pp->setvars[i].second = nullptr;
         }
     }
+    if (pp->fg != nullptr)
+        pp->fg->parse_stats.var_time = chuffed_clock::now() - start;
     for (unsigned int i = pp->domainConstraints.size(); i--;) {
         if (!pp->hadError) {
             try {
@@ -309,6 +323,113 @@ void initfg(ParserState* pp) {
 #endif
 }
 
+/*
+ * The items after the variables, shared by the parser and by loading a snapshot
+ *
+ */
+
+void postConstraintItem(ParserState* pp, ConExpr& c, AST::Node* ann) {
+    if (pp->snapshot != nullptr)
+        pp->snapshot->constraint(c, ann);
+    if (pp->hadError)
+        return;
+    if (c.id == "chuffed_on_restart_status") {
+        pp->fg->restart_status = c.args->a[0]->getIntVar();
+        pp->fg->enable_on_restart = true;
+    } else if (c.id == "chuffed_on_restart_complete") {
+        mark_complete(pp->fg->bv[c.args->a[0]->getBoolVar()], &pp->fg->mark_complete);
+        pp->fg->enable_on_restart = true;
+    } else if (c.id == "chuffed_on_restart_uniform_int") {
+        pp->fg->int_uniform.emplace_back(std::array<int, 3>{ c.args->a[0]->getInt(), c.args->a[1]->getInt(), c.args->a[2]->getIntVar() });
+        pp->fg->enable_on_restart = true;
+    } else if (c.id == "chuffed_on_restart_last_val_bool") {
+        pp->last_val_bool.emplace_back(c.args->a[0]->getBoolVar(), c.args->a[1]->getBoolVar());
+        pp->fg->enable_on_restart = true;
+    } else if (c.id == "chuffed_on_restart_last_val_int") {
+        pp->last_val_int.emplace_back(c.args->a[0]->getIntVar(), c.args->a[1]->getIntVar());
+        pp->fg->enable_on_restart = true;
+    } else if (c.id == "chuffed_on_restart_sol_bool") {
+        pp->fg->bool_sol.emplace_back(std::tuple<int, bool, int>{ c.args->a[0]->getBoolVar(), false, c.args->a[1]->getBoolVar() });
+        pp->fg->enable_on_restart = true;
+        pp->fg->enable_store_solution = true;
+    } else if (c.id == "chuffed_on_restart_sol_int") {
+        pp->fg->int_sol.emplace_back(std::array<int, 3>{ c.args->a[0]->getIntVar(), 0, c.args->a[1]->getIntVar() });
+        pp->fg->enable_on_restart = true;
+        pp->fg->enable_store_solution = true;
+    } else {
+        try {
+            FlatZinc::FlatZincSpace::postConstraint(c, ann);
+        } catch (FlatZinc::Error& e) {
+            yyerror(pp, e.toString().c_str());
+        }
+    }
+}
+
+/// Post a constraint item, or keep it back for the presolver; takes ownership of \a c and \a ann
+void addConstraintItem(ParserState* pp, ConExpr* c, AST::Node* ann) {
+    if (pp->presolving) {
+        pp->deferred.emplace_back(c, ann);
+        return;
+    }
+    postConstraintItem(pp, *c, ann);
+    delete c;
+    delete ann;
+}
+
+/// Presolve the model read so far and look for globals in it, then create its variables and post
+/// the constraint items kept back
+void presolveModel(ParserState* pp) {
+    FlatZincSpace::PresolveStats stats;
+    FlatZincSpace::StructureStats structure;
+    if (!pp->hadError && so.presolve)
+        presolve(*pp, pp->deferred, stats);
+    if (!pp->hadError && so.detect_globals)
+        detectGlobals(*pp, pp->deferred, structure);
+    pp->presolving = false;
+    initfg(pp);
+    if (pp->fg != nullptr) {
+        pp->fg->presolve_stats = stats;
+        pp->fg->structure_stats = structure;
+    }
+    for (auto& item : pp->deferred) {
+        postConstraintItem(pp, *item.first, item.second);
+        delete item.first;
+        delete item.second;
+    }
+    pp->deferred.clear();
+}
+
+/// Add an integer variable after the others (for a constant objective), returning its index
+int addIntVar(ParserState* pp, const std::string& name, IntVarSpec* spec) {
+    const int i = pp->intvars.size();
+    pp->intvars.push_back(varspec(name, spec));
+    if (pp->snapshot != nullptr)
+        pp->snapshot->intVar(pp->intvars[i]);
+    if (pp->fg != nullptr) {
+        // Add a new IntVar to the FlatZincSpace if it was already created
+        try {
+            pp->fg->newIntVar(spec, name);
+        } catch (FlatZinc::Error& e) {
+            yyerror(pp, e.toString().c_str());
+        }
+    }
+    return i;
+}
+
+void postSolveItem(ParserState* pp, int kind, int objective, AST::Array* ann) {
+    if (pp->snapshot != nullptr)
+        pp->snapshot->solve(kind, objective, ann);
+    if (!pp->hadError) {
+        if (kind == SS_SATISFY)
+            pp->fg->solve(ann);
+        else if (kind == SS_MINIMIZE)
+            pp->fg->minimize(objective, ann);
+        else
+            pp->fg->maximize(objective, ann);
+    }
+    pp->postOnRestartPropagators();
+}
+
 AST::Node* arrayOutput(AST::Call* ann) {
     AST::Array* a = nullptr;
     
@@ -352,65 +473,182 @@ AST::Node* arrayOutput(AST::Call* ann) {
 
 namespace FlatZinc {
 
+    /// Read the whole of \a filename into \a s
+    static bool readFile(const std::string& filename, std::string& s) {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file.seekg(0, std::ios::end);
+        const std::streamoff size = file.tellg();
+        if (size < 0) {
+            // Not seekable (e.g. a pipe)
+            file.clear();
+            s.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            return true;
+        }
+        s.resize(size);
+        file.seekg(0, std::ios::beg);
+        file.read(&s[0], size);
+        return true;
+    }
+
+    /// Parse the model of \a pp, scanning \a inplace (which must be followed by two NULs) directly
+    /// when it is given, and record where the time went since \a start
+    /// Hand the parsed (or loaded) model over to the solver
+    static void finish(ParserState& pp, time_point start, time_point read) {
+        pp.endConstraint();
+        if (pp.snapshot != nullptr && !pp.hadError) {
+            pp.snapshot->output(pp._output);
+            if (!pp.snapshot->commit(so.save_model))
+                pp.err << "Cannot write model snapshot " << so.save_model << std::endl;
+        }
+        FlatZinc::s->output = pp.getOutput();
+        FlatZinc::s->setOutput();
+        FlatZinc::s->chooseEncodings();
+        FlatZinc::s->parse_stats.read_time = read - start;
+        FlatZinc::s->parse_stats.parse_time = chuffed_clock::now() - read;
+        FlatZinc::s->parse_stats.symbols = pp.symbols.size();
+
+        if (pp.yyscanner)
+            yylex_destroy(pp.yyscanner);
+        if (pp.hadError) abort();
+    }
+
+    static void parse(ParserState& pp, char* inplace, size_t size,
+                      time_point start, time_point read) {
+        SnapshotWriter snapshot;
+        if (!so.save_model.empty())
+            pp.snapshot = &snapshot;
+        pp.presolving = so.presolve || so.detect_globals;
+        yylex_init(&pp.yyscanner);
+        yyset_extra(&pp, pp.yyscanner);
+        if (inplace != nullptr) {
+            yy_scan_buffer(inplace, size + 2, pp.yyscanner);
+            // Unlike the buffers flex makes itself, one it is given starts with no line number
+            yyset_lineno(1, pp.yyscanner);
+        }
+        // yydebug = 1;
+        yyparse(&pp);
+        finish(pp, start, read);
+    }
+
     void solve(const std::string& filename, std::ostream& err) {
+        const time_point start = chuffed_clock::now();
 #ifdef HAVE_MMAP
-        int fd;
-        char* data;
-        struct stat sbuf;
-        fd = open(filename.c_str(), O_RDONLY);
+        const int fd = open(filename.c_str(), O_RDONLY);
         if (fd == -1) {
             err << "Cannot open file " << filename << std::endl;
             exit(0);
         }
-        if (stat(filename.c_str(), &sbuf) == -1) {
-            err << "Cannot stat file " << filename << std::endl;
-            return;          
+        // Flex scans a buffer in place if it ends with two NULs, writing into it as it goes, so
+        // map the file privately over zeroed memory one page longer than needed: the bytes past the
+        // end of the file read as zero, and only the pages flex writes to are ever copied.
+        struct stat sbuf;
+        char* data = static_cast<char*>(MAP_FAILED);
+        size_t size = 0;
+        if (fstat(fd, &sbuf) == 0 && sbuf.st_size > 0 && sbuf.st_size < INT_MAX - 2) {
+            size = sbuf.st_size;
+            data = static_cast<char*>(mmap(nullptr, size + 2, PROT_READ | PROT_WRITE,
+                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (data != MAP_FAILED &&
+                mmap(data, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+                munmap(data, size + 2);
+                data = static_cast<char*>(MAP_FAILED);
+            }
         }
-        data = (char*)mmap((caddr_t)0, sbuf.st_size, PROT_READ, MAP_SHARED, fd,0);
-        if (data == (caddr_t)(-1)) {
-            err << "Cannot mmap file " << filename << std::endl;
-            return;          
+        close(fd);
+        if (data != MAP_FAILED) {
+            ParserState pp(data, size, err);
+            parse(pp, data, size, start, chuffed_clock::now());
+            munmap(data, size + 2);
+            return;
         }
-
-        ParserState pp(data, sbuf.st_size, err);
-#else
-        std::ifstream file;
-        file.open(filename.c_str());
-        if (!file.is_open()) {
+#endif
+        // Without mmap, or when the file cannot be mapped (e.g. it is empty or a pipe)
+        std::string s;
+        if (!readFile(filename, s)) {
             err << "Cannot open file " << filename << std::endl;
             exit(0);
         }
-        std::string s = std::string(std::istreambuf_iterator<char>(file),
-                                                     std::istreambuf_iterator<char>());
         ParserState pp(s, err);
-#endif
-        yylex_init(&pp.yyscanner);
-        yyset_extra(&pp, pp.yyscanner);
-        // yydebug = 1;
-        yyparse(&pp);
-        FlatZinc::s->output = pp.getOutput();
-        FlatZinc::s->setOutput();
-        
-        if (pp.yyscanner)
-            yylex_destroy(pp.yyscanner);
-        if (pp.hadError) abort();
+        parse(pp, nullptr, 0, start, chuffed_clock::now());
     }
 
     void solve(std::istream& is, std::ostream& err) {
+        const time_point start = chuffed_clock::now();
         std::string s = std::string(std::istreambuf_iterator<char>(is),
                                std::istreambuf_iterator<char>());
 
         ParserState pp(s, err);
+        parse(pp, nullptr, 0, start, chuffed_clock::now());
+    }
+
+    void loadModel(const std::string& filename, std::ostream& err) {
+        const time_point start = chuffed_clock::now();
+        SnapshotReader in;
+        if (!in.open(filename)) {
+            err << "Cannot read model snapshot " << filename << std::endl;
+            exit(0);
+        }
+        ParserState pp(nullptr, 0, err);
+        // Saving a loaded model again rewrites it in the current format
+        SnapshotWriter snapshot;
+        if (!so.save_model.empty())
+            pp.snapshot = &snapshot;
+        pp.presolving = so.presolve || so.detect_globals;
+        // The error reporting of the shared helpers expects a scanner
         yylex_init(&pp.yyscanner);
         yyset_extra(&pp, pp.yyscanner);
-        // yydebug = 1;
-        yyparse(&pp);
-        FlatZinc::s->output = pp.getOutput();
-        FlatZinc::s->setOutput();
-        
-        if (pp.yyscanner)
-            yylex_destroy(pp.yyscanner);
-        if (pp.hadError) abort();
+        const time_point read = chuffed_clock::now();
+        try {
+            for (SnapshotRecord r = in.record(); ; r = in.record()) {
+                // The constraint items follow the variables, and precede everything else
+                if (pp.presolving && r != SR_VARS && r != SR_CONSTRAINT)
+                    presolveModel(&pp);
+                if (r == SR_END)
+                    break;
+                switch (r) {
+                case SR_VARS:
+                    in.vars(pp);
+                    if (!pp.presolving)
+                        initfg(&pp);
+                    break;
+                case SR_INT_VAR: {
+                    varspec v = in.intVar();
+                    addIntVar(&pp, v.first, static_cast<IntVarSpec*>(v.second));
+                    break;
+                }
+                case SR_CONSTRAINT: {
+                    if (!pp.presolving)
+                        AST::Arena::current = &pp.arena;
+                    AST::Node* ann;
+                    ConExpr* c = in.constraint(ann);
+                    addConstraintItem(&pp, c, ann);
+                    pp.endConstraint();
+                    break;
+                }
+                case SR_SOLVE: {
+                    int kind, objective;
+                    AST::Node* ann;
+                    in.solve(kind, objective, ann);
+                    postSolveItem(&pp, kind, objective, dynamic_cast<AST::Array*>(ann));
+                    delete ann;
+                    break;
+                }
+                case SR_OUTPUT:
+                    in.output(pp);
+                    break;
+                default:
+                    break;
+                }
+            }
+            if (!in.atEnd() || pp.fg == nullptr)
+                throw Error("Model snapshot", "truncated or corrupt");
+        } catch (FlatZinc::Error& e) {
+            err << "Cannot read model snapshot " << filename << ": " << e.toString() << std::endl;
+            exit(0);
+        }
+        finish(pp, start, read);
     }
 
 }
@@ -538,35 +776,36 @@ enum yysymbol_kind_t
   YYSYMBOL_vardecl_bool_var_array_init = 92, /* vardecl_bool_var_array_init  */
   YYSYMBOL_vardecl_float_var_array_init = 93, /* vardecl_float_var_array_init  */
   YYSYMBOL_vardecl_set_var_array_init = 94, /* vardecl_set_var_array_init  */
-  YYSYMBOL_constraint_item = 95,           /* constraint_item  */
-  YYSYMBOL_solve_item = 96,                /* solve_item  */
-  YYSYMBOL_int_ti_expr_tail = 97,          /* int_ti_expr_tail  */
-  YYSYMBOL_bool_ti_expr_tail = 98,         /* bool_ti_expr_tail  */
-  YYSYMBOL_float_ti_expr_tail = 99,        /* float_ti_expr_tail  */
-  YYSYMBOL_set_literal = 100,              /* set_literal  */
-  YYSYMBOL_int_list = 101,                 /* int_list  */
-  YYSYMBOL_int_list_head = 102,            /* int_list_head  */
-  YYSYMBOL_bool_list = 103,                /* bool_list  */
-  YYSYMBOL_bool_list_head = 104,           /* bool_list_head  */
-  YYSYMBOL_float_list = 105,               /* float_list  */
-  YYSYMBOL_float_list_head = 106,          /* float_list_head  */
-  YYSYMBOL_set_literal_list = 107,         /* set_literal_list  */
-  YYSYMBOL_set_literal_list_head = 108,    /* set_literal_list_head  */
-  YYSYMBOL_flat_expr_list = 109,           /* flat_expr_list  */
-  YYSYMBOL_flat_expr = 110,                /* flat_expr  */
-  YYSYMBOL_non_array_expr_opt = 111,       /* non_array_expr_opt  */
-  YYSYMBOL_non_array_expr = 112,           /* non_array_expr  */
-  YYSYMBOL_non_array_expr_list = 113,      /* non_array_expr_list  */
-  YYSYMBOL_non_array_expr_list_head = 114, /* non_array_expr_list_head  */
-  YYSYMBOL_solve_expr = 115,               /* solve_expr  */
-  YYSYMBOL_minmax = 116,                   /* minmax  */
-  YYSYMBOL_annotations = 117,              /* annotations  */
-  YYSYMBOL_annotations_head = 118,         /* annotations_head  */
-  YYSYMBOL_annotation = 119,               /* annotation  */
-  YYSYMBOL_annotation_list = 120,          /* annotation_list  */
-  YYSYMBOL_annotation_olist = 121,         /* annotation_olist  */
-  YYSYMBOL_annotation_expr = 122,          /* annotation_expr  */
-  YYSYMBOL_ann_non_array_expr = 123        /* ann_non_array_expr  */
+  YYSYMBOL_constraint_head = 95,           /* constraint_head  */
+  YYSYMBOL_constraint_item = 96,           /* constraint_item  */
+  YYSYMBOL_solve_item = 97,                /* solve_item  */
+  YYSYMBOL_int_ti_expr_tail = 98,          /* int_ti_expr_tail  */
+  YYSYMBOL_bool_ti_expr_tail = 99,         /* bool_ti_expr_tail  */
+  YYSYMBOL_float_ti_expr_tail = 100,       /* float_ti_expr_tail  */
+  YYSYMBOL_set_literal = 101,              /* set_literal  */
+  YYSYMBOL_int_list = 102,                 /* int_list  */
+  YYSYMBOL_int_list_head = 103,            /* int_list_head  */
+  YYSYMBOL_bool_list = 104,                /* bool_list  */
+  YYSYMBOL_bool_list_head = 105,           /* bool_list_head  */
+  YYSYMBOL_float_list = 106,               /* float_list  */
+  YYSYMBOL_float_list_head = 107,          /* float_list_head  */
+  YYSYMBOL_set_literal_list = 108,         /* set_literal_list  */
+  YYSYMBOL_set_literal_list_head = 109,    /* set_literal_list_head  */
+  YYSYMBOL_flat_expr_list = 110,           /* flat_expr_list  */
+  YYSYMBOL_flat_expr = 111,                /* flat_expr  */
+  YYSYMBOL_non_array_expr_opt = 112,       /* non_array_expr_opt  */
+  YYSYMBOL_non_array_expr = 113,           /* non_array_expr  */
+  YYSYMBOL_non_array_expr_list = 114,      /* non_array_expr_list  */
+  YYSYMBOL_non_array_expr_list_head = 115, /* non_array_expr_list_head  */
+  YYSYMBOL_solve_expr = 116,               /* solve_expr  */
+  YYSYMBOL_minmax = 117,                   /* minmax  */
+  YYSYMBOL_annotations = 118,              /* annotations  */
+  YYSYMBOL_annotations_head = 119,         /* annotations_head  */
+  YYSYMBOL_annotation = 120,               /* annotation  */
+  YYSYMBOL_annotation_list = 121,          /* annotation_list  */
+  YYSYMBOL_annotation_olist = 122,         /* annotation_olist  */
+  YYSYMBOL_annotation_expr = 123,          /* annotation_expr  */
+  YYSYMBOL_ann_non_array_expr = 124        /* ann_non_array_expr  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -894,16 +1133,16 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  7
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   332
+#define YYLAST   329
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  57
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  67
+#define YYNNTS  68
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  159
+#define YYNRULES  160
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  341
+#define YYNSTATES  342
 
 /* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   301
@@ -957,22 +1196,23 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   482,   482,   484,   486,   489,   490,   494,   499,   507,
-     508,   512,   517,   525,   526,   533,   535,   537,   540,   541,
-     544,   547,   548,   549,   550,   553,   554,   555,   556,   559,
-     560,   563,   564,   571,   603,   634,   641,   673,   699,   709,
-     722,   779,   830,   838,   892,   905,   918,   926,   941,   945,
-     960,   984,   987,   993,   998,  1004,  1006,  1009,  1015,  1019,
-    1034,  1058,  1061,  1067,  1072,  1079,  1085,  1089,  1104,  1128,
-    1131,  1137,  1142,  1149,  1152,  1156,  1171,  1195,  1198,  1204,
-    1209,  1216,  1223,  1226,  1233,  1236,  1243,  1246,  1253,  1256,
-    1262,  1305,  1326,  1349,  1358,  1376,  1380,  1384,  1390,  1394,
-    1408,  1409,  1416,  1420,  1429,  1432,  1438,  1443,  1451,  1454,
-    1460,  1465,  1473,  1476,  1482,  1487,  1495,  1498,  1504,  1510,
-    1522,  1526,  1533,  1537,  1544,  1547,  1553,  1557,  1561,  1565,
-    1569,  1618,  1632,  1635,  1641,  1645,  1656,  1675,  1703,  1725,
-    1726,  1734,  1737,  1743,  1747,  1754,  1759,  1765,  1769,  1777,
-    1780,  1786,  1790,  1796,  1800,  1804,  1808,  1812,  1855,  1866
+       0,   720,   720,   722,   724,   727,   728,   732,   738,   747,
+     748,   752,   760,   771,   775,   785,   787,   789,   792,   793,
+     796,   799,   800,   801,   802,   805,   806,   807,   808,   811,
+     812,   815,   816,   823,   855,   886,   893,   925,   951,   961,
+     974,  1031,  1082,  1090,  1144,  1157,  1170,  1178,  1193,  1197,
+    1212,  1236,  1239,  1245,  1250,  1256,  1258,  1261,  1267,  1271,
+    1286,  1310,  1313,  1319,  1324,  1331,  1337,  1341,  1356,  1380,
+    1383,  1389,  1394,  1401,  1404,  1408,  1423,  1447,  1450,  1456,
+    1461,  1468,  1475,  1478,  1485,  1488,  1495,  1498,  1505,  1508,
+    1516,  1526,  1536,  1549,  1564,  1569,  1580,  1584,  1588,  1594,
+    1598,  1612,  1613,  1620,  1624,  1633,  1636,  1642,  1647,  1655,
+    1658,  1664,  1669,  1677,  1680,  1686,  1691,  1699,  1702,  1708,
+    1714,  1726,  1730,  1737,  1741,  1748,  1751,  1757,  1761,  1765,
+    1769,  1773,  1823,  1837,  1840,  1846,  1850,  1861,  1869,  1887,
+    1909,  1910,  1918,  1921,  1927,  1931,  1938,  1943,  1949,  1953,
+    1961,  1964,  1970,  1974,  1980,  1984,  1988,  1992,  1996,  2040,
+    2051
 };
 #endif
 
@@ -1008,15 +1248,16 @@ static const char *const yytname[] =
   "set_init", "set_init_list", "set_init_list_head",
   "set_var_array_literal", "vardecl_int_var_array_init",
   "vardecl_bool_var_array_init", "vardecl_float_var_array_init",
-  "vardecl_set_var_array_init", "constraint_item", "solve_item",
-  "int_ti_expr_tail", "bool_ti_expr_tail", "float_ti_expr_tail",
-  "set_literal", "int_list", "int_list_head", "bool_list",
-  "bool_list_head", "float_list", "float_list_head", "set_literal_list",
-  "set_literal_list_head", "flat_expr_list", "flat_expr",
-  "non_array_expr_opt", "non_array_expr", "non_array_expr_list",
-  "non_array_expr_list_head", "solve_expr", "minmax", "annotations",
-  "annotations_head", "annotation", "annotation_list", "annotation_olist",
-  "annotation_expr", "ann_non_array_expr", YY_NULLPTR
+  "vardecl_set_var_array_init", "constraint_head", "constraint_item",
+  "solve_item", "int_ti_expr_tail", "bool_ti_expr_tail",
+  "float_ti_expr_tail", "set_literal", "int_list", "int_list_head",
+  "bool_list", "bool_list_head", "float_list", "float_list_head",
+  "set_literal_list", "set_literal_list_head", "flat_expr_list",
+  "flat_expr", "non_array_expr_opt", "non_array_expr",
+  "non_array_expr_list", "non_array_expr_list_head", "solve_expr",
+  "minmax", "annotations", "annotations_head", "annotation",
+  "annotation_list", "annotation_olist", "annotation_expr",
+  "ann_non_array_expr", YY_NULLPTR
 };
 
 static const char *
@@ -1026,7 +1267,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#define YYPACT_NINF (-124)
+#define YYPACT_NINF (-123)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -1040,41 +1281,41 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     -27,    10,    21,    53,   -27,   -18,   -10,  -124,    26,   114,
-      16,    28,  -124,    59,    94,    87,    53,    58,    64,    86,
-    -124,    27,   123,  -124,  -124,   105,   109,    91,   101,   103,
-     146,   149,    14,  -124,   100,   107,   154,   122,    87,   115,
-     116,  -124,   158,  -124,   155,   113,  -124,  -124,   136,   121,
-     133,  -124,   120,  -124,  -124,  -124,    14,  -124,  -124,   135,
-     137,   166,   167,   182,   171,   178,   144,  -124,   194,  -124,
-      72,   178,   151,   153,  -124,  -124,   178,  -124,    25,    14,
-    -124,    27,  -124,   195,   152,   198,   156,   200,   157,   178,
-     178,   178,   204,    88,   160,   196,   203,  -124,    20,   212,
-    -124,    30,  -124,  -124,   162,   199,  -124,    35,  -124,  -124,
-    -124,  -124,   213,  -124,  -124,  -124,  -124,   170,   170,   170,
-     168,   207,  -124,  -124,   -30,  -124,    88,    94,  -124,  -124,
-    -124,  -124,    43,    88,   178,   207,  -124,  -124,   175,    43,
-    -124,    24,  -124,  -124,   176,  -124,  -124,  -124,    61,    43,
-     225,    25,   201,   178,    43,  -124,  -124,  -124,   202,   227,
-      88,   141,  -124,   184,   186,   179,  -124,  -124,   183,    43,
-    -124,   187,   193,   178,    20,   178,  -124,   192,  -124,  -124,
-    -124,  -124,    96,   170,  -124,    98,  -124,    79,   197,   205,
-      88,  -124,  -124,    43,   206,  -124,    43,  -124,  -124,  -124,
-    -124,   242,   155,  -124,  -124,   163,   209,   210,   215,   211,
-    -124,  -124,  -124,  -124,  -124,  -124,   214,  -124,   216,   217,
-     219,   220,   244,   245,    14,   246,  -124,    14,   247,   248,
-     249,   178,   178,   221,   178,   222,   178,   178,   178,   223,
-     224,   250,   226,   251,   228,   229,   230,   233,   234,   178,
-     235,   178,   236,  -124,   237,  -124,   238,  -124,   259,   243,
-     239,    94,   240,   104,  -124,    47,  -124,   125,  -124,   252,
-     135,   253,   137,   255,   256,   258,  -124,  -124,   260,  -124,
-     261,   231,  -124,   263,  -124,   264,   241,  -124,   266,  -124,
-     267,   254,  -124,  -124,  -124,  -124,     3,  -124,    80,  -124,
-     271,  -124,   104,  -124,   272,  -124,    47,  -124,   273,  -124,
-     125,  -124,   207,  -124,   268,   269,   270,  -124,   274,   275,
-    -124,   276,  -124,   277,  -124,   278,  -124,  -124,     3,  -124,
-     289,  -124,    80,  -124,  -124,  -124,  -124,  -124,   279,  -124,
-    -124
+     -15,    48,    58,    37,   -15,    29,    24,  -123,    65,    91,
+      43,    55,  -123,    82,   113,   106,    37,    76,    75,    81,
+    -123,    12,   126,  -123,  -123,   103,   128,    85,    86,    90,
+     136,   138,    57,  -123,    89,    97,  -123,   109,   106,   148,
+     120,   124,  -123,   154,  -123,    94,   121,  -123,  -123,   130,
+     123,   132,  -123,   129,  -123,  -123,  -123,    57,  -123,  -123,
+     137,   140,   168,   180,   182,   174,   176,   142,  -123,   191,
+    -123,   176,   149,   150,    27,  -123,  -123,   176,  -123,    10,
+      57,  -123,    12,  -123,   189,   158,   196,   145,   198,   155,
+     176,   176,   176,   202,    83,   156,   197,   207,  -123,    73,
+    -123,  -123,   147,   211,  -123,   161,   200,  -123,   -24,  -123,
+    -123,  -123,  -123,   210,  -123,  -123,  -123,  -123,   165,   165,
+     165,   171,   203,  -123,  -123,     5,  -123,    83,   113,  -123,
+    -123,  -123,  -123,   173,    83,   176,  -123,  -123,  -123,    41,
+     203,  -123,  -123,   175,   173,  -123,    19,  -123,  -123,   172,
+     173,   226,    10,   199,   176,   173,  -123,  -123,  -123,   201,
+     230,    83,   152,  -123,   184,   186,   179,  -123,  -123,   183,
+    -123,   188,  -123,   173,  -123,   190,   194,   176,   147,   176,
+    -123,  -123,  -123,    38,   165,  -123,    88,  -123,    49,   193,
+     195,    83,  -123,  -123,   173,   243,   204,  -123,   173,  -123,
+    -123,  -123,  -123,    94,  -123,  -123,   162,   205,   208,   216,
+     209,  -123,  -123,  -123,  -123,   213,  -123,  -123,  -123,   218,
+     212,   217,   219,   244,   245,    57,   246,  -123,    57,   247,
+     248,   249,   176,   176,   220,   176,   221,   176,   176,   176,
+     222,   223,   252,   224,   255,   225,   227,   228,   215,   231,
+     176,   232,   176,   233,  -123,   234,  -123,   235,  -123,   258,
+     259,   236,   113,   237,    56,  -123,    28,  -123,   114,  -123,
+     239,   137,   240,   140,   242,   250,   253,  -123,  -123,   254,
+    -123,   251,   238,  -123,   256,  -123,   257,   261,  -123,   260,
+    -123,   262,   263,  -123,  -123,  -123,  -123,     8,  -123,    25,
+    -123,   270,  -123,    56,  -123,   271,  -123,    28,  -123,   272,
+    -123,   114,  -123,   203,  -123,   264,   266,   267,  -123,   265,
+     273,  -123,   268,  -123,   269,  -123,   274,  -123,  -123,     8,
+    -123,   277,  -123,    25,  -123,  -123,  -123,  -123,  -123,   275,
+    -123,  -123
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -1083,64 +1324,64 @@ static const yytype_int16 yypact[] =
 static const yytype_uint8 yydefact[] =
 {
        3,     0,     0,     7,     4,     0,     0,     1,     0,     0,
-       0,     0,    95,     0,   104,    11,     8,     0,     0,     0,
-       5,    16,     0,    98,   100,     0,   104,     0,     0,     0,
-       0,     0,     0,   106,     0,    55,     0,     0,    12,     0,
-       0,     9,     0,     6,     0,     0,    27,    28,     0,     0,
-      55,    18,     0,    24,    25,    97,     0,   110,   114,    55,
-      55,     0,     0,     0,     0,   141,     0,    96,    56,   105,
-     141,   141,     0,     0,    13,    10,   141,    23,     0,     0,
-      15,    56,    17,     0,     0,    56,     0,    56,     0,   141,
-     141,   141,     0,     0,     0,   142,     0,   107,     0,     0,
-      91,     0,     2,    14,     0,     0,    31,     0,    29,    26,
-      19,    20,     0,   111,    99,   115,   101,   124,   124,   124,
-       0,   154,   153,   155,   157,   159,   149,   104,   156,   143,
-     146,   151,     0,     0,   141,   127,   126,   128,   130,   132,
-     129,     0,   120,   122,     0,   140,   139,    93,     0,     0,
-       0,     0,     0,   141,     0,    33,    34,    35,     0,     0,
-       0,     0,   147,   150,     0,     0,    38,   144,     0,     0,
-     134,     0,    55,   141,     0,   141,   136,   137,    94,    37,
-      32,    30,     0,   124,   125,     0,   103,     0,   157,     0,
-       0,   152,   102,     0,     0,   123,    56,   133,    90,   121,
-      92,     0,     0,    21,    36,     0,     0,     0,     0,     0,
-     145,   158,   148,    39,   131,   135,     0,    22,     0,     0,
-       0,     0,     0,     0,     0,     0,   138,     0,     0,     0,
-       0,   141,   141,     0,   141,     0,   141,   141,   141,     0,
-       0,     0,     0,     0,    82,    84,    86,     0,     0,   141,
-       0,   141,     0,    40,     0,    41,     0,    42,   108,   112,
-       0,   104,    88,    51,    83,    69,    85,    61,    87,     0,
-      55,     0,    55,     0,     0,     0,    43,    48,    49,    53,
-       0,    55,    66,    67,    71,     0,    55,    58,    59,    63,
-       0,    55,    45,   109,    46,   113,   116,    44,    77,    89,
-       0,    57,    56,    52,     0,    73,    56,    70,     0,    65,
-      56,    62,     0,   118,     0,    55,    75,    79,     0,    55,
-      74,     0,    54,     0,    72,     0,    64,    47,    56,   117,
-       0,    81,    56,    78,    50,    68,    60,   119,     0,    80,
-      76
+       0,     0,    96,     0,   105,    11,     8,     0,     0,     0,
+       5,    16,     0,    99,   101,     0,   105,     0,     0,     0,
+       0,     0,     0,   107,     0,    55,    90,     0,    12,     0,
+       0,     0,     9,     0,     6,     0,     0,    27,    28,     0,
+       0,    55,    18,     0,    24,    25,    98,     0,   111,   115,
+      55,    55,     0,     0,     0,     0,   142,     0,    97,    56,
+     106,   142,     0,     0,   142,    13,    10,   142,    23,     0,
+       0,    15,    56,    17,     0,     0,    56,     0,    56,     0,
+     142,   142,   142,     0,     0,     0,   143,     0,   108,     0,
+       2,    14,     0,     0,    92,     0,     0,    31,     0,    29,
+      26,    19,    20,     0,   112,   100,   116,   102,   125,   125,
+     125,     0,   155,   154,   156,   158,   160,   150,   105,   157,
+     144,   147,   152,     0,     0,   142,   141,   140,    94,     0,
+     128,   127,   129,   131,   133,   130,     0,   121,   123,     0,
+       0,     0,     0,     0,   142,     0,    33,    34,    35,     0,
+       0,     0,     0,   148,   151,     0,     0,    38,   145,     0,
+     137,   138,    95,     0,   135,     0,    55,   142,     0,   142,
+      37,    32,    30,     0,   125,   126,     0,   104,     0,   158,
+       0,     0,   153,   103,     0,     0,     0,   124,    56,   134,
+      91,   122,    93,     0,    21,    36,     0,     0,     0,     0,
+       0,   146,   159,   149,    39,     0,   132,   136,    22,     0,
+       0,     0,     0,     0,     0,     0,     0,   139,     0,     0,
+       0,     0,   142,   142,     0,   142,     0,   142,   142,   142,
+       0,     0,     0,     0,     0,    82,    84,    86,     0,     0,
+     142,     0,   142,     0,    40,     0,    41,     0,    42,   109,
+     113,     0,   105,    88,    51,    83,    69,    85,    61,    87,
+       0,    55,     0,    55,     0,     0,     0,    43,    48,    49,
+      53,     0,    55,    66,    67,    71,     0,    55,    58,    59,
+      63,     0,    55,    45,   110,    46,   114,   117,    44,    77,
+      89,     0,    57,    56,    52,     0,    73,    56,    70,     0,
+      65,    56,    62,     0,   119,     0,    55,    75,    79,     0,
+      55,    74,     0,    54,     0,    72,     0,    64,    47,    56,
+     118,     0,    81,    56,    78,    50,    68,    60,   120,     0,
+      80,    76
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-    -124,  -124,  -124,  -124,  -124,  -124,  -124,  -124,   262,  -124,
-    -124,   218,  -124,   -43,  -124,   128,   280,   -38,  -124,  -124,
-     -50,  -124,   -15,  -124,  -124,  -124,    -9,  -124,  -124,  -124,
-     -34,  -124,  -124,  -124,  -124,  -124,  -124,  -124,   265,  -124,
-      -1,    95,    97,   -90,  -123,  -124,  -124,    50,  -124,    42,
-    -124,  -124,  -124,   139,  -107,  -112,  -124,  -124,  -124,  -124,
-     -57,  -124,   -88,   164,  -124,  -124,   150
+    -123,  -123,  -123,  -123,  -123,  -123,  -123,  -123,   285,  -123,
+    -123,   214,  -123,   -41,  -123,   143,   281,    -5,  -123,  -123,
+     -51,  -123,   -12,  -123,  -123,  -123,    -7,  -123,  -123,  -123,
+     -32,  -123,  -123,  -123,  -123,  -123,  -123,  -123,  -123,   276,
+    -123,    -2,    96,   101,   -91,  -122,  -123,  -123,    50,  -123,
+      60,  -123,  -123,  -123,   146,  -102,  -117,  -123,  -123,  -123,
+    -123,   -69,  -123,   -82,   164,  -123,  -123,   167
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int16 yydefgoto[] =
 {
-       0,     2,     3,     4,    15,    16,    37,    38,     5,    49,
-      50,    51,    52,    53,   107,   108,    17,   279,   280,   281,
-      69,   264,   289,   290,   291,   268,   284,   285,   286,   266,
-     317,   318,   319,   299,   253,   255,   257,   276,    39,    72,
-      54,    28,    29,   140,    34,    35,   269,    59,   271,    60,
-     314,   315,   141,   142,   155,   143,   171,   172,   178,   148,
-      94,    95,   162,   163,   164,   130,   131
+       0,     2,     3,     4,    15,    16,    37,    38,     5,    50,
+      51,    52,    53,    54,   108,   109,    17,   280,   281,   282,
+      70,   265,   290,   291,   292,   269,   285,   286,   287,   267,
+     318,   319,   320,   300,   254,   256,   258,   277,    39,    40,
+      72,    55,    28,    29,   145,    34,    35,   270,    60,   272,
+      61,   315,   316,   146,   147,   156,   148,   175,   176,   172,
+     139,    95,    96,   163,   164,   165,   131,   132
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -1148,78 +1389,76 @@ static const yytype_int16 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int16 yytable[] =
 {
-      82,    77,    18,   128,   165,   129,   312,     1,    27,    86,
-      88,   156,   157,   100,   101,    18,     6,     8,   160,   104,
-     166,     7,   161,   135,   136,   137,   138,   170,   105,    20,
-       8,    66,   117,   118,   119,    44,   128,   179,    21,    45,
-      46,    12,   184,   128,    22,   167,   135,   136,   137,   138,
-      47,   282,   106,   283,    12,    84,     8,   194,   127,   145,
-     146,     9,   147,    48,   176,    10,    11,   177,    30,    14,
-     128,   128,   139,   173,   174,   127,   204,   168,   109,    31,
-      12,   213,    14,   312,   215,   151,   316,    93,   152,    13,
-      32,   121,   122,   123,   124,   125,   183,    33,   127,     8,
-     128,     8,   212,    36,   202,    41,   205,   277,    14,    46,
-     278,   206,    33,    57,    58,    42,   198,     8,   200,    47,
-      98,   207,   197,    12,    99,    12,    55,    23,   210,   190,
-     287,   288,    48,    43,   208,   127,    56,    24,   274,   203,
-     126,    12,    61,   127,   121,   122,   123,   188,   125,    64,
-      25,    14,    62,    14,    63,    65,    67,    68,     8,   217,
-      70,    71,    74,    75,    76,    78,     8,    79,    46,    26,
-      80,    83,    89,    90,   239,   240,    23,   242,    47,   244,
-     245,   246,    12,    81,   209,    85,    24,    87,    91,    92,
-      12,    48,   260,    93,   262,    96,   127,    97,   102,   218,
-     103,   111,   113,   112,   219,   115,   313,   120,   320,   134,
-      14,   133,   114,   116,   132,   144,   149,   150,    26,   153,
-     293,   158,   295,   233,   154,   159,   235,   169,   180,   175,
-     186,   303,   182,   185,   190,   192,   307,   193,   337,   191,
-     195,   311,   320,   196,   201,   216,   224,   227,    58,   161,
-     231,   232,   234,   236,   237,   238,   249,   251,   211,   214,
-     222,   223,   225,    57,   322,   329,    19,   226,   228,   333,
-     229,   230,   241,   243,   321,   323,   325,   247,   248,   181,
-     250,   302,   252,   254,   256,   258,   259,   261,   263,   265,
-     267,   306,   338,   273,   275,   326,    40,   324,   339,   110,
-     220,   272,   221,    73,   310,   292,   294,   296,   270,   297,
-     298,   189,   300,   199,   301,   304,     0,   305,   308,   328,
-     309,   327,   330,     0,   187,   332,     0,   331,     0,   334,
-     335,   336,   340
+      83,    18,    99,   129,    78,   104,   166,    27,   105,    87,
+      89,   313,   130,   106,    18,     8,   167,   157,   158,     1,
+      45,   118,   119,   120,    46,    47,   152,   174,   313,   153,
+      67,   317,   283,   180,   284,    48,   129,   107,   185,    12,
+       8,     8,    94,   129,   170,     9,   203,   171,    49,    10,
+      11,    47,   168,   161,     6,    85,   196,   162,     7,   278,
+       8,    48,   279,   128,    12,    12,   169,    14,   177,   178,
+     129,   129,    21,    13,    49,   102,    20,   214,   110,   103,
+     128,   217,   205,    22,    12,   184,   122,   123,   124,   125,
+     126,     8,    14,    14,     8,    30,   206,     8,   211,   191,
+     129,   207,   136,   137,    23,   138,    31,    47,   200,   213,
+     202,   208,    14,    32,    24,    12,    33,    48,    12,   288,
+     289,    12,    36,    42,   209,   199,    43,    25,    44,    56,
+      49,    33,    58,    59,    57,   127,    62,    63,   128,    65,
+     275,    64,   204,    14,    66,    68,    26,    69,    71,    14,
+     140,   141,   142,   143,    74,   122,   123,   124,   189,   126,
+      77,    80,   218,   240,   241,     8,   243,    75,   245,   246,
+     247,    76,    81,    79,    90,    23,   140,   141,   142,   143,
+      84,   261,    82,   263,   210,    24,    91,    86,    92,    12,
+      88,    94,    93,    97,    98,   112,   100,   101,   219,   144,
+     114,   115,   128,   116,   220,   121,   314,   128,   321,   113,
+     133,   117,   134,   135,   149,   150,   154,    26,   151,   155,
+     294,   160,   296,   234,   159,   179,   236,   173,   128,   181,
+     183,   304,   186,   187,   191,   193,   308,   194,   338,   192,
+     195,   312,   321,   197,   198,   162,   215,   225,   212,   228,
+     232,   233,   235,   237,   238,   239,   223,   216,   250,   224,
+     226,   252,    58,   229,    59,   330,   227,   259,   230,   334,
+     231,   242,   244,   322,   324,   326,   248,   249,   251,   253,
+     339,   255,   257,   260,   262,   264,   266,   268,   303,    19,
+     274,   276,   293,   295,   297,   182,   111,    41,   323,   327,
+     325,   340,   221,   298,   302,   299,   301,   222,   305,   271,
+     306,   307,   309,   311,    73,   310,   329,   328,   332,   331,
+     273,   335,   336,   333,   201,   188,     0,   337,   341,   190
 };
 
 static const yytype_int16 yycheck[] =
 {
-      50,    44,     3,    93,   127,    93,     3,    34,     9,    59,
-      60,   118,   119,    70,    71,    16,     6,     3,    48,    76,
-     132,     0,    52,     3,     4,     5,     6,   139,     3,    47,
-       3,    32,    89,    90,    91,     8,   126,   149,    48,    12,
-      13,    27,   154,   133,    18,   133,     3,     4,     5,     6,
-      23,     4,    27,     6,    27,    56,     3,   169,    55,    29,
-      30,     8,    32,    36,     3,    12,    13,     6,    52,    55,
-     160,   161,    52,    49,    50,    55,   183,   134,    79,    51,
-      27,   193,    55,     3,   196,    50,     6,    15,    53,    36,
-      31,     3,     4,     5,     6,     7,   153,     3,    55,     3,
-     190,     3,   190,    16,     8,    47,     8,     3,    55,    13,
-       6,    13,     3,     4,     5,    51,   173,     3,   175,    23,
-      48,    23,   172,    27,    52,    27,     3,    13,    49,    50,
-       5,     6,    36,    47,    36,    55,    31,    23,   261,   182,
-      52,    27,    51,    55,     3,     4,     5,     6,     7,     3,
-      36,    55,    51,    55,    51,     6,    56,    50,     3,   202,
-       6,    39,    47,    47,     6,    52,     3,    31,    13,    55,
-      49,    51,     6,     6,   231,   232,    13,   234,    23,   236,
-     237,   238,    27,    50,   185,    50,    23,    50,     6,    18,
-      27,    36,   249,    15,   251,    51,    55,     3,    47,    36,
-      47,     6,     4,    51,   205,     5,   296,     3,   298,     6,
-      55,    15,    56,    56,    54,     3,    54,    18,    55,     6,
-     270,    53,   272,   224,    54,    18,   227,    52,     3,    53,
-       3,   281,    31,    31,    50,    56,   286,    54,   328,    53,
-      53,   291,   332,    50,    52,     3,    31,    31,     5,    52,
-       6,     6,     6,     6,     6,     6,     6,     6,    53,    53,
-      51,    51,    51,     4,   302,   315,     4,    53,    51,   319,
-      51,    51,    51,    51,     3,     3,     3,    54,    54,   151,
-      54,    50,    54,    54,    54,    52,    52,    52,    52,    52,
-      52,    50,     3,    54,    54,   310,    16,   306,   332,    81,
-     205,   259,   205,    38,    50,    53,    53,    52,   258,    53,
-      52,   161,    52,   174,    53,    52,    -1,    53,    52,    50,
-      53,    53,    52,    -1,   160,    50,    -1,    53,    -1,    53,
-      53,    53,    53
+      51,     3,    71,    94,    45,    74,   128,     9,    77,    60,
+      61,     3,    94,     3,    16,     3,   133,   119,   120,    34,
+       8,    90,    91,    92,    12,    13,    50,   144,     3,    53,
+      32,     6,     4,   150,     6,    23,   127,    27,   155,    27,
+       3,     3,    15,   134,     3,     8,     8,     6,    36,    12,
+      13,    13,   134,    48,     6,    57,   173,    52,     0,     3,
+       3,    23,     6,    55,    27,    27,   135,    55,    49,    50,
+     161,   162,    48,    36,    36,    48,    47,   194,    80,    52,
+      55,   198,   184,    18,    27,   154,     3,     4,     5,     6,
+       7,     3,    55,    55,     3,    52,     8,     3,    49,    50,
+     191,    13,    29,    30,    13,    32,    51,    13,   177,   191,
+     179,    23,    55,    31,    23,    27,     3,    23,    27,     5,
+       6,    27,    16,    47,    36,   176,    51,    36,    47,     3,
+      36,     3,     4,     5,    31,    52,    51,    51,    55,     3,
+     262,    51,   183,    55,     6,    56,    55,    50,    39,    55,
+       3,     4,     5,     6,     6,     3,     4,     5,     6,     7,
+       6,    31,   203,   232,   233,     3,   235,    47,   237,   238,
+     239,    47,    49,    52,     6,    13,     3,     4,     5,     6,
+      51,   250,    50,   252,   186,    23,     6,    50,     6,    27,
+      50,    15,    18,    51,     3,     6,    47,    47,    36,    52,
+       4,    56,    55,     5,   206,     3,   297,    55,   299,    51,
+      54,    56,    15,     6,     3,    54,     6,    55,    18,    54,
+     271,    18,   273,   225,    53,    53,   228,    52,    55,     3,
+      31,   282,    31,     3,    50,    56,   287,    54,   329,    53,
+      52,   292,   333,    53,    50,    52,     3,    31,    53,    31,
+       6,     6,     6,     6,     6,     6,    51,    53,     6,    51,
+      51,     6,     4,    51,     5,   316,    53,    52,    51,   320,
+      51,    51,    51,     3,     3,     3,    54,    54,    54,    54,
+       3,    54,    54,    52,    52,    52,    52,    52,    50,     4,
+      54,    54,    53,    53,    52,   152,    82,    16,   303,   311,
+     307,   333,   206,    53,    53,    52,    52,   206,    52,   259,
+      53,    50,    52,    50,    38,    53,    50,    53,    53,    52,
+     260,    53,    53,    50,   178,   161,    -1,    53,    53,   162
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
@@ -1227,40 +1466,40 @@ static const yytype_int16 yycheck[] =
 static const yytype_int8 yystos[] =
 {
        0,    34,    58,    59,    60,    65,     6,     0,     3,     8,
-      12,    13,    27,    36,    55,    61,    62,    73,    97,    65,
-      47,    48,    18,    13,    23,    36,    55,    97,    98,    99,
-      52,    51,    31,     3,   101,   102,    16,    63,    64,    95,
-      73,    47,    51,    47,     8,    12,    13,    23,    36,    66,
-      67,    68,    69,    70,    97,     3,    31,     4,     5,   104,
-     106,    51,    51,    51,     3,     6,    97,    56,    50,    77,
-       6,    39,    96,    95,    47,    47,     6,    70,    52,    31,
-      49,    50,    77,    51,    97,    50,    77,    50,    77,     6,
-       6,     6,    18,    15,   117,   118,    51,     3,    48,    52,
-     117,   117,    47,    47,   117,     3,    27,    71,    72,    97,
-      68,     6,    51,     4,    56,     5,    56,   117,   117,   117,
-       3,     3,     4,     5,     6,     7,    52,    55,   100,   119,
-     122,   123,    54,    15,     6,     3,     4,     5,     6,    52,
-     100,   109,   110,   112,     3,    29,    30,    32,   116,    54,
-      18,    50,    53,     6,    54,   111,   111,   111,    53,    18,
-      48,    52,   119,   120,   121,   101,   112,   119,   117,    52,
-     112,   113,   114,    49,    50,    53,     3,     6,   115,   112,
-       3,    72,    31,   117,   112,    31,     3,   120,     6,   123,
-      50,    53,    56,    54,   112,    53,    50,    77,   117,   110,
-     117,    52,     8,    70,   111,     8,    13,    23,    36,    97,
-      49,    53,   119,   112,    53,   112,     3,    70,    36,    97,
-      98,    99,    51,    51,    31,    51,    53,    31,    51,    51,
-      51,     6,     6,    97,     6,    97,     6,     6,     6,   117,
-     117,    51,   117,    51,   117,   117,   117,    54,    54,     6,
-      54,     6,    54,    91,    54,    92,    54,    93,    52,    52,
-     117,    52,   117,    52,    78,    52,    86,    52,    82,   103,
-     104,   105,   106,    54,   101,    54,    94,     3,     6,    74,
-      75,    76,     4,     6,    83,    84,    85,     5,     6,    79,
-      80,    81,    53,    77,    53,    77,    52,    53,    52,    90,
-      52,    53,    50,    77,    52,    53,    50,    77,    52,    53,
-      50,    77,     3,   100,   107,   108,     6,    87,    88,    89,
-     100,     3,    74,     3,    83,     3,    79,    53,    50,    77,
-      52,    53,    50,    77,    53,    53,    53,   100,     3,    87,
-      53
+      12,    13,    27,    36,    55,    61,    62,    73,    98,    65,
+      47,    48,    18,    13,    23,    36,    55,    98,    99,   100,
+      52,    51,    31,     3,   102,   103,    16,    63,    64,    95,
+      96,    73,    47,    51,    47,     8,    12,    13,    23,    36,
+      66,    67,    68,    69,    70,    98,     3,    31,     4,     5,
+     105,   107,    51,    51,    51,     3,     6,    98,    56,    50,
+      77,    39,    97,    96,     6,    47,    47,     6,    70,    52,
+      31,    49,    50,    77,    51,    98,    50,    77,    50,    77,
+       6,     6,     6,    18,    15,   118,   119,    51,     3,   118,
+      47,    47,    48,    52,   118,   118,     3,    27,    71,    72,
+      98,    68,     6,    51,     4,    56,     5,    56,   118,   118,
+     118,     3,     3,     4,     5,     6,     7,    52,    55,   101,
+     120,   123,   124,    54,    15,     6,    29,    30,    32,   117,
+       3,     4,     5,     6,    52,   101,   110,   111,   113,     3,
+      54,    18,    50,    53,     6,    54,   112,   112,   112,    53,
+      18,    48,    52,   120,   121,   122,   102,   113,   120,   118,
+       3,     6,   116,    52,   113,   114,   115,    49,    50,    53,
+     113,     3,    72,    31,   118,   113,    31,     3,   121,     6,
+     124,    50,    53,    56,    54,    52,   113,    53,    50,    77,
+     118,   111,   118,     8,    70,   112,     8,    13,    23,    36,
+      98,    49,    53,   120,   113,     3,    53,   113,    70,    36,
+      98,    99,   100,    51,    51,    31,    51,    53,    31,    51,
+      51,    51,     6,     6,    98,     6,    98,     6,     6,     6,
+     118,   118,    51,   118,    51,   118,   118,   118,    54,    54,
+       6,    54,     6,    54,    91,    54,    92,    54,    93,    52,
+      52,   118,    52,   118,    52,    78,    52,    86,    52,    82,
+     104,   105,   106,   107,    54,   102,    54,    94,     3,     6,
+      74,    75,    76,     4,     6,    83,    84,    85,     5,     6,
+      79,    80,    81,    53,    77,    53,    77,    52,    53,    52,
+      90,    52,    53,    50,    77,    52,    53,    50,    77,    52,
+      53,    50,    77,     3,   101,   108,   109,     6,    87,    88,
+      89,   101,     3,    74,     3,    83,     3,    79,    53,    50,
+      77,    52,    53,    50,    77,    53,    53,    53,   101,     3,
+      87,    53
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
@@ -1275,13 +1514,14 @@ static const yytype_int8 yyr1[] =
       79,    80,    80,    81,    81,    82,    83,    83,    83,    84,
       84,    85,    85,    86,    87,    87,    87,    88,    88,    89,
       89,    90,    91,    91,    92,    92,    93,    93,    94,    94,
-      95,    95,    95,    96,    96,    97,    97,    97,    98,    98,
-      99,    99,   100,   100,   101,   101,   102,   102,   103,   103,
-     104,   104,   105,   105,   106,   106,   107,   107,   108,   108,
-     109,   109,   110,   110,   111,   111,   112,   112,   112,   112,
-     112,   112,   113,   113,   114,   114,   115,   115,   115,   116,
-     116,   117,   117,   118,   118,   119,   119,   120,   120,   121,
-     121,   122,   122,   123,   123,   123,   123,   123,   123,   123
+      95,    96,    96,    96,    97,    97,    98,    98,    98,    99,
+      99,   100,   100,   101,   101,   102,   102,   103,   103,   104,
+     104,   105,   105,   106,   106,   107,   107,   108,   108,   109,
+     109,   110,   110,   111,   111,   112,   112,   113,   113,   113,
+     113,   113,   113,   114,   114,   115,   115,   116,   116,   116,
+     117,   117,   118,   118,   119,   119,   120,   120,   121,   121,
+     122,   122,   123,   123,   124,   124,   124,   124,   124,   124,
+     124
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
@@ -1296,13 +1536,14 @@ static const yytype_int8 yyr2[] =
        4,     0,     2,     1,     3,     3,     1,     1,     4,     0,
        2,     1,     3,     3,     1,     1,     4,     0,     2,     1,
        3,     3,     0,     2,     0,     2,     0,     2,     0,     2,
-       6,     3,     6,     3,     4,     1,     3,     3,     1,     4,
-       1,     4,     3,     3,     0,     2,     1,     3,     0,     2,
-       1,     3,     0,     2,     1,     3,     0,     2,     1,     3,
-       1,     3,     1,     3,     0,     2,     1,     1,     1,     1,
-       1,     4,     0,     2,     1,     3,     1,     1,     4,     1,
-       1,     0,     1,     2,     3,     4,     1,     1,     3,     0,
-       1,     1,     3,     1,     1,     1,     1,     1,     4,     1
+       1,     6,     3,     6,     3,     4,     1,     3,     3,     1,
+       4,     1,     4,     3,     3,     0,     2,     1,     3,     0,
+       2,     1,     3,     0,     2,     1,     3,     0,     2,     1,
+       3,     1,     3,     1,     3,     0,     2,     1,     1,     1,
+       1,     1,     4,     0,     2,     1,     3,     1,     1,     4,
+       1,     1,     0,     1,     2,     3,     4,     1,     1,     3,
+       0,     1,     1,     3,     1,     1,     1,     1,     1,     4,
+       1
 };
 
 
@@ -2046,7 +2287,8 @@ yyreduce:
   case 7: /* vardecl_items: %empty  */
         {
 #if !EXPOSE_INT_LITS
-            initfg(static_cast<ParserState*>(parm));
+            if (!static_cast<ParserState*>(parm)->presolving)
+                initfg(static_cast<ParserState*>(parm));
 #endif
         }
     break;
@@ -2054,7 +2296,8 @@ yyreduce:
   case 8: /* vardecl_items: vardecl_items_head  */
         {
 #if !EXPOSE_INT_LITS
-            initfg(static_cast<ParserState*>(parm));
+            if (!static_cast<ParserState*>(parm)->presolving)
+                initfg(static_cast<ParserState*>(parm));
 #endif
         }
     break;
@@ -2063,6 +2306,9 @@ yyreduce:
         {
 #if EXPOSE_INT_LITS
             initfg(static_cast<ParserState*>(parm));
+#else
+            if (static_cast<ParserState*>(parm)->presolving)
+                presolveModel(static_cast<ParserState*>(parm));
 #endif
         }
     break;
@@ -2071,10 +2317,25 @@ yyreduce:
         {
 #if EXPOSE_INT_LITS
             initfg(static_cast<ParserState*>(parm));
+#else
+            if (static_cast<ParserState*>(parm)->presolving)
+                presolveModel(static_cast<ParserState*>(parm));
 #endif
         }
     break;
 
+  case 13: /* constraint_items_head: constraint_item ';'  */
+        {
+            static_cast<ParserState*>(parm)->endConstraint();
+        }
+    break;
+
+  case 14: /* constraint_items_head: constraint_items_head constraint_item ';'  */
+        {
+            static_cast<ParserState*>(parm)->endConstraint();
+        }
+    break;
+
   case 33: /* vardecl_item: VAR int_ti_expr_tail ':' ID annotations non_array_expr_opt  */
         {
             ParserState* pp = static_cast<ParserState*>(parm);
@@ -2490,14 +2751,14 @@ yyreduce:
 
   case 50: /* int_init: ID '[' INT_LIT ']'  */
         { 
-            std::vector<int> v;
+            const std::vector<int>* v;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->intvararrays.get((yyvsp[-3].sValue), v)) {
+            if ((v = pp->intvararrays.find((yyvsp[-3].sValue)))) {
                 yyassert(pp,static_cast<unsigned int>((yyvsp[-1].iValue)) > 0 && 
-                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v.size(),
+                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v->size(),
                                  "array access out of bounds");
                 if (!pp->hadError)
-                    (yyval.varSpec) = new IntVarSpec(Alias(v[(yyvsp[-1].iValue)-1]),false,true,false);
+                    (yyval.varSpec) = new IntVarSpec(Alias((*v)[(yyvsp[-1].iValue)-1]),false,true,false);
                 else
                     (yyval.varSpec) = new IntVarSpec(0,false,true,false); // keep things consistent
             } else {
@@ -2568,14 +2829,14 @@ yyreduce:
 
   case 60: /* float_init: ID '[' INT_LIT ']'  */
         { 
-            std::vector<int> v;
+            const std::vector<int>* v;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->floatvararrays.get((yyvsp[-3].sValue), v)) {
+            if ((v = pp->floatvararrays.find((yyvsp[-3].sValue)))) {
                 yyassert(pp,static_cast<unsigned int>((yyvsp[-1].iValue)) > 0 && 
-                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v.size(),
+                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v->size(),
                                  "array access out of bounds");
                 if (!pp->hadError)
-                    (yyval.varSpec) = new FloatVarSpec(Alias(v[(yyvsp[-1].iValue)-1]),false,true,false);
+                    (yyval.varSpec) = new FloatVarSpec(Alias((*v)[(yyvsp[-1].iValue)-1]),false,true,false);
                 else
                     (yyval.varSpec) = new FloatVarSpec(0.0,false,true,false);
             } else {
@@ -2646,14 +2907,14 @@ yyreduce:
 
   case 68: /* bool_init: ID '[' INT_LIT ']'  */
         { 
-            std::vector<int> v;
+            const std::vector<int>* v;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->boolvararrays.get((yyvsp[-3].sValue), v)) {
+            if ((v = pp->boolvararrays.find((yyvsp[-3].sValue)))) {
                 yyassert(pp,static_cast<unsigned int>((yyvsp[-1].iValue)) > 0 && 
-                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v.size(),
+                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v->size(),
                                  "array access out of bounds");
                 if (!pp->hadError)
-                    (yyval.varSpec) = new BoolVarSpec(Alias(v[(yyvsp[-1].iValue)-1]),false,true,false);
+                    (yyval.varSpec) = new BoolVarSpec(Alias((*v)[(yyvsp[-1].iValue)-1]),false,true,false);
                 else
                     (yyval.varSpec) = new BoolVarSpec(false,false,true,false);
             } else {
@@ -2722,14 +2983,14 @@ yyreduce:
 
   case 76: /* set_init: ID '[' INT_LIT ']'  */
         { 
-            std::vector<int> v;
+            const std::vector<int>* v;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->setvararrays.get((yyvsp[-3].sValue), v)) {
+            if ((v = pp->setvararrays.find((yyvsp[-3].sValue)))) {
                 yyassert(pp,static_cast<unsigned int>((yyvsp[-1].iValue)) > 0 && 
-                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v.size(),
+                                        static_cast<unsigned int>((yyvsp[-1].iValue)) <= v->size(),
                                  "array access out of bounds");
                 if (!pp->hadError)
-                    (yyval.varSpec) = new SetVarSpec(Alias(v[(yyvsp[-1].iValue)-1]),false,true,false);
+                    (yyval.varSpec) = new SetVarSpec(Alias((*v)[(yyvsp[-1].iValue)-1]),false,true,false);
                 else
                     (yyval.varSpec) = new SetVarSpec(Alias(0),false,true,false);
             } else {
@@ -2823,52 +3084,29 @@ yyreduce:
         }
     break;
 
-  case 90: /* constraint_item: CONSTRAINT ID '(' flat_expr_list ')' annotations  */
+  case 90: /* constraint_head: CONSTRAINT  */
+        {
+#if !EXPOSE_INT_LITS
+            // The presolver keeps the nodes of every constraint until all have been read
+            if (!static_cast<ParserState*>(parm)->presolving)
+                AST::Arena::current = &static_cast<ParserState*>(parm)->arena;
+#endif
+        }
+    break;
+
+  case 91: /* constraint_item: constraint_head ID '(' flat_expr_list ')' annotations  */
         { 
             ParserState *pp = static_cast<ParserState*>(parm);
 #if EXPOSE_INT_LITS
             pp->domainConstraints2.push_back(std::pair<ConExpr*, AST::Node*>(new ConExpr((yyvsp[-4].sValue), (yyvsp[-2].argVec)), (yyvsp[0].argVec)));
 #else
-            ConExpr c((yyvsp[-4].sValue), (yyvsp[-2].argVec));
-            if (!pp->hadError) {
-                if (c.id == "chuffed_on_restart_status") {
-                    pp->fg->restart_status = c.args->a[0]->getIntVar();
-                    pp->fg->enable_on_restart = true;
-                } else if (c.id == "chuffed_on_restart_complete") {
-                    mark_complete(pp->fg->bv[c.args->a[0]->getBoolVar()], &pp->fg->mark_complete);
-                    pp->fg->enable_on_restart = true;
-                } else if (c.id == "chuffed_on_restart_uniform_int") {
-                    pp->fg->int_uniform.emplace_back(std::array<int, 3>{ c.args->a[0]->getInt(), c.args->a[1]->getInt(), c.args->a[2]->getIntVar() });
-                    pp->fg->enable_on_restart = true;
-                } else if (c.id == "chuffed_on_restart_last_val_bool") {
-                    pp->last_val_bool.emplace_back(c.args->a[0]->getBoolVar(), c.args->a[1]->getBoolVar());
-                    pp->fg->enable_on_restart = true;
-                } else if (c.id == "chuffed_on_restart_last_val_int") {
-                    pp->last_val_int.emplace_back(c.args->a[0]->getIntVar(), c.args->a[1]->getIntVar());
-                    pp->fg->enable_on_restart = true;
-                } else if (c.id == "chuffed_on_restart_sol_bool") {
-                    pp->fg->bool_sol.emplace_back(std::tuple<int, bool, int>{ c.args->a[0]->getBoolVar(), false, c.args->a[1]->getBoolVar() });
-                    pp->fg->enable_on_restart = true;
-                    pp->fg->enable_store_solution = true;
-                } else if (c.id == "chuffed_on_restart_sol_int") {
-                    pp->fg->int_sol.emplace_back(std::array<int, 3>{ c.args->a[0]->getIntVar(), 0, c.args->a[1]->getIntVar() });
-                    pp->fg->enable_on_restart = true;
-                    pp->fg->enable_store_solution = true;
-                } else {
-                    try {
-                        FlatZinc::FlatZincSpace::postConstraint(c, (yyvsp[0].argVec));
-                    } catch (FlatZinc::Error& e) {
-                        yyerror(pp, e.toString().c_str());
-                    }
-                }
-            }
-            delete (yyvsp[0].argVec);
+            addConstraintItem(pp, new ConExpr((yyvsp[-4].sValue), (yyvsp[-2].argVec)), (yyvsp[0].argVec));
 #endif
             free((yyvsp[-4].sValue));
         }
     break;
 
-  case 91: /* constraint_item: CONSTRAINT ID annotations  */
+  case 92: /* constraint_item: constraint_head ID annotations  */
         {
             ParserState *pp = static_cast<ParserState*>(parm);
             AST::Array* args = new AST::Array(2);
@@ -2877,21 +3115,13 @@ yyreduce:
 #if EXPOSE_INT_LITS
             pp->domainConstraints2.push_back(std::pair<ConExpr*, AST::Node*>(new ConExpr("bool_eq", args), (yyvsp[0].argVec)));
 #else
-            ConExpr c("bool_eq", args);
-            if (!pp->hadError) {
-                try {
-                    FlatZinc::FlatZincSpace::postConstraint(c, (yyvsp[0].argVec));
-                } catch (FlatZinc::Error& e) {
-                    yyerror(pp, e.toString().c_str());
-                }
-            }
-            delete (yyvsp[0].argVec);
+            addConstraintItem(pp, new ConExpr("bool_eq", args), (yyvsp[0].argVec));
 #endif
             free((yyvsp[-1].sValue));
         }
     break;
 
-  case 92: /* constraint_item: CONSTRAINT ID '[' INT_LIT ']' annotations  */
+  case 93: /* constraint_item: constraint_head ID '[' INT_LIT ']' annotations  */
         { 
             ParserState *pp = static_cast<ParserState*>(parm);
             AST::Array* args = new AST::Array(2);
@@ -2900,70 +3130,51 @@ yyreduce:
 #if EXPOSE_INT_LITS
             pp->domainConstraints2.push_back(std::pair<ConExpr*, AST::Node*>(new ConExpr("bool_eq", args), (yyvsp[0].argVec)));
 #else
-            ConExpr c("bool_eq", args);
-            if (!pp->hadError) {
-                try {
-                    FlatZinc::FlatZincSpace::postConstraint(c, (yyvsp[0].argVec));
-                } catch (FlatZinc::Error& e) {
-                    yyerror(pp, e.toString().c_str());
-                }
-            }
-            delete (yyvsp[0].argVec);
+            addConstraintItem(pp, new ConExpr("bool_eq", args), (yyvsp[0].argVec));
 #endif
             free((yyvsp[-4].sValue));
         }
     break;
 
-  case 93: /* solve_item: SOLVE annotations SATISFY  */
+  case 94: /* solve_item: SOLVE annotations SATISFY  */
         { 
-            ParserState *pp = static_cast<ParserState*>(parm);
-            if (!pp->hadError) {
-                pp->fg->solve((yyvsp[-1].argVec));
-            }
-            pp->postOnRestartPropagators();
+            postSolveItem(static_cast<ParserState*>(parm), SS_SATISFY, -1, (yyvsp[-1].argVec));
             delete (yyvsp[-1].argVec);
         }
     break;
 
-  case 94: /* solve_item: SOLVE annotations minmax solve_expr  */
+  case 95: /* solve_item: SOLVE annotations minmax solve_expr  */
         { 
-            ParserState *pp = static_cast<ParserState*>(parm);
-            if (!pp->hadError) {
-                if ((yyvsp[-1].bValue))
-                    pp->fg->minimize((yyvsp[0].iValue),(yyvsp[-2].argVec));
-                else
-                    pp->fg->maximize((yyvsp[0].iValue),(yyvsp[-2].argVec));
-            }
-            pp->postOnRestartPropagators();
+            postSolveItem(static_cast<ParserState*>(parm), (yyvsp[-1].bValue) ? SS_MINIMIZE : SS_MAXIMIZE, (yyvsp[0].iValue), (yyvsp[-2].argVec));
             delete (yyvsp[-2].argVec);
         }
     break;
 
-  case 95: /* int_ti_expr_tail: INTTOK  */
+  case 96: /* int_ti_expr_tail: INTTOK  */
         { 
             (yyval.oSet) = Option<AST::SetLit* >::none(); 
         }
     break;
 
-  case 96: /* int_ti_expr_tail: '{' int_list '}'  */
+  case 97: /* int_ti_expr_tail: '{' int_list '}'  */
         { 
             (yyval.oSet) = Option<AST::SetLit* >::some(new AST::SetLit(*(yyvsp[-1].setValue))); 
         }
     break;
 
-  case 97: /* int_ti_expr_tail: INT_LIT DOTDOT INT_LIT  */
+  case 98: /* int_ti_expr_tail: INT_LIT DOTDOT INT_LIT  */
         { 
             (yyval.oSet) = Option<AST::SetLit* >::some(new AST::SetLit((yyvsp[-2].iValue), (yyvsp[0].iValue)));
         }
     break;
 
-  case 98: /* bool_ti_expr_tail: BOOLTOK  */
+  case 99: /* bool_ti_expr_tail: BOOLTOK  */
         { 
             (yyval.oSet) = Option<AST::SetLit* >::none(); 
         }
     break;
 
-  case 99: /* bool_ti_expr_tail: '{' bool_list_head list_tail '}'  */
+  case 100: /* bool_ti_expr_tail: '{' bool_list_head list_tail '}'  */
         { 
             bool haveTrue = false;
             bool haveFalse = false;
@@ -2977,109 +3188,109 @@ yyreduce:
         }
     break;
 
-  case 102: /* set_literal: '{' int_list '}'  */
+  case 103: /* set_literal: '{' int_list '}'  */
         { 
             (yyval.setLit) = new AST::SetLit(*(yyvsp[-1].setValue)); 
         }
     break;
 
-  case 103: /* set_literal: INT_LIT DOTDOT INT_LIT  */
+  case 104: /* set_literal: INT_LIT DOTDOT INT_LIT  */
         { 
             (yyval.setLit) = new AST::SetLit((yyvsp[-2].iValue), (yyvsp[0].iValue)); 
         }
     break;
 
-  case 104: /* int_list: %empty  */
+  case 105: /* int_list: %empty  */
         { 
             (yyval.setValue) = new std::vector<int>(0); 
         }
     break;
 
-  case 105: /* int_list: int_list_head list_tail  */
+  case 106: /* int_list: int_list_head list_tail  */
         { 
             (yyval.setValue) = (yyvsp[-1].setValue); 
         }
     break;
 
-  case 106: /* int_list_head: INT_LIT  */
+  case 107: /* int_list_head: INT_LIT  */
         { 
             (yyval.setValue) = new std::vector<int>(1); 
             (*(yyval.setValue))[0] = (yyvsp[0].iValue); 
         }
     break;
 
-  case 107: /* int_list_head: int_list_head ',' INT_LIT  */
+  case 108: /* int_list_head: int_list_head ',' INT_LIT  */
         { 
             (yyval.setValue) = (yyvsp[-2].setValue); 
             (yyval.setValue)->push_back((yyvsp[0].iValue)); 
         }
     break;
 
-  case 108: /* bool_list: %empty  */
+  case 109: /* bool_list: %empty  */
         { 
             (yyval.setValue) = new std::vector<int>(0); 
         }
     break;
 
-  case 109: /* bool_list: bool_list_head list_tail  */
+  case 110: /* bool_list: bool_list_head list_tail  */
         { 
             (yyval.setValue) = (yyvsp[-1].setValue); 
         }
     break;
 
-  case 110: /* bool_list_head: BOOL_LIT  */
+  case 111: /* bool_list_head: BOOL_LIT  */
         { 
             (yyval.setValue) = new std::vector<int>(1); 
             (*(yyval.setValue))[0] = (yyvsp[0].iValue); 
         }
     break;
 
-  case 111: /* bool_list_head: bool_list_head ',' BOOL_LIT  */
+  case 112: /* bool_list_head: bool_list_head ',' BOOL_LIT  */
         { 
             (yyval.setValue) = (yyvsp[-2].setValue); 
             (yyval.setValue)->push_back((yyvsp[0].iValue)); 
         }
     break;
 
-  case 112: /* float_list: %empty  */
+  case 113: /* float_list: %empty  */
         { 
             (yyval.floatSetValue) = new std::vector<double>(0); 
         }
     break;
 
-  case 113: /* float_list: float_list_head list_tail  */
+  case 114: /* float_list: float_list_head list_tail  */
         { 
             (yyval.floatSetValue) = (yyvsp[-1].floatSetValue); 
         }
     break;
 
-  case 114: /* float_list_head: FLOAT_LIT  */
+  case 115: /* float_list_head: FLOAT_LIT  */
         {
             (yyval.floatSetValue) = new std::vector<double>(1); 
             (*(yyval.floatSetValue))[0] = (yyvsp[0].dValue); 
         }
     break;
 
-  case 115: /* float_list_head: float_list_head ',' FLOAT_LIT  */
+  case 116: /* float_list_head: float_list_head ',' FLOAT_LIT  */
         { 
             (yyval.floatSetValue) = (yyvsp[-2].floatSetValue); 
             (yyval.floatSetValue)->push_back((yyvsp[0].dValue)); 
         }
     break;
 
-  case 116: /* set_literal_list: %empty  */
+  case 117: /* set_literal_list: %empty  */
         { 
             (yyval.setValueList) = new std::vector<AST::SetLit>(0); 
         }
     break;
 
-  case 117: /* set_literal_list: set_literal_list_head list_tail  */
+  case 118: /* set_literal_list: set_literal_list_head list_tail  */
         { 
             (yyval.setValueList) = (yyvsp[-1].setValueList); 
         }
     break;
 
-  case 118: /* set_literal_list_head: set_literal  */
+  case 119: /* set_literal_list_head: set_literal  */
         { 
             (yyval.setValueList) = new std::vector<AST::SetLit>(1); 
             (*(yyval.setValueList))[0] = *(yyvsp[0].setLit); 
@@ -3087,7 +3298,7 @@ yyreduce:
         }
     break;
 
-  case 119: /* set_literal_list_head: set_literal_list_head ',' set_literal  */
+  case 120: /* set_literal_list_head: set_literal_list_head ',' set_literal  */
         { 
             (yyval.setValueList) = (yyvsp[-2].setValueList); 
             (yyval.setValueList)->push_back(*(yyvsp[0].setLit)); 
@@ -3095,110 +3306,111 @@ yyreduce:
         }
     break;
 
-  case 120: /* flat_expr_list: flat_expr  */
+  case 121: /* flat_expr_list: flat_expr  */
         { 
             (yyval.argVec) = new AST::Array((yyvsp[0].arg)); 
         }
     break;
 
-  case 121: /* flat_expr_list: flat_expr_list ',' flat_expr  */
+  case 122: /* flat_expr_list: flat_expr_list ',' flat_expr  */
         { 
             (yyval.argVec) = (yyvsp[-2].argVec); 
             (yyval.argVec)->append((yyvsp[0].arg)); 
         }
     break;
 
-  case 122: /* flat_expr: non_array_expr  */
+  case 123: /* flat_expr: non_array_expr  */
         { 
             (yyval.arg) = (yyvsp[0].arg); 
         }
     break;
 
-  case 123: /* flat_expr: '[' non_array_expr_list ']'  */
+  case 124: /* flat_expr: '[' non_array_expr_list ']'  */
         { 
             (yyval.arg) = (yyvsp[-1].argVec); 
         }
     break;
 
-  case 124: /* non_array_expr_opt: %empty  */
+  case 125: /* non_array_expr_opt: %empty  */
         { 
             (yyval.oArg) = Option<AST::Node*>::none(); 
         }
     break;
 
-  case 125: /* non_array_expr_opt: '=' non_array_expr  */
+  case 126: /* non_array_expr_opt: '=' non_array_expr  */
         { 
             (yyval.oArg) = Option<AST::Node*>::some((yyvsp[0].arg)); 
         }
     break;
 
-  case 126: /* non_array_expr: BOOL_LIT  */
+  case 127: /* non_array_expr: BOOL_LIT  */
         { 
             (yyval.arg) = new AST::BoolLit((yyvsp[0].iValue)); 
         }
     break;
 
-  case 127: /* non_array_expr: INT_LIT  */
+  case 128: /* non_array_expr: INT_LIT  */
         { 
             (yyval.arg) = new AST::IntLit((yyvsp[0].iValue)); 
         }
     break;
 
-  case 128: /* non_array_expr: FLOAT_LIT  */
+  case 129: /* non_array_expr: FLOAT_LIT  */
         { 
             (yyval.arg) = new AST::FloatLit((yyvsp[0].dValue)); 
         }
     break;
 
-  case 129: /* non_array_expr: set_literal  */
+  case 130: /* non_array_expr: set_literal  */
         { 
             (yyval.arg) = (yyvsp[0].setLit); 
         }
     break;
 
-  case 130: /* non_array_expr: ID  */
+  case 131: /* non_array_expr: ID  */
         { 
-            std::vector<int> as;
+            const std::vector<int>* as;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->intvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::IntVar(as[i]);
+            const int sym = pp->symbols.lookup((yyvsp[0].sValue), strlen((yyvsp[0].sValue)));
+            if ((as = pp->intvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::IntVar((*as)[i]);
                 (yyval.arg) = ia;
-            } else if (pp->boolvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::BoolVar(as[i]);
+            } else if ((as = pp->boolvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::BoolVar((*as)[i]);
                 (yyval.arg) = ia;
-            } else if (pp->setvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::SetVar(as[i]);
+            } else if ((as = pp->setvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::SetVar((*as)[i]);
                 (yyval.arg) = ia;
             } else {
-                std::vector<int> is;
-                std::vector<AST::SetLit> isS;
-                int ival = 0;
-                bool bval = false;
-                if (pp->intvalarrays.get((yyvsp[0].sValue), is)) {
-                    AST::Array *v = new AST::Array(is.size());
-                    for (int i = is.size(); i--;)
-                        v->a[i] = new AST::IntLit(is[i]);
+                const std::vector<int>* is;
+                const std::vector<AST::SetLit>* isS;
+                const int* ival;
+                const bool* bval;
+                if ((is = pp->intvalarrays.find(sym))) {
+                    AST::Array *v = new AST::Array(is->size());
+                    for (int i = is->size(); i--;)
+                        v->a[i] = new AST::IntLit((*is)[i]);
                     (yyval.arg) = v;
-                } else if (pp->boolvalarrays.get((yyvsp[0].sValue), is)) {
-                    AST::Array *v = new AST::Array(is.size());
-                    for (int i = is.size(); i--;)
-                        v->a[i] = new AST::BoolLit(is[i]);
+                } else if ((is = pp->boolvalarrays.find(sym))) {
+                    AST::Array *v = new AST::Array(is->size());
+                    for (int i = is->size(); i--;)
+                        v->a[i] = new AST::BoolLit((*is)[i]);
                     (yyval.arg) = v;
-                } else if (pp->setvalarrays.get((yyvsp[0].sValue), isS)) {
-                    AST::Array *v = new AST::Array(isS.size());
-                    for (int i = isS.size(); i--;)
-                        v->a[i] = new AST::SetLit(isS[i]);
+                } else if ((isS = pp->setvalarrays.find(sym))) {
+                    AST::Array *v = new AST::Array(isS->size());
+                    for (int i = isS->size(); i--;)
+                        v->a[i] = new AST::SetLit((*isS)[i]);
                     (yyval.arg) = v;                      
-                } else if (pp->intvals.get((yyvsp[0].sValue), ival)) {
-                    (yyval.arg) = new AST::IntLit(ival);
-                } else if (pp->boolvals.get((yyvsp[0].sValue), bval)) {
-                    (yyval.arg) = new AST::BoolLit(bval);
+                } else if ((ival = pp->intvals.find(sym))) {
+                    (yyval.arg) = new AST::IntLit(*ival);
+                } else if ((bval = pp->boolvals.find(sym))) {
+                    (yyval.arg) = new AST::BoolLit(*bval);
                 } else {
                     (yyval.arg) = getVarRefArg(pp,(yyvsp[0].sValue));
                 }
@@ -3207,7 +3419,7 @@ yyreduce:
         }
     break;
 
-  case 131: /* non_array_expr: ID '[' non_array_expr ']'  */
+  case 132: /* non_array_expr: ID '[' non_array_expr ']'  */
         { 
             ParserState* pp = static_cast<ParserState*>(parm);
             int i = -1;
@@ -3220,71 +3432,50 @@ yyreduce:
         }
     break;
 
-  case 132: /* non_array_expr_list: %empty  */
+  case 133: /* non_array_expr_list: %empty  */
         { 
             (yyval.argVec) = new AST::Array(0); 
         }
     break;
 
-  case 133: /* non_array_expr_list: non_array_expr_list_head list_tail  */
+  case 134: /* non_array_expr_list: non_array_expr_list_head list_tail  */
         { 
             (yyval.argVec) = (yyvsp[-1].argVec); 
         }
     break;
 
-  case 134: /* non_array_expr_list_head: non_array_expr  */
+  case 135: /* non_array_expr_list_head: non_array_expr  */
         { 
             (yyval.argVec) = new AST::Array((yyvsp[0].arg)); 
         }
     break;
 
-  case 135: /* non_array_expr_list_head: non_array_expr_list_head ',' non_array_expr  */
+  case 136: /* non_array_expr_list_head: non_array_expr_list_head ',' non_array_expr  */
         { 
             (yyval.argVec) = (yyvsp[-2].argVec); 
             (yyval.argVec)->append((yyvsp[0].arg)); 
         }
     break;
 
-  case 136: /* solve_expr: INT_LIT  */
+  case 137: /* solve_expr: INT_LIT  */
         {
             ParserState *pp = static_cast<ParserState*>(parm);
             // Create a new variable in the parser and append at the end
-            const int i = pp->intvars.size();
             const std::string objname = "X_INTRODUCED_CHUFFEDOBJ";
-            pp->intvarTable.put(objname, i);
-            pp->intvars.push_back(varspec(objname,
-                new IntVarSpec((yyvsp[0].iValue),false,true,false)));
-            if (pp->fg != nullptr) {
-                // Add a new IntVar to the FlatZincSpace if it was already created
-                try {
-                    pp->fg->newIntVar(static_cast<IntVarSpec*>(pp->intvars[i].second), pp->intvars[i].first);
-                } catch (FlatZinc::Error& e) {
-                    yyerror(pp, e.toString().c_str());
-                }
-            }
-            (yyval.iValue) = i;
+            pp->intvarTable.put(objname, pp->intvars.size());
+            (yyval.iValue) = addIntVar(pp, objname, new IntVarSpec((yyvsp[0].iValue),false,true,false));
         }
     break;
 
-  case 137: /* solve_expr: ID  */
+  case 138: /* solve_expr: ID  */
         { 
             ParserState *pp = static_cast<ParserState*>(parm);
             int tmp = -1;
             // Check whether the Objective variable is an integer constant
             if (pp->intvals.get((yyvsp[0].sValue), tmp) && !pp->intvarTable.get((yyvsp[0].sValue), (yyval.iValue))) {
                 // Create a new variable in the parser and append at the end
-                const int i = pp->intvars.size();
-                pp->intvarTable.put((yyvsp[0].sValue), i);
-                pp->intvars.push_back(varspec((yyvsp[0].sValue),
-                    new IntVarSpec(tmp,false,true,false)));
-                if (pp->fg != nullptr) {
-                    // Add a new IntVar to the FlatZincSpace if it was already created
-                    try {
-                        pp->fg->newIntVar(static_cast<IntVarSpec*>(pp->intvars[i].second), pp->intvars[i].first);
-                    } catch (FlatZinc::Error& e) {
-                        yyerror(pp, e.toString().c_str());
-                    }
-                }
+                pp->intvarTable.put((yyvsp[0].sValue), pp->intvars.size());
+                addIntVar(pp, (yyvsp[0].sValue), new IntVarSpec(tmp,false,true,false));
             }
             if (!pp->intvarTable.get((yyvsp[0].sValue), (yyval.iValue))) {
                 pp->err << "Error: unknown integer variable " << (yyvsp[0].sValue)
@@ -3296,7 +3487,7 @@ yyreduce:
         }
     break;
 
-  case 138: /* solve_expr: ID '[' INT_LIT ']'  */
+  case 139: /* solve_expr: ID '[' INT_LIT ']'  */
         {
             std::vector<int> tmp;
             ParserState *pp = static_cast<ParserState*>(parm);
@@ -3318,142 +3509,143 @@ yyreduce:
         }
     break;
 
-  case 141: /* annotations: %empty  */
+  case 142: /* annotations: %empty  */
         { 
             (yyval.argVec) = nullptr; 
         }
     break;
 
-  case 142: /* annotations: annotations_head  */
+  case 143: /* annotations: annotations_head  */
         { 
             (yyval.argVec) = (yyvsp[0].argVec); 
         }
     break;
 
-  case 143: /* annotations_head: COLONCOLON annotation  */
+  case 144: /* annotations_head: COLONCOLON annotation  */
         { 
             (yyval.argVec) = new AST::Array((yyvsp[0].arg)); 
         }
     break;
 
-  case 144: /* annotations_head: annotations_head COLONCOLON annotation  */
+  case 145: /* annotations_head: annotations_head COLONCOLON annotation  */
         { 
             (yyval.argVec) = (yyvsp[-2].argVec); 
             (yyval.argVec)->append((yyvsp[0].arg)); 
         }
     break;
 
-  case 145: /* annotation: ID '(' annotation_list ')'  */
+  case 146: /* annotation: ID '(' annotation_list ')'  */
         { 
             (yyval.arg) = new AST::Call((yyvsp[-3].sValue), AST::extractSingleton((yyvsp[-1].arg))); 
             free((yyvsp[-3].sValue));
         }
     break;
 
-  case 146: /* annotation: annotation_expr  */
+  case 147: /* annotation: annotation_expr  */
         { 
             (yyval.arg) = (yyvsp[0].arg); 
         }
     break;
 
-  case 147: /* annotation_list: annotation  */
+  case 148: /* annotation_list: annotation  */
         { 
             (yyval.arg) = new AST::Array((yyvsp[0].arg)); 
         }
     break;
 
-  case 148: /* annotation_list: annotation_list ',' annotation  */
+  case 149: /* annotation_list: annotation_list ',' annotation  */
         { 
             (yyval.arg) = (yyvsp[-2].arg); 
             (yyval.arg)->append((yyvsp[0].arg)); 
         }
     break;
 
-  case 149: /* annotation_olist: %empty  */
+  case 150: /* annotation_olist: %empty  */
         {
             (yyval.arg) = new AST::Array(0);
         }
     break;
 
-  case 150: /* annotation_olist: annotation_list  */
+  case 151: /* annotation_olist: annotation_list  */
         {
             (yyval.arg) = (yyvsp[0].arg);
         }
     break;
 
-  case 151: /* annotation_expr: ann_non_array_expr  */
+  case 152: /* annotation_expr: ann_non_array_expr  */
         { 
             (yyval.arg) = (yyvsp[0].arg); 
         }
     break;
 
-  case 152: /* annotation_expr: '[' annotation_olist ']'  */
+  case 153: /* annotation_expr: '[' annotation_olist ']'  */
         { 
             (yyval.arg) = (yyvsp[-1].arg); 
         }
     break;
 
-  case 153: /* ann_non_array_expr: BOOL_LIT  */
+  case 154: /* ann_non_array_expr: BOOL_LIT  */
         { 
             (yyval.arg) = new AST::BoolLit((yyvsp[0].iValue)); 
         }
     break;
 
-  case 154: /* ann_non_array_expr: INT_LIT  */
+  case 155: /* ann_non_array_expr: INT_LIT  */
         { 
             (yyval.arg) = new AST::IntLit((yyvsp[0].iValue)); 
         }
     break;
 
-  case 155: /* ann_non_array_expr: FLOAT_LIT  */
+  case 156: /* ann_non_array_expr: FLOAT_LIT  */
         { 
             (yyval.arg) = new AST::FloatLit((yyvsp[0].dValue)); 
         }
     break;
 
-  case 156: /* ann_non_array_expr: set_literal  */
+  case 157: /* ann_non_array_expr: set_literal  */
         { 
             (yyval.arg) = (yyvsp[0].setLit); 
         }
     break;
 
-  case 157: /* ann_non_array_expr: ID  */
+  case 158: /* ann_non_array_expr: ID  */
         { 
-            std::vector<int> as;
+            const std::vector<int>* as;
             ParserState* pp = static_cast<ParserState*>(parm);
-            if (pp->intvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::IntVar(as[i]);
+            const int sym = pp->symbols.lookup((yyvsp[0].sValue), strlen((yyvsp[0].sValue)));
+            if ((as = pp->intvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::IntVar((*as)[i]);
                 (yyval.arg) = ia;
-            } else if (pp->boolvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::BoolVar(as[i]);
+            } else if ((as = pp->boolvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::BoolVar((*as)[i]);
                 (yyval.arg) = ia;
-            } else if (pp->setvararrays.get((yyvsp[0].sValue), as)) {
-                AST::Array *ia = new AST::Array(as.size());
-                for (int i = as.size(); i--;)
-                    ia->a[i] = new AST::SetVar(as[i]);
+            } else if ((as = pp->setvararrays.find(sym))) {
+                AST::Array *ia = new AST::Array(as->size());
+                for (int i = as->size(); i--;)
+                    ia->a[i] = new AST::SetVar((*as)[i]);
                 (yyval.arg) = ia;
             } else {
-                std::vector<int> is;
-                int ival = 0;
-                bool bval = false;
-                if (pp->intvalarrays.get((yyvsp[0].sValue), is)) {
-                    AST::Array *v = new AST::Array(is.size());
-                    for (int i = is.size(); i--;)
-                        v->a[i] = new AST::IntLit(is[i]);
+                const std::vector<int>* is;
+                const int* ival;
+                const bool* bval;
+                if ((is = pp->intvalarrays.find(sym))) {
+                    AST::Array *v = new AST::Array(is->size());
+                    for (int i = is->size(); i--;)
+                        v->a[i] = new AST::IntLit((*is)[i]);
                     (yyval.arg) = v;
-                } else if (pp->boolvalarrays.get((yyvsp[0].sValue), is)) {
-                    AST::Array *v = new AST::Array(is.size());
-                    for (int i = is.size(); i--;)
-                        v->a[i] = new AST::BoolLit(is[i]);
+                } else if ((is = pp->boolvalarrays.find(sym))) {
+                    AST::Array *v = new AST::Array(is->size());
+                    for (int i = is->size(); i--;)
+                        v->a[i] = new AST::BoolLit((*is)[i]);
                     (yyval.arg) = v;
-                } else if (pp->intvals.get((yyvsp[0].sValue), ival)) {
-                    (yyval.arg) = new AST::IntLit(ival);
-                } else if (pp->boolvals.get((yyvsp[0].sValue), bval)) {
-                    (yyval.arg) = new AST::BoolLit(bval);
+                } else if ((ival = pp->intvals.find(sym))) {
+                    (yyval.arg) = new AST::IntLit(*ival);
+                } else if ((bval = pp->boolvals.find(sym))) {
+                    (yyval.arg) = new AST::BoolLit(*bval);
                 } else {
                     (yyval.arg) = getVarRefArg(pp,(yyvsp[0].sValue),true);
                 }
@@ -3462,7 +3654,7 @@ yyreduce:
         }
     break;
 
-  case 158: /* ann_non_array_expr: ID '[' ann_non_array_expr ']'  */
+  case 159: /* ann_non_array_expr: ID '[' ann_non_array_expr ']'  */
         { 
             ParserState* pp = static_cast<ParserState*>(parm);
             int i = -1;
@@ -3475,7 +3667,7 @@ yyreduce:
         }
     break;
 
-  case 159: /* ann_non_array_expr: STRING_LIT  */
+  case 160: /* ann_non_array_expr: STRING_LIT  */
         {
             (yyval.arg) = new AST::String((yyvsp[0].sValue));
             free((yyvsp[0].sValue));
@@ -0,0 +1,1523 @@
+#include "chuffed/flatzinc/presolve.h"
+
+#include "chuffed/core/options.h"
+#include "chuffed/flatzinc/ast.h"
+#include "chuffed/flatzinc/flatzinc.h"
+#include "chuffed/support/misc.h"
+#include "chuffed/vars/int-var.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+namespace {
+
+// Rows whose activity could reach this magnitude are left as they are, so no sum can overflow
+const double MAX_ACTIVITY = 1e18;
+
+// Bound propagation stops after visiting this many terms per term in the model
+const int64_t PROPAGATION_BUDGET = 32;
+
+// The constraints posted as graph propagators
+const std::unordered_set<std::string> GRAPH_CONSTRAINTS = {"chuffed_tree",
+																													 "chuffed_connected",
+																													 "chuffed_steiner",
+																													 "chuffed_minimal_spanning_tree",
+																													 "chuffed_dtree",
+																													 "chuffed_dpath",
+																													 "chuffed_bounded_dpath",
+																													 "chuffed_dag"};
+
+int64_t floorDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if (a % b != 0 && ((a < 0) != (b < 0))) {
+		q--;
+	}
+	return q;
+}
+
+int64_t ceilDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if (a % b != 0 && ((a < 0) == (b < 0))) {
+		q++;
+	}
+	return q;
+}
+
+int64_t gcd(int64_t a, int64_t b) {
+	while (b != 0) {
+		const int64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+bool fitsInt(int64_t x) { return x >= INT_MIN && x <= INT_MAX; }
+
+/// Domain of a class of integer variables known to be equal
+struct Dom {
+	int64_t lo;
+	int64_t hi;
+	/// Whether the domain is vals (within lo..hi) rather than all of lo..hi
+	bool sparse{false};
+	std::vector<int> vals;
+	/// Whether the class holds a variable the presolver must leave alone
+	bool frozen{false};
+};
+
+struct Term {
+	int x;
+	int64_t a;
+};
+
+/// The linear constraint sum(a*x) <= rhs (or = rhs) of a constraint item
+struct Row {
+	int item;
+	std::vector<Term> terms;
+	int64_t rhs;
+	bool eq;
+	/// Whether the item is an int_lin_le or int_lin_eq, and so can be replaced by the row
+	bool rewrite;
+	/// Whether the row is small enough to compute with
+	bool safe{true};
+	/// Whether the row no longer matches the arguments of its item
+	bool modified{false};
+	bool dropped{false};
+	bool queued{false};
+};
+
+/// The domain of a variable that is not an alias
+Dom specDom(const IntVarSpec* spec) {
+	Dom d;
+	d.lo = IntVar::min_limit;
+	d.hi = IntVar::max_limit;
+	if (spec->assigned) {
+		d.lo = d.hi = spec->i;
+	} else if (spec->domain()) {
+		const AST::SetLit* sl = spec->domain.some();
+		if (sl->interval) {
+			d.lo = sl->min;
+			d.hi = sl->max;
+		} else {
+			d.sparse = true;
+			d.vals = sl->s;
+			std::sort(d.vals.begin(), d.vals.end());
+			d.vals.erase(std::unique(d.vals.begin(), d.vals.end()), d.vals.end());
+			if (d.vals.empty()) {
+				d.lo = 1;
+				d.hi = 0;
+			} else {
+				d.lo = d.vals.front();
+				d.hi = d.vals.back();
+			}
+		}
+	}
+	return d;
+}
+
+IntVarSpec* copySpec(const IntVarSpec* s) {
+	auto* c = new IntVarSpec(Option<AST::SetLit*>::none(), s->output, s->introduced,
+													 s->looks_introduced);
+	c->alias = s->alias;
+	c->assigned = s->assigned;
+	c->i = s->i;
+	c->view_var = s->view_var;
+	c->view_a = s->view_a;
+	c->view_b = s->view_b;
+	if (!s->alias && !s->assigned && s->domain()) {
+		c->domain = Option<AST::SetLit*>::some(new AST::SetLit(*s->domain.some()));
+	}
+	return c;
+}
+
+BoolVarSpec* copySpec(const BoolVarSpec* s) {
+	Option<AST::SetLit*> none = Option<AST::SetLit*>::none();
+	auto* c = new BoolVarSpec(none, s->output, s->introduced, s->looks_introduced);
+	c->alias = s->alias;
+	c->assigned = s->assigned;
+	c->i = s->i;
+	if (!s->alias && !s->assigned && s->domain()) {
+		c->domain = Option<AST::SetLit*>::some(new AST::SetLit(*s->domain.some()));
+	}
+	return c;
+}
+
+template <class Spec>
+void releaseDomain(Spec* s) {
+	if (!s->alias && !s->assigned && s->domain()) {
+		delete s->domain.some();
+	}
+	s->domain = Option<AST::SetLit*>::none();
+}
+
+/// The parser gives all the elements of an array declared without an initializer the same
+/// specification, owned (and deleted by initfg) by the element whose name does not start with
+/// '['. Give \a vars[i] a specification of its own, and then keep that rule for every group.
+template <class Spec>
+class SpecOwner {
+public:
+	SpecOwner(std::vector<varspec>& _vars) : vars(_vars) {
+		for (auto& v : vars) {
+			uses[v.second]++;
+		}
+	}
+
+	Spec* own(int i) {
+		auto* s = static_cast<Spec*>(vars[i].second);
+		auto it = uses.find(s);
+		if (it->second > 1) {
+			it->second--;
+			s = copySpec(s);
+			uses[s] = 1;
+			vars[i].second = s;
+			changed = true;
+		}
+		return s;
+	}
+
+	void finish() {
+		if (!changed) {
+			return;
+		}
+		std::unordered_map<VarSpec*, size_t> last;
+		for (size_t i = 0; i < vars.size(); i++) {
+			last[vars[i].second] = i;
+		}
+		for (size_t i = 0; i < vars.size(); i++) {
+			std::string& name = vars[i].first;
+			const bool owner = last[vars[i].second] == i;
+			if (owner && !name.empty() && name[0] == '[') {
+				name.erase(0, 1);
+			} else if (!owner && (name.empty() || name[0] != '[')) {
+				name.insert(0, 1, '[');
+			}
+		}
+	}
+
+private:
+	std::vector<varspec>& vars;
+	std::unordered_map<VarSpec*, int> uses;
+	bool changed{false};
+};
+
+class Presolver {
+public:
+	Presolver(ParserState& _pp, std::vector<std::pair<ConExpr*, AST::Node*>>& _items,
+						FlatZincSpace::PresolveStats& _stats)
+			: pp(_pp), items(_items), stats(_stats), dropped(_items.size(), false) {}
+
+	void run() {
+		initVars();
+		for (size_t k = 0; k < items.size() && !infeasible; k++) {
+			scan(k);
+		}
+		if (!infeasible) {
+			for (auto& r : rows) {
+				normalize(r);
+			}
+			propagate();
+		}
+		if (!infeasible) {
+			for (auto& r : rows) {
+				normalize(r);
+			}
+			dropImplied();
+		}
+		if (!infeasible) {
+			tightenCoefficients();
+		}
+		if (!infeasible) {
+			dropDominated();
+		}
+		if (infeasible) {
+			stats.infeasible = true;
+			if (so.verbosity >= 1) {
+				fprintf(stderr, "%% Presolve found the model infeasible, leaving it unchanged\n");
+			}
+			return;
+		}
+		dropDuplicates();
+		apply();
+	}
+
+private:
+	ParserState& pp;
+	std::vector<std::pair<ConExpr*, AST::Node*>>& items;
+	FlatZincSpace::PresolveStats& stats;
+
+	// Classes of equal integer variables, each represented by its smallest index
+	std::vector<int> parent;
+	std::vector<Dom> dom;
+	std::vector<Dom> initial;
+	// Classes of equal Boolean variables, with their value or -1
+	std::vector<int> bparent;
+	std::vector<int> bval;
+	std::vector<int> binitial;
+	std::vector<bool> bfrozen;
+
+	std::vector<Row> rows;
+	std::vector<bool> dropped;
+	std::vector<bool> is_row;
+	bool infeasible{false};
+
+	int find(int x) {
+		while (parent[x] != x) {
+			x = parent[x] = parent[parent[x]];
+		}
+		return x;
+	}
+	int bfind(int x) {
+		while (bparent[x] != x) {
+			x = bparent[x] = bparent[bparent[x]];
+		}
+		return x;
+	}
+
+	void initVars() {
+		const int n = pp.intvars.size();
+		parent.resize(n);
+		dom.resize(n);
+		for (int i = 0; i < n; i++) {
+			parent[i] = i;
+			auto* spec = static_cast<IntVarSpec*>(pp.intvars[i].second);
+			if (spec->alias) {
+				// Takes the domain of the variable it aliases below
+				dom[i].lo = IntVar::min_limit;
+				dom[i].hi = IntVar::max_limit;
+			} else {
+				dom[i] = specDom(spec);
+			}
+		}
+		initial = dom;
+
+		const int nb = pp.boolvars.size();
+		bparent.resize(nb);
+		bval.assign(nb, -1);
+		bfrozen.assign(nb, false);
+		for (int i = 0; i < nb; i++) {
+			bparent[i] = i;
+			auto* spec = static_cast<BoolVarSpec*>(pp.boolvars[i].second);
+			if (spec->alias) {
+				continue;
+			}
+			if (spec->assigned) {
+				bval[i] = spec->i;
+			} else if (spec->domain()) {
+				const AST::SetLit* sl = spec->domain.some();
+				if (sl->interval && sl->min == sl->max) {
+					bval[i] = sl->min;
+				} else if (!sl->interval && sl->s.size() == 1) {
+					bval[i] = sl->s[0];
+				}
+			}
+		}
+		binitial = bval;
+
+		// The on_restart constraints read and write their variables outside of propagation, and the
+		// graph propagators fail to explain their inferences when node or edge variables are
+		// constants (or the same variable)
+		for (auto& item : items) {
+			if (item.first->id.compare(0, 18, "chuffed_on_restart") == 0 ||
+					GRAPH_CONSTRAINTS.count(item.first->id) != 0) {
+				freeze(item.first->args);
+			}
+		}
+
+		for (int i = 0; i < n; i++) {
+			auto* spec = static_cast<IntVarSpec*>(pp.intvars[i].second);
+			if (spec->alias) {
+				unite(i, spec->i, true);
+			}
+		}
+		for (int i = 0; i < nb; i++) {
+			auto* spec = static_cast<BoolVarSpec*>(pp.boolvars[i].second);
+			if (spec->alias) {
+				bunite(i, spec->i, true);
+			}
+		}
+		is_row.assign(items.size(), false);
+	}
+
+	void freeze(AST::Node* n) {
+		if (auto* a = dynamic_cast<AST::Array*>(n)) {
+			for (auto* e : a->a) {
+				freeze(e);
+			}
+		} else if (auto* x = dynamic_cast<AST::IntVar*>(n)) {
+			dom[x->i].frozen = true;
+		} else if (auto* b = dynamic_cast<AST::BoolVar*>(n)) {
+			bfrozen[b->i] = true;
+		}
+	}
+
+	/// Restrict the domain of class \a x to lo..hi, returning whether it changed
+	bool setBounds(int x, int64_t lo, int64_t hi) {
+		Dom& d = dom[x];
+		lo = std::max(lo, d.lo);
+		hi = std::min(hi, d.hi);
+		if (d.sparse && lo <= hi) {
+			auto it = std::lower_bound(d.vals.begin(), d.vals.end(), lo);
+			auto jt = std::upper_bound(d.vals.begin(), d.vals.end(), hi);
+			if (it >= jt) {
+				lo = hi + 1;
+			} else {
+				lo = *it;
+				hi = *(jt - 1);
+			}
+		}
+		if (lo > hi) {
+			infeasible = true;
+			return false;
+		}
+		if (lo == d.lo && hi == d.hi) {
+			return false;
+		}
+		d.lo = lo;
+		d.hi = hi;
+		return true;
+	}
+
+	bool tighten(int x, int64_t lo, int64_t hi) { return !dom[x].frozen && setBounds(x, lo, hi); }
+
+	/// Merge the classes of \a x and \a y, returning whether they are now the same
+	bool unite(int x, int y, bool force) {
+		x = find(x);
+		y = find(y);
+		if (x == y) {
+			return true;
+		}
+		if (!force && (dom[x].frozen || dom[y].frozen)) {
+			return false;
+		}
+		if (y < x) {
+			std::swap(x, y);
+		}
+		parent[y] = x;
+		Dom& d = dom[x];
+		const Dom& e = dom[y];
+		if (e.sparse) {
+			if (d.sparse) {
+				std::vector<int> both;
+				std::set_intersection(d.vals.begin(), d.vals.end(), e.vals.begin(), e.vals.end(),
+															std::back_inserter(both));
+				d.vals.swap(both);
+			} else {
+				d.sparse = true;
+				d.vals = e.vals;
+			}
+		}
+		d.frozen = d.frozen || e.frozen;
+		setBounds(x, e.lo, e.hi);
+		// Snap the bounds to the values, even when they did not change
+		setBounds(x, d.lo, d.hi);
+		return true;
+	}
+
+	bool fix(int x, int v) {
+		x = find(x);
+		if (dom[x].frozen) {
+			return false;
+		}
+		setBounds(x, v, v);
+		return true;
+	}
+
+	bool bunite(int x, int y, bool force) {
+		x = bfind(x);
+		y = bfind(y);
+		if (x == y) {
+			return true;
+		}
+		if (!force && (bfrozen[x] || bfrozen[y])) {
+			return false;
+		}
+		if (y < x) {
+			std::swap(x, y);
+		}
+		bparent[y] = x;
+		bfrozen[x] = bfrozen[x] || bfrozen[y];
+		if (bval[y] >= 0) {
+			if (bval[x] >= 0 && bval[x] != bval[y]) {
+				infeasible = true;
+			}
+			bval[x] = bval[y];
+		}
+		return true;
+	}
+
+	bool bfix(int x, int v) {
+		x = bfind(x);
+		if (bfrozen[x]) {
+			return false;
+		}
+		if (bval[x] >= 0 && bval[x] != v) {
+			infeasible = true;
+		}
+		bval[x] = v;
+		return true;
+	}
+
+	//-----
+	// Reading the constraint items
+
+	void scan(int k) {
+		const ConExpr& c = *items[k].first;
+		const std::vector<AST::Node*>& a = c.args->a;
+		if (c.id == "int_eq" && a.size() == 2) {
+			dropped[k] = equal(a[0], a[1]);
+		} else if (c.id == "bool_eq" && a.size() == 2) {
+			dropped[k] = bequal(a[0], a[1]);
+		} else if ((c.id == "int_lin_le" || c.id == "int_lin_eq") && a.size() == 3) {
+			linear(k, c.id == "int_lin_eq");
+		} else if ((c.id == "int_le" || c.id == "int_lt") && a.size() == 2) {
+			comparison(k, c.id == "int_lt");
+		}
+	}
+
+	bool equal(AST::Node* x, AST::Node* y) {
+		if (x->isIntVar() && y->isIntVar()) {
+			return unite(x->getIntVar(), y->getIntVar(), false);
+		}
+		if (x->isIntVar() && y->isInt()) {
+			return fix(x->getIntVar(), y->getInt());
+		}
+		if (y->isIntVar() && x->isInt()) {
+			return fix(y->getIntVar(), x->getInt());
+		}
+		if (x->isInt() && y->isInt()) {
+			infeasible = infeasible || x->getInt() != y->getInt();
+			return true;
+		}
+		return false;
+	}
+
+	bool bequal(AST::Node* x, AST::Node* y) {
+		if (x->isBoolVar() && y->isBoolVar()) {
+			return bunite(x->getBoolVar(), y->getBoolVar(), false);
+		}
+		if (x->isBoolVar() && y->isBool()) {
+			return bfix(x->getBoolVar(), static_cast<int>(y->getBool()));
+		}
+		if (y->isBoolVar() && x->isBool()) {
+			return bfix(y->getBoolVar(), static_cast<int>(x->getBool()));
+		}
+		if (x->isBool() && y->isBool()) {
+			infeasible = infeasible || x->getBool() != y->getBool();
+			return true;
+		}
+		return false;
+	}
+
+	void linear(int k, bool eq) {
+		const std::vector<AST::Node*>& args = items[k].first->args->a;
+		auto* as = dynamic_cast<AST::Array*>(args[0]);
+		auto* xs = dynamic_cast<AST::Array*>(args[1]);
+		if (as == nullptr || xs == nullptr || as->a.size() != xs->a.size() || !args[2]->isInt()) {
+			return;
+		}
+		Row r;
+		r.item = k;
+		r.eq = eq;
+		r.rewrite = true;
+		r.rhs = args[2]->getInt();
+		for (size_t i = 0; i < as->a.size(); i++) {
+			if (!as->a[i]->isInt()) {
+				return;
+			}
+			const int64_t a = as->a[i]->getInt();
+			if (xs->a[i]->isIntVar()) {
+				r.terms.push_back({xs->a[i]->getIntVar(), a});
+			} else if (xs->a[i]->isInt()) {
+				r.rhs -= a * xs->a[i]->getInt();
+				r.modified = true;
+			} else {
+				return;
+			}
+		}
+		// x = y, written as an equation
+		if (eq && r.terms.size() == 2 && r.rhs == 0 && r.terms[0].a == -r.terms[1].a &&
+				r.terms[0].a != 0 && unite(r.terms[0].x, r.terms[1].x, false)) {
+			dropped[k] = true;
+			return;
+		}
+		is_row[k] = true;
+		rows.push_back(r);
+	}
+
+	void comparison(int k, bool strict) {
+		const std::vector<AST::Node*>& args = items[k].first->args->a;
+		Row r;
+		r.item = k;
+		r.eq = false;
+		r.rewrite = false;
+		r.rhs = strict ? -1 : 0;
+		for (int i = 0; i < 2; i++) {
+			const int64_t a = i == 0 ? 1 : -1;
+			if (args[i]->isIntVar()) {
+				r.terms.push_back({args[i]->getIntVar(), a});
+			} else if (args[i]->isInt()) {
+				r.rhs -= a * args[i]->getInt();
+			} else {
+				return;
+			}
+		}
+		is_row[k] = true;
+		rows.push_back(r);
+	}
+
+	//-----
+	// Linear rows
+
+	/// Rename the variables of \a r to their classes, merge repeated variables and take out the
+	/// fixed ones, keeping the order of the rest
+	void normalize(Row& r) {
+		if (!r.safe) {
+			return;
+		}
+		double magnitude = std::fabs(static_cast<double>(r.rhs));
+		for (const auto& t : r.terms) {
+			const Dom& d = dom[find(t.x)];
+			magnitude += std::fabs(static_cast<double>(t.a)) *
+									 std::max(std::fabs(static_cast<double>(d.lo)), std::fabs(static_cast<double>(d.hi)));
+		}
+		if (magnitude >= MAX_ACTIVITY) {
+			r.safe = false;
+			return;
+		}
+		std::vector<Term> out;
+		std::unordered_map<int, size_t> at;
+		for (const auto& t : r.terms) {
+			const int x = find(t.x);
+			if (x != t.x) {
+				r.modified = true;
+			}
+			if (dom[x].lo == dom[x].hi) {
+				r.rhs -= t.a * dom[x].lo;
+				r.modified = true;
+				continue;
+			}
+			auto it = at.find(x);
+			if (it != at.end()) {
+				out[it->second].a += t.a;
+				r.modified = true;
+			} else {
+				at[x] = out.size();
+				out.push_back({x, t.a});
+			}
+		}
+		size_t j = 0;
+		for (const auto& t : out) {
+			if (t.a != 0) {
+				out[j++] = t;
+			} else {
+				r.modified = true;
+			}
+		}
+		out.resize(j);
+		r.terms.swap(out);
+	}
+
+	void activity(const Row& r, int64_t& mn, int64_t& mx) {
+		mn = mx = 0;
+		for (const auto& t : r.terms) {
+			const Dom& d = dom[t.x];
+			if (t.a > 0) {
+				mn += t.a * d.lo;
+				mx += t.a * d.hi;
+			} else {
+				mn += t.a * d.hi;
+				mx += t.a * d.lo;
+			}
+		}
+	}
+
+	/// Bound propagation over the rows, until a fixpoint or the budget runs out
+	void propagate() {
+		std::vector<std::vector<int>> occurs(dom.size());
+		std::vector<int> queue;
+		int64_t budget = 0;
+		for (size_t ri = 0; ri < rows.size(); ri++) {
+			Row& r = rows[ri];
+			if (!r.safe) {
+				continue;
+			}
+			for (const auto& t : r.terms) {
+				occurs[t.x].push_back(ri);
+			}
+			budget += r.terms.size() + 1;
+			queue.push_back(ri);
+			r.queued = true;
+		}
+		budget *= PROPAGATION_BUDGET;
+		for (size_t head = 0; head < queue.size() && budget > 0; head++) {
+			Row& r = rows[queue[head]];
+			r.queued = false;
+			budget -= r.terms.size() + 1;
+			int64_t mn;
+			int64_t mx;
+			activity(r, mn, mx);
+			if (mn > r.rhs || (r.eq && mx < r.rhs)) {
+				infeasible = true;
+				return;
+			}
+			for (const auto& t : r.terms) {
+				// Bounds derived from the activity before the earlier terms were tightened are weaker,
+				// but still valid
+				const Dom& d = dom[t.x];
+				int64_t lo = d.lo;
+				int64_t hi = d.hi;
+				if (t.a > 0) {
+					hi = std::min(hi, floorDiv(r.rhs - (mn - t.a * d.lo), t.a));
+					if (r.eq) {
+						lo = std::max(lo, ceilDiv(r.rhs - (mx - t.a * d.hi), t.a));
+					}
+				} else {
+					lo = std::max(lo, ceilDiv(r.rhs - (mn - t.a * d.hi), t.a));
+					if (r.eq) {
+						hi = std::min(hi, floorDiv(r.rhs - (mx - t.a * d.lo), t.a));
+					}
+				}
+				if (tighten(t.x, lo, hi)) {
+					for (const int o : occurs[t.x]) {
+						if (!rows[o].queued) {
+							rows[o].queued = true;
+							queue.push_back(o);
+						}
+					}
+				}
+				if (infeasible) {
+					return;
+				}
+			}
+		}
+	}
+
+	/// Drop the rows the domains already imply (including every row left with one variable)
+	void dropImplied() {
+		for (auto& r : rows) {
+			if (!r.safe) {
+				continue;
+			}
+			int64_t mn;
+			int64_t mx;
+			activity(r, mn, mx);
+			if (mn > r.rhs || (r.eq && mx < r.rhs)) {
+				infeasible = true;
+				return;
+			}
+			if (r.eq ? mn == mx : mx <= r.rhs) {
+				r.dropped = true;
+			}
+		}
+	}
+
+	/// Shrink the coefficients of 0/1 variables in inequalities as far as the other terms allow,
+	/// then divide every rewritten row by the gcd of its coefficients
+	void tightenCoefficients() {
+		for (auto& r : rows) {
+			if (!r.safe || r.dropped || !r.rewrite) {
+				continue;
+			}
+			if (!r.eq) {
+				int64_t mn;
+				int64_t mx;
+				activity(r, mn, mx);
+				for (auto& t : r.terms) {
+					const Dom& d = dom[t.x];
+					const int64_t slack = mx - r.rhs;
+					if (d.lo != 0 || d.hi != 1 || slack <= 0) {
+						continue;
+					}
+					if (t.a > slack) {
+						// With x = 0 the row is implied, so only x = 1 needs to be kept as it is
+						mx -= t.a - slack;
+						r.rhs -= t.a - slack;
+						t.a = slack;
+						r.modified = true;
+						stats.coefficients++;
+					} else if (-t.a > slack) {
+						t.a = -slack;
+						r.modified = true;
+						stats.coefficients++;
+					}
+				}
+			}
+			int64_t g = 0;
+			for (const auto& t : r.terms) {
+				g = gcd(g, std::abs(t.a));
+			}
+			if (g > 1) {
+				if (r.eq && r.rhs % g != 0) {
+					infeasible = true;
+					return;
+				}
+				for (auto& t : r.terms) {
+					t.a /= g;
+				}
+				r.rhs = floorDiv(r.rhs, g);
+				r.modified = true;
+				stats.coefficients++;
+			}
+		}
+	}
+
+	/// Drop rows with the same left-hand side as an equation or a stronger inequality
+	void dropDominated() {
+		std::map<std::vector<int64_t>, int> eqs;
+		std::map<std::vector<int64_t>, int> les;
+		for (int pass = 0; pass < 2; pass++) {
+			for (size_t ri = 0; ri < rows.size(); ri++) {
+				Row& r = rows[ri];
+				if (!r.safe || r.dropped || r.eq != (pass == 0)) {
+					continue;
+				}
+				std::vector<Term> terms(r.terms);
+				std::sort(terms.begin(), terms.end(), [](const Term& s, const Term& t) { return s.x < t.x; });
+				std::vector<int64_t> key;
+				for (const auto& t : terms) {
+					key.push_back(t.x);
+					key.push_back(t.a);
+				}
+				auto e = eqs.find(key);
+				if (r.eq) {
+					if (e == eqs.end()) {
+						eqs[key] = ri;
+					} else if (rows[e->second].rhs == r.rhs) {
+						r.dropped = true;
+					} else {
+						infeasible = true;
+						return;
+					}
+					continue;
+				}
+				if (e != eqs.end() && rows[e->second].rhs <= r.rhs) {
+					r.dropped = true;
+					continue;
+				}
+				auto l = les.find(key);
+				if (l == les.end()) {
+					les[key] = ri;
+				} else if (rows[l->second].rhs <= r.rhs) {
+					r.dropped = true;
+				} else {
+					rows[l->second].dropped = true;
+					l->second = ri;
+				}
+			}
+		}
+	}
+
+	//-----
+	// Other constraints
+
+	bool key(AST::Node* n, std::string& out) {
+		if (n == nullptr) {
+			out += '_';
+		} else if (auto* x = dynamic_cast<AST::IntVar*>(n)) {
+			out += 'x';
+			out += std::to_string(find(x->i));
+		} else if (auto* b = dynamic_cast<AST::BoolVar*>(n)) {
+			out += 'b';
+			out += std::to_string(bfind(b->i));
+		} else if (auto* s = dynamic_cast<AST::SetVar*>(n)) {
+			out += 's';
+			out += std::to_string(s->i);
+		} else if (auto* f = dynamic_cast<AST::FloatVar*>(n)) {
+			out += 'f';
+			out += std::to_string(f->i);
+		} else if (auto* i = dynamic_cast<AST::IntLit*>(n)) {
+			out += 'i';
+			out += std::to_string(i->i);
+		} else if (auto* bl = dynamic_cast<AST::BoolLit*>(n)) {
+			out += bl->b ? "T" : "F";
+		} else if (auto* fl = dynamic_cast<AST::FloatLit*>(n)) {
+			uint64_t bits;
+			memcpy(&bits, &fl->d, sizeof(bits));
+			out += 'd';
+			out += std::to_string(bits);
+		} else if (auto* sl = dynamic_cast<AST::SetLit*>(n)) {
+			if (sl->interval) {
+				out += '{' + std::to_string(sl->min) + ".." + std::to_string(sl->max) + '}';
+			} else {
+				out += '{';
+				for (const int v : sl->s) {
+					out += std::to_string(v) + ',';
+				}
+				out += '}';
+			}
+		} else if (auto* a = dynamic_cast<AST::Array*>(n)) {
+			out += '[';
+			for (auto* e : a->a) {
+				if (!key(e, out)) {
+					return false;
+				}
+				out += ',';
+			}
+			out += ']';
+		} else if (auto* c = dynamic_cast<AST::Call*>(n)) {
+			out += c->id + '(';
+			if (!key(c->args, out)) {
+				return false;
+			}
+			out += ')';
+		} else if (auto* at = dynamic_cast<AST::Atom*>(n)) {
+			out += '@' + at->id;
+		} else if (auto* str = dynamic_cast<AST::String*>(n)) {
+			out += '"' + std::to_string(str->s.size()) + ':' + str->s;
+		} else {
+			return false;
+		}
+		return true;
+	}
+
+	/// Drop the items identical (up to equal variables) to an earlier one, annotations included
+	void dropDuplicates() {
+		std::unordered_set<std::string> seen;
+		for (size_t k = 0; k < items.size(); k++) {
+			const ConExpr& c = *items[k].first;
+			if (dropped[k] || is_row[k] || c.id.compare(0, 18, "chuffed_on_restart") == 0) {
+				continue;
+			}
+			std::string s = c.id;
+			if (key(c.args, s) && key(items[k].second, s) && !seen.insert(s).second) {
+				dropped[k] = true;
+			}
+		}
+	}
+
+	//-----
+	// Writing the result back
+
+	void apply() {
+		SpecOwner<IntVarSpec> ints(pp.intvars);
+		for (size_t i = 0; i < dom.size(); i++) {
+			const int r = find(i);
+			auto* spec = static_cast<IntVarSpec*>(pp.intvars[i].second);
+			if (r != static_cast<int>(i)) {
+				if (!spec->alias || spec->i != r) {
+					spec = ints.own(i);
+					if (!spec->alias) {
+						stats.int_vars++;
+						// The class keeps the most visible flags of its variables
+						auto* rs = ints.own(r);
+						rs->output = rs->output || spec->output;
+						rs->introduced = rs->introduced && spec->introduced;
+						rs->looks_introduced = rs->looks_introduced && spec->looks_introduced;
+					}
+					releaseDomain(spec);
+					spec->alias = true;
+					spec->assigned = false;
+					spec->i = r;
+				}
+				continue;
+			}
+			const Dom& d = dom[i];
+			const Dom& o = initial[i];
+			if (d.frozen) {
+				continue;
+			}
+			if (d.lo == d.hi) {
+				if (!spec->assigned) {
+					spec = ints.own(i);
+					releaseDomain(spec);
+					spec->assigned = true;
+					spec->i = d.lo;
+					stats.int_vars++;
+				}
+				continue;
+			}
+			std::vector<int> vals;
+			if (d.sparse) {
+				for (const int v : d.vals) {
+					if (v >= d.lo && v <= d.hi) {
+						vals.push_back(v);
+					}
+				}
+			}
+			if (d.lo == o.lo && d.hi == o.hi && d.sparse == o.sparse && vals.size() == o.vals.size()) {
+				continue;
+			}
+			spec = ints.own(i);
+			releaseDomain(spec);
+			if (d.sparse && static_cast<int64_t>(vals.size()) != d.hi - d.lo + 1) {
+				spec->domain = Option<AST::SetLit*>::some(new AST::SetLit(vals));
+			} else {
+				spec->domain = Option<AST::SetLit*>::some(new AST::SetLit(d.lo, d.hi));
+			}
+			stats.bounds++;
+		}
+		ints.finish();
+
+		SpecOwner<BoolVarSpec> bools(pp.boolvars);
+		for (size_t i = 0; i < bparent.size(); i++) {
+			const int r = bfind(i);
+			auto* spec = static_cast<BoolVarSpec*>(pp.boolvars[i].second);
+			if (r != static_cast<int>(i)) {
+				if (!spec->alias || spec->i != r) {
+					spec = bools.own(i);
+					if (!spec->alias) {
+						stats.bool_vars++;
+						auto* rs = bools.own(r);
+						rs->output = rs->output || spec->output;
+						rs->introduced = rs->introduced && spec->introduced;
+						rs->looks_introduced = rs->looks_introduced && spec->looks_introduced;
+					}
+					releaseDomain(spec);
+					spec->alias = true;
+					spec->assigned = false;
+					spec->i = r;
+				}
+			} else if (bval[i] >= 0 && binitial[i] < 0) {
+				spec = bools.own(i);
+				releaseDomain(spec);
+				spec->assigned = true;
+				spec->i = bval[i];
+				stats.bool_vars++;
+			}
+		}
+		bools.finish();
+
+		for (const auto& r : rows) {
+			if (!r.safe) {
+				continue;
+			}
+			if (r.dropped) {
+				dropped[r.item] = true;
+			} else if (r.rewrite && r.modified) {
+				rewrite(r);
+			}
+		}
+		size_t j = 0;
+		for (size_t k = 0; k < items.size(); k++) {
+			if (dropped[k]) {
+				delete items[k].first;
+				delete items[k].second;
+				stats.constraints++;
+			} else {
+				items[j++] = items[k];
+			}
+		}
+		items.resize(j);
+	}
+
+	void rewrite(const Row& r) {
+		if (!fitsInt(r.rhs)) {
+			return;
+		}
+		auto* as = new AST::Array();
+		auto* xs = new AST::Array();
+		for (const auto& t : r.terms) {
+			if (!fitsInt(t.a)) {
+				delete as;
+				delete xs;
+				return;
+			}
+			as->a.push_back(new AST::IntLit(static_cast<int>(t.a)));
+			xs->a.push_back(new AST::IntVar(t.x));
+		}
+		ConExpr& c = *items[r.item].first;
+		delete c.args;
+		c.args = new AST::Array(3);
+		c.args->a[0] = as;
+		c.args->a[1] = xs;
+		c.args->a[2] = new AST::IntLit(static_cast<int>(r.rhs));
+	}
+};
+
+/// Replaces the integer variables defined by a two-variable equation p*y + q*x = s, where p
+/// divides q and s, with the view y = a*x + b. The equation is dropped, y's domain is moved onto
+/// x, and y is substituted out of the linear and comparison constraints, which become linear
+/// constraints over x. The engine only creates an IntVar for a view that the search or the
+/// objective needs.
+class ViewFinder {
+public:
+	ViewFinder(ParserState& _pp, std::vector<std::pair<ConExpr*, AST::Node*>>& _items,
+						 FlatZincSpace::PresolveStats& _stats)
+			: pp(_pp), items(_items), stats(_stats), lins(_items.size()) {}
+
+	void run() {
+		initVars();
+		for (size_t k = 0; k < items.size(); k++) {
+			if (!parse(*items[k].first, lins[k])) {
+				exclude(items[k].first->args);
+			}
+		}
+		for (auto* c : pp.domainConstraints) {
+			exclude(c->args);
+		}
+		for (const auto& l : lins) {
+			if (l.parsed && l.rel == "eq" && l.reif == nullptr) {
+				define(l);
+			}
+		}
+		if (views > 0) {
+			apply();
+		}
+	}
+
+private:
+	/// x = a*root + b, where root is -1 for a variable that is not a view
+	struct View {
+		int root;
+		int64_t a;
+		int64_t b;
+	};
+
+	/// The constraint sum(a*x) rel rhs of a constraint item, reified by reif if it is not nullptr
+	struct Lin {
+		bool parsed{false};
+		std::vector<Term> terms;
+		int64_t rhs{0};
+		std::string rel;
+		AST::Node* reif{nullptr};
+	};
+
+	ParserState& pp;
+	std::vector<std::pair<ConExpr*, AST::Node*>>& items;
+	FlatZincSpace::PresolveStats& stats;
+
+	// Every variable stands for the variable it (eventually) aliases
+	std::vector<int> rep;
+	std::vector<View> view;
+	std::vector<Dom> dom;
+	std::vector<Dom> initial;
+	// Whether the variable may become a view
+	std::vector<bool> eligible;
+	std::vector<Lin> lins;
+	int views{0};
+
+	void initVars() {
+		const int n = pp.intvars.size();
+		rep.resize(n);
+		view.assign(n, View{-1, 1, 0});
+		dom.resize(n);
+		eligible.assign(n, false);
+		for (int i = 0; i < n; i++) {
+			auto* spec = static_cast<IntVarSpec*>(pp.intvars[i].second);
+			if (spec->alias) {
+				rep[i] = rep[spec->i];
+				continue;
+			}
+			rep[i] = i;
+			dom[i] = specDom(spec);
+			eligible[i] = !spec->assigned && spec->view_var < 0;
+		}
+		initial = dom;
+		// The on_restart constraints read and write their variables outside of propagation
+		for (auto& item : items) {
+			if (item.first->id.compare(0, 18, "chuffed_on_restart") == 0) {
+				freeze(item.first->args);
+			}
+		}
+	}
+
+	/// Leave the variables in \a n as they are, since they appear in a constraint that is kept
+	void exclude(AST::Node* n) {
+		if (auto* a = dynamic_cast<AST::Array*>(n)) {
+			for (auto* e : a->a) {
+				exclude(e);
+			}
+		} else if (auto* x = dynamic_cast<AST::IntVar*>(n)) {
+			eligible[rep[x->i]] = false;
+		}
+	}
+
+	void freeze(AST::Node* n) {
+		if (auto* a = dynamic_cast<AST::Array*>(n)) {
+			for (auto* e : a->a) {
+				freeze(e);
+			}
+		} else if (auto* x = dynamic_cast<AST::IntVar*>(n)) {
+			dom[rep[x->i]].frozen = true;
+		}
+	}
+
+	/// Find the \a root with x = a*root + b, returning false if a or b does not fit an int
+	bool resolve(int x, int& root, int64_t& a, int64_t& b) {
+		x = rep[x];
+		root = x;
+		a = 1;
+		b = 0;
+		while (view[root].root >= 0) {
+			const View& v = view[root];
+			b += a * v.b;
+			a *= v.a;
+			if (!fitsInt(a) || !fitsInt(b)) {
+				return false;
+			}
+			root = v.root;
+		}
+		if (view[x].root >= 0) {
+			view[x] = View{root, a, b};
+		}
+		return true;
+	}
+
+	//-----
+	// Reading the constraint items
+
+	bool term(Lin& l, AST::Node* n, int64_t a) {
+		if (n->isIntVar()) {
+			l.terms.push_back(Term{n->getIntVar(), a});
+			return true;
+		}
+		if (n->isInt()) {
+			l.rhs -= a * n->getInt();
+			return true;
+		}
+		return false;
+	}
+
+	bool parse(const ConExpr& c, Lin& l) {
+		static const char* rels[] = {"eq", "ne", "le", "lt", "ge", "gt"};
+		const std::vector<AST::Node*>& a = c.args->a;
+		std::string id = c.id;
+		const bool reif = id.size() > 5 && id.compare(id.size() - 5, 5, "_reif") == 0;
+		if (reif) {
+			id.erase(id.size() - 5);
+		}
+		bool ok = false;
+		if (id.compare(0, 8, "int_lin_") == 0) {
+			l.rel = id.substr(8);
+			if (a.size() == (reif ? 4U : 3U) && a[0]->isArray() && a[1]->isArray() && a[2]->isInt()) {
+				const std::vector<AST::Node*>& as = a[0]->getArray()->a;
+				const std::vector<AST::Node*>& xs = a[1]->getArray()->a;
+				ok = as.size() == xs.size();
+				l.rhs = a[2]->getInt();
+				for (size_t i = 0; ok && i < as.size(); i++) {
+					ok = as[i]->isInt() && term(l, xs[i], as[i]->getInt());
+				}
+			}
+		} else if (id.compare(0, 4, "int_") == 0 && id.size() == 6) {
+			// x rel y as x - y rel 0
+			l.rel = id.substr(4);
+			ok = a.size() == (reif ? 3U : 2U) && term(l, a[0], 1) && term(l, a[1], -1);
+		} else if (reif) {
+			return false;
+		} else if ((id == "int_plus" || id == "int_minus") && a.size() == 3) {
+			l.rel = "eq";
+			ok = term(l, a[0], 1) && term(l, a[1], id == "int_plus" ? 1 : -1) && term(l, a[2], -1);
+		} else if (id == "int_times" && a.size() == 3 && (a[0]->isInt() || a[1]->isInt())) {
+			l.rel = "eq";
+			const int k = a[0]->isInt() ? 0 : 1;
+			ok = term(l, a[1 - k], a[k]->getInt()) && term(l, a[2], -1);
+		} else if (id == "int_negate" && a.size() == 2) {
+			l.rel = "eq";
+			ok = term(l, a[0], 1) && term(l, a[1], 1);
+		}
+		ok = ok && std::find_if(std::begin(rels), std::end(rels), [&](const char* r) {
+								 return l.rel == r;
+							 }) != std::end(rels);
+		if (ok && reif) {
+			l.reif = a.back();
+			ok = l.reif->isBoolVar() || l.reif->isBool();
+		}
+		if (!ok) {
+			l = Lin();
+			return false;
+		}
+		l.parsed = true;
+		return true;
+	}
+
+	/// The terms of \a l over the roots, merged and without zero coefficients, returning false if
+	/// a coefficient or the right-hand side does not fit an int
+	bool collect(const Lin& l, std::vector<Term>& terms, int64_t& rhs) {
+		std::map<int, int64_t> sum;
+		rhs = l.rhs;
+		if (!fitsInt(rhs)) {
+			return false;
+		}
+		for (const auto& t : l.terms) {
+			int root;
+			int64_t a;
+			int64_t b;
+			if (!fitsInt(t.a) || !resolve(t.x, root, a, b)) {
+				return false;
+			}
+			int64_t& s = sum[root];
+			s += t.a * a;
+			rhs -= t.a * b;
+			if (!fitsInt(s) || !fitsInt(rhs)) {
+				return false;
+			}
+		}
+		terms.clear();
+		for (const auto& s : sum) {
+			if (s.second != 0) {
+				terms.push_back(Term{s.first, s.second});
+			}
+		}
+		return true;
+	}
+
+	bool touched(const Lin& l) {
+		for (const auto& t : l.terms) {
+			if (view[rep[t.x]].root >= 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//-----
+	// Finding the views
+
+	bool introduced(int x) { return static_cast<IntVarSpec*>(pp.intvars[x].second)->introduced; }
+
+	void define(const Lin& l) {
+		std::vector<Term> t;
+		int64_t rhs;
+		if (!collect(l, t, rhs) || t.size() != 2) {
+			return;
+		}
+		// Rather make an introduced variable a view, and otherwise the later one
+		int e = introduced(t[0].x) != introduced(t[1].x) ? (introduced(t[0].x) ? 0 : 1)
+																										 : (t[0].x > t[1].x ? 0 : 1);
+		for (int tries = 0; tries < 2; tries++, e = 1 - e) {
+			const Term& y = t[e];
+			const Term& x = t[1 - e];
+			if (eligible[y.x] && x.a % y.a == 0 && rhs % y.a == 0 &&
+					eliminate(y.x, x.x, -x.a / y.a, rhs / y.a)) {
+				return;
+			}
+		}
+	}
+
+	/// Make \a y the view a*x + b, if x can take the domain of y
+	bool eliminate(int y, int x, int64_t a, int64_t b) {
+		const Dom& dy = dom[y];
+		Dom d;
+		d.lo = a > 0 ? ceilDiv(dy.lo - b, a) : ceilDiv(dy.hi - b, a);
+		d.hi = a > 0 ? floorDiv(dy.hi - b, a) : floorDiv(dy.lo - b, a);
+		if (dy.sparse) {
+			d.sparse = true;
+			for (const int v : dy.vals) {
+				if ((v - b) % a == 0 && fitsInt((v - b) / a)) {
+					d.vals.push_back(static_cast<int>((v - b) / a));
+				}
+			}
+			std::sort(d.vals.begin(), d.vals.end());
+		}
+		const Dom& dx = dom[x];
+		Dom r = intersect(dx, d);
+		if (r.lo > r.hi) {
+			return false;
+		}
+		if (dx.frozen &&
+				(r.lo != dx.lo || r.hi != dx.hi || r.sparse != dx.sparse || r.vals.size() != dx.vals.size())) {
+			return false;
+		}
+		dom[x] = std::move(r);
+		view[y] = View{x, a, b};
+		eligible[y] = false;
+		views++;
+		return true;
+	}
+
+	static Dom intersect(const Dom& p, const Dom& q) {
+		Dom r;
+		r.lo = std::max(p.lo, q.lo);
+		r.hi = std::min(p.hi, q.hi);
+		r.frozen = p.frozen;
+		if (p.sparse || q.sparse) {
+			r.sparse = true;
+			std::vector<int> vals;
+			if (p.sparse && q.sparse) {
+				std::set_intersection(p.vals.begin(), p.vals.end(), q.vals.begin(), q.vals.end(),
+															std::back_inserter(vals));
+			} else {
+				vals = p.sparse ? p.vals : q.vals;
+			}
+			for (const int v : vals) {
+				if (v >= r.lo && v <= r.hi) {
+					r.vals.push_back(v);
+				}
+			}
+			if (r.vals.empty()) {
+				r.lo = 1;
+				r.hi = 0;
+			} else {
+				r.lo = r.vals.front();
+				r.hi = r.vals.back();
+			}
+		}
+		return r;
+	}
+
+	//-----
+	// Writing back the model
+
+	static bool holds(const std::string& rel, int64_t rhs) {
+		if (rel == "eq") {
+			return 0 == rhs;
+		}
+		if (rel == "ne") {
+			return 0 != rhs;
+		}
+		if (rel == "le") {
+			return 0 <= rhs;
+		}
+		if (rel == "lt") {
+			return 0 < rhs;
+		}
+		if (rel == "ge") {
+			return 0 >= rhs;
+		}
+		return 0 > rhs;
+	}
+
+	/// The item replacing \a l, or nullptr if it can be dropped; \a ok is cleared if it cannot be
+	/// written
+	ConExpr* rewrite(const Lin& l, bool& ok) {
+		std::vector<Term> t;
+		int64_t rhs;
+		if (!collect(l, t, rhs)) {
+			ok = false;
+			return nullptr;
+		}
+		AST::Node* reif = nullptr;
+		if (l.reif != nullptr) {
+			reif = l.reif->isBool() ? static_cast<AST::Node*>(new AST::BoolLit(l.reif->getBool()))
+															: new AST::BoolVar(l.reif->getBoolVar());
+		}
+		if (t.empty()) {
+			if (reif == nullptr) {
+				// The equation of a view, or a constraint it decides
+				ok = holds(l.rel, rhs);
+				return nullptr;
+			}
+			auto* args = new AST::Array(2);
+			args->a[0] = reif;
+			args->a[1] = new AST::BoolLit(holds(l.rel, rhs));
+			return new ConExpr("bool_eq", args);
+		}
+		double activity = 0;
+		auto* as = new AST::Array();
+		auto* xs = new AST::Array();
+		for (const auto& u : t) {
+			const Dom& d = dom[u.x];
+			activity += std::fabs(static_cast<double>(u.a)) *
+									std::max(std::fabs(static_cast<double>(d.lo)), std::fabs(static_cast<double>(d.hi)));
+			as->a.push_back(new AST::IntLit(static_cast<int>(u.a)));
+			xs->a.push_back(new AST::IntVar(u.x));
+		}
+		ok = activity < MAX_ACTIVITY;
+		auto* args = new AST::Array(reif != nullptr ? 4 : 3);
+		args->a[0] = as;
+		args->a[1] = xs;
+		args->a[2] = new AST::IntLit(static_cast<int>(rhs));
+		if (reif != nullptr) {
+			args->a[3] = reif;
+		}
+		return new ConExpr("int_lin_" + l.rel + (reif != nullptr ? "_reif" : ""), args);
+	}
+
+	void apply() {
+		// Nothing changes unless every item and every view can be written
+		std::vector<std::pair<size_t, ConExpr*>> rewritten;
+		std::vector<bool> dropped(items.size(), false);
+		bool ok = true;
+		for (size_t k = 0; k < items.size() && ok; k++) {
+			if (!lins[k].parsed || !touched(lins[k])) {
+				continue;
+			}
+			ConExpr* c = rewrite(lins[k], ok);
+			if (c != nullptr) {
+				rewritten.emplace_back(k, c);
+			} else {
+				dropped[k] = true;
+			}
+		}
+		const int n = pp.intvars.size();
+		std::vector<View> resolved(n, View{-1, 1, 0});
+		for (int i = 0; i < n && ok; i++) {
+			if (rep[i] == i && view[i].root >= 0) {
+				ok = resolve(i, resolved[i].root, resolved[i].a, resolved[i].b);
+			}
+		}
+		if (!ok) {
+			for (auto& r : rewritten) {
+				delete r.second;
+			}
+			if (so.verbosity >= 1) {
+				fprintf(stderr, "%% Presolve found views it cannot write, leaving them out\n");
+			}
+			return;
+		}
+
+		SpecOwner<IntVarSpec> ints(pp.intvars);
+		for (int i = 0; i < n; i++) {
+			if (rep[i] != i) {
+				continue;
+			}
+			if (resolved[i].root >= 0) {
+				auto* spec = ints.own(i);
+				releaseDomain(spec);
+				spec->view_var = resolved[i].root;
+				spec->view_a = static_cast<int>(resolved[i].a);
+				spec->view_b = static_cast<int>(resolved[i].b);
+				stats.views++;
+				continue;
+			}
+			const Dom& d = dom[i];
+			const Dom& o = initial[i];
+			if (static_cast<IntVarSpec*>(pp.intvars[i].second)->assigned ||
+					(d.lo == o.lo && d.hi == o.hi && d.sparse == o.sparse && d.vals.size() == o.vals.size())) {
+				continue;
+			}
+			auto* spec = ints.own(i);
+			releaseDomain(spec);
+			if (d.sparse && static_cast<int64_t>(d.vals.size()) != d.hi - d.lo + 1) {
+				spec->domain = Option<AST::SetLit*>::some(new AST::SetLit(d.vals));
+			} else {
+				spec->domain = Option<AST::SetLit*>::some(new AST::SetLit(d.lo, d.hi));
+			}
+			stats.bounds++;
+		}
+		ints.finish();
+
+		for (auto& r : rewritten) {
+			delete items[r.first].first;
+			items[r.first].first = r.second;
+		}
+		size_t j = 0;
+		for (size_t k = 0; k < items.size(); k++) {
+			if (dropped[k]) {
+				delete items[k].first;
+				delete items[k].second;
+				stats.constraints++;
+			} else {
+				items[j++] = items[k];
+			}
+		}
+		items.resize(j);
+	}
+};
+
+}  // namespace
+
+void presolve(ParserState& pp, std::vector<std::pair<ConExpr*, AST::Node*>>& items,
+							FlatZincSpace::PresolveStats& stats) {
+	const time_point start = chuffed_clock::now();
+	Presolver(pp, items, stats).run();
+	if (!stats.infeasible) {
+		ViewFinder(pp, items, stats).run();
+	}
+	stats.time = chuffed_clock::now() - start;
+}
+
+}  // namespace FlatZinc
@@ -0,0 +1,28 @@
+#ifndef FLATZINC_PRESOLVE_H
+#define FLATZINC_PRESOLVE_H
+// Presolving of a parsed FlatZinc model, enabled by --presolve.
+//
+// The presolver runs once every constraint item has been read and before any variable is
+// created, so what it finds shrinks the model the engine sees: fixed variables become constants,
+// variables known to be equal become aliases of one another, and tightened bounds become the
+// domains the variables are created with. Finally, a variable defined by an equation over two
+// variables, y = a*x + b, becomes a view of x: it is substituted out of the linear and comparison
+// constraints, and only gets an IntVar of its own if the search or the objective needs one. It
+// only writes linear constraints (int_lin_*) and bool_eq, and otherwise only drops constraint
+// items, so every poster in the registry sees arguments of the forms it already handles.
+#include "chuffed/flatzinc/flatzinc.h"
+
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+/// Simplify the variable specifications of \a pp together with the constraint items \a items,
+/// deleting and removing the items that are no longer needed. If the model is found to be
+/// infeasible nothing is changed, and the engine finds the same failure when it posts the model.
+void presolve(ParserState& pp, std::vector<std::pair<ConExpr*, AST::Node*>>& items,
+							FlatZincSpace::PresolveStats& stats);
+
+}  // namespace FlatZinc
+
+#endif
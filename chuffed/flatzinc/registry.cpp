@@ -663,6 +663,7 @@ void p_regular(const ConExpr& ce, AST::Node* ann) {
 	} else {
 		regular(iv, q, s, d, q0, f);
 	}
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_ROW, iv);
 }
 
 void p_cost_regular(const ConExpr& ce, AST::Node* ann) {
@@ -678,21 +679,12 @@ void p_cost_regular(const ConExpr& ce, AST::Node* ann) {
 
 	assert(d_flat.size() == q * s);
 
+	// States and values are both numbered from 1, as wdfa_to_layergraph expects.
 	vec<vec<int> > d;
 	vec<vec<int> > w;
-	// State 0 is garbage
-	d.push();
-	for (int j = 0; j <= s; j++) {
-		d.last().push(0);
-		w.last().push(0);
-	}
-	// Fill in the remaining transitions
 	for (int i = 0; i < q; i++) {
 		d.push();
 		w.push();
-		// Values start from 1, so [x = 0] goes to garbage.
-		d.last().push(0);
-		w.last().push(0);
 		for (int j = 0; j < s; j++) {
 			d.last().push(d_flat[i * s + j]);
 			w.last().push(w_flat[i * s + j]);
@@ -714,7 +706,8 @@ void p_cost_regular(const ConExpr& ce, AST::Node* ann) {
 
 	IntVar* cost = getIntVar(ce[7]);
 
-	wmdd_cost_regular(iv, q + 1, s + 1, d, w, q0, f, cost, getMDDOpts(ann));
+	wmdd_cost_regular(iv, q, s, d, w, q0, f, cost, getMDDOpts(ann));
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_ROW, iv);
 }
 
 void p_disjunctive(const ConExpr& ce, AST::Node* /*ann*/) {
@@ -723,6 +716,7 @@ void p_disjunctive(const ConExpr& ce, AST::Node* /*ann*/) {
 	vec<int> d;
 	arg2intargs(d, ce[1]);
 	disjunctive(s, d);
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_WINDOW, s);
 }
 
 void p_cumulative(const ConExpr& ce, AST::Node* ann) {
@@ -735,6 +729,7 @@ void p_cumulative(const ConExpr& ce, AST::Node* ann) {
 	const int limit = ce[3]->getInt();
 	const std::list<std::string> opt = getCumulativeOptions(ann);
 	cumulative(s, d, p, limit, opt);
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_WINDOW, s);
 }
 
 void p_cumulative2(const ConExpr& ce, AST::Node* ann) {
@@ -746,6 +741,7 @@ void p_cumulative2(const ConExpr& ce, AST::Node* ann) {
 	arg2intvarargs(r, ce[2]);
 	const std::list<std::string> opt = getCumulativeOptions(ann);
 	cumulative2(s, d, r, getIntVar(ce[3]), opt);
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_WINDOW, s);
 }
 
 void p_cumulative_cal(const ConExpr& ce, AST::Node* ann) {
@@ -776,6 +772,7 @@ void p_cumulative_cal(const ConExpr& ce, AST::Node* ann) {
 	const int resCal = ce[9]->getInt();
 	const std::list<std::string> opt = getCumulativeOptions(ann);
 	cumulative_cal(s, d, p, getIntVar(ce[3]), cal, taskCal, rho, resCal, opt);
+	FlatZinc::s->lnsStructure(FlatZincSpace::LNS_WINDOW, s);
 }
 
 void p_circuit(const ConExpr& ce, AST::Node* /*ann*/) {
@@ -783,6 +780,24 @@ void p_circuit(const ConExpr& ce, AST::Node* /*ann*/) {
 	arg2intvarargs(x, ce[0]);
 	const int index_offset = ce[1]->getInt();
 	circuit(x, index_offset);
+	s->lnsStructure(FlatZincSpace::LNS_SEGMENT, x, index_offset);
+}
+
+void p_weighted_circuit(const ConExpr& ce, AST::Node* /*ann*/) {
+	vec<IntVar*> x;
+	arg2intvarargs(x, ce[0]);
+	const int index_offset = ce[1]->getInt();
+	vec<int> c_flat;
+	arg2intargs(c_flat, ce[2]);
+	assert(c_flat.size() == x.size() * x.size());
+	vec<vec<int> > c(x.size());
+	for (int i = 0; i < x.size(); i++) {
+		for (int j = 0; j < x.size(); j++) {
+			c[i].push(c_flat[i * x.size() + j]);
+		}
+	}
+	weighted_circuit(x, c, getIntVar(ce[3]), index_offset);
+	s->lnsStructure(FlatZincSpace::LNS_SEGMENT, x, index_offset);
 }
 
 void p_subcircuit(const ConExpr& ce, AST::Node* /*ann*/) {
@@ -790,6 +805,7 @@ void p_subcircuit(const ConExpr& ce, AST::Node* /*ann*/) {
 	arg2intvarargs(x, ce[0]);
 	const int index_offset = ce[1]->getInt();
 	subcircuit(x, index_offset);
+	s->lnsStructure(FlatZincSpace::LNS_SEGMENT, x, index_offset);
 }
 
 void p_minimum(const ConExpr& ce, AST::Node* /*ann*/) {
@@ -1429,7 +1445,7 @@ void p_mst_new(const ConExpr& ce, AST::Node* /*ann*/) {
 	vec<int> to;
 	arg2intargs(to, ce[3]);
 	vec<int> ws;
-	arg2intargs(to, ce[4]);
+	arg2intargs(ws, ce[4]);
 	vec<BoolView> vs;
 	arg2BoolVarArgs(vs, ce[5]);
 	vec<BoolView> es;
@@ -1906,6 +1922,7 @@ public:
 		registry().add("chuffed_cumulative_cal", &p_cumulative_cal);
 		registry().add("chuffed_circuit", &p_circuit);
 		registry().add("chuffed_subcircuit", &p_subcircuit);
+		registry().add("chuffed_weighted_circuit", &p_weighted_circuit);
 		registry().add("array_int_minimum", &p_minimum);
 		registry().add("array_int_maximum", &p_maximum);
 		registry().add("chuffed_maximum_arg_bool", &p_bool_arg_max);
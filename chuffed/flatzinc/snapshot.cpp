@@ -0,0 +1,437 @@
+#include "chuffed/flatzinc/snapshot.h"
+
+#include "chuffed/flatzinc/ast.h"
+#include "chuffed/flatzinc/flatzinc.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+// Bump whenever the layout of a snapshot changes.
+#define SNAPSHOT_VERSION 2
+
+static const char SNAPSHOT_MAGIC[4] = {'C', 'F', 'Z', 'S'};
+
+enum NodeTag {
+	N_NULL,
+	N_BOOL,
+	N_INT,
+	N_FLOAT,
+	N_SET,
+	N_BOOL_VAR,
+	N_INT_VAR,
+	N_FLOAT_VAR,
+	N_SET_VAR,
+	N_ARRAY,
+	N_CALL,
+	N_ACCESS,
+	N_ATOM,
+	N_STRING
+};
+
+enum SpecKind { SK_INT, SK_BOOL, SK_SET };
+
+enum SpecFlags {
+	SF_OUTPUT = 1,
+	SF_INTRODUCED = 2,
+	SF_LOOKS = 4,
+	SF_ALIAS = 8,
+	SF_ASSIGNED = 16,
+	SF_VIEW = 32
+};
+
+static Error corrupt() { return Error("Model snapshot", "truncated or corrupt"); }
+
+//-----
+// Writing
+
+SnapshotWriter::SnapshotWriter() {
+	buf.append(SNAPSHOT_MAGIC, 4);
+	put<uint32_t>(SNAPSHOT_VERSION);
+}
+
+void SnapshotWriter::str(const std::string& s) {
+	put<uint32_t>(s.size());
+	buf.append(s);
+}
+
+void SnapshotWriter::setLit(const AST::SetLit& s) {
+	put<uint8_t>(s.interval);
+	if (s.interval) {
+		put<int32_t>(s.min);
+		put<int32_t>(s.max);
+	} else {
+		put<uint32_t>(s.s.size());
+		buf.append(reinterpret_cast<const char*>(s.s.data()), s.s.size() * sizeof(int));
+	}
+}
+
+void SnapshotWriter::node(AST::Node* n) {
+	if (n == nullptr) {
+		put<uint8_t>(N_NULL);
+	} else if (auto* b = dynamic_cast<AST::BoolLit*>(n)) {
+		put<uint8_t>(N_BOOL);
+		put<uint8_t>(b->b);
+	} else if (auto* i = dynamic_cast<AST::IntLit*>(n)) {
+		put<uint8_t>(N_INT);
+		put<int32_t>(i->i);
+	} else if (auto* f = dynamic_cast<AST::FloatLit*>(n)) {
+		put<uint8_t>(N_FLOAT);
+		put<double>(f->d);
+	} else if (auto* s = dynamic_cast<AST::SetLit*>(n)) {
+		put<uint8_t>(N_SET);
+		setLit(*s);
+	} else if (auto* v = dynamic_cast<AST::Var*>(n)) {
+		if (dynamic_cast<AST::BoolVar*>(n) != nullptr) {
+			put<uint8_t>(N_BOOL_VAR);
+		} else if (dynamic_cast<AST::IntVar*>(n) != nullptr) {
+			put<uint8_t>(N_INT_VAR);
+		} else if (dynamic_cast<AST::FloatVar*>(n) != nullptr) {
+			put<uint8_t>(N_FLOAT_VAR);
+		} else {
+			put<uint8_t>(N_SET_VAR);
+		}
+		put<int32_t>(v->i);
+	} else if (auto* a = dynamic_cast<AST::Array*>(n)) {
+		put<uint8_t>(N_ARRAY);
+		put<uint32_t>(a->a.size());
+		for (auto* e : a->a) {
+			node(e);
+		}
+	} else if (auto* c = dynamic_cast<AST::Call*>(n)) {
+		put<uint8_t>(N_CALL);
+		str(c->id);
+		node(c->args);
+	} else if (auto* aa = dynamic_cast<AST::ArrayAccess*>(n)) {
+		put<uint8_t>(N_ACCESS);
+		node(aa->a);
+		node(aa->idx);
+	} else if (auto* at = dynamic_cast<AST::Atom*>(n)) {
+		put<uint8_t>(N_ATOM);
+		str(at->id);
+	} else if (auto* st = dynamic_cast<AST::String*>(n)) {
+		put<uint8_t>(N_STRING);
+		str(st->s);
+	} else {
+		throw Error("Model snapshot", "unknown kind of node");
+	}
+}
+
+// Fields that a constructor leaves unset are written as zero
+void SnapshotWriter::spec(const VarSpec& v, const Option<AST::SetLit*>* domain) {
+	const bool assigned = !v.alias && v.assigned;
+	const auto* view = dynamic_cast<const IntVarSpec*>(&v);
+	if (view != nullptr && (v.alias || assigned || view->view_var < 0)) {
+		view = nullptr;
+	}
+	put<uint8_t>((v.output ? SF_OUTPUT : 0) | (v.introduced ? SF_INTRODUCED : 0) |
+							 (v.looks_introduced ? SF_LOOKS : 0) | (v.alias ? SF_ALIAS : 0) |
+							 (assigned ? SF_ASSIGNED : 0) | (view != nullptr ? SF_VIEW : 0));
+	put<int32_t>(v.alias || assigned ? v.i : 0);
+	if (view != nullptr) {
+		put<int32_t>(view->view_var);
+		put<int32_t>(view->view_a);
+		put<int32_t>(view->view_b);
+	}
+	if (domain != nullptr) {
+		put<uint8_t>((*domain)());
+		if ((*domain)()) {
+			setLit(*domain->some());
+		}
+	}
+}
+
+void SnapshotWriter::specs(const std::vector<varspec>& vs, int kind) {
+	put<uint32_t>(vs.size());
+	for (const auto& v : vs) {
+		str(v.first);
+		switch (kind) {
+			case SK_INT: {
+				const auto& s = *static_cast<IntVarSpec*>(v.second);
+				spec(s, !s.alias && !s.assigned ? &s.domain : nullptr);
+			} break;
+			case SK_BOOL: {
+				const auto& s = *static_cast<BoolVarSpec*>(v.second);
+				spec(s, !s.alias && !s.assigned ? &s.domain : nullptr);
+			} break;
+			default: {
+				const auto& s = *static_cast<SetVarSpec*>(v.second);
+				spec(s, !s.alias ? &s.upperBound : nullptr);
+			}
+		}
+	}
+}
+
+void SnapshotWriter::vars(const ParserState& pp) {
+	put<uint8_t>(SR_VARS);
+	specs(pp.intvars, SK_INT);
+	specs(pp.boolvars, SK_BOOL);
+	specs(pp.setvars, SK_SET);
+	put<uint32_t>(pp.domainConstraints.size());
+	for (auto* c : pp.domainConstraints) {
+		str(c->id);
+		node(c->args);
+	}
+}
+
+void SnapshotWriter::intVar(const varspec& v) {
+	put<uint8_t>(SR_INT_VAR);
+	specs(std::vector<varspec>(1, v), SK_INT);
+}
+
+void SnapshotWriter::constraint(const ConExpr& c, AST::Node* ann) {
+	put<uint8_t>(SR_CONSTRAINT);
+	str(c.id);
+	node(c.args);
+	node(ann);
+}
+
+void SnapshotWriter::solve(int kind, int objective, AST::Node* ann) {
+	put<uint8_t>(SR_SOLVE);
+	put<uint8_t>(kind);
+	put<int32_t>(objective);
+	node(ann);
+}
+
+void SnapshotWriter::output(const std::vector<std::pair<std::string, AST::Node*>>& out) {
+	put<uint8_t>(SR_OUTPUT);
+	put<uint32_t>(out.size());
+	for (const auto& o : out) {
+		str(o.first);
+		node(o.second);
+	}
+}
+
+bool SnapshotWriter::commit(const std::string& path) {
+	put<uint8_t>(SR_END);
+	std::ofstream out(path.c_str(), std::ios::binary);
+	out.write(buf.data(), buf.size());
+	out.close();
+	return static_cast<bool>(out);
+}
+
+//-----
+// Reading
+
+bool SnapshotReader::open(const std::string& path) {
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	file.seekg(0, std::ios::end);
+	const std::streamoff size = file.tellg();
+	if (size < 8) {
+		return false;
+	}
+	data.resize(size);
+	file.seekg(0, std::ios::beg);
+	file.read(&data[0], size);
+	if (!file || memcmp(data.data(), SNAPSHOT_MAGIC, 4) != 0) {
+		return false;
+	}
+	pos = 4;
+	return get<uint32_t>() == SNAPSHOT_VERSION;
+}
+
+void SnapshotReader::need(size_t bytes) const {
+	if (pos + bytes > data.size()) {
+		throw corrupt();
+	}
+}
+
+std::string SnapshotReader::str() {
+	const auto n = get<uint32_t>();
+	need(n);
+	std::string s(data.data() + pos, n);
+	pos += n;
+	return s;
+}
+
+AST::SetLit* SnapshotReader::setLit() {
+	if (get<uint8_t>() != 0) {
+		const int min = get<int32_t>();
+		const int max = get<int32_t>();
+		return new AST::SetLit(min, max);
+	}
+	const auto n = get<uint32_t>();
+	need(static_cast<size_t>(n) * sizeof(int));
+	std::vector<int> s(n);
+	memcpy(s.data(), data.data() + pos, n * sizeof(int));
+	pos += n * sizeof(int);
+	return new AST::SetLit(std::move(s));
+}
+
+AST::Node* SnapshotReader::node() {
+	switch (get<uint8_t>()) {
+		case N_NULL:
+			return nullptr;
+		case N_BOOL:
+			return new AST::BoolLit(get<uint8_t>() != 0);
+		case N_INT:
+			return new AST::IntLit(get<int32_t>());
+		case N_FLOAT:
+			return new AST::FloatLit(get<double>());
+		case N_SET:
+			return setLit();
+		case N_BOOL_VAR:
+			return new AST::BoolVar(get<int32_t>());
+		case N_INT_VAR:
+			return new AST::IntVar(get<int32_t>());
+		case N_FLOAT_VAR:
+			return new AST::FloatVar(get<int32_t>());
+		case N_SET_VAR:
+			return new AST::SetVar(get<int32_t>());
+		case N_ARRAY: {
+			const auto n = get<uint32_t>();
+			auto* a = new AST::Array(static_cast<int>(n));
+			for (uint32_t i = 0; i < n; i++) {
+				a->a[i] = node();
+			}
+			return a;
+		}
+		case N_CALL: {
+			std::string id = str();
+			return new AST::Call(std::move(id), node());
+		}
+		case N_ACCESS: {
+			AST::Node* a = node();
+			return new AST::ArrayAccess(a, node());
+		}
+		case N_ATOM:
+			return new AST::Atom(str());
+		case N_STRING:
+			return new AST::String(str());
+		default:
+			throw corrupt();
+	}
+}
+
+static AST::Array* asArray(AST::Node* n) {
+	auto* a = dynamic_cast<AST::Array*>(n);
+	if (a == nullptr) {
+		delete n;
+		throw corrupt();
+	}
+	return a;
+}
+
+VarSpec* SnapshotReader::spec(int kind) {
+	const auto flags = get<uint8_t>();
+	const bool output = (flags & SF_OUTPUT) != 0;
+	const bool introduced = (flags & SF_INTRODUCED) != 0;
+	const bool looks = (flags & SF_LOOKS) != 0;
+	const int i = get<int32_t>();
+	if ((flags & SF_ALIAS) != 0) {
+		VarSpec* v;
+		switch (kind) {
+			case SK_INT:
+				v = new IntVarSpec(Alias(i), output, introduced, looks);
+				break;
+			case SK_BOOL:
+				v = new BoolVarSpec(Alias(i), output, introduced, looks);
+				break;
+			default:
+				v = new SetVarSpec(Alias(i), output, introduced, looks);
+		}
+		v->assigned = false;
+		return v;
+	}
+	if ((flags & SF_ASSIGNED) != 0 && kind != SK_SET) {
+		if (kind == SK_INT) {
+			return new IntVarSpec(i, output, introduced, looks);
+		}
+		return new BoolVarSpec(i != 0, output, introduced, looks);
+	}
+	int view[3] = {-1, 1, 0};
+	if ((flags & SF_VIEW) != 0) {
+		for (int& x : view) {
+			x = get<int32_t>();
+		}
+	}
+	Option<AST::SetLit*> domain = Option<AST::SetLit*>::none();
+	if (get<uint8_t>() != 0) {
+		domain = Option<AST::SetLit*>::some(setLit());
+	}
+	switch (kind) {
+		case SK_INT: {
+			auto* v = new IntVarSpec(domain, output, introduced, looks);
+			v->view_var = view[0];
+			v->view_a = view[1];
+			v->view_b = view[2];
+			return v;
+		}
+		case SK_BOOL:
+			return new BoolVarSpec(domain, output, introduced, looks);
+		default:
+			if ((flags & SF_ASSIGNED) != 0) {
+				return new SetVarSpec(domain.some(), output, introduced, looks);
+			}
+			return new SetVarSpec(domain, output, introduced, looks);
+	}
+}
+
+void SnapshotReader::specs(std::vector<varspec>& vs, int kind) {
+	const auto n = get<uint32_t>();
+	vs.reserve(vs.size() + n);
+	for (uint32_t i = 0; i < n; i++) {
+		std::string name = str();
+		vs.emplace_back(std::move(name), spec(kind));
+	}
+}
+
+SnapshotRecord SnapshotReader::record() {
+	const auto r = get<uint8_t>();
+	if (r > SR_END) {
+		throw corrupt();
+	}
+	return static_cast<SnapshotRecord>(r);
+}
+
+void SnapshotReader::vars(ParserState& pp) {
+	specs(pp.intvars, SK_INT);
+	specs(pp.boolvars, SK_BOOL);
+	specs(pp.setvars, SK_SET);
+	const auto n = get<uint32_t>();
+	for (uint32_t i = 0; i < n; i++) {
+		std::string id = str();
+		pp.domainConstraints.push_back(new ConExpr(std::move(id), asArray(node())));
+	}
+}
+
+varspec SnapshotReader::intVar() {
+	std::vector<varspec> vs;
+	specs(vs, SK_INT);
+	if (vs.size() != 1) {
+		throw corrupt();
+	}
+	return vs[0];
+}
+
+ConExpr* SnapshotReader::constraint(AST::Node*& ann) {
+	std::string id = str();
+	auto* c = new ConExpr(std::move(id), asArray(node()));
+	ann = node();
+	return c;
+}
+
+void SnapshotReader::solve(int& kind, int& objective, AST::Node*& ann) {
+	kind = get<uint8_t>();
+	objective = get<int32_t>();
+	ann = node();
+}
+
+void SnapshotReader::output(ParserState& pp) {
+	const auto n = get<uint32_t>();
+	for (uint32_t i = 0; i < n; i++) {
+		std::string name = str();
+		pp.output(name, node());
+	}
+}
+
+}  // namespace FlatZinc
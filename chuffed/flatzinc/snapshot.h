@@ -0,0 +1,96 @@
+#ifndef FLATZINC_SNAPSHOT_H
+#define FLATZINC_SNAPSHOT_H
+// Binary snapshot of a parsed FlatZinc model, written by --save-model and read by --load-model.
+//
+// A snapshot holds what the parser hands over to the solver, in the order it does so: the
+// variable specifications at the point the variables are created, then every constraint item
+// with its annotations, any variable introduced for a constant objective, the solve item and
+// finally the output specification. Loading replays these records through the same code as the
+// parser, so nothing is lexed, parsed or looked up by name. Numbers are stored in the byte order
+// of the machine that wrote the snapshot.
+#include "chuffed/flatzinc/ast.h"
+#include "chuffed/flatzinc/flatzinc.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+enum SnapshotRecord { SR_VARS, SR_INT_VAR, SR_CONSTRAINT, SR_SOLVE, SR_OUTPUT, SR_END };
+
+/// Kind of solve item in a snapshot
+enum SnapshotSolve { SS_SATISFY, SS_MINIMIZE, SS_MAXIMIZE };
+
+class SnapshotWriter {
+public:
+	SnapshotWriter();
+
+	/// The variables (and their domain constraints) the parser is about to create
+	void vars(const ParserState& pp);
+	/// An integer variable added after the others, for a constant objective
+	void intVar(const varspec& v);
+	void constraint(const ConExpr& c, AST::Node* ann);
+	void solve(int kind, int objective, AST::Node* ann);
+	void output(const std::vector<std::pair<std::string, AST::Node*>>& out);
+
+	/// Write the snapshot to \a path, returning whether it succeeded
+	bool commit(const std::string& path);
+
+private:
+	std::string buf;
+
+	template <class T>
+	void put(T x) {
+		buf.append(reinterpret_cast<const char*>(&x), sizeof(T));
+	}
+	void str(const std::string& s);
+	void node(AST::Node* n);
+	void setLit(const AST::SetLit& s);
+	void spec(const VarSpec& v, const Option<AST::SetLit*>* domain);
+	void specs(const std::vector<varspec>& vs, int kind);
+};
+
+class SnapshotReader {
+public:
+	/// Read the whole of \a path, returning false if it cannot be read or is not a snapshot
+	bool open(const std::string& path);
+
+	/// Return the kind of the next record
+	SnapshotRecord record();
+	/// Fill the variables and domain constraints of \a pp
+	void vars(ParserState& pp);
+	varspec intVar();
+	/// Return the next constraint, and set \a ann to its annotations
+	ConExpr* constraint(AST::Node*& ann);
+	void solve(int& kind, int& objective, AST::Node*& ann);
+	void output(ParserState& pp);
+
+	/// Whether everything has been read
+	bool atEnd() const { return pos == data.size(); }
+
+private:
+	std::string data;
+	size_t pos{0};
+
+	void need(size_t bytes) const;
+	template <class T>
+	T get() {
+		need(sizeof(T));
+		T x;
+		memcpy(&x, data.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return x;
+	}
+	std::string str();
+	AST::Node* node();
+	AST::SetLit* setLit();
+	VarSpec* spec(int kind);
+	void specs(std::vector<varspec>& vs, int kind);
+};
+
+}  // namespace FlatZinc
+
+#endif
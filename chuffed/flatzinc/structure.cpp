@@ -0,0 +1,544 @@
+#include "chuffed/flatzinc/structure.h"
+
+#include "chuffed/flatzinc/ast.h"
+#include "chuffed/flatzinc/flatzinc.h"
+#include "chuffed/support/misc.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+namespace {
+
+// Growing cliques stops after this many steps per edge of the graph
+const int64_t CLIQUE_BUDGET = 64;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if (a % b != 0 && ((a < 0) != (b < 0))) {
+		q--;
+	}
+	return q;
+}
+
+int64_t ceilDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if (a % b != 0 && ((a < 0) == (b < 0))) {
+		q++;
+	}
+	return q;
+}
+
+bool fitsInt(int64_t x) { return x >= INT_MIN && x <= INT_MAX; }
+
+/// Undirected graph whose edges are covered by cliques
+class Graph {
+public:
+	int addNode() {
+		adj.emplace_back();
+		return static_cast<int>(adj.size()) - 1;
+	}
+	void addEdge(int u, int v) {
+		adj[u].push_back(v);
+		adj[v].push_back(u);
+	}
+
+	static uint64_t edge(int u, int v) {
+		if (u > v) {
+			std::swap(u, v);
+		}
+		return (static_cast<uint64_t>(u) << 32) | static_cast<uint32_t>(v);
+	}
+
+	/// Cover the edges greedily with cliques, each grown from an uncovered edge by adding the
+	/// common neighbour of highest degree, and return those of at least three nodes
+	std::vector<std::vector<int>> cliques() {
+		const int n = adj.size();
+		int64_t budget = 0;
+		for (auto& a : adj) {
+			std::sort(a.begin(), a.end());
+			a.erase(std::unique(a.begin(), a.end()), a.end());
+			budget += a.size();
+		}
+		budget *= CLIQUE_BUDGET;
+		std::vector<int> order(n);
+		std::iota(order.begin(), order.end(), 0);
+		auto higher = [&](int u, int v) { return adj[u].size() > adj[v].size(); };
+		std::stable_sort(order.begin(), order.end(), higher);
+
+		std::unordered_set<uint64_t> covered;
+		std::vector<std::vector<int>> out;
+		for (const int u : order) {
+			for (const int v : adj[u]) {
+				if (budget <= 0) {
+					return out;
+				}
+				if (covered.count(edge(u, v)) != 0) {
+					continue;
+				}
+				std::vector<int> clique{u, v};
+				std::vector<int> cand;
+				std::set_intersection(adj[u].begin(), adj[u].end(), adj[v].begin(), adj[v].end(),
+															std::back_inserter(cand));
+				budget -= adj[u].size() + adj[v].size();
+				while (!cand.empty() && budget > 0) {
+					const int w = *std::min_element(cand.begin(), cand.end(), higher);
+					clique.push_back(w);
+					std::vector<int> next;
+					std::set_intersection(cand.begin(), cand.end(), adj[w].begin(), adj[w].end(),
+																std::back_inserter(next));
+					budget -= cand.size() + adj[w].size();
+					cand.swap(next);
+				}
+				for (size_t i = 0; i < clique.size(); i++) {
+					for (size_t j = i + 1; j < clique.size(); j++) {
+						covered.insert(edge(clique[i], clique[j]));
+					}
+				}
+				budget -= clique.size() * clique.size();
+				if (clique.size() >= 3) {
+					std::sort(clique.begin(), clique.end());
+					out.push_back(clique);
+				}
+			}
+		}
+		return out;
+	}
+
+	/// The edges within \a cliques
+	static std::unordered_set<uint64_t> edges(const std::vector<std::vector<int>>& cliques) {
+		std::unordered_set<uint64_t> out;
+		for (const auto& c : cliques) {
+			for (size_t i = 0; i < c.size(); i++) {
+				for (size_t j = i + 1; j < c.size(); j++) {
+					out.insert(edge(c[i], c[j]));
+				}
+			}
+		}
+		return out;
+	}
+
+private:
+	std::vector<std::vector<int>> adj;
+};
+
+class Detector {
+public:
+	Detector(ParserState& _pp, std::vector<std::pair<ConExpr*, AST::Node*>>& _items,
+					 FlatZincSpace::StructureStats& _stats)
+			: pp(_pp), items(_items), stats(_stats), dropped(_items.size(), false) {}
+
+	void run() {
+		allDifferent();
+		boolSums();
+		disjunctive();
+
+		size_t j = 0;
+		for (size_t k = 0; k < items.size(); k++) {
+			if (dropped[k]) {
+				delete items[k].first;
+				delete items[k].second;
+				stats.constraints++;
+			} else {
+				items[j++] = items[k];
+			}
+		}
+		items.resize(j);
+		for (auto* c : added) {
+			items.emplace_back(c, nullptr);
+		}
+	}
+
+private:
+	ParserState& pp;
+	std::vector<std::pair<ConExpr*, AST::Node*>>& items;
+	FlatZincSpace::StructureStats& stats;
+	std::vector<bool> dropped;
+	std::vector<ConExpr*> added;
+
+	/// The variable \a x is an alias of, or \a x itself
+	int intRep(int x) {
+		auto* s = static_cast<IntVarSpec*>(pp.intvars[x].second);
+		while (s->alias) {
+			x = s->i;
+			s = static_cast<IntVarSpec*>(pp.intvars[x].second);
+		}
+		return x;
+	}
+	int boolRep(int b) {
+		auto* s = static_cast<BoolVarSpec*>(pp.boolvars[b].second);
+		while (s->alias) {
+			b = s->i;
+			s = static_cast<BoolVarSpec*>(pp.boolvars[b].second);
+		}
+		return b;
+	}
+
+	static AST::Array* arrayArg(AST::Node* n, size_t size) {
+		auto* a = dynamic_cast<AST::Array*>(n);
+		return a != nullptr && a->a.size() == size ? a : nullptr;
+	}
+
+	//-----
+	// all_different
+
+	/// Whether \a c states x != y for two variables
+	bool notEqual(const ConExpr& c, int& x, int& y) {
+		const std::vector<AST::Node*>& a = c.args->a;
+		if (c.id == "int_ne" && a.size() == 2) {
+			if (!a[0]->isIntVar() || !a[1]->isIntVar()) {
+				return false;
+			}
+			x = a[0]->getIntVar();
+			y = a[1]->getIntVar();
+			return true;
+		}
+		if (c.id == "int_lin_ne" && a.size() == 3) {
+			AST::Array* as = arrayArg(a[0], 2);
+			AST::Array* xs = arrayArg(a[1], 2);
+			if (as == nullptr || xs == nullptr || !as->a[0]->isInt() || !as->a[1]->isInt() ||
+					as->a[0]->getInt() == 0 || as->a[0]->getInt() != -as->a[1]->getInt() ||
+					!xs->a[0]->isIntVar() || !xs->a[1]->isIntVar() || !a[2]->isInt() ||
+					a[2]->getInt() != 0) {
+				return false;
+			}
+			x = xs->a[0]->getIntVar();
+			y = xs->a[1]->getIntVar();
+			return true;
+		}
+		return false;
+	}
+
+	/// Replace the cliques of pairwise different variables by all_different constraints
+	void allDifferent() {
+		Graph g;
+		std::unordered_map<int, int> node;
+		std::vector<int> var;
+		std::vector<std::pair<size_t, uint64_t>> ne;
+		auto nodeOf = [&](int x) {
+			auto it = node.find(x);
+			if (it != node.end()) {
+				return it->second;
+			}
+			var.push_back(x);
+			return node[x] = g.addNode();
+		};
+		for (size_t k = 0; k < items.size(); k++) {
+			int x;
+			int y;
+			if (!notEqual(*items[k].first, x, y)) {
+				continue;
+			}
+			x = intRep(x);
+			y = intRep(y);
+			if (x == y) {
+				continue;
+			}
+			const int u = nodeOf(x);
+			const int v = nodeOf(y);
+			g.addEdge(u, v);
+			ne.emplace_back(k, Graph::edge(u, v));
+		}
+		const std::vector<std::vector<int>> cliques = g.cliques();
+		if (cliques.empty()) {
+			return;
+		}
+		for (const auto& c : cliques) {
+			auto* xs = new AST::Array();
+			for (const int u : c) {
+				xs->a.push_back(new AST::IntVar(var[u]));
+			}
+			auto* args = new AST::Array(1);
+			args->a[0] = xs;
+			added.push_back(new ConExpr("fzn_all_different_int", args));
+			stats.all_different++;
+		}
+		const std::unordered_set<uint64_t> grouped = Graph::edges(cliques);
+		for (const auto& e : ne) {
+			if (grouped.count(e.second) != 0) {
+				dropped[e.first] = true;
+			}
+		}
+	}
+
+	//-----
+	// Boolean sums
+
+	/// Rewrite the linear constraints over variables equal to bool2int of a Boolean, and with
+	/// equal coefficients, as Boolean sums
+	void boolSums() {
+		std::unordered_map<int, int> channel;
+		for (auto& item : items) {
+			const ConExpr& c = *item.first;
+			if (c.id == "bool2int" && c.args->a.size() == 2 && c[0]->isBoolVar() && c[1]->isIntVar()) {
+				channel.emplace(intRep(c[1]->getIntVar()), c[0]->getBoolVar());
+			}
+		}
+		if (channel.empty()) {
+			return;
+		}
+		for (size_t k = 0; k < items.size(); k++) {
+			ConExpr& c = *items[k].first;
+			if ((c.id != "int_lin_le" && c.id != "int_lin_eq") || c.args->a.size() != 3 ||
+					!c[2]->isInt()) {
+				continue;
+			}
+			auto* as = dynamic_cast<AST::Array*>(c[0]);
+			auto* xs = dynamic_cast<AST::Array*>(c[1]);
+			if (as == nullptr || xs == nullptr || as->a.size() != xs->a.size()) {
+				continue;
+			}
+			int64_t coef = 0;
+			int64_t rhs = c[2]->getInt();
+			std::vector<int> bs;
+			std::unordered_set<int> seen;
+			bool ok = true;
+			for (size_t i = 0; i < as->a.size() && ok; i++) {
+				if (!as->a[i]->isInt()) {
+					ok = false;
+					break;
+				}
+				const int64_t a = as->a[i]->getInt();
+				if (xs->a[i]->isInt()) {
+					rhs -= a * xs->a[i]->getInt();
+					continue;
+				}
+				if (a == 0) {
+					continue;
+				}
+				if (!xs->a[i]->isIntVar()) {
+					ok = false;
+					break;
+				}
+				const int x = intRep(xs->a[i]->getIntVar());
+				auto it = channel.find(x);
+				ok = it != channel.end() && seen.insert(x).second && (coef == 0 || a == coef);
+				coef = a;
+				if (ok) {
+					bs.push_back(it->second);
+				}
+			}
+			if (!ok || bs.size() < 2) {
+				continue;
+			}
+			// sum(coef * b) <= rhs, or = rhs
+			int64_t bound;
+			const char* id;
+			if (c.id == "int_lin_eq") {
+				if (rhs % coef != 0) {
+					continue;
+				}
+				bound = rhs / coef;
+				id = "bool_sum_eq";
+			} else if (coef > 0) {
+				bound = floorDiv(rhs, coef);
+				id = "bool_sum_le";
+			} else {
+				bound = ceilDiv(rhs, coef);
+				id = "bool_sum_ge";
+			}
+			if (!fitsInt(bound)) {
+				continue;
+			}
+			auto* bv = new AST::Array();
+			for (const int b : bs) {
+				bv->a.push_back(new AST::BoolVar(b));
+			}
+			delete c.args;
+			c.args = new AST::Array(2);
+			c.args->a[0] = bv;
+			c.args->a[1] = new AST::IntLit(static_cast<int>(bound));
+			c.id = id;
+			stats.bool_sums++;
+		}
+	}
+
+	//-----
+	// disjunctive
+
+	/// The precedence before + d <= after
+	struct Precedence {
+		size_t item;
+		int before;
+		int after;
+		int d;
+	};
+
+	/// Whether \a c is b <-> (x + d <= y) for some d > 0
+	bool precedence(const ConExpr& c, int& b, Precedence& p) {
+		const std::vector<AST::Node*>& a = c.args->a;
+		if (c.id != "int_lin_le_reif" || a.size() != 4 || !a[2]->isInt() || !a[3]->isBoolVar()) {
+			return false;
+		}
+		AST::Array* as = arrayArg(a[0], 2);
+		AST::Array* xs = arrayArg(a[1], 2);
+		if (as == nullptr || xs == nullptr || !as->a[0]->isInt() || !as->a[1]->isInt() ||
+				!xs->a[0]->isIntVar() || !xs->a[1]->isIntVar()) {
+			return false;
+		}
+		const int a0 = as->a[0]->getInt();
+		if ((a0 != 1 && a0 != -1) || as->a[1]->getInt() != -a0) {
+			return false;
+		}
+		const int x = intRep(xs->a[0]->getIntVar());
+		const int y = intRep(xs->a[1]->getIntVar());
+		const int64_t d = -static_cast<int64_t>(a[2]->getInt());
+		if (x == y || d <= 0 || !fitsInt(d)) {
+			return false;
+		}
+		b = boolRep(a[3]->getBoolVar());
+		p.before = a0 == 1 ? x : y;
+		p.after = a0 == 1 ? y : x;
+		p.d = static_cast<int>(d);
+		return true;
+	}
+
+	/// Whether \a c states b1 \/ b2 for two Boolean variables
+	bool disjunction(const ConExpr& c, int& b1, int& b2) {
+		const std::vector<AST::Node*>& a = c.args->a;
+		AST::Array* bs = nullptr;
+		if (c.id == "bool_clause" && a.size() == 2) {
+			AST::Array* neg = arrayArg(a[1], 0);
+			bs = neg != nullptr ? arrayArg(a[0], 2) : nullptr;
+		} else if (c.id == "array_bool_or" && a.size() == 2 && a[1]->isBool() && a[1]->getBool()) {
+			bs = arrayArg(a[0], 2);
+		} else if (c.id == "bool_or" && a.size() == 3 && a[2]->isBool() && a[2]->getBool()) {
+			if (!a[0]->isBoolVar() || !a[1]->isBoolVar()) {
+				return false;
+			}
+			b1 = boolRep(a[0]->getBoolVar());
+			b2 = boolRep(a[1]->getBoolVar());
+			return true;
+		}
+		if (bs == nullptr || !bs->a[0]->isBoolVar() || !bs->a[1]->isBoolVar()) {
+			return false;
+		}
+		b1 = boolRep(bs->a[0]->getBoolVar());
+		b2 = boolRep(bs->a[1]->getBoolVar());
+		return true;
+	}
+
+	void countBools(AST::Node* n, std::vector<int>& uses) {
+		if (auto* a = dynamic_cast<AST::Array*>(n)) {
+			for (auto* e : a->a) {
+				countBools(e, uses);
+			}
+		} else if (auto* b = dynamic_cast<AST::BoolVar*>(n)) {
+			uses[boolRep(b->i)]++;
+		}
+	}
+
+	/// Post a disjunctive constraint over each clique of tasks that pairwise must not overlap.
+	/// The propagator makes its own precedence literals, so the pairs whose literals are used
+	/// nowhere else are taken out.
+	void disjunctive() {
+		std::unordered_map<int, Precedence> precs;
+		for (size_t k = 0; k < items.size(); k++) {
+			int b;
+			Precedence p;
+			if (!dropped[k] && precedence(*items[k].first, b, p)) {
+				p.item = k;
+				precs.emplace(b, p);
+			}
+		}
+		if (precs.size() < 2) {
+			return;
+		}
+
+		Graph g;
+		std::unordered_map<uint64_t, int> task;
+		std::vector<int> start;
+		std::vector<int> dur;
+		auto taskOf = [&](int x, int d) {
+			const uint64_t key = (static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(d);
+			auto it = task.find(key);
+			if (it != task.end()) {
+				return it->second;
+			}
+			start.push_back(x);
+			dur.push_back(d);
+			return task[key] = g.addNode();
+		};
+		struct Pair {
+			size_t clause;
+			const Precedence* p;
+			const Precedence* q;
+			int b1;
+			int b2;
+		};
+		std::unordered_map<uint64_t, Pair> pairs;
+		for (size_t k = 0; k < items.size(); k++) {
+			int b1;
+			int b2;
+			if (dropped[k] || !disjunction(*items[k].first, b1, b2) || b1 == b2) {
+				continue;
+			}
+			auto p = precs.find(b1);
+			auto q = precs.find(b2);
+			if (p == precs.end() || q == precs.end() || p->second.before != q->second.after ||
+					p->second.after != q->second.before) {
+				continue;
+			}
+			const int u = taskOf(p->second.before, p->second.d);
+			const int v = taskOf(q->second.before, q->second.d);
+			g.addEdge(u, v);
+			pairs.emplace(Graph::edge(u, v), Pair{k, &p->second, &q->second, b1, b2});
+		}
+		const std::vector<std::vector<int>> cliques = g.cliques();
+		if (cliques.empty()) {
+			return;
+		}
+		for (const auto& c : cliques) {
+			auto* xs = new AST::Array();
+			auto* ds = new AST::Array();
+			for (const int u : c) {
+				xs->a.push_back(new AST::IntVar(start[u]));
+				ds->a.push_back(new AST::IntLit(dur[u]));
+			}
+			auto* args = new AST::Array(2);
+			args->a[0] = xs;
+			args->a[1] = ds;
+			added.push_back(new ConExpr("chuffed_disjunctive_strict", args));
+			stats.disjunctive++;
+		}
+
+		std::vector<int> uses(pp.boolvars.size(), 0);
+		for (auto& item : items) {
+			countBools(item.first->args, uses);
+		}
+		auto unused = [&](int b) {
+			return uses[b] == 2 && !static_cast<BoolVarSpec*>(pp.boolvars[b].second)->output;
+		};
+		for (const uint64_t e : Graph::edges(cliques)) {
+			auto it = pairs.find(e);
+			if (it == pairs.end()) {
+				continue;
+			}
+			const Pair& pr = it->second;
+			if (unused(pr.b1) && unused(pr.b2)) {
+				dropped[pr.clause] = true;
+				dropped[pr.p->item] = true;
+				dropped[pr.q->item] = true;
+			}
+		}
+	}
+};
+
+}  // namespace
+
+void detectGlobals(ParserState& pp, std::vector<std::pair<ConExpr*, AST::Node*>>& items,
+									 FlatZincSpace::StructureStats& stats) {
+	const time_point start = chuffed_clock::now();
+	Detector(pp, items, stats).run();
+	stats.time = chuffed_clock::now() - start;
+}
+
+}  // namespace FlatZinc
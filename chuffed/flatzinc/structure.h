@@ -0,0 +1,26 @@
+#ifndef FLATZINC_STRUCTURE_H
+#define FLATZINC_STRUCTURE_H
+// Detection of global constraints in a decomposed FlatZinc model, enabled by --detect-globals.
+//
+// Models flattened without the chuffed globals often state with many small constraints what one
+// global propagator does better. Once every constraint item has been read (and presolved, if
+// asked for), this pass finds three such patterns:
+//  - cliques of pairwise int_ne, which are replaced by one all_different;
+//  - linear constraints with equal coefficients over variables channelled from Booleans by
+//    bool2int, which become Boolean sums;
+//  - cliques of tasks that pairwise must not overlap, written as a disjunction of two reified
+//    precedences, which get a redundant disjunctive constraint.
+#include "chuffed/flatzinc/flatzinc.h"
+
+#include <utility>
+#include <vector>
+
+namespace FlatZinc {
+
+/// Replace or strengthen the constraint items in \a items with the globals found among them
+void detectGlobals(ParserState& pp, std::vector<std::pair<ConExpr*, AST::Node*>>& items,
+									 FlatZincSpace::StructureStats& stats);
+
+}  // namespace FlatZinc
+
+#endif
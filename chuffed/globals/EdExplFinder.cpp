@@ -14,7 +14,6 @@
 #include <cstdlib>
 #include <iostream>
 #include <queue>
-#include <set>
 #include <utility>
 #include <vector>
 
@@ -168,11 +167,12 @@ void EdExplFinder::bfs_shortest_path() {
 	(*shortestPathMatrix)[matrixCoord(seqSize, seqSize)] = 0;
 
 	auto* nodeQueue = new std::queue<std::pair<int, int> >();
-	std::set<std::pair<int, int> > node_set;
+	// positions currently in the queue
+	std::vector<bool> queued(static_cast<size_t>((seqSize + 1) * (seqSize + 1)), false);
 	// start with bottom right position
 	const std::pair<int, int> start_node = std::pair<int, int>(seqSize, seqSize);
 	nodeQueue->push(start_node);
-	node_set.insert(start_node);
+	queued[matrixCoord(seqSize, seqSize)] = true;
 
 	// d = distance to diagonal that should be calculated in the matrix
 	const int d = lb / min_id_cost;
@@ -180,10 +180,10 @@ void EdExplFinder::bfs_shortest_path() {
 	while (!nodeQueue->empty()) {
 		const std::pair<int, int> currentNode = nodeQueue->front();
 		nodeQueue->pop();
-		node_set.erase(currentNode);
 
 		const int i = currentNode.first;
 		const int j = currentNode.second;
+		queued[matrixCoord(i, j)] = false;
 
 		const int s_ij = (*shortestPathMatrix)[matrixCoord(i, j)];
 
@@ -216,10 +216,9 @@ void EdExplFinder::bfs_shortest_path() {
 					const int s_ij_minus_1 = (*shortestPathMatrix)[matrixCoord(i, j - 1)];
 					(*shortestPathMatrix)[matrixCoord(i, j - 1)] = std::min(s_ij_minus_1, s_ij + ins_cost);
 
-					const std::pair<int, int> node = std::pair<int, int>(i, j - 1);
-					if (node_set.count(node) == 0) {
-						nodeQueue->push(node);
-						node_set.insert(node);
+					if (!queued[matrixCoord(i, j - 1)]) {
+						nodeQueue->push(std::pair<int, int>(i, j - 1));
+						queued[matrixCoord(i, j - 1)] = true;
 					}
 				}
 			}
@@ -250,10 +249,9 @@ void EdExplFinder::bfs_shortest_path() {
 					const int s_i_minus_1_j = (*shortestPathMatrix)[matrixCoord(i - 1, j)];
 					(*shortestPathMatrix)[matrixCoord(i - 1, j)] = std::min(s_i_minus_1_j, s_ij + del_cost);
 
-					const std::pair<int, int> node = std::pair<int, int>(i - 1, j);
-					if (node_set.count(node) == 0) {
-						nodeQueue->push(node);
-						node_set.insert(node);
+					if (!queued[matrixCoord(i - 1, j)]) {
+						nodeQueue->push(std::pair<int, int>(i - 1, j));
+						queued[matrixCoord(i - 1, j)] = true;
 					}
 				}
 			}
@@ -282,10 +280,9 @@ void EdExplFinder::bfs_shortest_path() {
 						(*shortestPathMatrix)[matrixCoord(i - 1, j - 1)] =
 								std::min(s_i_minus_1_j_minus_1, s_ij + subst_cost);
 
-						const std::pair<int, int> node = std::pair<int, int>(i - 1, j - 1);
-						if (node_set.count(node) == 0) {
-							nodeQueue->push(node);
-							node_set.insert(node);
+						if (!queued[matrixCoord(i - 1, j - 1)]) {
+							nodeQueue->push(std::pair<int, int>(i - 1, j - 1));
+							queued[matrixCoord(i - 1, j - 1)] = true;
 						}
 					}
 				}
@@ -431,7 +431,6 @@ bool BoundedPathPropagator::falseOrFail(int e, Clause*& r) {
 	if (!getEdgeVar(e).isFixed()) {
 		if (so.lazy) {
 			std::vector<Lit> lits;
-			lits.emplace_back();
 			backward_sp_tmp->set_source(tl);
 			backward_sp_tmp->run();
 			explain_sp->reset(w->getMax() - backward_sp->distTo(hd) - ws[e], backward_sp_tmp, lits);
@@ -698,7 +697,7 @@ bool BoundedPathPropagator::propagate() {
 bool BoundedPathPropagator::propagate_dijkstra() {
 	Clause* r = nullptr;
 
-	backward_sp->run();
+	backward_sp->refresh();
 
 	if (backward_sp->distTo(source) > w->getMax()) {
 		if (so.lazy) {
@@ -722,7 +721,7 @@ bool BoundedPathPropagator::propagate_dijkstra() {
 		// The path propagator must run before!
 	}
 	// return true;
-	forward_sp->run();
+	forward_sp->refresh();
 
 	int max_d = 0;     // Distance to furthest in-node
 	int arg_max = -1;  // Furthest in-node
@@ -738,10 +737,10 @@ bool BoundedPathPropagator::propagate_dijkstra() {
 #endif
 		if (recompute) {
 			if (prev_node != -1 && !forward_sp->is_leaf(prev_node)) {
-				forward_sp->run();
+				forward_sp->refresh();
 			}
 			if (prev_node != -1 && !backward_sp->is_leaf(prev_node)) {
-				backward_sp->run();
+				backward_sp->refresh();
 			}
 			recompute = false;
 		}
@@ -753,7 +752,6 @@ bool BoundedPathPropagator::propagate_dijkstra() {
 			if (!getNodeVar(u).isFixed()) {
 				if (so.lazy) {
 					std::vector<Lit> lits;
-					lits.emplace_back();
 					backward_sp_tmp->set_source(u);
 					backward_sp_tmp->run();
 					explain_sp->reset(w->getMax(), backward_sp_tmp, lits);
@@ -789,7 +787,6 @@ bool BoundedPathPropagator::propagate_dijkstra() {
 			if (!getNodeVar(u).isFixed()) {
 				if (so.lazy) {
 					std::vector<Lit> lits;
-					lits.emplace_back();
 					explain_sp->set_source(u);
 					explain_sp->reset(w->getMax(), backward_sp, lits);
 					explain_sp->set_explaining(dest);
@@ -833,7 +830,6 @@ bool BoundedPathPropagator::propagate_dijkstra() {
 					r = ReasonNew(prop_expl);
 #else
 					std::vector<Lit> lits;
-					lits.emplace_back();
 					backward_sp_tmp->set_source(u);
 					backward_sp_tmp->run();
 					explain_sp->reset(w->getMax() - backward_sp->distTo(u), backward_sp_tmp, lits);
@@ -76,6 +76,22 @@ class BoundedPathPropagator : public GraphPropagator {
 				Dijkstra::enqueue(node);
 			}
 		}
+
+		// Repair the distances of the last search, unless backtracking has undone part of the
+		// domains it saw since, then search again
+		void refresh() {
+			if (stamp == searches) {
+				update();
+			} else {
+				run();
+			}
+			stamp = ++searches;
+		}
+
+	private:
+		// Equal while no stamp given since the last search has been undone
+		Tint stamp{0};
+		int searches{0};
 	};
 	FilteredDijkstra* forward_sp;
 	FilteredDijkstra* backward_sp;
@@ -18,6 +18,8 @@
 DAGPropagator::DAGPropagator(int _r, vec<BoolView>& _vs, vec<BoolView>& _es,
 														 vec<vec<edge_id> >& _in, vec<vec<edge_id> >& _out, vec<vec<int> >& _en)
 		: DReachabilityPropagator(_r, _vs, _es, _in, _out, _en) {
+	processed_e.resize(nbEdges());
+	processed_n.resize(nbNodes());
 	if (!getNodeVar(get_root_idx()).isFixed()) {
 		getNodeVar(get_root_idx()).setVal(true);
 	}
@@ -109,7 +111,7 @@ bool DAGPropagator::propagateNewEdge(int e) {
 
 	TrailedSuccList::const_iterator succ_taile = succs[getTail(e)].end();
 	connectTo(getTail(e), getHead(e));
-	processed_e[e] = true;
+	processed_e.mark(e);
 
 	// Only checking the new ones
 	for (; succ_taile != succs[getTail(e)].end(); succ_taile++) {
@@ -152,7 +154,7 @@ bool DAGPropagator::propagateNewNode(int n) {
 		prevent_cycle(i);
 	}
 
-	processed_n[n] = true;
+	processed_n.mark(n);
 	return true;
 }
 
@@ -271,8 +273,8 @@ bool DAGPropagator::prevent_cycle(int e) {
 }
 
 bool DAGPropagator::propagate() {
-	processed_e = std::vector<bool>(nbEdges(), false);
-	processed_n = std::vector<bool>(nbNodes(), false);
+	processed_e.clear();
+	processed_n.clear();
 
 	if (!DReachabilityPropagator::propagate()) {
 		return false;
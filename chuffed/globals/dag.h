@@ -67,8 +67,8 @@ class DAGPropagator : public DReachabilityPropagator {
 		//            & (1 << sizeof(int) - (dest % sizeof(int)));
 	}
 
-	std::vector<bool> processed_e;
-	std::vector<bool> processed_n;
+	EpochMarks processed_e;
+	EpochMarks processed_n;
 
 	void findPathFromTo(int u, int v, vec<Lit>& path);
 
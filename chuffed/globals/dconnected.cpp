@@ -11,7 +11,9 @@
 #include "chuffed/vars/bool-view.h"
 #include "chuffed/vars/vars.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -39,16 +41,15 @@ void FilteredLT::init() {
 	LengauerTarjan::init();
 }
 
-void FilteredLT::DFS(int r) {
+void FilteredLT::visit(int v) {
 	if (DEBUG) {
-		std::cout << "DFS Visiting " << r << " " << p->getNodeVar(r).isFixed()
-							<< ((p->getNodeVar(r).isFixed()) ? static_cast<int>(p->getNodeVar(r).isTrue()) : -1)
+		std::cout << "DFS Visiting " << v << " " << p->getNodeVar(v).isFixed()
+							<< ((p->getNodeVar(v).isFixed()) ? static_cast<int>(p->getNodeVar(v).isTrue()) : -1)
 							<< '\n';
 	}
-	if (p->getNodeVar(r).isFixed() && p->getNodeVar(r).isTrue()) {
+	if (p->getNodeVar(v).isFixed() && p->getNodeVar(v).isTrue()) {
 		visited_innodes++;
 	}
-	LengauerTarjan::DFS(r);
 }
 
 bool FilteredLT::ignore_node(int u) {
@@ -65,6 +66,68 @@ bool FilteredLT::ignore_edge(int e) {
 	return false;
 }
 
+bool FilteredLT::is_live(int e) {
+	return !ignore_edge(e) && !ignore_node(en[e][0]) && !ignore_node(en[e][1]);
+}
+
+// Can removing e change the dominators? The DFS tree stays the same unless e is a tree edge,
+// and then only the semidominator of the head of e can change, which happens only if e gave
+// its minimum. Walking the tree for that costs budget, a recomputation is cheaper when it
+// runs out.
+bool FilteredLT::affects(int e, int& budget) {
+	const int x = en[e][0];
+	const int y = en[e][1];
+	if (x == y || !visited_dfs(x) || y == root) {
+		return false;
+	}
+	if (parent[y] == x) {
+		return true;
+	}
+	int c = pre[x];
+	if (pre[x] > pre[y]) {
+		for (int u = x; pre[u] > pre[y]; u = parent[u]) {
+			c = std::min(c, semi[u]);
+			if (--budget < 0) {
+				return true;
+			}
+		}
+	}
+	return c <= semi[y];
+}
+
+void FilteredLT::update() {
+	const int m = static_cast<int>(en.size());
+	if (computed) {
+		int budget = static_cast<int>(in.size()) + m;
+		bool recompute = false;
+		for (int e = 0; e < m && !recompute; e++) {
+			const bool l = is_live(e);
+			if (l == live[e]) {
+				continue;
+			}
+			// Edges only come back on backtracking, which can remove dominators
+			if (l || affects(e, budget)) {
+				recompute = true;
+			} else {
+				live[e] = false;
+			}
+		}
+		if (!recompute) {
+			kept++;
+			return;
+		}
+	}
+	init();
+	LengauerTarjan::DFS();
+	find_doms();
+	live.resize(m);
+	for (int e = 0; e < m; e++) {
+		live[e] = is_live(e);
+	}
+	computed = true;
+	recomputations++;
+}
+
 bool DReachabilityPropagator::correctDominator(int r, std::vector<bool>& v, int avoid) {
 	if (r == avoid) {
 		return true;
@@ -344,6 +407,11 @@ DReachabilityPropagator::DReachabilityPropagator(int _r, vec<BoolView>& _vs, vec
 		}
 	}
 
+	in_arcs.build(in, endnodes);
+	red.resize(nbNodes());
+	rev_seen.resize(nbNodes());
+	no_side.resize(nbNodes());
+
 	nodes2edge = std::vector<std::vector<int> >(nbNodes());
 	for (int i = 0; i < nbNodes(); i++) {
 		nodes2edge[i] = std::vector<int>(nbNodes(), -1);
@@ -545,6 +613,11 @@ void DReachabilityPropagator::clearPropState() {
 	rem_edge.clear();
 }
 
+void DReachabilityPropagator::printStats() {
+	printf("%%%%%%mzn-stat: dominatorRecomputations=%lld\n", lt->recomputations);
+	printf("%%%%%%mzn-stat: dominatorUpdatesKept=%lld\n", lt->kept);
+}
+
 bool DReachabilityPropagator::propagateRemEdge(int e) {
 	assert(getEdgeVar(e).isFixed());
 	assert(getEdgeVar(e).isFalse());
@@ -604,9 +677,13 @@ bool DReachabilityPropagator::propagateRemNode(int node) {
 bool DReachabilityPropagator::_propagateReachability(bool local) {
 	update_innodes();
 	// cout <<"PROPAGATE REACHABILITY"<<endl;
-	lt->init();
-	lt->LengauerTarjan::DFS();
-	const int reached = lt->get_visited_innodes();
+	lt->update();
+	int reached = 0;
+	for (const int i : in_nodes_list) {
+		if (lt->visited_dfs(i)) {
+			reached++;
+		}
+	}
 	if (DEBUG) {
 		std::cout << "Reached " << reached << " in_nodes_tsize " << in_nodes_tsize
 							<< " in_nodes.size() " << in_nodes_list.size() << '\n';
@@ -626,9 +703,8 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 			psfail.push(getNodeVar(get_root_idx()).getValLit());
 			assert(getNodeVar(some_node).isFixed() && getNodeVar(some_node).isTrue());
 			psfail.push(getNodeVar(some_node).getValLit());
-			std::vector<bool> v(nbNodes(), false);
-			std::vector<bool> falsev(nbNodes(), false);
-			reverseDFStoBorder(some_node, v, falsev, psfail);
+			rev_seen.clear();
+			reverseDFStoBorder(some_node, rev_seen, no_side, psfail);
 			if (DEBUG) {
 				std::cout << "Expl size: " << psfail.size() << '\n';
 			}
@@ -647,9 +723,8 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 				vec<Lit> ps;
 				ps.push();
 				ps.push(getNodeVar(get_root_idx()).getValLit());
-				std::vector<bool> v(nbNodes(), false);
-				std::vector<bool> falsev(nbNodes(), false);
-				reverseDFStoBorder(i, v, falsev, ps);
+				rev_seen.clear();
+				reverseDFStoBorder(i, rev_seen, no_side, ps);
 				r = Reason_new(ps);
 			}
 			getNodeVar(i).setVal(false, r);
@@ -662,12 +737,13 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 		}
 	}  //*/
 
-	lt->find_doms();
 	// for (int i = 0; i < nbNodes(); i++)
 	//     cerr <<"("<<i <<","<< lt->dominator(i)<<") ";
 	// cerr<<endl;
 
-	for (const int u : in_nodes_list) {
+	// Dominators added below are appended to in_nodes_list
+	for (int k = 0; k < in_nodes_list.size(); k++) {
+		const int u = in_nodes_list[k];
 		assert(getNodeVar(u).isFixed());
 		assert(getNodeVar(u).isTrue());
 		if (DEBUG) {
@@ -682,6 +758,7 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 			continue;
 		}
 
+#ifndef NDEBUG
 		std::vector<bool> visited = std::vector<bool>(nbNodes(), false);
 		if (DEBUG) {
 			std::cout << "STARTING DFS (avoid " << dom_u << ")" << '\n';
@@ -704,6 +781,7 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 			std::cout << dom_u << " " << u << " " << get_root_idx() << '\n';
 		}
 		assert(!visited[u]);
+#endif
 
 		Clause* r = nullptr;
 
@@ -775,45 +853,41 @@ bool DReachabilityPropagator::_propagateReachability(bool local) {
 
 bool DReachabilityPropagator::propagateReachability() { return _propagateReachability(false); }
 
-void DReachabilityPropagator::reverseDFS(int u, std::vector<bool>& v, int skip_n) {
+void DReachabilityPropagator::reverseDFS(int u, EpochMarks& v, int skip_n) {
 	if (DEBUG) {
 		std::cout << "Reverse DFS from " << u << '\n';
 	}
-	v[u] = true;
-	for (const int ie : in[u]) {
-		if (getEdgeVar(ie).isFixed() && getEdgeVar(ie).isFalse()) {
-			continue;
-		}
-		const int o = getTail(ie);
-		if (o == skip_n || v[o]) {
-			continue;
-		}
-		reverseDFS(o, v, skip_n);
-	}
+	graph_dfs(
+			in_arcs, u, v, search_stack,
+			[&](int /*w*/, const CSRGraph::Arc& a) {
+				if (getEdgeVar(a.edge).isFixed() && getEdgeVar(a.edge).isFalse()) {
+					return false;
+				}
+				return a.node != skip_n;
+			},
+			[](int /*w*/) {});
 }
 
-void DReachabilityPropagator::reverseDFStoBorder(int u, std::vector<bool>& v,
-																								 std::vector<bool>& my_side, vec<Lit>& expl,
-																								 int skip_n) {
+void DReachabilityPropagator::reverseDFStoBorder(int u, EpochMarks& v, EpochMarks& my_side,
+																								 vec<Lit>& expl, int skip_n) {
 	if (DEBUG) {
 		std::cout << "Reverse DFS to border from " << u << '\n';
 	}
-	v[u] = true;
-	for (const int ie : in[u]) {
-		if (getEdgeVar(ie).isFixed() && getEdgeVar(ie).isFalse() && lt->visited_dfs(getTail(ie)) &&
-				!my_side[getTail(ie)]) {
-			expl.push(getEdgeVar(ie).getValLit());
-			if (DEBUG) {
-				std::cout << "Added to explanation for dom/bridge edge:" << ie << '\n';
-			}
-		} else {
-			const int o = getTail(ie);
-			if (o == skip_n || v[o]) {
-				continue;
-			}
-			reverseDFStoBorder(o, v, my_side, expl, skip_n);
-		}
-	}
+	graph_dfs(
+			in_arcs, u, v, search_stack,
+			[&](int /*w*/, const CSRGraph::Arc& a) {
+				const int ie = a.edge;
+				if (getEdgeVar(ie).isFixed() && getEdgeVar(ie).isFalse() && lt->visited_dfs(a.node) &&
+						!my_side[a.node]) {
+					expl.push(getEdgeVar(ie).getValLit());
+					if (DEBUG) {
+						std::cout << "Added to explanation for dom/bridge edge:" << ie << '\n';
+					}
+					return false;
+				}
+				return a.node != skip_n;
+			},
+			[](int /*w*/) {});
 }
 
 void DReachabilityPropagator::explain_dominator(int u, int dom, Clause** r) {
@@ -827,10 +901,10 @@ void DReachabilityPropagator::explain_dominator(int u, int dom, Clause** r) {
 	if (getNodeVar(u).isFixed() && getNodeVar(u).isTrue()) {
 		ps.push(getNodeVar(u).getValLit());
 	}
-	std::vector<bool> red(nbNodes(), false);
+	red.clear();
 	reverseDFS(u, red, dom);
-	std::vector<bool> v(nbNodes(), false);
-	reverseDFStoBorder(u, v, red, ps, dom);
+	rev_seen.clear();
+	reverseDFStoBorder(u, rev_seen, red, ps, dom);
 	if (DEBUG) {
 		std::cout << "Size expl for dominator " << ps.size() << '\n';
 	}
@@ -847,10 +921,10 @@ void DReachabilityPropagator::explain_dominator(int u, int dom, vec<Lit>& ps) {
 	if (getNodeVar(u).isFixed() && getNodeVar(u).isTrue()) {
 		ps.push(getNodeVar(u).getValLit());
 	}
-	std::vector<bool> red(nbNodes(), false);
+	red.clear();
 	reverseDFS(u, red, dom);
-	std::vector<bool> v(nbNodes(), false);
-	reverseDFStoBorder(u, v, red, ps, dom);
+	rev_seen.clear();
+	reverseDFStoBorder(u, rev_seen, red, ps, dom);
 	if (DEBUG) {
 		std::cout << "Size expl for dominator " << ps.size() << '\n';
 	}
@@ -16,16 +16,29 @@ class FilteredLT : public LengauerTarjan {
 	GraphPropagator* p;
 	int visited_innodes{0};
 
+	// Edges that were present when the dominators were last computed. Removing edges can only
+	// add dominators, and most removals change none; these are detected without recomputing.
+	std::vector<bool> live;
+	bool computed{false};
+
+	bool is_live(int e);
+	bool affects(int e, int& budget);
+
 protected:
-	void DFS(int r) override;
+	void visit(int v) override;
 
 public:
+	long long recomputations{0};
+	long long kept{0};
+
 	FilteredLT(GraphPropagator* _p, int _r, std::vector<std::vector<int> > _en,
 						 std::vector<std::vector<int> > _in, std::vector<std::vector<int> > _ou);
 	int get_visited_innodes() const;
 	void init() override;
 	bool ignore_node(int u) override;
 	bool ignore_edge(int e) override;
+	// Bring the reachability and dominators up to date with the current domains
+	void update();
 };
 
 class DReachabilityPropagator : public GraphPropagator {
@@ -55,6 +68,12 @@ protected:
 
 	std::vector<std::vector<edge_id> > in;
 	std::vector<std::vector<edge_id> > ou;
+	// in as arcs to the tails, and the marks of the reverse searches done by the explanations
+	CSRGraph in_arcs;
+	EpochMarks red;
+	EpochMarks rev_seen;
+	EpochMarks no_side;  // Never marked
+	std::vector<int> search_stack;
 
 	int get_some_innode_not(int other_than);
 	int get_root_idx() const;
@@ -71,6 +90,7 @@ public:
 	void wakeup(int i, int c) override;
 	bool propagate() override;
 	void clearPropState() override;
+	void printStats() override;
 
 	virtual bool propagateNewEdge(int edge);
 	virtual bool propagateRemEdge(int edge);
@@ -84,8 +104,8 @@ public:
 	FilteredLT* getDominatorsAlgorithm() { return lt; }
 	void explain_dominator(int u, int dom, Clause** r);
 	void explain_dominator(int u, int dom, vec<Lit>& ps);
-	void reverseDFS(int u, std::vector<bool>& v, int skip_n = -1);
-	void reverseDFStoBorder(int u, std::vector<bool>& v, std::vector<bool>& my_side, vec<Lit>& expl,
+	void reverseDFS(int u, EpochMarks& v, int skip_n = -1);
+	void reverseDFStoBorder(int u, EpochMarks& v, EpochMarks& my_side, vec<Lit>& expl,
 													int skip_n = -1);
 
 	virtual inline int findEdge(int u, int v) {
@@ -26,6 +26,8 @@ DTreePropagator::DTreePropagator(int _r, vec<BoolView>& _vs, vec<BoolView>& _es,
 																 vec<vec<int> >& _en)
 		: DReachabilityPropagator(_r, _vs, _es, _in, _out, _en), uf(nbNodes()), ruf(nbNodes()) {
 	priority = 1;
+	processed_e.resize(nbEdges());
+	processed_n.resize(nbNodes());
 
 	for (const int e : in[get_root_idx()]) {
 		if (getEdgeVar(e).setValNotR(false)) {
@@ -93,7 +95,7 @@ bool DTreePropagator::propagateNewEdge(int e) {
 		}
 	}
 
-	processed_e[e] = true;
+	processed_e.mark(e);
 	/*
 	int tl = getTail(e);
 	for (int i = 0; i < ou[tl].size(); i++) {
@@ -164,7 +166,7 @@ bool DTreePropagator::propagateNewNode(int n) {
 		prevent_cycle(i);
 	}
 
-	processed_n[n] = true;
+	processed_n.mark(n);
 
 	return true;
 }
@@ -226,8 +228,8 @@ void DTreePropagator::prevent_cycle(int e) {
 }
 
 bool DTreePropagator::propagate() {
-	processed_n = std::vector<bool>(nbNodes(), false);
-	processed_e = std::vector<bool>(nbEdges(), false);
+	processed_n.clear();
+	processed_e.clear();
 	if (!DReachabilityPropagator::propagate()) {
 		return false;
 	}
@@ -241,7 +243,7 @@ bool DTreePropagator::propagate() {
 			if (!propagateNewEdge(*it)) {
 				return false;
 			}
-			processed_e[*it] = true;
+			processed_e.mark(*it);
 			last_state_e[*it] = VT_IN;
 		}
 	}
@@ -251,7 +253,7 @@ bool DTreePropagator::propagate() {
 			if (!propagateNewNode(*it)) {
 				return false;
 			}
-			processed_n[*it] = true;
+			processed_n.mark(*it);
 			last_state_n[*it] = VT_IN;
 		}
 	}
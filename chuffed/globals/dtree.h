@@ -10,8 +10,8 @@ class DTreePropagator : public DReachabilityPropagator {
 	UF<Tint> uf;
 	RerootedUnionFind<Tint> ruf;
 
-	std::vector<bool> processed_e;
-	std::vector<bool> processed_n;
+	EpochMarks processed_e;
+	EpochMarks processed_n;
 
 	void explain_cycle(int u, int v, vec<Lit>& path);
 
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cstdint>
 #include <cstdio>
 #include <iostream>
 
@@ -31,6 +32,9 @@ public:
 	int max_id_cost;
 	// minimum cost of any insertion/deletion operation
 	int min_id_cost;
+	// cost of every insertion, deletion and substitution of a different character, if they are all
+	// equal and substituting a character by itself is free, 0 otherwise
+	int uniform_cost;
 
 	vec<int> insertion_cost;
 	vec<int> deletion_cost;
@@ -62,7 +66,11 @@ public:
 				seq2(_seq2.release()),
 				ed(_ed),
 				dpMatrix(vec<int>((seqSize + 1) * (seqSize + 1))),
-				cellHasChanged(vec<int>(seqSize * 2)) {
+				cellHasChanged(vec<int>(seqSize * 2)),
+				nbWords((seqSize + 63) / 64),
+				peq(vec<uint64_t>(max_char * nbWords)),
+				pv(vec<uint64_t>(nbWords)),
+				mv(vec<uint64_t>(nbWords)) {
 		// get maximum costs over all insertions/deletions
 		max_id_cost = 0;
 		for (int i = 0; i < max_char; i++) {
@@ -75,6 +83,18 @@ public:
 			min_id_cost = std::min(min_id_cost, deletion_cost[i]);
 		}
 
+		uniform_cost = max_id_cost;
+		for (int i = 0; i < max_char; i++) {
+			if (insertion_cost[i] != uniform_cost || deletion_cost[i] != uniform_cost) {
+				uniform_cost = 0;
+			}
+			for (int j = 0; j < max_char; j++) {
+				if (substitution_cost[i * max_char + j] != (i == j ? 0 : uniform_cost)) {
+					uniform_cost = 0;
+				}
+			}
+		}
+
 		// set maximum possible upper bound in the beginning
 		lastBound = seqSize * 2 * max_id_cost;
 
@@ -156,24 +176,47 @@ public:
 #endif
 
 		const int ub = std::min(2 * seqSize * max_id_cost, lastBound + cellChanges * 2 * max_id_cost);
-
-		updateDpMatrix(ub);
 		cellChanges = 0;
 		for (int i = 0; i < seqSize * 2; i++) {
 			cellHasChanged[i] = 0;
 		}
 
+		// Most of the time the bound does not go up. Check that first, with the bit-parallel
+		// distance if the costs are uniform and both lengths are known, or else with the band
+		// limited by the upper bound of ed. The matrix the explanations need is only built when
+		// the bound does go up.
+		const int len1 = uniform_cost > 0 ? getDecidedLength(seq1) : -1;
+		const int len2 = uniform_cost > 0 ? getDecidedLength(seq2) : -1;
+		if (len1 >= 0 && len2 >= 0) {
+			const int exactLB = getBitParallelLB(len1, len2);
+			if (ed.getMin() >= exactLB) {
+				lastBound = exactLB;
+				return true;
+			}
+		} else if (ed.getMax() < ub) {
+			// Every path costing at most edUB stays in the band, so a distance within it is exact
+			const int edUB = static_cast<int>(ed.getMax()) + 1;
+			updateDpMatrix(edUB);
+			const int bandLB = getEditDistanceLB();
+			if (bandLB <= edUB && ed.getMin() >= bandLB) {
+				lastBound = bandLB;
+				return true;
+			}
+		}
+
+		updateDpMatrix(ub);
+
 #ifndef NDEBUG
 		printCurrentDpMatrix();
 #endif
 
+		// calc edit distance
+		const int editDistanceLB = getEditDistanceLB();
+
 		// Step 2:
 		// Propagate lower bound to edit distance, and add explanation
 		//
 
-		// calc edit distance
-		const int editDistanceLB = getEditDistanceLB();
-
 		lastBound = editDistanceLB;
 
 		if (ed.getMin() < editDistanceLB) {
@@ -204,10 +247,9 @@ public:
 																								 editDistanceLB, seqSize, min_id_cost);
 							break;
 					}
-
-					if (!ed.setMin(editDistanceLB, r)) {
-						return false;
-					}
+				}
+				if (!ed.setMin(editDistanceLB, r)) {
+					return false;
 				}
 			}
 		}
@@ -222,6 +264,95 @@ private:
 	int cellChanges;
 	vec<int> cellHasChanged;
 
+	// Bit-parallel edit distance (Myers, Hyyro) over blocks of 64 rows. peq holds for each
+	// character the rows of seq1 that can take it, pv and mv the rows where the matrix goes up
+	// or down by one from the row above in the current column.
+	const int nbWords;
+	vec<uint64_t> peq;
+	vec<uint64_t> pv;
+	vec<uint64_t> mv;
+
+	// Number of positions of seq that cannot be 0, if all others are fixed to 0, -1 otherwise
+	int getDecidedLength(IntView<>* const seq) const {
+		int len = 0;
+		while (len < seqSize && !seq[len].indomain(0)) {
+			len++;
+		}
+		for (int i = len; i < seqSize; i++) {
+			if (!seq[i].isFixed() || seq[i].getVal() != 0) {
+				return -1;
+			}
+		}
+		return len;
+	}
+
+	// Advance block b by one column where the rows in eq may match, given the difference hin
+	// along the top of the block. Returns the difference along the row at high.
+	int advanceBlock(int b, uint64_t eq, int hin, uint64_t high) {
+		const uint64_t pvb = pv[b];
+		const uint64_t mvb = mv[b];
+		const uint64_t xv = eq | mvb;
+		if (hin < 0) {
+			eq |= 1;
+		}
+		const uint64_t xh = (((eq & pvb) + pvb) ^ pvb) | eq;
+		uint64_t ph = mvb | ~(xh | pvb);
+		uint64_t mh = pvb & xh;
+		int hout = 0;
+		if ((ph & high) != 0U) {
+			hout = 1;
+		} else if ((mh & high) != 0U) {
+			hout = -1;
+		}
+		ph <<= 1;
+		mh <<= 1;
+		if (hin < 0) {
+			mh |= 1;
+		} else if (hin > 0) {
+			ph |= 1;
+		}
+		pv[b] = mh | ~(xv | ph);
+		mv[b] = ph & xv;
+		return hout;
+	}
+
+	// Edit distance of the first len1 positions of seq1 and len2 of seq2 with uniform costs, where
+	// two positions match if their domains share a character. This is the value the dp matrix
+	// gives for the whole sequences when the remaining positions are fixed to 0.
+	int getBitParallelLB(int len1, int len2) {
+		if (len1 == 0 || len2 == 0) {
+			return uniform_cost * (len1 + len2);
+		}
+		const int words = (len1 + 63) / 64;
+		for (int k = 0; k < max_char * words; k++) {
+			peq[k] = 0;
+		}
+		for (int i = 0; i < len1; i++) {
+			for (const int c : seq1[i]) {
+				peq[(c - 1) * words + i / 64] |= uint64_t(1) << (i % 64);
+			}
+		}
+		for (int b = 0; b < words; b++) {
+			pv[b] = ~uint64_t(0);
+			mv[b] = 0;
+		}
+		const uint64_t last = uint64_t(1) << ((len1 - 1) % 64);
+		// distance to the last row, the first row goes up by one in every column
+		int dist = len1;
+		for (int j = 0; j < len2; j++) {
+			int h = 1;
+			for (int b = 0; b < words; b++) {
+				uint64_t eq = 0;
+				for (const int c : seq2[j]) {
+					eq |= peq[(c - 1) * words + b];
+				}
+				h = advanceBlock(b, eq, h, b == words - 1 ? last : uint64_t(1) << 63);
+			}
+			dist += h;
+		}
+		return dist * uniform_cost;
+	}
+
 	int getMinimumDeletionCosts(IntView<>* const iVar) {
 		int min_deletion_costs = INT_MAX;
 		// find minimum deletion costs
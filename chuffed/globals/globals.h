@@ -33,6 +33,11 @@ void inverse(vec<IntVar*>& x, vec<IntVar*>& y, int o1 = 0, int o2 = 0, ConLevel
 void circuit(vec<IntVar*>& x, int offset = 0);
 void path(vec<IntVar*>& x);
 
+// weighted_circuit.cpp
+
+// x forms a circuit, cost = sum c[i][x[i]-offset]
+void weighted_circuit(vec<IntVar*>& x, vec<vec<int> >& c, IntVar* cost, int offset = 0);
+
 // subcircuit.c
 
 void subcircuit(vec<IntVar*>& x, int offset = 0);
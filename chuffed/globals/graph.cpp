@@ -77,6 +77,8 @@ GraphPropagator::GraphPropagator(vec<BoolView>& _vs, vec<BoolView>& _es, vec<vec
 
 GraphPropagator::~GraphPropagator() = default;
 
+void GraphPropagator::buildIncidence() { incidence.build(adj, endnodes); }
+
 void GraphPropagator::attachToAll() {
 	// Do not use in inheriting classes!!
 	for (int j = 0; j < nbNodes(); j++) {
@@ -2,6 +2,7 @@
 #define GRAPH_PROPAGATOR_H
 
 #include "chuffed/core/propagator.h"
+#include "chuffed/support/graph_kernel.h"
 #include "chuffed/support/union_find.h"
 
 #include <map>
@@ -25,6 +26,9 @@ public:
 	virtual std::vector<Lit> fullExpl(bool fail);
 
 	std::vector<std::vector<edge_id> > adj;
+	// adj in CSR form, built by buildIncidence() once adj is known
+	CSRGraph incidence;
+	void buildIncidence();
 
 	bool coherence_innodes(int edge);
 	bool coherence_outedges(int node);
@@ -82,7 +86,7 @@ public:
 
 	inline bool isSelfLoop(int e) { return getEndnode(e, 0) == getEndnode(e, 1); }
 
-	inline std::vector<int> getAdjacentEdges(int u) { return adj[u]; }
+	inline const std::vector<int>& getAdjacentEdges(int u) const { return adj[u]; }
 
 	std::string available_to_dot();
 	std::string all_to_dot();
@@ -2,6 +2,7 @@
 
 #include "chuffed/core/sat.h"
 #include "chuffed/mdd/MDD.h"
+#include "chuffed/mdd/mdd_cache.h"
 #include "chuffed/mdd/mdd_prop.h"
 #include "chuffed/mdd/opts.h"
 #include "chuffed/mdd/weighted_dfa.h"
@@ -10,7 +11,12 @@
 #include "chuffed/vars/int-var.h"
 #include "chuffed/vars/int-view.h"
 
+#include <thirdparty/MurmurHash3/MurmurHash3.h>
+
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 struct dfa_trans {
@@ -20,6 +26,45 @@ struct dfa_trans {
 };
 
 static void addMDDProp(vec<IntVar*>& x, MDDTable& tab, MDDNodeInt m, const MDDOpts& mopts);
+static void addMDDProp(vec<IntVar*>& x, MDDTemplate* templ, const MDDOpts& mopts);
+
+// Compiled MDDs are shared by all constraints posting the same automaton or table over the same
+// domain sizes, so only the state of each propagator is per constraint. The key flattens
+// everything the compiled form depends on, starting with the kind of constraint.
+enum MDDKind { MK_REGULAR, MK_TABLE, MK_COST_REGULAR };
+
+using MDDKey = std::vector<int>;
+
+struct MDDKeyHash {
+	size_t operator()(const MDDKey& k) const {
+		uint32_t ret;
+		MurmurHash3_x86_32(k.data(), static_cast<int>(k.size() * sizeof(int)), 0xdeadbeef, &ret);
+		return ret;
+	}
+};
+
+struct WMDDLayers {
+	vec<int> level;
+	vec<Edge> edges;
+};
+
+static std::unordered_map<MDDKey, MDDTemplate*, MDDKeyHash> mdd_templates;
+static std::unordered_map<MDDKey, WMDDLayers*, MDDKeyHash> wmdd_layers;
+
+static void pushKey(MDDKey& key, vec<int>& v) {
+	key.push_back(v.size());
+	for (int i = 0; i < v.size(); i++) {
+		key.push_back(v[i]);
+	}
+}
+
+// The domain sizes the compiled MDD is bounded to
+static void pushDoms(MDDKey& key, vec<IntVar*>& x) {
+	key.push_back(x.size());
+	for (int i = 0; i < x.size(); i++) {
+		key.push_back(x[i]->getMax() + 1);
+	}
+}
 
 // MDDNodeInt fd_regular(MDDTable& tab, int n, int nstates, vec< vec<int> >& transition, int q0,
 // vec<int>& accepts, bool offset = true);
@@ -44,7 +89,6 @@ void addMDD(vec<IntVar*>& x, MDD m, const MDDOpts& mdd_opts) {
 
 static void addMDDProp(vec<IntVar*>& x, MDDTable& tab, MDDNodeInt m, const MDDOpts& mopts) {
 	vec<int> doms;
-	vec<IntView<> > w;
 
 	vec<intpair> bounds;
 	for (int i = 0; i < x.size(); i++) {
@@ -55,6 +99,11 @@ static void addMDDProp(vec<IntVar*>& x, MDDTable& tab, MDDNodeInt m, const MDDOp
 	//   m = tab.bound(m, bounds);
 	//   m = tab.expand(0, m);
 
+	addMDDProp(x, new MDDTemplate(tab, m, doms), mopts);
+}
+
+static void addMDDProp(vec<IntVar*>& x, MDDTemplate* templ, const MDDOpts& mopts) {
+	vec<IntView<> > w;
 	for (int i = 0; i < x.size(); i++) {
 		x[i]->specialiseToEL();
 	}
@@ -62,8 +111,6 @@ static void addMDDProp(vec<IntVar*>& x, MDDTable& tab, MDDNodeInt m, const MDDOp
 		w.push(IntView<>(x[i], 1, 0));
 	}
 
-	auto* templ = new MDDTemplate(tab, m, doms);
-
 	new MDDProp<0>(templ, w, mopts);
 }
 
@@ -72,12 +119,45 @@ static void addMDDProp(vec<IntVar*>& x, MDDTable& tab, MDDNodeInt m, const MDDOp
 //
 void mdd_regular(vec<IntVar*>& x, int q, int /*s*/, vec<vec<int> >& d, int q0, vec<int>& f,
 								 bool offset, const MDDOpts& mopts) {
-	MDDTable tab(x.size());
-	const MDDNodeInt m(fd_regular(tab, x.size(), q + 1, d, q0, f, offset));
-	addMDDProp(x, tab, m, mopts);
+	MDDKey key = {MK_REGULAR, q, q0, static_cast<int>(offset)};
+	pushDoms(key, x);
+	pushKey(key, f);
+	for (int i = 0; i < q; i++) {
+		pushKey(key, d[i]);
+	}
+	MDDTemplate*& templ(mdd_templates[key]);
+	if (templ == nullptr) {
+		templ = mdd_cache_load(key);
+	}
+	if (templ == nullptr) {
+		vec<int> doms;
+		for (int i = 0; i < x.size(); i++) {
+			doms.push(x[i]->getMax() + 1);
+		}
+		MDDTable tab(x.size());
+		const MDDNodeInt m(fd_regular(tab, x.size(), q + 1, d, q0, f, offset));
+		templ = new MDDTemplate(tab, m, doms);
+		mdd_cache_store(key, *templ);
+	}
+	addMDDProp(x, templ, mopts);
 }
 
 void mdd_table(vec<IntVar*>& x, vec<vec<int> >& t, const MDDOpts& mopts) {
+	MDDKey key = {MK_TABLE};
+	pushDoms(key, x);
+	key.push_back(t.size());
+	for (int i = 0; i < t.size(); i++) {
+		pushKey(key, t[i]);
+	}
+	MDDTemplate*& templ(mdd_templates[key]);
+	if (templ == nullptr) {
+		templ = mdd_cache_load(key);
+	}
+	if (templ != nullptr) {
+		addMDDProp(x, templ, mopts);
+		return;
+	}
+
 	vec<int> doms;
 
 	int maxdom = 0;
@@ -97,7 +177,9 @@ void mdd_table(vec<IntVar*>& x, vec<vec<int> >& t, const MDDOpts& mopts) {
 
 	//   tab.print_mdd_tikz(m);
 
-	addMDDProp(x, tab, m, mopts);
+	templ = new MDDTemplate(tab, m, doms);
+	mdd_cache_store(key, *templ);
+	addMDDProp(x, templ, mopts);
 }
 
 // MDD mdd_table(MDDTable& mddtab, int arity, vec<int>& doms, vec< std::vector<unsigned int> >&
@@ -165,6 +247,26 @@ MDDNodeInt fd_regular(MDDTable& tab, int n, int nstates, vec<vec<int> >& transit
 //
 void wmdd_cost_regular(vec<IntVar*>& x, int q, int s, vec<vec<int> >& d, vec<vec<int> >& w, int q0,
 											 vec<int>& f, IntVar* cost, const MDDOpts& mopts) {
+	MDDKey key = {MK_COST_REGULAR, x.size(), q, s, q0};
+	pushKey(key, f);
+	for (int qi = 0; qi < q; qi++) {
+		pushKey(key, d[qi]);
+		pushKey(key, w[qi]);
+	}
+	WMDDLayers*& layers(wmdd_layers[key]);
+	if (layers == nullptr) {
+		auto* cached = new WMDDLayers;
+		if (wmdd_cache_load(key, cached->level, cached->edges)) {
+			layers = cached;
+		} else {
+			delete cached;
+		}
+	}
+	if (layers != nullptr) {
+		layers_to_wmdd(x, cost, layers->level, layers->edges, mopts);
+		return;
+	}
+
 	vec<WDFATrans> T;
 	// Construct the weighted transitions.
 	for (int qi = 0; qi < q; qi++) {
@@ -179,5 +281,8 @@ void wmdd_cost_regular(vec<IntVar*>& x, int q, int s, vec<vec<int> >& d, vec<vec
 
 	EVLayerGraph g;
 	const EVLayerGraph::NodeID root = wdfa_to_layergraph(g, x.size(), s, (WDFATrans*)T, q, q0, f);
-	evgraph_to_wmdd(x, cost, g, root, mopts);
+	layers = new WMDDLayers;
+	evgraph_to_layers(x.size(), g, root, layers->level, layers->edges);
+	wmdd_cache_store(key, layers->level, layers->edges);
+	layers_to_wmdd(x, cost, layers->level, layers->edges, mopts);
 }
@@ -62,6 +62,10 @@ protected:
 
 	Tint specialtint;
 
+	// Settled nodes of the current shortest path search, and the component it starts from
+	EpochMarks settled;
+	EpochMarks cc_marks;
+
 	bool verify_state() {
 		int ccc = 0;
 		for (int i = 0; i < nbNodes(); i++) {
@@ -170,7 +174,8 @@ protected:
 		spC[s] = -1;
 		clearPathData(s);
 
-		std::vector<bool> visited(nbNodes(), false);
+		EpochMarks& visited = settled;
+		visited.clear();
 		std::vector<int> costs(nbNodes(), INT_MAX);
 		std::vector<int> edge(nbNodes(), -1);
 		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
@@ -185,7 +190,7 @@ protected:
 		while (count < nbNodes()) {
 			const std::pair<int, int> top = q.top();
 			curr = top.first;
-			visited[curr] = true;
+			visited.mark(curr);
 			// Reached the closest terminal outside of the CC of s
 			if (getNodeVar(curr).isFixed() && getNodeVar(curr).isTrue() && !areSameCC(s, curr) &&
 					uf.find(curr) == curr) {
@@ -242,7 +247,8 @@ protected:
 		spC[s] = -1;
 		clearPathData(s);
 
-		std::vector<bool> visited(nbNodes(), false);
+		EpochMarks& visited = settled;
+		visited.clear();
 		std::vector<int> costs(nbNodes(), INT_MAX);
 		std::vector<int> edge(nbNodes(), -1);
 		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
@@ -258,7 +264,7 @@ protected:
 		while (!q.empty() && count < nbNodes()) {
 			const std::pair<int, int> top = q.top();
 			curr = top.first;
-			visited[curr] = true;
+			visited.mark(curr);
 			// Reached the closest terminal outside of the CC of s
 			if (getNodeVar(curr).isFixed() && getNodeVar(curr).isTrue() && !areSameCC(s, curr) &&
 					uf.find(curr) == curr) {
@@ -342,6 +348,8 @@ public:
 				ccs(0),
 				specialtint(0),
 				w(_w) {
+		settled.resize(nbNodes());
+		cc_marks.resize(nbNodes());
 		explvp.push();
 		priority = 5;
 		nb_innodes = 0;
@@ -730,6 +738,10 @@ protected:
 
 	Tint* removedEdgesFromSP;
 
+	// Settled nodes of the current shortest path search, and the component it starts from
+	EpochMarks settled;
+	EpochMarks cc_marks;
+
 	/**
 	 * Propagation rules on Stiener nodes (cf. paper)
 	 */
@@ -811,6 +823,8 @@ public:
 				mandatoryWeight(0),  // apsp(this),
 				lowerBound(0),
 				totalWeight(_w) {
+		settled.resize(nbNodes());
+		cc_marks.resize(nbNodes());
 		for (int i = 0; i < _ws.size(); i++) {
 			weights.push(_ws[i]);
 		}
@@ -926,7 +940,7 @@ public:
 	 * res[]: for each node, cost and predecor info
 	 * n: number of nodes in the graph
 	 */
-	int Dijkstra(int s, DijkstraInfo res[], std::vector<bool>& cc, int n) {
+	int Dijkstra(int s, DijkstraInfo res[], EpochMarks& cc, int n) {
 		for (int i = 0; i < n; i++) {
 			res[i].cost = INT_MAX;
 		}
@@ -934,7 +948,8 @@ public:
 		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
 												comp>
 				q;  // priority key: cost
-		std::vector<bool> visited(n, false);
+		EpochMarks& visited = settled;
+		visited.clear();
 		int count = 0;
 		res[s].prev = s;
 		res[s].cost = 0;
@@ -955,7 +970,7 @@ public:
 			}
 
 			q.pop();
-			visited[curr] = true;
+			visited.mark(curr);
 			count++;
 
 			for (int i = 0; i < adj[curr].size(); i++) {
@@ -997,7 +1012,8 @@ public:
 		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
 												comp>
 				q;  // priority key: cost
-		std::vector<bool> visited(n, false);
+		EpochMarks& visited = settled;
+		visited.clear();
 		int count = 0;
 		res[s].prev = s;
 		res[s].cost = 0;
@@ -1011,7 +1027,7 @@ public:
 			curr = top.first;
 
 			q.pop();
-			visited[curr] = true;
+			visited.mark(curr);
 			count++;
 
 			for (int i = 0; i < adj[curr].size(); i++) {
@@ -1063,7 +1079,8 @@ public:
 			const int rep = i;
 			std::vector<DijkstraInfo> dijkstraPath(nbNodes());
 			struct CC cc;
-			std::vector<bool> ccvisited(nbNodes(), false);
+			EpochMarks& ccvisited = cc_marks;
+			ccvisited.clear();
 			getCC(rep, ccvisited, &cc);
 			const int other = Dijkstra(rep, dijkstraPath.data(), ccvisited, nbNodes());
 			// other can be three things:
@@ -1167,7 +1184,8 @@ public:
 		std::vector<DijkstraInfo> dijkstraPath(nbNodes());
 		// int end = fullDijkstra(repN, dijkstraPath,nbNodes());
 		struct CC cc;
-		std::vector<bool> ccvisited(nbNodes(), false);
+		EpochMarks& ccvisited = cc_marks;
+		ccvisited.clear();
 		getCC(repN, ccvisited, &cc);
 		int min = -1;
 		int argmin = -1;
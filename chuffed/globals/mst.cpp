@@ -13,6 +13,8 @@
 
 #include <algorithm>  // std::min, std::sort
 #include <cassert>
+#include <climits>
+#include <cstdio>
 #include <utility>
 #include <vector>
 
@@ -76,6 +78,385 @@ std::pair<int, int> Kruskal_weight(std::vector<int>& weights, int n,
 class MSTPropagator : public TreePropagator {
 	std::vector<iipair> sorted;
 
+	// Minimum spanning forest of the available edges containing all the mandatory edges. It is
+	// updated edge by edge as edges get fixed and restored by trailing on backtrack. state[e] is
+	// the value of e the forest has been updated for.
+	enum EState { ES_UNK, ES_IN, ES_OUT };
+	std::vector<Tchar> state;
+	std::vector<Tchar> in_mst;
+	Tint mst_cost;
+	Tchar built;
+
+	// Every forest gets a fresh id, so that the untrailed data below can tell if it is stale
+	Tint mst_id;
+	int next_id{0};
+
+	// Forest adjacency
+	int adj_id{-1};
+	std::vector<std::vector<int> > tree_adj;
+
+	// Rooted forest, with binary lifting tables for the heaviest edge on a path
+	int rooted_id{-1};
+	int log_n{1};
+	std::vector<int> depth;
+	std::vector<int> comp;
+	std::vector<int> parent_edge;
+	std::vector<std::vector<int> > up;
+	std::vector<std::vector<int> > up_max;
+
+	// Forest and bound for which the edges have been filtered
+	Tint filtered_id;
+	Tint filtered_ub;
+
+	// Temporary storage
+	std::vector<int> mark;
+	int mark_stamp{0};
+	std::vector<int> stack;
+	std::vector<int> side;
+	std::vector<int> pred;
+	std::vector<int> jump;
+	std::vector<int> subs;
+
+	long long updates{0};
+	long long rebuilds{0};
+
+	int heavier(int e1, int e2) const {
+		if (e1 < 0) {
+			return e2;
+		}
+		if (e2 < 0) {
+			return e1;
+		}
+		return ws[e2] > ws[e1] ? e2 : e1;
+	}
+
+	void newMark() {
+		if (++mark_stamp == INT_MAX) {
+			std::fill(mark.begin(), mark.end(), 0);
+			mark_stamp = 1;
+		}
+	}
+
+	void syncAdj() {
+		if (adj_id == mst_id) {
+			return;
+		}
+		for (int i = 0; i < nbNodes(); i++) {
+			tree_adj[i].clear();
+		}
+		for (int e = 0; e < nbEdges(); e++) {
+			if (in_mst[e] != 0) {
+				tree_adj[endnodes[e][0]].push_back(e);
+				tree_adj[endnodes[e][1]].push_back(e);
+			}
+		}
+		adj_id = mst_id;
+	}
+
+	void setInTree(int e, bool in) {
+		assert((in_mst[e] != 0) != in);
+		in_mst[e] = in;
+		mst_cost += in ? ws[e] : -ws[e];
+		for (int k = 0; k < 2; k++) {
+			std::vector<int>& a = tree_adj[endnodes[e][k]];
+			if (in) {
+				a.push_back(e);
+			} else {
+				a.erase(std::find(a.begin(), a.end(), e));
+			}
+		}
+		mst_id = ++next_id;
+		adj_id = mst_id;
+	}
+
+	// Kruskal from scratch on the current domains
+	void rebuild() {
+		rebuilds++;
+		std::vector<bool> in(nbEdges(), false);
+		int cost = 0;
+		UF<int> uf(nbNodes());
+		for (int e = 0; e < nbEdges(); e++) {
+			const char s = getEdgeVar(e).isFixed() ? (getEdgeVar(e).isTrue() ? ES_IN : ES_OUT) : ES_UNK;
+			if (state[e] != s) {
+				state[e] = s;
+			}
+			if (s == ES_IN && uf.unite(endnodes[e][0], endnodes[e][1])) {
+				in[e] = true;
+				cost += ws[e];
+			}
+		}
+		for (auto& i : sorted) {
+			const int e = i.first;
+			if (state[e] == ES_UNK && uf.unite(endnodes[e][0], endnodes[e][1])) {
+				in[e] = true;
+				cost += ws[e];
+			}
+		}
+		for (int e = 0; e < nbEdges(); e++) {
+			if ((in_mst[e] != 0) != in[e]) {
+				in_mst[e] = in[e];
+			}
+		}
+		mst_cost = cost;
+		mst_id = ++next_id;
+		built = 1;
+	}
+
+	// Forest edges on the path from u to v, false if they are not connected
+	bool findPath(int u, int v, std::vector<int>& path) {
+		path.clear();
+		if (u == v) {
+			return true;
+		}
+		newMark();
+		mark[u] = mark_stamp;
+		stack.clear();
+		stack.push_back(u);
+		while (!stack.empty() && mark[v] != mark_stamp) {
+			const int x = stack.back();
+			stack.pop_back();
+			for (const int e : tree_adj[x]) {
+				const int y = getOtherEndnode(e, x);
+				if (mark[y] != mark_stamp) {
+					mark[y] = mark_stamp;
+					pred[y] = e;
+					stack.push_back(y);
+				}
+			}
+		}
+		if (mark[v] != mark_stamp) {
+			return false;
+		}
+		for (int x = v; x != u; x = getOtherEndnode(pred[x], x)) {
+			path.push_back(pred[x]);
+		}
+		return true;
+	}
+
+	// Edge e became mandatory: it replaces the heaviest optional edge on the cycle it closes
+	bool include(int e) {
+		if (in_mst[e] != 0) {
+			return true;
+		}
+		if (!findPath(endnodes[e][0], endnodes[e][1], side)) {
+			setInTree(e, true);
+			return true;
+		}
+		int out = -1;
+		for (const int f : side) {
+			if (state[f] != ES_IN) {
+				out = heavier(out, f);
+			}
+		}
+		if (out < 0) {
+			// Cycle of mandatory edges
+			return false;
+		}
+		setInTree(out, false);
+		setInTree(e, true);
+		return true;
+	}
+
+	// Edge e was removed: it is replaced by the lightest optional edge across the cut it leaves
+	void exclude(int e) {
+		if (in_mst[e] == 0) {
+			return;
+		}
+		setInTree(e, false);
+		// Mark the smaller of the two sides
+		for (int k = 0; k < 2; k++) {
+			newMark();
+			side.clear();
+			stack.clear();
+			stack.push_back(endnodes[e][k]);
+			mark[endnodes[e][k]] = mark_stamp;
+			while (!stack.empty()) {
+				const int x = stack.back();
+				stack.pop_back();
+				side.push_back(x);
+				for (const int f : tree_adj[x]) {
+					const int y = getOtherEndnode(f, x);
+					if (mark[y] != mark_stamp) {
+						mark[y] = mark_stamp;
+						stack.push_back(y);
+					}
+				}
+			}
+			if (2 * side.size() <= nbNodes()) {
+				break;
+			}
+		}
+		int best = -1;
+		for (const int x : side) {
+			for (const int f : adj[x]) {
+				if (state[f] == ES_UNK && in_mst[f] == 0 && mark[getOtherEndnode(f, x)] != mark_stamp &&
+						(best < 0 || ws[f] < ws[best])) {
+					best = f;
+				}
+			}
+		}
+		if (best >= 0) {
+			setInTree(best, true);
+		}
+	}
+
+	// Bring the forest up to date with the edges fixed since it was last updated. The edges are
+	// compared against state rather than collected on wakeup: an edge fixed at one level may only
+	// be seen by a propagation at a later one, whose trailed changes are undone before the edge is.
+	void update() {
+		if (built == 0) {
+			rebuild();
+			return;
+		}
+		syncAdj();
+		for (int e = 0; e < nbEdges(); e++) {
+			if (state[e] != ES_UNK) {
+				assert(getEdgeVar(e).isFixed());
+				continue;
+			}
+			if (!getEdgeVar(e).isFixed()) {
+				continue;
+			}
+			updates++;
+			if (getEdgeVar(e).isTrue()) {
+				state[e] = ES_IN;
+				if (!include(e)) {
+					rebuild();
+					return;
+				}
+			} else {
+				state[e] = ES_OUT;
+				exclude(e);
+			}
+		}
+	}
+
+	void buildRooted() {
+		if (rooted_id == mst_id) {
+			return;
+		}
+		syncAdj();
+		const int n = nbNodes();
+		std::fill(comp.begin(), comp.end(), -1);
+		for (int r = 0; r < n; r++) {
+			if (comp[r] >= 0) {
+				continue;
+			}
+			comp[r] = r;
+			depth[r] = 0;
+			parent_edge[r] = -1;
+			up[0][r] = r;
+			up_max[0][r] = -1;
+			stack.clear();
+			stack.push_back(r);
+			while (!stack.empty()) {
+				const int x = stack.back();
+				stack.pop_back();
+				for (const int e : tree_adj[x]) {
+					const int y = getOtherEndnode(e, x);
+					if (comp[y] < 0) {
+						comp[y] = r;
+						depth[y] = depth[x] + 1;
+						parent_edge[y] = e;
+						up[0][y] = x;
+						up_max[0][y] = e;
+						stack.push_back(y);
+					}
+				}
+			}
+		}
+		for (int k = 1; k < log_n; k++) {
+			for (int x = 0; x < n; x++) {
+				const int m = up[k - 1][x];
+				up[k][x] = up[k - 1][m];
+				up_max[k][x] = heavier(up_max[k - 1][x], up_max[k - 1][m]);
+			}
+		}
+		rooted_id = mst_id;
+	}
+
+	// Heaviest forest edge on the path from u to v, -1 if there is none
+	int pathMax(int u, int v) {
+		if (u == v || comp[u] != comp[v]) {
+			return -1;
+		}
+		int res = -1;
+		if (depth[u] < depth[v]) {
+			std::swap(u, v);
+		}
+		for (int k = log_n - 1; k >= 0; k--) {
+			if (depth[u] - (1 << k) >= depth[v]) {
+				res = heavier(res, up_max[k][u]);
+				u = up[k][u];
+			}
+		}
+		if (u == v) {
+			return res;
+		}
+		for (int k = log_n - 1; k >= 0; k--) {
+			if (up[k][u] != up[k][v]) {
+				res = heavier(res, heavier(up_max[k][u], up_max[k][v]));
+				u = up[k][u];
+				v = up[k][v];
+			}
+		}
+		return heavier(res, heavier(up_max[0][u], up_max[0][v]));
+	}
+
+	// subs[f] = lightest non mandatory edge outside the forest whose cycle goes through f
+	void computeSubs() {
+		std::fill(subs.begin(), subs.end(), -1);
+		for (int x = 0; x < nbNodes(); x++) {
+			jump[x] = x;
+		}
+		auto find = [&](int x) {
+			while (jump[x] != x) {
+				jump[x] = jump[jump[x]];
+				x = jump[x];
+			}
+			return x;
+		};
+		for (auto& i : sorted) {
+			const int e = i.first;
+			if (in_mst[e] != 0 || getEdgeVar(e).isTrue()) {
+				continue;
+			}
+			int u = endnodes[e][0];
+			int v = endnodes[e][1];
+			if (comp[u] != comp[v]) {
+				continue;
+			}
+			u = find(u);
+			v = find(v);
+			while (u != v) {
+				if (depth[u] < depth[v]) {
+					std::swap(u, v);
+				}
+				subs[parent_edge[u]] = e;
+				jump[u] = up[0][u];
+				u = find(u);
+			}
+		}
+	}
+
+	// Removed edges that would give a lighter forest, and the mandatory edges that matter
+	void explain(vec<Lit>& ps) {
+		buildRooted();
+		for (int e = 0; e < nbEdges(); e++) {
+			if (!getEdgeVar(e).isFalse() || isSelfLoop(e)) {
+				continue;
+			}
+			const int u = endnodes[e][0];
+			const int v = endnodes[e][1];
+			const int g = pathMax(u, v);
+			if (comp[u] != comp[v] || ws[g] > ws[e]) {
+				ps.push(getEdgeVar(e).getValLit());
+			}
+		}
+		computeSubs();
+		explain_mandatory(ps, mst_cost, subs);
+	}
+
 protected:
 public:
 	IntVar* w;
@@ -95,7 +476,14 @@ public:
 
 	MSTPropagator(vec<BoolView>& _vs, vec<BoolView>& _es, vec<vec<edge_id> >& _adj,
 								vec<vec<int> >& _en, IntVar* _w, vec<int>& _ws)
-			: TreePropagator(_vs, _es, _adj, _en), w(_w), sort_by_w(this) {
+			: TreePropagator(_vs, _es, _adj, _en),
+				mst_cost(0),
+				built(0),
+				mst_id(-1),
+				filtered_id(-1),
+				filtered_ub(0),
+				w(_w),
+				sort_by_w(this) {
 		for (int i = 0; i < _ws.size(); i++) {
 			ws.push_back(_ws[i]);
 		}
@@ -117,6 +505,27 @@ public:
 			w->setMax(kkl.second);
 		}
 		w->attach(this, nbEdges() + nbNodes(), EVENT_LU);
+
+		const int n = nbNodes();
+		while ((1 << log_n) < n) {
+			log_n++;
+		}
+		state.resize(nbEdges());
+		in_mst.resize(nbEdges());
+		for (int e = 0; e < nbEdges(); e++) {
+			state[e] = ES_UNK;
+			in_mst[e] = false;
+		}
+		tree_adj.resize(n);
+		depth.resize(n);
+		comp.resize(n);
+		parent_edge.resize(n);
+		up.assign(log_n, std::vector<int>(n));
+		up_max.assign(log_n, std::vector<int>(n));
+		mark.assign(n, 0);
+		pred.resize(n);
+		jump.resize(n);
+		subs.resize(nbEdges());
 	}
 
 	void wakeup(int i, int c) override {
@@ -132,89 +541,14 @@ public:
 			return false;
 		}
 
-		std::vector<int> support(nbEdges(), -1);
-		std::vector<int> subs(nbEdges(), -1);
-		vec<Lit> expl_fail;
-		int c = 0;
-		// Computing the MST with the inedges
-		{
-			UF<int> uf(nbNodes());
-			RerootedUnionFind<int> ruf(nbNodes());
-			std::vector<bool> already(nbEdges(), false);
-			int in = 0;
-			for (int i = 0; i < nbEdges(); i++) {
-				if (getEdgeVar(i).isTrue()) {
-					const bool ok = ruf.unite(endnodes[i][0], endnodes[i][1]);
-					assert(ok);
-					uf.unite(endnodes[i][0], endnodes[i][1]);
-					in++;
-					c += ws[i];
-				}
-			}
+		update();
 
-			unsigned int i = 0;
-			while (i < sorted.size()) {
-				const int e = sorted[i].first;
-				if (getEdgeVar(e).isTrue()) {
-					i++;
-					continue;
-				}
-				// cout <<"Looking at "<<e<<endl;
-				const int w = sorted[i].second;
-				const int u = endnodes[e][0];
-				const int v = endnodes[e][1];
-				const bool connected = uf.connected(u, v);
-
-				// I wanted to connected them, but I can't bc I'm out
-				if (getEdgeVar(e).isFalse() && !connected) {
-					if (!already[e]) {
-						expl_fail.push(getEdgeVar(e).getValLit());
-						already[e] = true;
-					}
-				}
-				// I wanted to connected them, but I can't bc They are already connected
-				else if (connected) {
-					std::vector<int> path = ruf.connectionsFromTo(u, v);
-					int arg_maxw = findEdge(path[0], path[1]);
-					// int below_cost = 0;
-					// int above_cost = 0;
-					bool heavier = false;
-					//  ^ used to see if the path used mandatory edges BECAUSE e is
-					// forbidden and there in no other way of connecting its endnodes
-
-					for (int k = 0; k < path.size() - 1; k++) {
-						const int e_path = findEdge(path[k], path[k + 1]);
-						arg_maxw = ws[e_path] > ws[arg_maxw] ? e_path : arg_maxw;
-						heavier |= ws[e_path] > w;
-						assert(e_path != e);
-						subs[e_path] =
-								(subs[e_path] == -1) ? e : ((ws[subs[e_path]] > ws[e]) ? e : subs[e_path]);
-					}
-					if (heavier) {
-						if (getEdgeVar(e).isFalse()) {
-							expl_fail.push(getEdgeVar(e).getValLit());
-						}
-					}
-					support[e] = arg_maxw;
-				}
-				// I can connect them!
-				if (in < nbNodes() - 1 && !getEdgeVar(e).isFixed() && !connected) {
-					const bool ok = ruf.unite(u, v);
-					assert(ok);
-					uf.unite(u, v);
-					in++;
-					c += w;
-				}
-				i++;
-			}
-		}
 		// Lower bound:
-		if (c > w->getMax()) {
+		if (mst_cost > w->getMax()) {
 			if (so.lazy) {
-				explain_mandatory(expl_fail, c, subs);
-				// assert(expl_fail.size() >= 1); //dont really need it
+				vec<Lit> expl_fail;
+				explain(expl_fail);
 				expl_fail.push(w->getMaxLit());
-				// vec<Lit> ps; fullExpl(ps);
 				Clause* expl = Clause_new(expl_fail);
 				expl->temp_expl = 1;
 				sat.rtrail.last().push(expl);
@@ -222,22 +556,29 @@ public:
 			}
 			return false;
 		}
+
+		// Forcing e in replaces the heaviest edge on the path between its endnodes
+		if (filtered_id == mst_id && filtered_ub == w->getMax()) {
+			return true;
+		}
+		buildRooted();
 		bool computed_expl = false;
 		vec<Lit> ps;
 		for (int e = 0; e < nbEdges(); e++) {
-			if (support[e] < 0 || getEdgeVar(e).isFixed()) {
+			if (in_mst[e] != 0 || getEdgeVar(e).isFixed()) {
+				continue;
+			}
+			const int g = pathMax(endnodes[e][0], endnodes[e][1]);
+			if (g < 0) {
 				continue;
 			}
 
-			if (c - ws[support[e]] + ws[e] > w->getMax()) {
+			if (mst_cost - ws[g] + ws[e] > w->getMax()) {
 				Clause* r = nullptr;
 				if (so.lazy) {
 					if (!computed_expl) {
 						ps.push();
-						for (int i = 0; i < expl_fail.size(); i++) {
-							ps.push(expl_fail[i]);
-						}
-						explain_mandatory(ps, c, subs);
+						explain(ps);
 						ps.push(w->getMaxLit());
 						computed_expl = true;
 					}
@@ -247,9 +588,16 @@ public:
 				getEdgeVar(e).setVal(false, r);
 			}
 		}
+		filtered_id = mst_id;
+		filtered_ub = w->getMax();
 		return true;
 	}
 
+	void printStats() override {
+		printf("%%%%%%mzn-stat: mstUpdates=%lld\n", updates);
+		printf("%%%%%%mzn-stat: mstRebuilds=%lld\n", rebuilds);
+	}
+
 	void explain_mandatory(vec<Lit>& expl_fail, int c, std::vector<int>& substitute) {
 		int add = 0;
 		/*std::vector<int> in_edges;
@@ -32,27 +32,27 @@
  * Detect that whe cannot reach some otehr node from 'node'
  * return true if no conflict, false otherwise (explanation built inside)
  */
-bool TreePropagator::reachable(int node, std::vector<bool>& blue, bool doDFS) {
+bool TreePropagator::reachable(int node, EpochMarks& blue, bool doDFS) {
 	if (doDFS) {
-		blue = std::vector<bool>(nbNodes(), false);
+		blue.clear();
 		int count = 0;
 		DFSBlue(node, blue, count);
 	}
 	for (int i = 0; i < nbNodes(); i++) {
 		if (blue[i] == false && getNodeVar(i).isFixed() && getNodeVar(i).isTrue()) {
 			if (so.lazy) {
-				std::unordered_set<edge_id> badEdges;
-				std::vector<bool> pink(nbNodes(), false);
+				std::vector<edge_id>& badEdges = bad_edges;
+				badEdges.clear();
+				pink.clear();
 				DFSPink(i, pink, blue, badEdges);
 				// REASON: 0<i<n visited[i] /\ any-fixed-not-visited => fail
 
 				vec<Lit> ps;
 				assert(getNodeVar(node).isFixed());
 				ps.push(getNodeVar(node).getValLit());
-				std::unordered_set<edge_id>::iterator it;
-				for (it = badEdges.begin(); it != badEdges.end(); ++it) {
-					assert(getEdgeVar(*it).isFixed());
-					ps.push(getEdgeVar(*it).getValLit());
+				for (const int e : badEdges) {
+					assert(getEdgeVar(e).isFixed());
+					ps.push(getEdgeVar(e).getValLit());
 				}
 				assert(getNodeVar(i).isFixed());
 				ps.push(getNodeVar(i).getValLit());
@@ -66,8 +66,9 @@ bool TreePropagator::reachable(int node, std::vector<bool>& blue, bool doDFS) {
 		if (blue[i] == false && !getNodeVar(i).isFixed()) {
 			Clause* r = nullptr;
 			if (so.lazy) {
-				std::unordered_set<edge_id> badEdges;
-				std::vector<bool> pink(nbNodes(), false);
+				std::vector<edge_id>& badEdges = bad_edges;
+				badEdges.clear();
+				pink.clear();
 				DFSPink(i, pink, blue, badEdges);
 				// REASON: 0<i<n visited[i] => unfixed-not-visited = false
 
@@ -75,10 +76,9 @@ bool TreePropagator::reachable(int node, std::vector<bool>& blue, bool doDFS) {
 				ps.push();
 				assert(getNodeVar(node).isFixed());
 				ps.push(getNodeVar(node).getValLit());
-				std::unordered_set<edge_id>::iterator it;
-				for (it = badEdges.begin(); it != badEdges.end(); ++it) {
-					assert(getEdgeVar(*it).isFixed());
-					ps.push(getEdgeVar(*it).getValLit());
+				for (const int e : badEdges) {
+					assert(getEdgeVar(e).isFixed());
+					ps.push(getEdgeVar(e).getValLit());
 				}
 				r = Reason_new(ps);
 			}
@@ -94,16 +94,8 @@ bool TreePropagator::reachable(int node, std::vector<bool>& blue, bool doDFS) {
  * Detect bridges and articulations and build them (with explanations)
  * return the number of bridges+articulations built
  */
-int TreePropagator::articulations(int n, std::vector<bool>& reachable, int& count) {
-	reachable = std::vector<bool>(nbNodes(), false);
-
-	std::vector<int> parent(nbNodes(), -1);
-	std::vector<int> depth(nbNodes(), -1);
-	std::vector<int> low_(nbNodes(), -1);
-
-	std::stack<node_id> hits;
-	hits.push(-1);
-	std::stack<edge_id> s;
+int TreePropagator::articulations(int n, EpochMarks& reachable, int& count) {
+	reachable.clear();
 
 	count = 0;
 
@@ -111,16 +103,15 @@ int TreePropagator::articulations(int n, std::vector<bool>& reachable, int& coun
 	std::vector<partialExpl> bridgeExpl;
 	std::vector<partialExpl> articuExpl;
 
-	_findAndBuildBridges(n, count, s, depth.data(), low_.data(), reachable, parent.data(), hits,
-											 tmpExpl, bridgeExpl, articuExpl);
+	_findAndBuildBridges(n, count, reachable, tmpExpl, bridgeExpl, articuExpl);
 
 	int nbBridgesBuilt = 0;
 
 	bridgeExpl.insert(bridgeExpl.end(), articuExpl.begin(), articuExpl.end());
 
 	std::map<node_id, node_id> memory;
-	std::vector<int> toBePropagated(nbNodes(), -1);
 	if (!bridgeExpl.empty()) {
+		std::fill(toBePropagated.begin(), toBePropagated.end(), -1);
 		std::vector<partialExpl>::iterator it;
 		for (it = bridgeExpl.begin(); it != bridgeExpl.end(); it++) {
 			Clause* r = nullptr;
@@ -165,20 +156,20 @@ int TreePropagator::articulations(int n, std::vector<bool>& reachable, int& coun
 			if (so.lazy) {
 				std::vector<int> reasons;
 
-				std::vector<bool> walk1(nbNodes(), false);
-				walkIsland(cause1, walk1, bridge, isArt);
-				std::vector<bool> walk2(nbNodes(), false);
-				walkBrokenBridges(cause1, reachable, walk1, walk2, bridge, reasons, isArt);
+				walked.clear();
+				walkIsland(cause1, walked, bridge, isArt);
+				walked2.clear();
+				walkBrokenBridges(cause1, reachable, walked, walked2, bridge, reasons, isArt);
 				vec<Lit> ps;
 				ps.push();
 				if (!isTerminal[cause1]) {
 					if (memory.find(cause1) == memory.end()) {
 						struct CC cc;
-						std::vector<bool> tmpV(nbNodes(), false);
-						getCC(cause1, tmpV, &cc);
+						in_cc.clear();
+						getCC(cause1, in_cc, &cc);
 						int term = cause1;
 						for (int tt = 0; tt < nbNodes(); tt++) {
-							if (tmpV[tt] && isTerminal[tt]) {
+							if (in_cc[tt] && isTerminal[tt]) {
 								term = tt;
 								break;
 							}
@@ -192,11 +183,11 @@ int TreePropagator::articulations(int n, std::vector<bool>& reachable, int& coun
 				if (!isTerminal[cause2]) {
 					if (memory.find(cause2) == memory.end()) {
 						struct CC cc;
-						std::vector<bool> tmpV(nbNodes(), false);
-						getCC(cause2, tmpV, &cc);
+						in_cc.clear();
+						getCC(cause2, in_cc, &cc);
 						int term = cause2;
 						for (int tt = 0; tt < nbNodes(); tt++) {
-							if (tmpV[tt] && isTerminal[tt]) {
+							if (in_cc[tt] && isTerminal[tt]) {
 								term = tt;
 								break;
 							}
@@ -334,43 +325,46 @@ void TreePropagator::unite(int u, int v) {
 	}
 }
 
-void TreePropagator::_findAndBuildBridges(int u, int& count, std::stack<edge_id>& s, int depth[],
-																					int low[], std::vector<bool>& visited, int parent[],
-																					std::stack<node_id>& hits,
+void TreePropagator::_findAndBuildBridges(int r, int& count, EpochMarks& visited,
 																					std::vector<std::pair<edge_id, node_id> >& semiExpl,
 																					std::vector<partialExpl>& bridgeExpl,
 																					std::vector<partialExpl>& articuExpl) {
-	visited[u] = true;
-	count++;
-	depth[u] = count;
-	low[u] = depth[u];
-
-	// Detect a cause for bridge
-	if (getNodeVar(u).isFixed() && getNodeVar(u).isTrue()) {
-		hits.push(u);
-	}
-	const int prevHitsTop = hits.top();
-
-	int topChangedTo = -1;
-
-	for (int i = 0; i < adj[u].size(); i++) {
-		const int e = adj[u][i];
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
-			continue;
+	// Iterative version of the recursive Tarjan search, each frame is a node being visited and
+	// child the node explored through its last arc, if any.
+	hits.clear();
+	hits.push_back(-1);
+	bridge_stack.clear();
+	bridge_frames.clear();
+	dfs_parent[r] = -1;
+
+	auto enter = [&](int u) {
+		visited.mark(u);
+		count++;
+		depth[u] = count;
+		low[u] = depth[u];
+
+		// Detect a cause for bridge
+		if (getNodeVar(u).isFixed() && getNodeVar(u).isTrue()) {
+			hits.push_back(u);
 		}
-		const int v = OTHER(getEndnode(e, 0), getEndnode(e, 1), u);
-		if (!visited[v]) {
-			s.push(e);
-			parent[v] = u;
+		bridge_frames.push_back({u, 0, -1, hits.back(), -1});
+	};
+	enter(r);
 
-			// cout <<"taking edge "<<e<<endl;
-			_findAndBuildBridges(v, count, s, depth, low, visited, parent, hits, semiExpl, bridgeExpl,
-													 articuExpl);
+	while (!bridge_frames.empty()) {
+		BridgeFrame& f = bridge_frames.back();
+		const int u = f.u;
 
-			if (!getNodeVar(u).isFixed() && hits.top() != prevHitsTop) {
+		if (f.child != -1) {
+			// Back from the child v, reached through edge e
+			const int e = incidence.arc(u, f.arc - 1).edge;
+			const int v = f.child;
+			f.child = -1;
+
+			if (!getNodeVar(u).isFixed() && hits.back() != f.prevHitsTop) {
 				// always prefer terminals, explanations witht hem will eb mroe reusable
-				if (topChangedTo == -1 || isTerminal[topChangedTo]) {
-					topChangedTo = hits.top();
+				if (f.topChangedTo == -1 || isTerminal[f.topChangedTo]) {
+					f.topChangedTo = hits.back();
 				}
 			}
 
@@ -378,55 +372,79 @@ void TreePropagator::_findAndBuildBridges(int u, int& count, std::stack<edge_id>
 				edge_id e2 = -1;
 				int cnt = 0;
 				do {
-					e2 = s.top();
-					s.pop();
+					e2 = bridge_stack.back();
+					bridge_stack.pop_back();
 					cnt++;
 				} while (e2 != e);
 
-				if (prevHitsTop != hits.top()) {
+				if (f.prevHitsTop != hits.back()) {
 					// Bridge
 					if (cnt == 1 && !getEdgeVar(e2).isFixed()) {
-						semiExpl.emplace_back(e2, hits.top());
-						// cout <<"BRIDGE"<<e2<<endl;
+						semiExpl.emplace_back(e2, hits.back());
 					}
 					if (!getNodeVar(u).isFixed()) {
 						// Articulation
 						// negative - 1 means articulation, > 0 means bridge
-						semiExpl.emplace_back(-u - 1, hits.top());
+						semiExpl.emplace_back(-u - 1, hits.back());
 					}
 				}
 			}
-			while (hits.top() != prevHitsTop) {
-				hits.pop();
+			while (hits.back() != f.prevHitsTop) {
+				hits.pop_back();
 			}
 
 			low[u] = std::min(low[u], low[v]);
-		} else if (parent[u] != v && depth[v] < depth[u]) {
-			// e is a backedge from u to its ancestor v
-			s.push(e);
-			low[u] = std::min(low[u], depth[v]);
 		}
-	}
 
-	if (getNodeVar(u).isFixed() && getNodeVar(u).getVal() == 1) {
-		while (hits.top() != u) {
-			hits.pop();
-		}
-		for (auto& i : semiExpl) {
-			partialExpl pE;
-			pE.bridge = i.first;
-			pE.cause1 = i.second;
-			pE.cause2 = u;
-			if (pE.bridge > 0) {
-				bridgeExpl.push_back(pE);
-			} else {
-				articuExpl.push_back(pE);
+		bool descended = false;
+		while (f.arc < incidence.degree(u)) {
+			const CSRGraph::Arc& a = incidence.arc(u, f.arc++);
+			const int e = a.edge;
+			if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
+				continue;
+			}
+			const int v = a.node;
+			if (!visited[v]) {
+				bridge_stack.push_back(e);
+				dfs_parent[v] = u;
+				f.child = v;
+				// f is invalidated by enter
+				enter(v);
+				descended = true;
+				break;
+			}
+			if (dfs_parent[u] != v && depth[v] < depth[u]) {
+				// e is a backedge from u to its ancestor v
+				bridge_stack.push_back(e);
+				low[u] = std::min(low[u], depth[v]);
 			}
 		}
-		semiExpl.clear();
-	} else {
-		if (topChangedTo != -1) {
-			hits.push(topChangedTo);
+		if (descended) {
+			continue;
+		}
+
+		const int topChangedTo = f.topChangedTo;
+		bridge_frames.pop_back();
+		if (getNodeVar(u).isFixed() && getNodeVar(u).getVal() == 1) {
+			while (hits.back() != u) {
+				hits.pop_back();
+			}
+			for (auto& i : semiExpl) {
+				partialExpl pE;
+				pE.bridge = i.first;
+				pE.cause1 = i.second;
+				pE.cause2 = u;
+				if (pE.bridge > 0) {
+					bridgeExpl.push_back(pE);
+				} else {
+					articuExpl.push_back(pE);
+				}
+			}
+			semiExpl.clear();
+		} else {
+			if (topChangedTo != -1) {
+				hits.push_back(topChangedTo);
+			}
 		}
 	}
 }
@@ -495,6 +513,17 @@ TreePropagator::TreePropagator(vec<BoolView>& _vs, vec<BoolView>& _es, vec<vec<e
 			adj[i].push_back(_adj[i][j]);
 		}
 	}
+	buildIncidence();
+	blue.resize(nbNodes());
+	pink.resize(nbNodes());
+	walked.resize(nbNodes());
+	walked2.resize(nbNodes());
+	in_cc.resize(nbNodes());
+	seen_edge.resize(nbEdges());
+	depth.resize(nbNodes());
+	low.resize(nbNodes());
+	dfs_parent.resize(nbNodes());
+	toBePropagated.resize(nbNodes());
 
 	nodes2edge = std::vector<std::vector<std::vector<int> > >(nbNodes());
 	for (int i = 0; i < nbNodes(); i++) {
@@ -616,20 +645,16 @@ bool TreePropagator::propagate() {
 }
 
 // Walks only on fixed edges == 1
-void TreePropagator::getCC(int node, std::vector<bool>& visited, CC* cc) {
-	visited[node] = true;
-	cc->count++;
-	cc->nodesIds.push_back(node);
-
-	for (int i = 0; i < adj[node].size(); i++) {
-		const int e = adj[node][i];
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isTrue()) {
-			const int other = OTHER(getEndnode(e, 0), getEndnode(e, 1), node);
-			if (!visited[other]) {
-				getCC(other, visited, cc);
-			}
-		}
-	}
+void TreePropagator::getCC(int node, EpochMarks& visited, CC* cc) {
+	graph_dfs(
+			incidence, node, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				return getEdgeVar(a.edge).isFixed() && getEdgeVar(a.edge).isTrue();
+			},
+			[&](int u) {
+				cc->count++;
+				cc->nodesIds.push_back(u);
+			});
 }
 
 bool TreePropagator::propagateNewNode(int node) {
@@ -640,7 +665,6 @@ bool TreePropagator::propagateNewNode(int node) {
 		4) Reachable
 	 */
 
-	std::vector<bool> blue(nbNodes());
 	bool didBlueDFS = false;
 	const int& count = newNodeCompleteCheckup_Count;
 	if (newNodeCompleteCheckup) {
@@ -713,13 +737,13 @@ bool TreePropagator::propagateNewEdge(int edge) {
 
 	// Doesn't make much difference in number of nodes but is good
 	// Remove possible cycles
-	std::unordered_set<edge_id> unk;
-	std::vector<bool> blue(nbNodes(), false);
-	getUnkEdgesInCC(u, blue, unk);
-	auto it = unk.begin();
-	for (; it != unk.end(); ++it) {
-		if (blue[getEndnode(*it, 0)] && blue[getEndnode(*it, 1)]) {
-			precycle_detect(*it);
+	std::vector<edge_id>& unk = unk_edges;
+	unk.clear();
+	in_cc.clear();
+	getUnkEdgesInCC(u, in_cc, unk);
+	for (const int e : unk) {
+		if (in_cc[getEndnode(e, 0)] && in_cc[getEndnode(e, 1)]) {
+			precycle_detect(e);
 		}
 	}
 	//*/
@@ -845,7 +869,6 @@ bool TreePropagator::propagateRemEdge(int edge) {
 	// if (!getNodeVar(node).isFixed() || getNodeVar(node).isFalse())
 	//     continue;
 
-	std::vector<bool> blue(nbNodes());
 	bool didBlueDFS = false;
 	const int& count = newNodeCompleteCheckup_Count;
 	if (newNodeCompleteCheckup) {
@@ -882,103 +905,74 @@ void TreePropagator::clearPropState() {
 	}
 }
 
-void TreePropagator::getUnkEdgesInCC(int r, std::vector<bool>& visited,
-																		 std::unordered_set<edge_id>& unk) {
-	visited[r] = true;
-	for (int i = 0; i < adj[r].size(); i++) {
-		const int e = adj[r][i];
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
-			continue;
-		}
-		if (!getEdgeVar(e).isFixed()) {
-			unk.insert(e);
-			continue;
-		}
-		const int other = getEndnode(e, 0) == r ? getEndnode(e, 1) : getEndnode(e, 0);
-		if (visited[other]) {
-			continue;
-		}
-		getUnkEdgesInCC(other, visited, unk);
-	}
+void TreePropagator::getUnkEdgesInCC(int r, EpochMarks& visited, std::vector<edge_id>& unk) {
+	seen_edge.clear();
+	graph_dfs(
+			incidence, r, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				const int e = a.edge;
+				if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
+					return false;
+				}
+				if (!getEdgeVar(e).isFixed()) {
+					if (seen_edge.visit(e)) {
+						unk.push_back(e);
+					}
+					return false;
+				}
+				return true;
+			},
+			[](int /*u*/) {});
 }
 
 /**
  * Goes through in and unknown edges.
  */
-void TreePropagator::DFSBlue(int r, std::vector<bool>& visited, int& count) {
-	visited[r] = true;
-	count++;
-	for (int i = 0; i < adj[r].size(); i++) {
-		const int e = adj[r][i];
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
-			continue;
-		}
-		const int e1 = getEndnode(e, 1);
-		const int e0 = getEndnode(e, 0);
-		const int other = e0 == r ? e1 : e0;
-		if (getNodeVar(other).isFixed() && getNodeVar(other).isFalse()) {
-			continue;
-		}
-		if (visited[other] == false) {
-			DFSBlue(other, visited, count);
-		}
-	}
+void TreePropagator::DFSBlue(int r, EpochMarks& visited, int& count) {
+	graph_dfs(
+			incidence, r, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				if (getEdgeVar(a.edge).isFixed() && getEdgeVar(a.edge).isFalse()) {
+					return false;
+				}
+				return !getNodeVar(a.node).isFixed() || getNodeVar(a.node).isTrue();
+			},
+			[&](int /*u*/) { count++; });
 }
 
 /**
  * Goes through all edges until it hits a 'blue' node.
  * badEdges is the set of edges with one node pink and one node blue.
  */
-void TreePropagator::DFSPink(int r, std::vector<bool>& visited, std::vector<bool>& blue,
-														 std::unordered_set<edge_id>& badEdges) {
-	visited[r] = true;
-	for (int i = 0; i < adj[r].size(); i++) {
-		const int e = adj[r][i];
-		const int e1 = getEndnode(e, 1);
-		const int e0 = getEndnode(e, 0);
-		const int other = e0 == r ? e1 : e0;
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
-			if (blue[other]) {
-				badEdges.insert(e);
-				continue;
-			}
-		} else if (blue[other]) {
-			continue;
-		}
-		if (visited[other] == false) {
-			DFSPink(other, visited, blue, badEdges);
-		}
-	}
+void TreePropagator::DFSPink(int r, EpochMarks& visited, EpochMarks& blue,
+														 std::vector<edge_id>& badEdges) {
+	graph_dfs(
+			incidence, r, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				if (!blue[a.node]) {
+					return true;
+				}
+				if (getEdgeVar(a.edge).isFixed() && getEdgeVar(a.edge).isFalse()) {
+					badEdges.push_back(a.edge);
+				}
+				return false;
+			},
+			[](int /*u*/) {});
 }
 
 /**
  * Goes through in and unkown edges. Avoid 'avoidBridge'
  */
-void TreePropagator::walkIsland(int r, std::vector<bool>& visited, int avoidBridge, bool isArt,
-																int parent) {
-	// cout << "Walking my island.... :" << r<<endl;
-	visited[r] = true;
-
-	for (int i = 0; i < adj[r].size(); i++) {
-		const int e = adj[r][i];
-		const int e1 = getEndnode(e, 1);
-		const int e0 = getEndnode(e, 0);
-		const int other = e0 == r ? e1 : e0;
-		if (isArt && other == avoidBridge) {
-			continue;
-		}
-		if (!isArt && e == avoidBridge) {
-			continue;
-		}
-		if (!getEdgeVar(e).isFixed() || getEdgeVar(e).isTrue()) {
-			if (other == parent) {
-				continue;
-			}
-			if (!visited[other]) {
-				walkIsland(other, visited, avoidBridge, isArt, r);
-			}
-		}
-	}
+void TreePropagator::walkIsland(int r, EpochMarks& visited, int avoidBridge, bool isArt) {
+	graph_dfs(
+			incidence, r, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				if (isArt ? a.node == avoidBridge : a.edge == avoidBridge) {
+					return false;
+				}
+				return !getEdgeVar(a.edge).isFixed() || getEdgeVar(a.edge).isTrue();
+			},
+			[](int /*u*/) {});
 }
 
 /**
@@ -986,37 +980,24 @@ void TreePropagator::walkIsland(int r, std::vector<bool>& visited, int avoidBrid
  * Bridges is the seat of edges that could bring us from visited to a
  * walked and reachable node.
  */
-void TreePropagator::walkBrokenBridges(int r, std::vector<bool>& reachable,
-																			 std::vector<bool>& walked, std::vector<bool>& visited,
-																			 int avoidBridge, std::vector<edge_id>& bridges, bool isArt,
-																			 int parent) {
-	// cout << "Walking my island again.... :" << r<<" "<<avoidBridge<<endl;
-	visited[r] = true;
-	for (int i = 0; i < adj[r].size(); i++) {
-		const int e = adj[r][i];
-		const int e1 = getEndnode(e, 1);
-		const int e0 = getEndnode(e, 0);
-		const int other = e0 == r ? e1 : e0;
-		if (isArt && other == avoidBridge) {
-			continue;
-		}
-		if (!isArt && e == avoidBridge) {
-			continue;
-		}
-		if (other == parent) {
-			continue;
-		}
-		if (getEdgeVar(e).isFixed() && getEdgeVar(e).isFalse()) {
-			// cout << other<<" "<<reachable[other] <<" "<< walked[other]<<endl;
-			if (reachable[other] && !walked[other] && !visited[other]) {
-				bridges.push_back(e);
-				continue;
-			}
-		}
-		if (!visited[other]) {
-			walkBrokenBridges(other, reachable, walked, visited, avoidBridge, bridges, isArt, r);
-		}
-	}
+void TreePropagator::walkBrokenBridges(int r, EpochMarks& reachable, EpochMarks& walked,
+																			 EpochMarks& visited, int avoidBridge,
+																			 std::vector<edge_id>& bridges, bool isArt) {
+	graph_dfs(
+			incidence, r, visited, search_stack,
+			[&](int /*u*/, const CSRGraph::Arc& a) {
+				if (isArt ? a.node == avoidBridge : a.edge == avoidBridge) {
+					return false;
+				}
+				if (getEdgeVar(a.edge).isFixed() && getEdgeVar(a.edge).isFalse()) {
+					if (reachable[a.node] && !walked[a.node] && !visited[a.node]) {
+						bridges.push_back(a.edge);
+						return false;
+					}
+				}
+				return true;
+			},
+			[](int /*u*/) {});
 }
 
 bool TreePropagator::checkFinalSatisfied() {
@@ -1079,6 +1060,8 @@ void connected(vec<BoolView>& _vs, vec<BoolView>& _es, vec<vec<edge_id> >& _adj,
 }
 
 class PrimStrategy : public BranchGroup {
+	EpochMarks visited;
+	std::vector<int> queue;
 	std::vector<std::vector<int> > dist;
 	std::vector<std::vector<bool> > inf;
 	std::vector<std::vector<std::vector<std::pair<int, int> > > > leaving_cc;
@@ -1124,7 +1107,10 @@ public:
 			leaving_cc.emplace_back();
 			border_cc.emplace_back();
 			const int last_t = leaving_cc.size() - 1;
-			std::vector<bool> visited = std::vector<bool>(p->nbNodes(), false);
+			if (visited.size() < p->nbNodes()) {
+				visited.resize(p->nbNodes());
+			}
+			visited.clear();
 			for (int n = 0; n < p->nbNodes(); n++) {
 				if (!p->getNodeVar(n).isFixed() || p->getNodeVar(n).isFalse()) {
 					continue;
@@ -1134,24 +1120,20 @@ public:
 					leaving_cc[last_t].emplace_back();
 					border_cc[last_t].emplace_back();
 					const int last_cc = leaving_cc[last_t].size() - 1;
-					std::queue<int> q;
-					q.push(n);
-					while (!q.empty()) {
-						const int c = q.front();
-						q.pop();
-						visited[c] = true;
-						const std::vector<int> adj = p->getAdjacentEdges(c);
-						for (const int e : adj) {
-							if (!p->getEdgeVar(e).isFixed()) {
-								leaving_cc[last_t][last_cc].emplace_back(e, p->getOtherEndnode(e, c));
-								if (border_cc[last_t][last_cc].empty() || border_cc[last_t][last_cc].back() != c) {
-									border_cc[last_t][last_cc].push_back(c);
+					graph_bfs(
+							p->incidence, n, visited, queue,
+							[&](int c, const CSRGraph::Arc& a) {
+								if (!p->getEdgeVar(a.edge).isFixed()) {
+									leaving_cc[last_t][last_cc].emplace_back(a.edge, a.node);
+									if (border_cc[last_t][last_cc].empty() ||
+											border_cc[last_t][last_cc].back() != c) {
+										border_cc[last_t][last_cc].push_back(c);
+									}
+									return false;
 								}
-							} else if (p->getEdgeVar(e).isTrue() && !visited[p->getOtherEndnode(e, c)]) {
-								q.push(p->getOtherEndnode(e, c));
-							}
-						}
-					}
+								return p->getEdgeVar(a.edge).isTrue();
+							},
+							[](int /*c*/) {});
 				}
 			}
 		}
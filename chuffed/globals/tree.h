@@ -57,14 +57,38 @@ protected:
 
 	edge_id findEdge(int u, int v, int idx = 0);
 	void moveInEdgeToFront(int e);
-	void _findAndBuildBridges(int u, int& count, std::stack<edge_id>& s, int depth[], int low[],
-														std::vector<bool>& visited, int parent[], std::stack<node_id>& hits,
+	// Search state, sized once for the lifetime of the propagator
+	struct BridgeFrame {
+		node_id u;
+		int arc;
+		node_id child;
+		node_id prevHitsTop;
+		node_id topChangedTo;
+	};
+	EpochMarks blue;
+	EpochMarks pink;
+	EpochMarks walked;
+	EpochMarks walked2;
+	EpochMarks in_cc;
+	EpochMarks seen_edge;
+	std::vector<int> search_stack;
+	std::vector<BridgeFrame> bridge_frames;
+	std::vector<int> depth;
+	std::vector<int> low;
+	std::vector<int> dfs_parent;
+	std::vector<node_id> hits;
+	std::vector<edge_id> bridge_stack;
+	std::vector<int> toBePropagated;
+	std::vector<edge_id> bad_edges;
+	std::vector<edge_id> unk_edges;
+
+	void _findAndBuildBridges(int u, int& count, EpochMarks& visited,
 														std::vector<std::pair<edge_id, node_id> >& semiExpl,
 														std::vector<partialExpl>& bridgeExpl,
 														std::vector<partialExpl>& articuExpl);
 
-	int articulations(int n, std::vector<bool>& reachable, int& count);
-	bool reachable(int n, std::vector<bool>& blue, bool doDFS = false);
+	int articulations(int n, EpochMarks& reachable, int& count);
+	bool reachable(int n, EpochMarks& blue, bool doDFS = false);
 	virtual void unite(int u, int v);
 	virtual bool cycle_detect(int edge);
 	virtual void precycle_detect(int unk_edge);
@@ -82,21 +106,17 @@ public:
 	void clearPropState() override;
 
 	// Walks only on fixed edges == 1
-	void getCC(int node, std::vector<bool>& visited, CC* cc);
-	void getAvailableCC(int node, std::vector<bool>& visited, CC* cc);
+	void getCC(int node, EpochMarks& visited, CC* cc);
 	virtual bool propagateNewNode(int node);
 	virtual bool propagateRemNode(int node);
 	virtual bool propagateNewEdge(int edge);
 	virtual bool propagateRemEdge(int edge);
-	void getUnkEdgesInCC(int r, std::vector<bool>& visited, std::unordered_set<edge_id>& unk);
-	void DFSBlue(int r, std::vector<bool>& visited, int& count);
-	void DFSPink(int r, std::vector<bool>& visited, std::vector<bool>& blue,
-							 std::unordered_set<int>& badEdges);
-	void walkIsland(int r, std::vector<bool>& visited, int avoidBridge, bool isArt = false,
-									int parent = -1);
-	void walkBrokenBridges(int r, std::vector<bool>& reachable, std::vector<bool>& walked,
-												 std::vector<bool>& visited, int avoidBridge, std::vector<edge_id>& bridges,
-												 bool isArt = false, int parent = -1);
+	void getUnkEdgesInCC(int r, EpochMarks& visited, std::vector<edge_id>& unk);
+	void DFSBlue(int r, EpochMarks& visited, int& count);
+	void DFSPink(int r, EpochMarks& visited, EpochMarks& blue, std::vector<edge_id>& badEdges);
+	void walkIsland(int r, EpochMarks& visited, int avoidBridge, bool isArt = false);
+	void walkBrokenBridges(int r, EpochMarks& reachable, EpochMarks& walked, EpochMarks& visited,
+												 int avoidBridge, std::vector<edge_id>& bridges, bool isArt = false);
 
 	virtual bool checkFinalSatisfied();
 
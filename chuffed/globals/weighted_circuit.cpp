@@ -0,0 +1,363 @@
+#include "chuffed/core/engine.h"
+#include "chuffed/core/options.h"
+#include "chuffed/core/propagator.h"
+#include "chuffed/core/sat-types.h"
+#include "chuffed/core/sat.h"
+#include "chuffed/globals/globals.h"
+#include "chuffed/primitives/primitives.h"
+#include "chuffed/support/vec.h"
+#include "chuffed/vars/int-var.h"
+#include "chuffed/vars/int-view.h"
+#include "chuffed/vars/modelling.h"
+#include "chuffed/vars/vars.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+
+// cost >= length of the circuit formed by x, where arc i -> j costs c[i][j]
+// Lower bound from Held-Karp 1-trees over the symmetric weights min(c[i][j], c[j][i])
+
+template <int U = 0>
+class WeightedCircuit : public Propagator {
+	static constexpr double eps = 1e-6;
+
+	const int n;
+	vec<IntView<U> > x;
+	const IntView<> cost;
+
+	// Symmetric edge weights
+	vec<vec<int> > w;
+
+	// Lagrangian multipliers, kept between propagations as a warm start
+	vec<double> pi;
+
+	// Multipliers and 1-tree giving the best bound in the last propagation. Node 0 is the special
+	// node of the 1-tree, it is joined by its two cheapest edges (to tree_a and tree_b) to a
+	// spanning tree of the other nodes given by parent.
+	vec<double> best_pi;
+	vec<int> parent;
+	int tree_a;
+	int tree_b;
+	double best_bound;
+
+	// Temporary storage
+	vec<int> t_parent;
+	vec<int> degree;
+	vec<double> key;
+	vec<bool> in_tree;
+	vec<vec<int> > children;
+	vec<double> path_max;
+	vec<int> stack;
+
+	long long one_trees{0};
+	long long filtered{0};
+
+	bool available(int i, int j) const { return x[i].indomain(j) || x[j].indomain(i); }
+
+	double rw(const vec<double>& p, int i, int j) const { return w[i][j] + p[i] + p[j]; }
+
+	// Compute a minimum 1-tree for multipliers p, returns false if none exists
+	bool oneTree(const vec<double>& p, double& bound, int& a, int& b) {
+		one_trees++;
+		for (int i = 0; i < n; i++) {
+			degree[i] = 0;
+			in_tree[i] = false;
+			key[i] = HUGE_VAL;
+			t_parent[i] = -1;
+		}
+		bound = 0;
+		// Prim's algorithm over nodes 1 .. n-1
+		key[1] = 0;
+		for (int k = 1; k < n; k++) {
+			int u = -1;
+			for (int i = 1; i < n; i++) {
+				if (!in_tree[i] && (u == -1 || key[i] < key[u])) {
+					u = i;
+				}
+			}
+			if (key[u] == HUGE_VAL) {
+				return false;
+			}
+			in_tree[u] = true;
+			if (t_parent[u] >= 0) {
+				bound += key[u];
+				degree[u]++;
+				degree[t_parent[u]]++;
+			}
+			for (int v = 1; v < n; v++) {
+				if (!in_tree[v] && available(u, v) && rw(p, u, v) < key[v]) {
+					key[v] = rw(p, u, v);
+					t_parent[v] = u;
+				}
+			}
+		}
+		// Two cheapest edges at node 0
+		a = b = -1;
+		for (int v = 1; v < n; v++) {
+			if (!available(0, v)) {
+				continue;
+			}
+			if (a == -1 || rw(p, 0, v) < rw(p, 0, a)) {
+				b = a;
+				a = v;
+			} else if (b == -1 || rw(p, 0, v) < rw(p, 0, b)) {
+				b = v;
+			}
+		}
+		if (b == -1) {
+			return false;
+		}
+		bound += rw(p, 0, a) + rw(p, 0, b);
+		degree[0] = 2;
+		degree[a]++;
+		degree[b]++;
+		for (int i = 0; i < n; i++) {
+			bound -= 2 * p[i];
+		}
+		return true;
+	}
+
+	// Largest reduced weight of an edge in the best 1-tree
+	double treeMax() const {
+		double m = std::max(rw(best_pi, 0, tree_a), rw(best_pi, 0, tree_b));
+		for (int v = 1; v < n; v++) {
+			if (parent[v] >= 0) {
+				m = std::max(m, rw(best_pi, v, parent[v]));
+			}
+		}
+		return m;
+	}
+
+	// The best 1-tree stays optimal as long as no edge with a smaller reduced weight than
+	// threshold comes back, so the removed ones are the explanation.
+	void explainTree(vec<Lit>& ps, double threshold) {
+		for (int i = 0; i < n; i++) {
+			for (int j = i + 1; j < n; j++) {
+				if (!available(i, j) && rw(best_pi, i, j) < threshold - eps) {
+					ps.push(x[i].getLit(j, LR_EQ));
+					ps.push(x[j].getLit(i, LR_EQ));
+				}
+			}
+		}
+	}
+
+	// path_max[v] = largest reduced weight on the tree path from r to v
+	void computePathMax(int r) {
+		path_max[r] = -HUGE_VAL;
+		stack.clear();
+		stack.push(r);
+		for (int i = 1; i < n; i++) {
+			in_tree[i] = false;
+		}
+		in_tree[r] = true;
+		while (stack.size() > 0) {
+			const int u = stack.last();
+			stack.pop();
+			const int pu = parent[u];
+			if (pu >= 0 && !in_tree[pu]) {
+				in_tree[pu] = true;
+				path_max[pu] = std::max(path_max[u], rw(best_pi, u, pu));
+				stack.push(pu);
+			}
+			for (int k = 0; k < children[u].size(); k++) {
+				const int v = children[u][k];
+				if (!in_tree[v]) {
+					in_tree[v] = true;
+					path_max[v] = std::max(path_max[u], rw(best_pi, u, v));
+					stack.push(v);
+				}
+			}
+		}
+	}
+
+	bool removeArc(int i, int j, double threshold) {
+		if (!x[i].indomain(j)) {
+			return true;
+		}
+		Clause* r = nullptr;
+		if (so.lazy) {
+			vec<Lit> ps;
+			ps.push();
+			ps.push(cost.getMaxLit());
+			explainTree(ps, threshold);
+			r = Reason_new(ps);
+		}
+		filtered++;
+		return x[i].remVal(j, r);
+	}
+
+public:
+	WeightedCircuit(vec<IntView<U> >& _x, vec<vec<int> >& c, IntView<> _cost)
+			: n(_x.size()), x(_x), cost(_cost) {
+		priority = 5;
+		w.growTo(n);
+		for (int i = 0; i < n; i++) {
+			w[i].growTo(n, 0);
+			for (int j = 0; j < n; j++) {
+				if (i != j) {
+					w[i][j] = std::min(c[i][j], c[j][i]);
+				}
+			}
+		}
+		pi.growTo(n, 0);
+		best_pi.growTo(n, 0);
+		parent.growTo(n, -1);
+		t_parent.growTo(n, -1);
+		degree.growTo(n, 0);
+		key.growTo(n, 0);
+		in_tree.growTo(n, false);
+		children.growTo(n);
+		path_max.growTo(n, 0);
+
+		for (int i = 0; i < n; i++) {
+			x[i].attach(this, i, EVENT_C);
+		}
+		cost.attach(this, n, EVENT_U);
+	}
+
+	bool propagate() override {
+		if (n < 3) {
+			return true;
+		}
+
+		// Subgradient optimisation of the multipliers, starting from the previous ones
+		const int iterations = engine.decisionLevel() == 0 ? 100 : 10;
+		const double ub = cost.getMax();
+		double lambda = 2;
+		int no_improve = 0;
+		bool found = false;
+		best_bound = -HUGE_VAL;
+		for (int it = 0; it < iterations; it++) {
+			double bound;
+			int a;
+			int b;
+			if (!oneTree(pi, bound, a, b)) {
+				// Disconnected, the circuit propagator will fail
+				return true;
+			}
+			if (!found || bound > best_bound + eps) {
+				found = true;
+				best_bound = bound;
+				tree_a = a;
+				tree_b = b;
+				for (int i = 0; i < n; i++) {
+					best_pi[i] = pi[i];
+					parent[i] = t_parent[i];
+				}
+				no_improve = 0;
+			} else if (++no_improve >= 3) {
+				lambda /= 2;
+				no_improve = 0;
+			}
+			int norm = 0;
+			for (int i = 0; i < n; i++) {
+				norm += (degree[i] - 2) * (degree[i] - 2);
+			}
+			if (norm == 0 || bound > ub + eps) {
+				// The 1-tree is a tour, or the bound already fails
+				break;
+			}
+			// Aim at the upper bound, or a bit above the current bound if cost is (nearly) unbounded
+			const double target = std::min(ub, bound + std::max(1.0, std::fabs(bound) * 0.05));
+			const double step = lambda * (target - bound) / norm;
+			for (int i = 0; i < n; i++) {
+				pi[i] += step * (degree[i] - 2);
+			}
+		}
+		for (int i = 0; i < n; i++) {
+			pi[i] = best_pi[i];
+		}
+
+		const double threshold = treeMax();
+		const int64_t lb = static_cast<int64_t>(std::ceil(best_bound - eps));
+		if (cost.setMinNotR(lb)) {
+			Clause* r = nullptr;
+			if (so.lazy) {
+				vec<Lit> ps;
+				ps.push();
+				explainTree(ps, threshold);
+				r = Reason_new(ps);
+			}
+			if (!cost.setMin(lb, r)) {
+				return false;
+			}
+		}
+
+		// Marginal cost filtering: forcing edge {i, j} into the 1-tree replaces the largest edge on
+		// the tree path between i and j (the larger edge at node 0 if i = 0)
+		for (int i = 0; i < n; i++) {
+			children[i].clear();
+		}
+		for (int v = 1; v < n; v++) {
+			if (parent[v] >= 0) {
+				children[parent[v]].push(v);
+			}
+		}
+		const double ub_now = cost.getMax();
+		const double big_a = std::max(rw(best_pi, 0, tree_a), rw(best_pi, 0, tree_b));
+		for (int j = 1; j < n; j++) {
+			if (j == tree_a || j == tree_b || !available(0, j)) {
+				continue;
+			}
+			const double e = rw(best_pi, 0, j);
+			if (best_bound + e - big_a > ub_now + eps) {
+				if (!removeArc(0, j, std::max(threshold, e)) || !removeArc(j, 0, std::max(threshold, e))) {
+					return false;
+				}
+			}
+		}
+		for (int i = 1; i < n; i++) {
+			computePathMax(i);
+			for (int j = i + 1; j < n; j++) {
+				if (parent[i] == j || parent[j] == i || !available(i, j)) {
+					continue;
+				}
+				const double e = rw(best_pi, i, j);
+				if (best_bound + e - path_max[j] > ub_now + eps) {
+					if (!removeArc(i, j, std::max(threshold, e)) || !removeArc(j, i, std::max(threshold, e))) {
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void printStats() override {
+		printf("%%%%%%mzn-stat: weightedCircuitOneTrees=%lld\n", one_trees);
+		printf("%%%%%%mzn-stat: weightedCircuitFiltered=%lld\n", filtered);
+	}
+};
+
+void weighted_circuit(vec<IntVar*>& _x, vec<vec<int> >& c, IntVar* cost, int offset) {
+	circuit(_x, offset);
+
+	// cost = sum c[i][x[i]]
+	vec<IntVar*> d;
+	for (int i = 0; i < _x.size(); i++) {
+		IntVar* v;
+		createVar(v, *std::min_element((int*)c[i], (int*)c[i] + c[i].size()),
+							*std::max_element((int*)c[i], (int*)c[i] + c[i].size()));
+		array_int_element(_x[i], c[i], v, offset);
+		d.push(v);
+	}
+	int_linear(d, IRT_EQ, cost);
+
+	if (offset == 0) {
+		vec<IntView<> > x;
+		for (int i = 0; i < _x.size(); i++) {
+			x.push(IntView<>(_x[i]));
+		}
+		new WeightedCircuit<0>(x, c, IntView<>(cost));
+	} else {
+		vec<IntView<4> > x;
+		for (int i = 0; i < _x.size(); i++) {
+			x.push(IntView<4>(_x[i], 1, -offset));
+		}
+		new WeightedCircuit<4>(x, c, IntView<>(cost));
+	}
+}
@@ -0,0 +1,248 @@
+#include "chuffed/mdd/mdd_cache.h"
+
+#include "chuffed/core/options.h"
+#include "chuffed/mdd/mdd_prop.h"
+#include "chuffed/mdd/wmdd_prop.h"
+#include "chuffed/support/misc.h"
+#include "chuffed/support/vec.h"
+
+#include <thirdparty/MurmurHash3/MurmurHash3.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bump whenever the layout of the compiled forms changes.
+#define MDD_CACHE_VERSION 1
+
+static const char MDD_CACHE_MAGIC[4] = {'C', 'M', 'D', 'D'};
+
+enum CacheKind { CK_MDD, CK_WMDD };
+
+struct CacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t kind;
+	// Sizes of the stored structs, so a build with a different layout misses
+	uint32_t layout[4];
+	uint32_t key_size;
+};
+
+static void layoutOf(uint32_t* layout) {
+	layout[0] = sizeof(val_entry);
+	layout[1] = sizeof(inc_node);
+	layout[2] = sizeof(inc_edge);
+	layout[3] = sizeof(Edge);
+}
+
+static std::string cachePath(const std::vector<int>& key, int kind) {
+	uint64_t h[2];
+	MurmurHash3_x64_128(key.data(), static_cast<int>(key.size() * sizeof(int)), kind, h);
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mdd", static_cast<unsigned long long>(h[0]));
+	return so.mdd_cache + SEP_ + name;
+}
+
+//-----
+// Reading: the whole file is mapped, checked and copied out.
+
+class CacheReader {
+public:
+	CacheReader(const std::string& path) {
+#ifndef WIN32
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return;
+		}
+		struct stat sbuf;
+		if (fstat(fd, &sbuf) == 0 && sbuf.st_size > 0) {
+			void* p = mmap(nullptr, sbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				data = static_cast<const char*>(p);
+				size = sbuf.st_size;
+			}
+		}
+		::close(fd);
+#else
+		std::ifstream file(path.c_str(), std::ios::binary);
+		if (!file.is_open()) {
+			return;
+		}
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data = buffer.data();
+		size = buffer.size();
+#endif
+	}
+	~CacheReader() {
+#ifndef WIN32
+		if (data != nullptr) {
+			munmap(const_cast<char*>(data), size);
+		}
+#endif
+	}
+	CacheReader(const CacheReader&) = delete;
+	CacheReader& operator=(const CacheReader&) = delete;
+
+	// Checks the header and the key, leaving the reader at the first array
+	bool open(const std::vector<int>& key, int kind) {
+		CacheHeader h;
+		if (!read(&h, sizeof(h))) {
+			return false;
+		}
+		uint32_t layout[4];
+		layoutOf(layout);
+		if (memcmp(h.magic, MDD_CACHE_MAGIC, 4) != 0 || h.version != MDD_CACHE_VERSION ||
+				h.kind != static_cast<uint32_t>(kind) || memcmp(h.layout, layout, sizeof(layout)) != 0 ||
+				h.key_size != key.size()) {
+			return false;
+		}
+		const size_t bytes = key.size() * sizeof(int);
+		if (pos + bytes > size || memcmp(data + pos, key.data(), bytes) != 0) {
+			return false;
+		}
+		pos += bytes;
+		return true;
+	}
+
+	template <class T>
+	bool array(vec<T>& v) {
+		uint32_t n;
+		if (!read(&n, sizeof(n)) || pos + (size_t)n * sizeof(T) > size) {
+			return false;
+		}
+		v.clear();
+		v.growTo(n);
+		if (n > 0) {
+			memcpy((T*)v, data + pos, n * sizeof(T));
+		}
+		pos += n * sizeof(T);
+		return true;
+	}
+
+	bool atEnd() const { return pos == size; }
+
+private:
+	bool read(void* out, size_t bytes) {
+		if (data == nullptr || pos + bytes > size) {
+			return false;
+		}
+		memcpy(out, data + pos, bytes);
+		pos += bytes;
+		return true;
+	}
+
+	const char* data{nullptr};
+	size_t size{0};
+	size_t pos{0};
+#ifdef WIN32
+	std::string buffer;
+#endif
+};
+
+//-----
+// Writing: to a temporary file renamed into place, so concurrent runs never see half an entry.
+
+class CacheWriter {
+public:
+	CacheWriter(const std::vector<int>& key, int kind)
+			: path(cachePath(key, kind)),
+#ifndef WIN32
+				tmp(path + ".tmp" + std::to_string(getpid())),
+#else
+				tmp(path + ".tmp"),
+#endif
+				out(tmp.c_str(), std::ios::binary) {
+		CacheHeader h;
+		memcpy(h.magic, MDD_CACHE_MAGIC, 4);
+		h.version = MDD_CACHE_VERSION;
+		h.kind = kind;
+		layoutOf(h.layout);
+		h.key_size = key.size();
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		out.write(reinterpret_cast<const char*>(key.data()), key.size() * sizeof(int));
+	}
+
+	template <class T>
+	void array(vec<T>& v) {
+		const uint32_t n = v.size();
+		out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+		if (n > 0) {
+			out.write(reinterpret_cast<const char*>((T*)v), n * sizeof(T));
+		}
+	}
+
+	void commit() {
+		out.close();
+		if (!out || std::rename(tmp.c_str(), path.c_str()) != 0) {
+			std::remove(tmp.c_str());
+			if (so.verbosity >= 1) {
+				fprintf(stderr, "%% Cannot write MDD cache entry %s\n", path.c_str());
+			}
+		}
+	}
+
+private:
+	std::string path;
+	std::string tmp;
+	std::ofstream out;
+};
+
+//-----
+
+MDDTemplate* mdd_cache_load(const std::vector<int>& key) {
+	if (so.mdd_cache.empty()) {
+		return nullptr;
+	}
+	CacheReader in(cachePath(key, CK_MDD));
+	auto* templ = new MDDTemplate();
+	if (in.open(key, CK_MDD) && in.array(templ->_doms) && in.array(templ->_val_entries) &&
+			in.array(templ->_mdd_nodes) && in.array(templ->_val_edges) &&
+			in.array(templ->_node_edges) && in.array(templ->_edges) && in.atEnd()) {
+		return templ;
+	}
+	delete templ;
+	return nullptr;
+}
+
+void mdd_cache_store(const std::vector<int>& key, MDDTemplate& templ) {
+	if (so.mdd_cache.empty()) {
+		return;
+	}
+	CacheWriter out(key, CK_MDD);
+	out.array(templ._doms);
+	out.array(templ._val_entries);
+	out.array(templ._mdd_nodes);
+	out.array(templ._val_edges);
+	out.array(templ._node_edges);
+	out.array(templ._edges);
+	out.commit();
+}
+
+bool wmdd_cache_load(const std::vector<int>& key, vec<int>& level, vec<Edge>& edges) {
+	if (so.mdd_cache.empty()) {
+		return false;
+	}
+	CacheReader in(cachePath(key, CK_WMDD));
+	return in.open(key, CK_WMDD) && in.array(level) && in.array(edges) && in.atEnd();
+}
+
+void wmdd_cache_store(const std::vector<int>& key, vec<int>& level, vec<Edge>& edges) {
+	if (so.mdd_cache.empty()) {
+		return;
+	}
+	CacheWriter out(key, CK_WMDD);
+	out.array(level);
+	out.array(edges);
+	out.commit();
+}
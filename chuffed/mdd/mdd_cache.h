@@ -0,0 +1,21 @@
+#ifndef MDD_CACHE_H_
+#define MDD_CACHE_H_
+// On-disk cache of compiled MDDs, enabled by --mdd-cache DIR.
+//
+// Entries are keyed by the flattened arguments of the constraint they were compiled from (see
+// mddglobals.cpp). Each entry is one file, named by a hash of the key, holding a versioned
+// header, the key itself (so a hash collision is a miss) and the raw arrays of the compiled form.
+#include "chuffed/mdd/mdd_prop.h"
+#include "chuffed/mdd/wmdd_prop.h"
+#include "chuffed/support/vec.h"
+
+#include <vector>
+
+// Returns nullptr on a miss, or when the cache is off.
+MDDTemplate* mdd_cache_load(const std::vector<int>& key);
+void mdd_cache_store(const std::vector<int>& key, MDDTemplate& templ);
+
+bool wmdd_cache_load(const std::vector<int>& key, vec<int>& level, vec<Edge>& edges);
+void wmdd_cache_store(const std::vector<int>& key, vec<int>& level, vec<Edge>& edges);
+
+#endif
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <iostream>
 #include <vector>
@@ -28,7 +29,10 @@
 // #define SORTOP >=
 #endif
 
-#define MAXTIME (3 << (sizeof(unsigned int) - 3))
+// Word-level bitsets, as used by fullProp.
+#define BITS_WORDS(n) (((n) + 63) >> 6)
+#define BITS_ELEM(b, i) (((b)[(i) >> 6] >> ((i) & 63)) & 1)
+#define BITS_INSERT(b, i) ((b)[(i) >> 6] |= ((uint64_t)1) << ((i) & 63))
 
 #define IS_DEAD(e) ((e)->kill_flags)
 #define WATCHED_ABOVE(e) (((e)->watch_flags) & 2)
@@ -184,8 +188,16 @@ MDDProp<U>::MDDProp(MDDTemplate* _templ, vec<IntView<U> >& _intvars, const MDDOp
 		}
 	}
 
-	_templ->_node_edges.copyTo(node_edges);
-	_templ->_val_edges.copyTo(val_edges);
+#ifdef USE_WATCHES
+	_templ->_node_edges.copyTo(own_node_edges);
+	_templ->_val_edges.copyTo(own_val_edges);
+	node_edges = own_node_edges;
+	val_edges = own_val_edges;
+#else
+	node_edges = _templ->_node_edges;
+	val_edges = _templ->_val_edges;
+#endif
+	num_val_edges = _templ->_val_edges.size();
 
 	// Attach to the solver.
 	priority = 1;
@@ -737,49 +749,9 @@ void MDDProp<U>::fullConstructReason(int lim, vec<int>& out, Value val) {
 	}
 }
 
-template <int U>
-unsigned char MDDProp<U>::mark_frontier(int node_id, int var, Value val, int lim) {
-	if (node_id == 0) {
-		return 1;
-	}
-
-	inc_node& node = nodes[node_id];
-
-	if (node.stat_flag != 0U) {
-		return node.stat_flag;
-	}
-
-	int* edge = OUT_EDGES(node_id);
-	int* end = OUT_END(node_id);
-
-	unsigned char ret = 2;
-
-	if (node.var == var) {
-		for (; edge != end; edge++) {
-			if (edges[*edge].val == val) {
-				ret |= mark_frontier(edges[*edge].end, var, val, lim);
-			} else {
-				mark_frontier(edges[*edge].end, var, val, lim);
-			}
-		}
-	} else {
-		for (; edge != end; edge++) {
-			const Value v = edges[*edge].val;
-			if (fixedvars.elemLim(lim, v)) {
-				mark_frontier(edges[*edge].end, var, val, lim);
-			} else {
-				ret |= mark_frontier(edges[*edge].end, var, val, lim);
-			}
-		}
-	}
-
-	node.stat_flag = ret;
-	return ret;
-}
-
 template <int U>
 unsigned char MDDProp<U>::mark_frontier_total(int var, Value val, int lim) {
-	int* edge(&(val_edges.last()));
+	int* edge(val_edges + num_val_edges - 1);
 	int* val_start;
 
 	for (int v = val_entries.size() - 1; v >= 0; v--) {
@@ -942,7 +914,6 @@ bool MDDProp<U>::fullProp() {
 	for (int c = 0; c < clear_queue.size(); c++) {
 		assert(fixedvars.elem(clear_queue[c]));
 
-		val_entries[clear_queue[c]].stat_flag = 0;
 		if (val_entries[clear_queue[c]].supp_count == 0) {
 			std::cout << prop_id << "|" << c << "|" << clear_queue[c] << std::endl;
 			std::cout << clear_queue << '\n';
@@ -950,48 +921,101 @@ bool MDDProp<U>::fullProp() {
 
 		assert(val_entries[clear_queue[c]].supp_count > 0);
 		trailChange(val_entries[clear_queue[c]].supp_count, 0);
-		inc_edge* e(edges + *(VAL_EDGES(clear_queue[c])));
-		trailChange(e->kill_flags, 1);
 	}
 	clear_queue.clear();
 
 	// verify();
 
-	nodes[0].stat_flag += 2;
-	nodes[0].stat_flag |= 1;
-
-	if ((nodes[0].stat_flag & MAXTIME) != 0) {
-		nodes[0].stat_flag = 3;
+	// Values are ordered by variable, so the supports in val_edges run layer by layer: one sweep
+	// upwards finds the nodes still reaching the true node, one sweep downwards those still reached
+	// from the root.
+	const int node_words = BITS_WORDS(nodes.size());
 
-		for (int i = 1; i < nodes.size(); i++) {
-			nodes[i].stat_flag = 0;
+	val_live.clear();
+	val_live.growTo(BITS_WORDS(val_entries.size()), 0);
+	for (int i = 0; i < val_entries.size(); i++) {
+		if (!fixedvars.elem(i)) {
+			BITS_INSERT(val_live, i);
 		}
 	}
 
-	for (int i = 0; i < val_entries.size(); i++) {
-		if (fixedvars.elem(i)) {
-			val_entries[i].stat_flag = 0;
-		} else {
-			val_entries[i].stat_flag = 1;
+	reach_below.clear();
+	reach_below.growTo(node_words, 0);
+	BITS_INSERT(reach_below, 0);
+	for (int v = val_entries.size() - 1; v >= 0; v--) {
+		if (BITS_ELEM(val_live, v) == 0) {
+			continue;
+		}
+		for (int* edge = VAL_END(v) - 1; edge >= VAL_EDGES(v); edge--) {
+			const inc_edge& e(edges[*edge]);
+			if (BITS_ELEM(reach_below, e.end) != 0) {
+				BITS_INSERT(reach_below, e.begin);
+			}
 		}
 	}
 
-	const unsigned char res(fullPropRec(1, nodes[0].stat_flag & ~1));
+	const unsigned char res = BITS_ELEM(reach_below, 1);
 	if ((res & 1) != 0) {
-		const int lim = fixedvars.size();
+		reach_above.clear();
+		reach_above.growTo(node_words, 0);
+		BITS_INSERT(reach_above, 1);
+		for (int v = 0; v < val_entries.size(); v++) {
+			if (BITS_ELEM(val_live, v) == 0) {
+				continue;
+			}
+			for (int* edge = VAL_EDGES(v); edge != VAL_END(v); edge++) {
+				const inc_edge& e(edges[*edge]);
+				if (BITS_ELEM(reach_above, e.begin) != 0) {
+					BITS_INSERT(reach_above, e.end);
+				}
+			}
+		}
 
-		for (int i = 0; i < val_entries.size(); i++) {
-			if (val_entries[i].stat_flag == 1) {
-				inferences.push(i);
-				fixedvars.insert(i);
-				val_entries[i].val_lim = lim;
+		// Kill the edges off a root-true path, flagged as the incremental propagator would so the
+		// greedy explanation can walk them: by domain, then from above, then from below.
+		const unsigned int count = fixedvars.size() << 3;
+		for (int k = 0; k < edges.size(); k++) {
+			inc_edge& e(edges[k]);
+			if (e.kill_flags != 0U) {
+				continue;
+			}
+			const bool live = BITS_ELEM(val_live, e.val) != 0;
+			unsigned int flag;
+			if (!live) {
+				flag = 4;
+			} else if (BITS_ELEM(reach_above, e.begin) == 0) {
+				flag = 1;
+			} else if (BITS_ELEM(reach_below, e.end) == 0) {
+				flag = 2;
+			} else {
+				continue;
+			}
+			trailChange(e.kill_flags, count | flag);
+
+			trailChange(nodes[e.begin].count_out, nodes[e.begin].count_out - 1);
+			if (nodes[e.begin].count_out == 0) {
+				nodes[e.begin].kill_flag = count | (BITS_ELEM(reach_above, e.begin) != 0 ? 2 : 1);
+			}
+			trailChange(nodes[e.end].count_in, nodes[e.end].count_in - 1);
+			if (nodes[e.end].count_in == 0) {
+				nodes[e.end].kill_flag = count | (BITS_ELEM(reach_above, e.end) != 0 ? 2 : 1);
+			}
 
-				val_entries[i].stat_flag = 0;
-				trailChange(val_entries[i].supp_count, 0);
-				inc_edge* e(edges + *(VAL_EDGES(i)));
-				trailChange(e->kill_flags, 1);
+			if (live) {
+				val_entry& valent(VAL(e.val));
+				trailChange(valent.supp_count, valent.supp_count - 1);
+				if (valent.supp_count == 0) {
+					inferences.push(e.val);
+				}
 			}
 		}
+
+		std::sort((int*)inferences, (int*)inferences + inferences.size());
+		const int lim = fixedvars.size();
+		for (int i = 0; i < inferences.size(); i++) {
+			fixedvars.insert(inferences[i]);
+			val_entries[inferences[i]].val_lim = lim;
+		}
 	}
 
 	if ((res & 1) == 0) {
@@ -1022,7 +1046,7 @@ bool MDDProp<U>::fullProp() {
 
 		if (intvars[v].remValNotR(val)) {
 			//            Clause* r = NULL;
-			const Reason r = Reason(prop_id, val);
+			const Reason r = Reason(prop_id, inferences[i]);
 			if (so.lazy) {
 				// vec<int> expl;
 				// genReason(expl, inferences[i]);
@@ -1046,35 +1070,6 @@ bool MDDProp<U>::fullProp() {
 #endif
 }
 
-template <int U>
-unsigned char MDDProp<U>::fullPropRec(int node, int timestamp) {
-	if (nodes[node].stat_flag >= timestamp) {
-		return nodes[node].stat_flag & 1;
-	}
-
-#ifdef INSTRUMENT
-//        node_visits++;
-//        if(prop)
-//            (prop->infcount)++;
-#endif
-
-	int* nstart = node_edges + nodes[node].out_start;
-	int* nend = nstart + nodes[node].num_out;
-
-	unsigned char out = 0;
-	for (; nstart < nend; nstart++) {
-		if (val_entries[edges[*nstart].val].stat_flag != 0) {
-			if ((fullPropRec(edges[*nstart].end, timestamp) & 1)) {
-				out = 1;
-				val_entries[edges[*nstart].val].stat_flag = 3;
-			}
-		}
-	}
-	nodes[node].stat_flag = timestamp | out;
-
-	return out;
-}
-
 // Assumes propagator has just been run.
 template <int U>
 void MDDProp<U>::verify() {
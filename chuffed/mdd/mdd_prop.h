@@ -9,6 +9,7 @@
 #include "chuffed/vars/int-view.h"
 
 #include <climits>
+#include <cstdint>
 #include <utility>
 
 #ifdef FULLPROP
@@ -65,6 +66,7 @@ struct val_entry {
 
 class MDDTemplate {
 public:
+	MDDTemplate() = default;
 	MDDTemplate(MDDTable& tab, MDDNodeInt root, vec<int>& domain_sizes);
 
 	vec<int>& getDoms() { return _doms; }
@@ -89,7 +91,6 @@ public:
 	MDDProp(MDDTemplate* /*_templ*/, vec<IntView<U> >& _intvars, const MDDOpts& opts);
 
 	bool fullProp();
-	unsigned char fullPropRec(int node, int timestamp);
 
 	void genReason(vec<int>& out, Value value);
 
@@ -100,7 +101,6 @@ public:
 	//    INT_MAX);
 
 	void fullConstructReason(int lim, vec<int>& out, Value val);
-	unsigned char mark_frontier(int node_id, int var, Value val, int lim);
 	unsigned char mark_frontier_total(int var, Value val, int lim);
 	//    void retrieveReason(vec<int>& out,int var, int val, int lim, int threshold = INT_MAX);
 	void retrieveReason(vec<int>& out, int var, int val, int lim, int threshold = 2);
@@ -184,11 +184,24 @@ private:
 	vec<val_entry> val_entries;
 	vec<inc_node> nodes;
 
-	vec<int> val_edges;
-	vec<int> node_edges;
+	// Supports of each value and edges of each node, read-only and so shared with the template
+	// unless watches reorder them.
+	int* val_edges;
+	int* node_edges;
+	int num_val_edges;
+#ifdef USE_WATCHES
+	vec<int> own_val_edges;
+	vec<int> own_node_edges;
+#endif
 
 	vec<inc_edge> edges;
 
+	// Scratch for fullProp: live values, and nodes reaching the true node from below and reached
+	// from the root above.
+	vec<uint64_t> val_live;
+	vec<uint64_t> reach_below;
+	vec<uint64_t> reach_above;
+
 	double act_decay;
 	double act_inc{1};
 	vec<double> activity;
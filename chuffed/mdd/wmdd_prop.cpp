@@ -181,6 +181,8 @@ WMDDProp::WMDDProp(vec<IntView<> >& _vs, IntView<> _c, vec<int>& _levels, vec<Ed
 	// Also need to wake up if the maximum cost drops.
 	cost.attach(this, boolvars.size(), EVENT_U);
 
+	priority = 3;
+
 	// Ensure all the paths are initialized.
 	const bool okay = fullProp();
 	if (!okay) {
@@ -446,7 +448,7 @@ bool WMDDProp::fullProp() {
 void WMDDProp::incPropDown(vec<int>& clear_queue, int maxC, vec<int>& valQ) {
 	//  for(int ni = 0; ni < nodes.size(); ni++)
 	//    nodes[ni].status = 0;
-	vec<int> downQ;
+	downQ.clear();
 	int clear_idx = 0;
 	int down_idx = 0;
 	int level = -1;
@@ -572,7 +574,7 @@ void WMDDProp::incPropUp(vec<int>& clear_queue, int maxC, vec<int>& valQ) {
 	//  for(int ni = 0; ni < nodes.size(); ni++)
 	//    nodes[ni].status = 0;
 
-	vec<int> upQ;
+	upQ.clear();
 	int clear_idx = clear_queue.size() - 1;
 	int up_idx = 0;
 	int level = nodes[T].var;
@@ -701,7 +703,7 @@ void WMDDProp::incPropUp(vec<int>& clear_queue, int maxC, vec<int>& valQ) {
 
 // Incremental propagation algorithm
 bool WMDDProp::incProp() {
-	vec<int> valQ;
+	valQ.clear();
 	// Changing ub(cost) doesn't change the distance
 	// along any paths; it just eliminates some paths.
 	// So it should be sufficient to check the value watches
@@ -1791,24 +1793,22 @@ void WMDDProp::debugStateDot() {
 // to extract the set of edges, and then traverse the edges to create the propagator.
 // WARNING: At no point have we actually checked to ensure there aren't any long edges.
 //          Or, indeed, that there aren't any repetitions or inversions in variable order.
-WMDDProp* evgraph_to_wmdd(vec<IntVar*> _vs, IntVar* _cost, EVLayerGraph& g,
-													EVLayerGraph::NodeID rootID, const MDDOpts& opts) {
+void evgraph_to_layers(int nvars, EVLayerGraph& g, EVLayerGraph::NodeID rootID, vec<int>& level,
+											 vec<Edge>& edges) {
 	const int nNodes = g.traverse(rootID);
 
-	// Level for each node.
-	vec<int> level;
-
+	// We can't initialize the levels until we traverse.
+	level.clear();
 	for (int ni = 0; ni < nNodes; ni++) {
-		// We can't initialize the levels until we traverse.
 		level.push(0);
 	}
 
 	// Traversal currently skips T.
 	// Set up the level indicator.
-	level[0] = _vs.size();
+	level[0] = nvars;
 
 	// T is 0, root is 1.
-	vec<Edge> edges;
+	edges.clear();
 	for (EVNode curr = g.travBegin(); curr != g.travEnd(); ++curr) {
 		level[curr.id()] = curr.var();
 		for (int ei = 0; ei < curr.size(); ei++) {
@@ -1818,7 +1818,10 @@ WMDDProp* evgraph_to_wmdd(vec<IntVar*> _vs, IntVar* _cost, EVLayerGraph& g,
 			edges.push(e);
 		}
 	}
+}
 
+WMDDProp* layers_to_wmdd(vec<IntVar*> _vs, IntVar* _cost, vec<int>& level, vec<Edge>& edges,
+												 const MDDOpts& opts) {
 	// Set up the views.
 	vec<IntView<> > vs;
 	for (int i = 0; i < _vs.size(); i++) {
@@ -1832,3 +1835,12 @@ WMDDProp* evgraph_to_wmdd(vec<IntVar*> _vs, IntVar* _cost, EVLayerGraph& g,
 	// Create the propagator.
 	return new WMDDProp(vs, cost, level, edges, opts);
 }
+
+WMDDProp* evgraph_to_wmdd(vec<IntVar*> _vs, IntVar* _cost, EVLayerGraph& g,
+													EVLayerGraph::NodeID rootID, const MDDOpts& opts) {
+	// Level for each node.
+	vec<int> level;
+	vec<Edge> edges;
+	evgraph_to_layers(_vs.size(), g, rootID, level, edges);
+	return layers_to_wmdd(_vs, _cost, level, edges, opts);
+}
@@ -239,6 +239,10 @@ protected:
 	// Intermediate state
 	vec<int> clear_queue;
 	bool cost_changed;
+	// Queues of incProp, kept to save reallocating them on every call
+	vec<int> downQ;
+	vec<int> upQ;
+	vec<int> valQ;
 
 	// Keeping track of which nodes have
 	// some path through x=v when doing
@@ -258,5 +262,11 @@ protected:
 // Maybe should move this to a separate module.
 WMDDProp* evgraph_to_wmdd(vec<IntVar*> vs, IntVar* cost, EVLayerGraph& g,
 													EVLayerGraph::NodeID rootID, const MDDOpts& opts);
+// The two halves of evgraph_to_wmdd: the node levels and edges of the graph below rootID depend
+// only on the graph, and can be given to any number of propagators.
+void evgraph_to_layers(int nvars, EVLayerGraph& g, EVLayerGraph::NodeID rootID, vec<int>& level,
+											 vec<Edge>& edges);
+WMDDProp* layers_to_wmdd(vec<IntVar*> vs, IntVar* cost, vec<int>& level, vec<Edge>& edges,
+												 const MDDOpts& opts);
 
 #endif
@@ -0,0 +1,590 @@
+#include "chuffed/core/engine.h"
+#include "chuffed/core/options.h"
+#include "chuffed/mip/mip.h"
+#include "chuffed/mip/simplex.h"
+#include "chuffed/support/vec.h"
+#include "chuffed/vars/int-var.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#define CUT_ROUNDS 10        // separation rounds per propagation at the root
+#define ROUND_CUTS 50        // cuts added to the simplex per round
+#define NODE_CUTS 5          // pool cuts added to the simplex per propagation below the root
+#define GOMORY_ROWS 50       // tableau rows tried per round
+#define MIN_FRAC 0.01        // values closer than this to an integer are not cut
+#define MIN_EFFICACY 1e-3    // distance of the LP solution from a useful cut
+#define MIN_GAIN 1e-3        // root rounds stop when the bound improves by less than this
+#define MAX_DYNAMISM 1e6     // ratio of largest to smallest coefficient of a cut
+#define MAX_PARALLEL 0.999   // cosine above which a cut is a copy of one already added
+#define MAX_DENSITY 0.1      // fraction of the columns a cut may have, dense rows slow the simplex
+#define CUT_SCALE 1000       // largest coefficient of a fractional cut once made integral
+#define MAX_ACTIVITY 1e9     // lhs of a cut must fit the ints of the simplex
+
+// Cuts are separated from the rows of the simplex and the bounds of its columns at the root, so
+// they are implied by the constraints and facts of level 0. They are then used like the
+// constraints: explanations only mention the bounds of the columns.
+
+//-----
+// Bounds
+
+// Column 0 is the objective, negated when maximising, and is not bounded in the simplex
+long long MIP::colMin(int j) const {
+	if (j > 0) {
+		return simplex.lb[j];
+	}
+	return engine.opt_type == OPT_MIN ? vars[0]->getMin() : -vars[0]->getMax();
+}
+
+long long MIP::colMax(int j) const {
+	if (j > 0) {
+		return simplex.ub[j];
+	}
+	return engine.opt_type == OPT_MIN ? vars[0]->getMax() : -vars[0]->getMin();
+}
+
+//-----
+// Cut loops
+
+// Separate rounds of cuts while they move the LP bound
+int MIP::rootCuts() {
+	int r = SIMPLEX_OPTIMAL;
+	for (int round = 0; round < CUT_ROUNDS; round++) {
+		const double bound = simplex.optimum();
+		if (separateCuts() == 0) {
+			break;
+		}
+		cut_rounds++;
+		r = doSimplex();
+		if (r != SIMPLEX_OPTIMAL || simplex.optimum() < bound + MIN_GAIN) {
+			break;
+		}
+	}
+	return r;
+}
+
+// Add the pool cuts which the LP solution violates most
+int MIP::poolCuts() {
+	if (cuts.size() == 0 || simplex.m == simplex.max_m) {
+		return SIMPLEX_OPTIMAL;
+	}
+	simplex.calcPrimal(xs);
+	new_cuts.clear();
+	cut_eff.clear();
+	for (int k = 0; k < cuts.size(); k++) {
+		const Cut& c = cuts[k];
+		if (c.active) {
+			continue;
+		}
+		double act = 0;
+		for (int j = 0; j < c.x.size(); j++) {
+			act += c.a[j] * xs[c.x[j]];
+		}
+		if (act < c.rhs - MIN_EFFICACY) {
+			new_cuts.push(k);
+			cut_eff.push(c.rhs - act);
+		}
+	}
+	if (new_cuts.size() == 0) {
+		return SIMPLEX_OPTIMAL;
+	}
+	vec<int> order(new_cuts.size());
+	for (int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort((int*)order, (int*)order + order.size(),
+						[&](int i, int j) { return cut_eff[i] > cut_eff[j]; });
+	vec<int> ids;
+	for (int i = 0; i < order.size() && ids.size() < NODE_CUTS; i++) {
+		if (simplex.m + ids.size() < simplex.max_m) {
+			ids.push(new_cuts[order[i]]);
+		}
+	}
+	simplex.addRows(cuts, ids);
+	cuts_readded += ids.size();
+	return doSimplex();
+}
+
+// Add the cuts cutting off the LP solution to the pool, and the most efficient of them which are
+// not parallel to each other to the simplex. Returns the number added to the simplex.
+int MIP::separateCuts() {
+	const int n = simplex.n;
+	xs.growTo(n + simplex.max_m);
+	binv.growTo(simplex.max_m);
+	cut_coef.growTo(n, 0);
+	simplex.calcPrimal(xs);
+
+	new_cuts.clear();
+	cut_eff.clear();
+
+	gomoryCuts();
+
+	vec<int> x;
+	vec<long long> a;
+	for (int i = 0; i < simplex.m; i++) {
+		if (simplex.row_id[i] >= root_rows) {
+			continue;
+		}
+		// s = -AH.z lies in [lb, ub], giving AH.z <= -lb and -AH.z <= ub
+		x.clear();
+		a.clear();
+		for (int j = 0; j < simplex.AH_nz[i]; j++) {
+			x.push(simplex.AH[i][j].index());
+			a.push((long long)simplex.AH[i][j].val());
+		}
+		const int s = simplex.n + i;
+		coverCut(x, a, -(long long)simplex.lb[s]);
+		mirCut(x, a, -(long long)simplex.lb[s]);
+		for (int j = 0; j < a.size(); j++) {
+			a[j] = -a[j];
+		}
+		coverCut(x, a, simplex.ub[s]);
+		mirCut(x, a, simplex.ub[s]);
+	}
+
+	vec<int> order(new_cuts.size());
+	for (int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort((int*)order, (int*)order + order.size(),
+						[&](int i, int j) { return cut_eff[i] > cut_eff[j]; });
+
+	vec<int> ids;
+	for (int i = 0; i < order.size(); i++) {
+		if (ids.size() == ROUND_CUTS || simplex.m + ids.size() == simplex.max_m) {
+			break;
+		}
+		const Cut& c = cuts[new_cuts[order[i]]];
+		double norm = 0;
+		for (int j = 0; j < c.x.size(); j++) {
+			cut_coef[c.x[j]] = c.a[j];
+			norm += (double)c.a[j] * c.a[j];
+		}
+		bool parallel = false;
+		for (int k = 0; k < ids.size() && !parallel; k++) {
+			const Cut& d = cuts[ids[k]];
+			double dot = 0;
+			double dnorm = 0;
+			for (int j = 0; j < d.x.size(); j++) {
+				dot += cut_coef[d.x[j]] * d.a[j];
+				dnorm += (double)d.a[j] * d.a[j];
+			}
+			parallel = dot > MAX_PARALLEL * sqrt(norm * dnorm);
+		}
+		for (int j = 0; j < c.x.size(); j++) {
+			cut_coef[c.x[j]] = 0;
+		}
+		if (!parallel) {
+			ids.push(new_cuts[order[i]]);
+		}
+	}
+
+	if (ids.size() > 0) {
+		simplex.addRows(cuts, ids);
+	}
+	if (so.verbosity >= 2) {
+		fprintf(stderr, "%d cuts found, %d added\n", new_cuts.size(), ids.size());
+	}
+	return ids.size();
+}
+
+//-----
+// Separators
+
+// Gomory mixed integer cuts from the tableau rows of the most fractional basic columns. A row
+// z_v + sum g_j w_j = beta over the distances w_j of the non-basic columns from their bounds,
+// all integral, gives sum phi(g_j) w_j >= 1.
+void MIP::gomoryCuts() {
+	const int n = simplex.n;
+	const int m = simplex.m;
+
+	vec<int> rows;
+	vec<double> frac;
+	for (int i = 0; i < m; i++) {
+		const int v = simplex.rtoc[i];
+		if (v == 0) {
+			continue;
+		}
+		const double f = xs[v] - floor(xs[v]);
+		if (f < MIN_FRAC || f > 1 - MIN_FRAC) {
+			continue;
+		}
+		rows.push(i);
+		frac.push(fabs(f - 0.5));
+	}
+	vec<int> order(rows.size());
+	for (int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort((int*)order, (int*)order + order.size(),
+						[&](int i, int j) { return frac[i] < frac[j]; });
+
+	for (int k = 0; k < order.size() && k < GOMORY_ROWS; k++) {
+		const int r = rows[order[k]];
+		const int v = simplex.rtoc[r];
+		simplex.calcBInvRow(binv, r);
+		const double f0 = xs[v] - floor(xs[v]);
+		// binv.M has entry 1 for v, up to the accuracy of the factorisation
+		double pv = 0;
+		if (v >= n) {
+			pv = binv[v - n];
+		} else {
+			for (int t = 0; t < simplex.AV_nz[v]; t++) {
+				pv += binv[simplex.AV[v][t].index()] * simplex.AV[v][t].val();
+			}
+		}
+		if (fabs(pv) < 0.5) {
+			continue;
+		}
+
+		auto phi = [&](double g) {
+			const double f = g - floor(g);
+			if (f < 1e-12 || f > 1 - 1e-12) {
+				return 0.0;
+			}
+			return f <= f0 ? f / f0 : (1 - f) / (1 - f0);
+		};
+
+		// z_j = bound + sign * w_j, where the cut term phi * w_j becomes coef * z_j
+		double d = 1;
+		for (int j = 1; j < n; j++) {
+			if (simplex.ctor[j] >= 0 || simplex.gap(j) == 0) {
+				continue;
+			}
+			double alpha = 0;
+			for (int t = 0; t < simplex.AV_nz[j]; t++) {
+				alpha += binv[simplex.AV[j][t].index()] * simplex.AV[j][t].val();
+			}
+			alpha /= pv;
+			const bool up = simplex.shift[j] != 0;
+			const double c = (up ? -phi(-alpha) : phi(alpha));
+			if (c == 0) {
+				continue;
+			}
+			if (cut_coef[j] == 0) {
+				cut_nz.push(j);
+			}
+			cut_coef[j] += c;
+			d += c * (up ? simplex.ub[j] : simplex.lb[j]);
+		}
+		for (int i = 0; i < m; i++) {
+			const int s = n + i;
+			if (simplex.ctor[s] >= 0 || simplex.gap(s) == 0) {
+				continue;
+			}
+			const bool up = simplex.shift[s] != 0;
+			const double alpha = binv[i] / pv;
+			const double c = (up ? -phi(-alpha) : phi(alpha));
+			if (c == 0) {
+				continue;
+			}
+			d += c * (up ? simplex.ub[s] : simplex.lb[s]);
+			// s = -AH.z
+			for (int t = 0; t < simplex.AH_nz[i]; t++) {
+				const int j = simplex.AH[i][t].index();
+				if (cut_coef[j] == 0) {
+					cut_nz.push(j);
+				}
+				cut_coef[j] -= c * simplex.AH[i][t].val();
+			}
+		}
+		addCut(d, gomory_cuts);
+	}
+}
+
+// Cover of the knapsack made of the binary columns of sum a[k]*z[x[k]] <= b, the other columns
+// taking the bound that makes them smallest. Columns with negative coefficients are complemented.
+void MIP::coverCut(const vec<int>& x, const vec<long long>& a, long long b) {
+	struct Item {
+		int j;
+		long long w;
+		double val;
+		bool neg;
+	};
+	vec<Item> items;
+	for (int k = 0; k < x.size(); k++) {
+		const int j = x[k];
+		const long long lo = colMin(j);
+		const long long hi = colMax(j);
+		if (lo == 0 && hi == 1 && j > 0) {
+			if (a[k] > 0) {
+				items.push({j, a[k], xs[j], false});
+			} else {
+				b -= a[k];
+				items.push({j, -a[k], 1 - xs[j], true});
+			}
+		} else {
+			b -= a[k] > 0 ? a[k] * lo : a[k] * hi;
+		}
+	}
+	if (b < 0 || items.size() < 2) {
+		return;
+	}
+	std::sort((Item*)items, (Item*)items + items.size(), [](const Item& p, const Item& q) {
+		return (1 - p.val) * q.w < (1 - q.val) * p.w;
+	});
+	long long weight = 0;
+	int size = 0;
+	while (size < items.size() && weight <= b) {
+		weight += items[size++].w;
+	}
+	if (weight <= b) {
+		return;
+	}
+	// Make the cover minimal, dropping the items the LP solution uses least first
+	std::sort((Item*)items, (Item*)items + size,
+						[](const Item& p, const Item& q) { return p.val < q.val; });
+	vec<bool> in(items.size(), false);
+	double lhs = 0;
+	int cover = 0;
+	long long wmax = 0;
+	for (int k = 0; k < size; k++) {
+		if (weight - items[k].w > b) {
+			weight -= items[k].w;
+			continue;
+		}
+		in[k] = true;
+		lhs += items[k].val;
+		cover++;
+	}
+	if (lhs <= cover - 1 + MIN_EFFICACY) {
+		return;
+	}
+	for (int k = 0; k < items.size(); k++) {
+		if (in[k]) {
+			wmax = std::max(wmax, items[k].w);
+		}
+	}
+	// Extended cover, sum of the items at least as heavy as the cover ones <= cover - 1
+	double d = -(cover - 1);
+	for (int k = 0; k < items.size(); k++) {
+		if (!in[k] && items[k].w < wmax) {
+			continue;
+		}
+		const int j = items[k].j;
+		cut_nz.push(j);
+		if (items[k].neg) {
+			cut_coef[j] = 1;
+			d += 1;
+		} else {
+			cut_coef[j] = -1;
+		}
+	}
+	addCut(d, cover_cuts);
+}
+
+// Mixed integer rounding of sum a[k]*z[x[k]] <= b. Every column is substituted by its distance y
+// from its nearest bound, the row is divided by the coefficient of a column strictly between its
+// bounds and rounded, keeping the division that cuts the LP solution furthest.
+void MIP::mirCut(const vec<int>& x, const vec<long long>& a, long long b) {
+	vec<double> ay(x.size());
+	vec<double> ys(x.size());
+	vec<bool> up(x.size());
+	double beta = b;
+	vec<double> deltas;
+	for (int k = 0; k < x.size(); k++) {
+		const int j = x[k];
+		const long long lo = colMin(j);
+		const long long hi = colMax(j);
+		up[k] = hi - xs[j] < xs[j] - lo;
+		ay[k] = (up[k] ? -a[k] : a[k]);
+		ys[k] = (up[k] ? hi - xs[j] : xs[j] - lo);
+		beta -= (double)a[k] * (up[k] ? hi : lo);
+		if (ys[k] > MIN_FRAC) {
+			const double delta = fabs(ay[k]);
+			bool seen = false;
+			for (int t = 0; t < deltas.size(); t++) {
+				seen = seen || deltas[t] == delta;
+			}
+			if (!seen && deltas.size() < 8) {
+				deltas.push(delta);
+			}
+		}
+	}
+	double best_eff = MIN_EFFICACY;
+	double best_delta = 0;
+	for (int t = 0; t < deltas.size(); t++) {
+		const double delta = deltas[t];
+		const double bd = beta / delta;
+		const double f0 = bd - floor(bd);
+		if (f0 < MIN_FRAC || f0 > 1 - MIN_FRAC) {
+			continue;
+		}
+		double lhs = 0;
+		double norm = 0;
+		for (int k = 0; k < x.size(); k++) {
+			const double c = ay[k] / delta;
+			const double f = c - floor(c);
+			const double g = floor(c) + std::max(0.0, f - f0) / (1 - f0);
+			lhs += g * ys[k];
+			norm += g * g;
+		}
+		if (norm == 0) {
+			continue;
+		}
+		const double eff = (lhs - floor(bd)) / sqrt(norm);
+		if (eff > best_eff) {
+			best_eff = eff;
+			best_delta = delta;
+		}
+	}
+	if (best_delta == 0) {
+		return;
+	}
+
+	// sum g_k y_k <= floor(beta / delta), negated to sum -g_k y_k >= -floor(beta / delta)
+	const double bd = beta / best_delta;
+	const double f0 = bd - floor(bd);
+	double d = -floor(bd);
+	for (int k = 0; k < x.size(); k++) {
+		const double c = ay[k] / best_delta;
+		const double f = c - floor(c);
+		const double g = floor(c) + std::max(0.0, f - f0) / (1 - f0);
+		if (g == 0) {
+			continue;
+		}
+		const int j = x[k];
+		if (cut_coef[j] == 0) {
+			cut_nz.push(j);
+		}
+		if (up[k]) {
+			// y = hi - z
+			cut_coef[j] += g;
+			d += g * colMax(j);
+		} else {
+			// y = z - lo
+			cut_coef[j] -= g;
+			d -= g * colMin(j);
+		}
+	}
+	addCut(d, mir_cuts);
+}
+
+//-----
+// Cut pool
+
+// Make sum cut_coef[j]*z[j] >= d integral, rounding each coefficient the way that loses least at
+// the LP solution, and add it to the pool if it still cuts the LP solution off. Clears cut_coef.
+void MIP::addCut(double d, long long& counter) {
+	double maxabs = 0;
+	for (int k = 0; k < cut_nz.size(); k++) {
+		maxabs = std::max(maxabs, fabs(cut_coef[cut_nz[k]]));
+	}
+	bool integral = true;
+	for (int k = 0; k < cut_nz.size(); k++) {
+		const int j = cut_nz[k];
+		double& c = cut_coef[j];
+		// tiny coefficients are replaced by the bound that weakens the cut
+		if (fabs(c) * MAX_DYNAMISM < maxabs) {
+			d -= c > 0 ? c * colMax(j) : c * colMin(j);
+			c = 0;
+		}
+		integral = integral && c == floor(c);
+	}
+
+	Cut cut;
+	bool valid = maxabs > 0;
+	if (valid) {
+		const double scale = (integral ? 1 : CUT_SCALE / maxabs);
+		double sd = scale * d;
+		for (int k = 0; k < cut_nz.size(); k++) {
+			const int j = cut_nz[k];
+			if (cut_coef[j] == 0) {
+				continue;
+			}
+			const double lo = colMin(j);
+			const double hi = colMax(j);
+			const double sc = scale * cut_coef[j];
+			cut_coef[j] = 0;  // a column may appear twice in cut_nz
+			const double fl = floor(sc);
+			const double f = sc - fl;
+			// a*z >= sc*z - f*hi when rounding down, a*z >= sc*z + (1 - f)*lo when rounding up
+			long long aj;
+			if (f * (hi - xs[j]) <= (1 - f) * (xs[j] - lo)) {
+				aj = (long long)fl;
+				sd -= f * hi;
+			} else {
+				aj = (long long)fl + 1;
+				sd += (1 - f) * lo;
+			}
+			if (aj != 0) {
+				cut.x.push(j);
+				cut.a.push((int)aj);
+			}
+			valid = valid && fabs(fl) < MAX_ACTIVITY;
+		}
+		valid = valid && fabs(sd) < MAX_ACTIVITY && cut.x.size() > 0;
+		if (valid) {
+			long long rhs = (long long)ceil(sd - 1e-6);
+			long long g = 0;
+			for (int k = 0; k < cut.a.size(); k++) {
+				long long p = std::abs((long long)cut.a[k]);
+				while (p != 0) {
+					const long long t = g % p;
+					g = p;
+					p = t;
+				}
+			}
+			if (g > 1) {
+				for (int k = 0; k < cut.a.size(); k++) {
+					cut.a[k] /= g;
+				}
+				rhs = (rhs >= 0 ? (rhs + g - 1) / g : -(-rhs / g));
+			}
+			cut.rhs = (int)rhs;
+		}
+	}
+	for (int k = 0; k < cut_nz.size(); k++) {
+		cut_coef[cut_nz[k]] = 0;
+	}
+	cut_nz.clear();
+	if (!valid) {
+		return;
+	}
+
+	if (cut.x.size() > 10 && cut.x.size() > MAX_DENSITY * simplex.n) {
+		return;
+	}
+
+	long long min_act = 0;
+	long long max_act = 0;
+	double act = 0;
+	double norm = 0;
+	uint64_t h = (uint64_t)cut.rhs;
+	for (int k = 0; k < cut.x.size(); k++) {
+		const long long a = cut.a[k];
+		const int j = cut.x[k];
+		min_act += std::min(a * colMin(j), a * colMax(j));
+		max_act += std::max(a * colMin(j), a * colMax(j));
+		act += a * xs[j];
+		norm += (double)(a * a);
+		h = h * 1000003 + (uint64_t)j;
+		h = h * 1000003 + (uint64_t)a;
+	}
+	if (std::max(std::abs(min_act), std::abs(max_act)) >= MAX_ACTIVITY) {
+		return;
+	}
+	// redundant, or one the root bounds already violate and which is better left to them
+	if (cut.rhs <= min_act || cut.rhs > max_act) {
+		return;
+	}
+	const double eff = (cut.rhs - act) / sqrt(norm);
+	if (eff < MIN_EFFICACY || !cut_set.insert(h).second) {
+		return;
+	}
+	cut.ub = (int)max_act;
+
+	cuts.push();
+	Cut& c = cuts.last();
+	cut.x.copyTo(c.x);
+	cut.a.copyTo(c.a);
+	c.rhs = cut.rhs;
+	c.ub = cut.ub;
+	new_cuts.push(cuts.size() - 1);
+	cut_eff.push(eff);
+	counter++;
+}
@@ -21,11 +21,12 @@
 
 #define MIP_DEBUG 0
 #define RC_BOUNDS 1
-#define DEFAULT_ROUNDS 0
+#define DEFAULT_ROUNDS 10
 #define RESTORE_ROOT 0
 #define RAND_RC 1
 #define ULEVEL_LIMIT 3
 #define LLEVEL_LIMIT 3
+#define RESTORE_PIVOTS 10
 
 MIP* mip;
 
@@ -81,6 +82,7 @@ void MIP::init() {
 
 	RL.growTo(vars.size());
 	place.growTo(vars.size());
+	root_rows = ineqs.size();
 
 	simplex.init();
 }
@@ -96,7 +98,15 @@ bool MIP::propagate() {
 
 	updateBounds();
 
+	const long long pivots = simplex.simplexs;
 	status = doSimplex();
+	if (status == SIMPLEX_OPTIMAL) {
+		status = (decisionLevel() == 0 ? rootCuts() : poolCuts());
+	}
+	if (decisionLevel() > 0 && simplex.simplexs > pivots) {
+		resolves++;
+		resolve_pivots += simplex.simplexs - pivots;
+	}
 
 	//	printObjective();
 	//	checkObjective();
@@ -132,12 +142,20 @@ void MIP::clearPropState() {
 //-----
 // Interface methods
 
-void MIP::newDecisionLevel() { bctrail_lim.push(bctrail.size()); }
+void MIP::newDecisionLevel() {
+	bctrail_lim.push(bctrail.size());
+	basis_lim.push(simplex.basis_trail.size());
+}
 
 void MIP::btToLevel(int level) {
+	if (decisionLevel() <= level) {
+		return;
+	}
 	if (RESTORE_ROOT && level == 0) {
 		bctrail.resize(bctrail_lim[0]);
 		bctrail_lim.resize(0);
+		simplex.basis_trail.clear();
+		basis_lim.resize(0);
 		simplex.loadState(simplex.root);
 		return;
 	}
@@ -149,6 +167,16 @@ void MIP::btToLevel(int level) {
 	}
 	bctrail.resize(bctrail_lim[level]);
 	bctrail_lim.resize(level);
+	// The basis the LP had at this level is a warm start for its bounds, worth a refactor if the
+	// deeper levels moved far from it. Otherwise their pivots now count as made at this level.
+	if (simplex.basis_trail.size() - basis_lim[level] >= RESTORE_PIVOTS) {
+		simplex.restoreBasis(basis_lim[level]);
+		basis_restores++;
+	}
+	if (level == 0) {
+		simplex.basis_trail.clear();
+	}
+	basis_lim.resize(level);
 	if (level > 0) {
 		//		printf("reset level limit\n");
 		level_lb = level - LLEVEL_LIMIT;
@@ -191,21 +219,7 @@ bool MIP::propagateAllBounds() {
 
 	const bool rc = false;
 
-	ps.clear();
-
-	if (so.lazy) {
-		place[0] = 0;
-		ps.push(engine.opt_type == OPT_MIN ? vars[0]->getMaxLit() : vars[0]->getMinLit());
-		for (int i = 1; i < vars.size(); i++) {
-			place[i] = ps.size();
-			if (RL[i] > 0) {
-				ps.push(vars[i]->getMinLit());
-			}
-			if (RL[i] < 0) {
-				ps.push(vars[i]->getMaxLit());
-			}
-		}
-	}
+	ps_ready = false;
 
 	// Propagate bounds on all vars
 
@@ -261,8 +275,12 @@ bool MIP::propagateBound(int i, long double s) {
 	const int64_t max = v.getMin() + (int64_t)floor(s);
 	//	fprintf(stderr, "%.3Lf %lld %lld %lld\n", s, v.getMin(), v.getMax(), max);
 	if (v.setMaxNotR(max)) {
+		if (i > 0) {
+			rc_fixings++;
+		}
 		Clause* m_r = nullptr;
 		if (so.lazy) {
+			explainBounds();
 			m_r = Clause_new(ps);
 			(*m_r)[place[i]] = (*m_r)[0];
 			m_r->temp_expl = 1;
@@ -275,6 +293,28 @@ bool MIP::propagateBound(int i, long double s) {
 	return true;
 }
 
+// The objective row gives obj = optimum + sum RL[i] * (x_i - bound_i) over every solution of the
+// rows, so the bound on the objective and the bounds the non-basic columns sit at explain any
+// bound derived from it. Built once per propagation, and only if something is propagated.
+void MIP::explainBounds() {
+	if (ps_ready) {
+		return;
+	}
+	ps_ready = true;
+	ps.clear();
+	place[0] = 0;
+	ps.push(engine.opt_type == OPT_MIN ? vars[0]->getMaxLit() : vars[0]->getMinLit());
+	for (int i = 1; i < vars.size(); i++) {
+		place[i] = ps.size();
+		if (RL[i] > 0) {
+			ps.push(vars[i]->getMinLit());
+		}
+		if (RL[i] < 0) {
+			ps.push(vars[i]->getMaxLit());
+		}
+	}
+}
+
 long double MIP::objVarBound() {
 	return engine.opt_type == OPT_MIN ? vars[0]->getMax() : -vars[0]->getMin();
 }
@@ -386,4 +426,17 @@ int MIP::doSimplex() const {
 void MIP::printStats() {
 	printf("%%%%%%mzn-stat: simplex=%lld\n", simplex.simplexs);
 	printf("%%%%%%mzn-stat: refactors=%lld\n", simplex.refactors);
+	printf("%%%%%%mzn-stat: hypersparseSolves=%lld\n", simplex.hyper_solves);
+	printf("%%%%%%mzn-stat: simplexTime=%.3f\n", to_sec(simplex_time));
+	printf("%%%%%%mzn-stat: resolves=%lld\n", resolves);
+	printf("%%%%%%mzn-stat: resolvePivots=%lld\n", resolve_pivots);
+	printf("%%%%%%mzn-stat: basisRestores=%lld\n", basis_restores);
+	printf("%%%%%%mzn-stat: rcFixings=%lld\n", rc_fixings);
+	printf("%%%%%%mzn-stat: cutRounds=%lld\n", cut_rounds);
+	printf("%%%%%%mzn-stat: cutPool=%d\n", cuts.size());
+	printf("%%%%%%mzn-stat: cutRows=%d\n", simplex.m - root_rows);
+	printf("%%%%%%mzn-stat: gomoryCuts=%lld\n", gomory_cuts);
+	printf("%%%%%%mzn-stat: coverCuts=%lld\n", cover_cuts);
+	printf("%%%%%%mzn-stat: mirCuts=%lld\n", mir_cuts);
+	printf("%%%%%%mzn-stat: cutsReadded=%lld\n", cuts_readded);
 }
@@ -2,10 +2,13 @@
 #define mip_h
 
 #include "chuffed/core/propagator.h"
+#include "chuffed/mip/simplex.h"
 #include "chuffed/support/misc.h"
 
+#include <cstdint>
 #include <map>
 #include <set>
+#include <unordered_set>
 
 class VarGroup;
 
@@ -41,11 +44,13 @@ public:
 	vec<LinearIneq> ineqs;
 
 	vec<long double> RL;
-	vec<Lit> ps;
+	vec<Lit> ps;  // explanation of the bounds propagated from the reduced costs
+	bool ps_ready{false};
 	vec<int> place;
 
 	vec<BoundChange> bctrail;
 	vec<int> bctrail_lim;
+	vec<int> basis_lim;  // size of simplex.basis_trail at the start of each level
 
 	int level_lb{-1};
 	int level_ub{-1};
@@ -54,10 +59,31 @@ public:
 
 	duration simplex_time;
 
+	long long resolves{0};        // propagations below the root that pivoted
+	long long resolve_pivots{0};  // pivots made by them
+	long long basis_restores{0};  // backtracks that went back to the basis of their level
+	long long rc_fixings{0};      // variable bounds tightened by reduced costs
+
+	vec<Cut> cuts;                        // cut pool, inactive cuts are added when violated
+	std::unordered_set<uint64_t> cut_set;  // hashes of the cuts in the pool
+	int root_rows{0};                     // rows of the simplex that are constraints
+
+	long long cut_rounds{0};
+	long long gomory_cuts{0};
+	long long cover_cuts{0};
+	long long mir_cuts{0};
+	long long cuts_readded{0};  // pool cuts added to the simplex below the root
+
 	VarGroup* toplevelgroup;
 
 	// temp data
 	vec<int> new_bc;
+	vec<double> xs;        // LP solution over all columns
+	vec<double> binv;      // row of B^-1
+	vec<double> cut_coef;  // cut being built, over the structural columns
+	vec<int> cut_nz;       // non-zeros of cut_coef
+	vec<int> new_cuts;
+	vec<double> cut_eff;  // efficacy of new_cuts
 
 	MIP();
 
@@ -89,8 +115,21 @@ public:
 	bool propagateAllBounds();
 	template <int T>
 	bool propagateBound(int i, long double s);
+	void explainBounds();
 	long double objVarBound();
 
+	// Cut methods
+
+	int rootCuts();
+	int poolCuts();
+	int separateCuts();
+	void gomoryCuts();
+	void coverCut(const vec<int>& x, const vec<long long>& a, long long b);
+	void mirCut(const vec<int>& x, const vec<long long>& a, long long b);
+	void addCut(double d, long long& counter);
+	long long colMin(int j) const;
+	long long colMax(int j) const;
+
 	// Inline functions
 
 	inline int decisionLevel() const { return bctrail_lim.size(); }
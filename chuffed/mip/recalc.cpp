@@ -3,17 +3,22 @@
 
 #include <algorithm>
 #include <cassert>
-#include <cstddef>
+#include <climits>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 
-void LUFactor::multiply(long double* a) {
+#define HYPERSPARSE_LIMIT 0.1  // largest fraction of positions reached by a hypersparse solve
+#define MARKOWITZ_TOL 0.1      // smallest pivot relative to the largest entry of its column
+#define MARKOWITZ_SEARCH 4     // number of columns and rows searched for a pivot
+
+void LUFactor::multiply(double* a) {
 	for (int i = 0; i < vals.size(); i++) {
 		a[r] += a[vals[i].index()] * vals[i].val();
 	}
 }
 
-void LUFactor::Tmultiply(long double* a) {
+void LUFactor::Tmultiply(double* a) {
 	if (a[r] != 0) {
 		for (int i = 0; i < vals.size(); i++) {
 			a[vals[i].index()] += vals[i].val() * a[r];
@@ -21,37 +26,63 @@ void LUFactor::Tmultiply(long double* a) {
 	}
 }
 
-void Simplex::Lmultiply(long double* a) {
-	for (int i = L_cols_zeros; i < m; i++) {
-		tm[i] = 0;
+void CountLists::init(int n) {
+	head.clear();
+	head.growTo(n + 1, -1);
+	next.clear();
+	next.growTo(n, -1);
+	prev.clear();
+	prev.growTo(n, -1);
+	count.clear();
+	count.growTo(n, -1);
+}
+
+void CountLists::insert(int i, int c) {
+	count[i] = c;
+	prev[i] = -1;
+	next[i] = head[c];
+	if (head[c] >= 0) {
+		prev[head[c]] = i;
 	}
-	for (int i = L_cols_zeros; i < m; i++) {
-		if (a[i] != 0) {
-			for (int j = 0; j < L_cols[i].size(); j++) {
-				tm[L_cols[i][j].index()] += a[i] * L_cols[i][j].val();
-			}
-		}
-		a[i] += tm[i];
-		checkZero13(a[i]);
+	head[c] = i;
+}
+
+void CountLists::remove(int i) {
+	if (prev[i] >= 0) {
+		next[prev[i]] = next[i];
+	} else {
+		head[count[i]] = next[i];
+	}
+	if (next[i] >= 0) {
+		prev[next[i]] = prev[i];
 	}
 }
 
-void Simplex::LTmultiply(long double* a) {
+void Simplex::Lmultiply(double* a) {
 	for (int i = L_cols_zeros; i < m; i++) {
-		tm[i] = 0;
+		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		for (int j = 0; j < L_cols[i].size(); j++) {
+			a[L_cols[i][j].index()] -= a[i] * L_cols[i][j].val();
+		}
 	}
+}
+
+void Simplex::LTmultiply(double* a) {
 	for (int i = m - 1; i >= L_cols_zeros; i--) {
-		if (a[i] != 0) {
-			for (int j = 0; j < L_rows[i].size(); j++) {
-				tm[L_rows[i][j].index()] += a[i] * L_rows[i][j].val();
-			}
-		}
-		a[i] += tm[i];
 		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		for (int j = 0; j < L_rows[i].size(); j++) {
+			a[L_rows[i][j].index()] -= a[i] * L_rows[i][j].val();
+		}
 	}
 }
 
-void Simplex::Umultiply(long double* a) {
+void Simplex::Umultiply(double* a) {
 	for (int k = m - 1; k >= U_diag_units; k--) {
 		const int i = U_perm[k];
 		checkZero13(a[i]);
@@ -65,7 +96,7 @@ void Simplex::Umultiply(long double* a) {
 	}
 }
 
-void Simplex::UTmultiply(long double* a) {
+void Simplex::UTmultiply(double* a) {
 	for (int k = 0; k < m; k++) {
 		const int i = U_perm[k];
 		checkZero13(a[i]);
@@ -79,7 +110,7 @@ void Simplex::UTmultiply(long double* a) {
 	}
 }
 
-void Simplex::Bmultiply(long double* a) {
+void Simplex::Bmultiply(double* a) {
 	Lmultiply(a);
 	for (int i = 0; i < num_lu_factors; i++) {
 		lu_factors[i].multiply(a);
@@ -87,8 +118,8 @@ void Simplex::Bmultiply(long double* a) {
 	Umultiply(a);
 }
 
-void Simplex::calcBInvRow(long double* a, int r) {
-	memset(a, 0, m * sizeof(long double));
+void Simplex::calcBInvRow(double* a, int r) {
+	memset(a, 0, m * sizeof(double));
 	a[r] = 1;
 	UTmultiply(a);
 	for (int i = num_lu_factors; (i--) != 0;) {
@@ -97,6 +128,206 @@ void Simplex::calcBInvRow(long double* a, int r) {
 	LTmultiply(a);
 }
 
+//-----
+// Hypersparse solves
+
+// Replace nz by the positions reachable from it through adj, ordered so that each position comes
+// before every position it reaches. Fails when so many are reached that a dense solve is cheaper.
+bool Simplex::sparseReach(const vec<vec<IndexVal> >& adj, vec<int>& nz) {
+	const int limit = static_cast<int>(HYPERSPARSE_LIMIT * m);
+	if (nz.size() > limit) {
+		return false;
+	}
+	if (++reach_stamp == INT_MAX) {
+		for (int i = 0; i < m; i++) {
+			reach_mark[i] = 0;
+		}
+		reach_stamp = 1;
+	}
+	reach_order.clear();
+	for (int s = 0; s < nz.size(); s++) {
+		if (reach_mark[nz[s]] == reach_stamp) {
+			continue;
+		}
+		reach_mark[nz[s]] = reach_stamp;
+		dfs_node.push(nz[s]);
+		dfs_child.push(0);
+		while (dfs_node.size() > 0) {
+			const int u = dfs_node.last();
+			const int k = dfs_child.last()++;
+			if (k < adj[u].size()) {
+				const int w = adj[u][k].index();
+				if (reach_mark[w] != reach_stamp) {
+					reach_mark[w] = reach_stamp;
+					dfs_node.push(w);
+					dfs_child.push(0);
+				}
+				continue;
+			}
+			dfs_node.pop();
+			dfs_child.pop();
+			reach_order.push(u);
+			if (reach_order.size() > limit) {
+				dfs_node.clear();
+				dfs_child.clear();
+				return false;
+			}
+		}
+	}
+	nz.clear();
+	for (int i = reach_order.size(); (i--) != 0;) {
+		nz.push(reach_order[i]);
+	}
+	hyper_solves++;
+	return true;
+}
+
+void Simplex::setDense(vec<int>& nz) const {
+	nz.clear();
+	for (int i = 0; i < m; i++) {
+		nz.push(i);
+	}
+}
+
+void Simplex::Lmultiply(double* a, vec<int>& nz) {
+	if (!sparseReach(L_cols, nz)) {
+		Lmultiply(a);
+		setDense(nz);
+		return;
+	}
+	for (int k = 0; k < nz.size(); k++) {
+		const int i = nz[k];
+		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		for (int j = 0; j < L_cols[i].size(); j++) {
+			a[L_cols[i][j].index()] -= a[i] * L_cols[i][j].val();
+		}
+	}
+}
+
+void Simplex::LTmultiply(double* a, vec<int>& nz) {
+	if (!sparseReach(L_rows, nz)) {
+		LTmultiply(a);
+		setDense(nz);
+		return;
+	}
+	for (int k = 0; k < nz.size(); k++) {
+		const int i = nz[k];
+		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		for (int j = 0; j < L_rows[i].size(); j++) {
+			a[L_rows[i][j].index()] -= a[i] * L_rows[i][j].val();
+		}
+	}
+}
+
+void Simplex::Umultiply(double* a, vec<int>& nz) {
+	if (!sparseReach(U_cols, nz)) {
+		Umultiply(a);
+		setDense(nz);
+		return;
+	}
+	for (int k = 0; k < nz.size(); k++) {
+		const int i = nz[k];
+		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		a[i] /= U_diag[i];
+		for (int j = 0; j < U_cols[i].size(); j++) {
+			a[U_cols[i][j].index()] -= a[i] * U_cols[i][j].val();
+		}
+	}
+}
+
+void Simplex::UTmultiply(double* a, vec<int>& nz) {
+	if (!sparseReach(U_rows, nz)) {
+		UTmultiply(a);
+		setDense(nz);
+		return;
+	}
+	for (int k = 0; k < nz.size(); k++) {
+		const int i = nz[k];
+		checkZero13(a[i]);
+		if (a[i] == 0) {
+			continue;
+		}
+		a[i] /= U_diag[i];
+		for (int j = 0; j < U_rows[i].size(); j++) {
+			a[U_rows[i][j].index()] -= a[i] * U_rows[i][j].val();
+		}
+	}
+}
+
+// The row etas only ever fill in their own row. A pattern that is still sparse has all its
+// positions marked by the sparseReach that produced it.
+void Simplex::Fmultiply(double* a, vec<int>& nz) {
+	const bool dense = (nz.size() == m);
+	for (int i = 0; i < num_lu_factors; i++) {
+		LUFactor& f = lu_factors[i];
+		f.multiply(a);
+		if (!dense && a[f.r] != 0 && reach_mark[f.r] != reach_stamp) {
+			reach_mark[f.r] = reach_stamp;
+			nz.push(f.r);
+		}
+	}
+}
+
+void Simplex::FTmultiply(double* a, vec<int>& nz) {
+	const bool dense = (nz.size() == m);
+	for (int i = num_lu_factors; (i--) != 0;) {
+		LUFactor& f = lu_factors[i];
+		if (a[f.r] == 0) {
+			continue;
+		}
+		f.Tmultiply(a);
+		if (dense) {
+			continue;
+		}
+		for (int j = 0; j < f.vals.size(); j++) {
+			const int k = f.vals[j].index();
+			if (reach_mark[k] != reach_stamp) {
+				reach_mark[k] = reach_stamp;
+				nz.push(k);
+			}
+		}
+	}
+}
+
+void Simplex::Bmultiply(double* a, vec<int>& nz) {
+	Lmultiply(a, nz);
+	Fmultiply(a, nz);
+	Umultiply(a, nz);
+}
+
+void Simplex::calcBInvRow(double* a, int r, vec<int>& nz) {
+	memset(a, 0, m * sizeof(double));
+	a[r] = 1;
+	nz.clear();
+	nz.push(r);
+	UTmultiply(a, nz);
+	FTmultiply(a, nz);
+	LTmultiply(a, nz);
+}
+
+// Entry in the pivot row of B^-1 times the pivot column
+double Simplex::pivotColumnEntry() {
+	memset(tm, 0, m * sizeof(double));
+	tm_nz.clear();
+	for (int i = 0; i < AV_nz[pivot_col]; i++) {
+		tm[AV[pivot_col][i].index()] = AV[pivot_col][i].val();
+		tm_nz.push(AV[pivot_col][i].index());
+	}
+	Bmultiply(tm, tm_nz);
+	return tm[pivot_row];
+}
+
+//-----
+
 void Simplex::calcRHS() {
 	for (int i = 0; i < m; i++) {
 		rhs[i] = BC[i];
@@ -104,6 +335,20 @@ void Simplex::calcRHS() {
 	Bmultiply(rhs);
 }
 
+// Values of all columns in the current basic solution
+void Simplex::calcPrimal(double* x) {
+	calcRHS();
+	for (int i = 0; i < n + m; i++) {
+		if (ctor[i] == -1) {
+			x[i] = (shift[i] != 0 ? ub[i] : lb[i]);
+		}
+	}
+	for (int i = 0; i < m; i++) {
+		const int v = rtoc[i];
+		x[v] = rhs[i] + (shift[v] != 0 ? ub[v] : lb[v]);
+	}
+}
+
 void Simplex::calcObjective() {
 	calcBInvRow(&obj[n], ctor[0]);
 	for (int i = 0; i < m; i++) {
@@ -136,33 +381,32 @@ void Simplex::calcObjBound() {
 
 void Simplex::updateBasis() {
 	// find new column
-	memset(column, 0, m * sizeof(long double));
+	memset(column, 0, m * sizeof(double));
+	col_nz.clear();
 	for (int i = 0; i < AV_nz[pivot_col]; i++) {
 		column[AV[pivot_col][i].index()] = AV[pivot_col][i].val();
+		col_nz.push(AV[pivot_col][i].index());
 	}
-	Lmultiply(column);
-	for (int i = 0; i < num_lu_factors; i++) {
-		lu_factors[i].multiply(column);
-	}
+	Lmultiply(column, col_nz);
+	Fmultiply(column, col_nz);
 
 	if (STEEPEST_EDGE) {
 		// calc Y
-		for (int i = 0; i < m; i++) {
-			Y[i] = column[i];
+		memset(Y, 0, m * sizeof(double));
+		for (int i = 0; i < col_nz.size(); i++) {
+			Y[col_nz[i]] = column[col_nz[i]];
 		}
-		Umultiply(Y);
+		col_nz.copyTo(Y_nz);
+		Umultiply(Y, Y_nz);
 
 		// calculate BZ
-		if (shift[rtoc[pivot_row]] == 0) {
-			for (int i = 0; i < m; i++) {
-				BZ[i] = Z[i];
-			}
-		} else {
-			for (int i = 0; i < m; i++) {
-				BZ[i] = -Z[i];
-			}
+		memset(BZ, 0, m * sizeof(double));
+		const double sign = (shift[rtoc[pivot_row]] == 0 ? 1 : -1);
+		for (int i = 0; i < Z_nz.size(); i++) {
+			BZ[Z_nz[i]] = sign * Z[Z_nz[i]];
 		}
-		Bmultiply(BZ);
+		Z_nz.copyTo(BZ_nz);
+		Bmultiply(BZ, BZ_nz);
 
 		updateNorms();
 	}
@@ -171,40 +415,47 @@ void Simplex::updateBasis() {
 
 	//	fprintf(stderr, "r = %d\n", r);
 
-	// get rth row in dense form
-	memset(tm, 0, m * sizeof(long double));
-	for (int i = 0; i < U_rows[r].size(); i++) {
-		tm[U_rows[r][i].index()] = U_rows[r][i].val();
+	int inv_r = 0;
+	while (U_perm[inv_r] != r) {
+		inv_r++;
 	}
 
 	LUFactor& f = lu_factors[num_lu_factors++];
 	f.r = r;
 	f.vals.clear();
 
-	int inv_r = 0;
-	while (U_perm[inv_r] != r) {
-		inv_r++;
+	// clear rth row using the rows below it, which is a triangular solve with the rth row
+	memset(tm, 0, m * sizeof(double));
+	tm_nz.clear();
+	for (int i = 0; i < U_rows[r].size(); i++) {
+		tm[U_rows[r][i].index()] = U_rows[r][i].val();
+		tm_nz.push(U_rows[r][i].index());
 	}
-
-	//	fprintf(stderr, "%d %d, ", inv_r, last_nz);
-
-	// clear rth row
-	for (int k = inv_r + 1; k < m; k++) {
-		const int i = U_perm[k];
+	const auto clearRow = [&](int i) {
 		checkZero13(tm[i]);
 		if (tm[i] == 0) {
-			continue;
+			return;
 		}
-		const long double a = -tm[i] / U_diag[i];
+		const double a = -tm[i] / U_diag[i];
 		f.vals.push(IndexVal(i, a));
 		for (int j = 0; j < U_rows[i].size(); j++) {
 			tm[U_rows[i][j].index()] += a * U_rows[i][j].val();
 		}
+	};
+	if (sparseReach(U_rows, tm_nz)) {
+		for (int k = 0; k < tm_nz.size(); k++) {
+			clearRow(tm_nz[k]);
+		}
+	} else {
+		for (int k = inv_r + 1; k < m; k++) {
+			clearRow(U_perm[k]);
+		}
 	}
 
 	// transform new column
 	f.multiply(column);
 
+	eta_nz += f.vals.size();
 	if (f.vals.size() == 0) {
 		num_lu_factors--;
 	}
@@ -219,20 +470,11 @@ void Simplex::updateBasis() {
 		U_diag_units--;
 	}
 
-	//	fprintf(stderr, "column: ");
-	//	for (int i = 0; i < m; i++) fprintf(stderr, "%.3Lf ", column[i]);
-	//	fprintf(stderr, "\n");
-
-	//	fprintf(stderr, "new column: ");
-	//	for (int i = 0; i < m; i++) fprintf(stderr, "%.3Lf ", column[i]);
-	//	fprintf(stderr, "\n");
-
 	// update U_col for i != r
 
 	for (int i = 0; i < U_rows[r].size(); i++) {
 		vec<IndexVal>& col = U_cols[U_rows[r][i].index()];
 		for (int j = 0; j < col.size(); j++) {
-			//		for (int j = col.size(); j--; ) {
 			if (col[j].index() == r) {
 				col[j] = col.last();
 				col.pop();
@@ -245,49 +487,55 @@ void Simplex::updateBasis() {
 
 	U_rows[r].clear();
 
-	//	int type[m];
-	int* type = new int[m];
-
-	for (int i = 0; i < m; i++) {
-		checkZero13(column[i]);
-		type[i] = ((column[i] != 0 && i != r) ? 1 : 0);
-	}
-
+	// tm_type[i] is 1 if the new column has an entry in row i, plus 2 if the old one had
+	touched.clear();
 	for (int i = 0; i < U_cols[r].size(); i++) {
-		type[U_cols[r][i].index()] += 2;
+		const int k = U_cols[r][i].index();
+		tm_type[k] += 2;
+		touched.push(k);
 	}
 	U_cols[r].clear();
 
-	for (int i = 0; i < m; i++) {
-		if (column[i] != 0 && i != r) {
-			U_cols[r].push(IndexVal(i, column[i]));
+	for (int j = 0; j < col_nz.size(); j++) {
+		const int i = col_nz[j];
+		if (i == r) {
+			continue;
 		}
-	}
-
-	for (int i = 0; i < m; i++) {
-		if (type[i] == 0) {
+		checkZero13(column[i]);
+		if (column[i] == 0) {
 			continue;
 		}
+		U_cols[r].push(IndexVal(i, column[i]));
+		if (tm_type[i] == 0) {
+			touched.push(i);
+		}
+		tm_type[i] += 1;
+	}
+
+	for (int j = 0; j < touched.size(); j++) {
+		const int i = touched[j];
+		const int type = tm_type[i];
+		tm_type[i] = 0;
 		vec<IndexVal>& row = U_rows[i];
-		if (type[i] == 1) {
+		if (type == 1) {
 			// add new element to U_rows[i]
 			row.push(IndexVal(r, column[i]));
 		}
-		if (type[i] == 2) {
+		if (type == 2) {
 			// remove element from U_rows[i]
-			for (int j = 0; j < row.size(); j++) {
-				if (row[j].index() == r) {
-					row[j] = row.last();
+			for (int k = 0; k < row.size(); k++) {
+				if (row[k].index() == r) {
+					row[k] = row.last();
 					row.pop();
 					break;
 				}
 			}
 		}
-		if (type[i] == 3) {
+		if (type == 3) {
 			// change element in U_rows[i]
-			for (int j = 0; j < row.size(); j++) {
-				if (row[j].index() == r) {
-					row[j].val() = column[i];
+			for (int k = 0; k < row.size(); k++) {
+				if (row[k].index() == r) {
+					row[k].val() = column[i];
 					break;
 				}
 			}
@@ -297,16 +545,16 @@ void Simplex::updateBasis() {
 	U_diag[r] = column[r];
 	assert(U_diag[r] != 0);
 	if (SIMPLEX_DEBUG && -0.0001 < U_diag[r] && U_diag[r] < 0.0001) {
-		fprintf(stderr, "Very small diag %d, %.18Lf\n", r, U_diag[r]);
+		fprintf(stderr, "Very small diag %d, %.18f\n", r, U_diag[r]);
 	}
-	delete[] type;
 }
 
 void Simplex::updateNorms() const {
-	const long double Z_norm2 = BZ[pivot_row];
+	const double Z_norm2 = BZ[pivot_row];
 
 	assert(Y[pivot_row] != 0);
-	for (int i = 0; i < m; i++) {
+	for (int k = 0; k < Y_nz.size(); k++) {
+		const int i = Y_nz[k];
 		if (i == pivot_row) {
 			norm2[pivot_row] /= Y[pivot_row] * Y[pivot_row];
 		} else {
@@ -314,16 +562,170 @@ void Simplex::updateNorms() const {
 			if (Y[i] == 0) {
 				continue;
 			}
-			const long double y_ratio = Y[i] / Y[pivot_row];
+			const double y_ratio = Y[i] / Y[pivot_row];
 			norm2[i] += -2 * y_ratio * BZ[i] + y_ratio * y_ratio * Z_norm2;
 		}
-		//		fprintf(stderr, "%d:%.3Lf ", i, norm2[i]);
 		if (norm2[i] < 1) {
 			norm2[i] = 1;
 		}
-		//		assert(norm2[i] > 0);
 	}
-	//	fprintf(stderr, "\n");
+}
+
+// Pick the pivot of the active submatrix with the smallest Markowitz count (r-1)(c-1) among
+// those at least MARKOWITZ_TOL times the largest entry of their column, searching the columns
+// and rows in order of count and stopping after a few once a pivot has been found
+void Simplex::findMarkowitzPivot(int& pr, int& pc) {
+	pr = -1;
+	pc = -1;
+	long long best = 0;
+	int searched = 0;
+	for (int cnt = 1; cnt <= m; cnt++) {
+		const long long bound = static_cast<long long>(cnt - 1) * (cnt - 1);
+		for (int c = col_counts.first(cnt); c >= 0; c = col_counts.after(c)) {
+			const vec<IndexVal>& col = act_cols[c];
+			double col_max = 0;
+			for (int j = 0; j < col.size(); j++) {
+				col_max = std::max(col_max, std::fabs(col[j].val()));
+			}
+			for (int j = 0; j < col.size(); j++) {
+				const double v = std::fabs(col[j].val());
+				if (v == 0 || v < MARKOWITZ_TOL * col_max) {
+					continue;
+				}
+				const long long cost =
+						static_cast<long long>(cnt - 1) * (act_rows[col[j].index()].size() - 1);
+				if (pc == -1 || cost < best) {
+					best = cost;
+					pr = col[j].index();
+					pc = c;
+				}
+			}
+			searched++;
+			if (pc != -1 && (searched >= MARKOWITZ_SEARCH || best <= bound)) {
+				return;
+			}
+		}
+		for (int r = row_counts.first(cnt); r >= 0; r = row_counts.after(r)) {
+			for (int i = 0; i < act_rows[r].size(); i++) {
+				const int c = act_rows[r][i];
+				const vec<IndexVal>& col = act_cols[c];
+				double col_max = 0;
+				double v = 0;
+				for (int j = 0; j < col.size(); j++) {
+					col_max = std::max(col_max, std::fabs(col[j].val()));
+					if (col[j].index() == r) {
+						v = std::fabs(col[j].val());
+					}
+				}
+				if (v == 0 || v < MARKOWITZ_TOL * col_max) {
+					continue;
+				}
+				const long long cost = static_cast<long long>(col.size() - 1) * (cnt - 1);
+				if (pc == -1 || cost < best) {
+					best = cost;
+					pr = r;
+					pc = c;
+				}
+			}
+			searched++;
+			if (pc != -1 && (searched >= MARKOWITZ_SEARCH || best <= bound)) {
+				return;
+			}
+		}
+	}
+	assert(pc != -1);
+}
+
+// Pivot k: eliminate column pc of the active submatrix with row pr. L_cols[k] and U_rows[k] are
+// filled in terms of the original rows and columns.
+void Simplex::eliminate(int k, int pr, int pc) {
+	vec<IndexVal>& pcol = act_cols[pc];
+	col_counts.remove(pc);
+	row_counts.remove(pr);
+
+	double piv = 0;
+	for (int j = 0; j < pcol.size(); j++) {
+		if (pcol[j].index() == pr) {
+			piv = pcol[j].val();
+		}
+	}
+	assert(piv != 0);
+	U_diag[k] = piv;
+	if (SIMPLEX_DEBUG && -0.0001 < piv && piv < 0.0001) {
+		fprintf(stderr, "Very small diag %d, %.18f\n", k, piv);
+	}
+
+	// the other rows of the pivot column lose it and get their multipliers
+	for (int j = 0; j < pcol.size(); j++) {
+		const int r = pcol[j].index();
+		if (r == pr) {
+			continue;
+		}
+		row_counts.remove(r);
+		vec<int>& ar = act_rows[r];
+		for (int i = 0; i < ar.size(); i++) {
+			if (ar[i] == pc) {
+				ar[i] = ar.last();
+				ar.pop();
+				break;
+			}
+		}
+		double a = pcol[j].val() / piv;
+		checkZero13(a);
+		if (a != 0) {
+			L_cols[k].push(IndexVal(r, a));
+		}
+	}
+
+	// the other columns of the pivot row give their entry to U and are updated
+	vec<int>& prow = act_rows[pr];
+	for (int i = 0; i < prow.size(); i++) {
+		const int c = prow[i];
+		if (c == pc) {
+			continue;
+		}
+		vec<IndexVal>& col = act_cols[c];
+		col_counts.remove(c);
+		for (int j = 0; j < col.size(); j++) {
+			act_pos[col[j].index()] = j;
+		}
+		const int p = act_pos[pr];
+		double u = col[p].val();
+		act_pos[pr] = -1;
+		col[p] = col.last();
+		col.pop();
+		if (p < col.size()) {
+			act_pos[col[p].index()] = p;
+		}
+		checkZero13(u);
+		if (u != 0) {
+			U_rows[k].push(IndexVal(c, u));
+			for (int j = 0; j < L_cols[k].size(); j++) {
+				const int r = L_cols[k][j].index();
+				const double d = -L_cols[k][j].val() * u;
+				if (act_pos[r] >= 0) {
+					col[act_pos[r]].val() += d;
+					checkZero13(col[act_pos[r]].val());
+				} else {
+					// fill in
+					col.push(IndexVal(r, d));
+					act_rows[r].push(c);
+				}
+			}
+		}
+		for (int j = 0; j < col.size(); j++) {
+			act_pos[col[j].index()] = -1;
+		}
+		col_counts.insert(c, col.size());
+	}
+
+	for (int j = 0; j < pcol.size(); j++) {
+		if (pcol[j].index() != pr) {
+			row_counts.insert(pcol[j].index(), act_rows[pcol[j].index()].size());
+		}
+	}
+	pcol.clear();
+	prow.clear();
 }
 
 void Simplex::refactorB() {
@@ -331,162 +733,85 @@ void Simplex::refactorB() {
 
 	refactors++;
 
-	//	int col_perm[m], col_perm2[m], row_perm[m], row_perm2[m];
 	int* col_perm = new int[m];
-	int* col_perm2 = new int[m];
 	int* row_perm = new int[m];
-	int* row_perm2 = new int[m];
+	int* pivot_rows = new int[m];
+	int* pivot_cols = new int[m];
 
 	for (int i = 0; i < m; i++) {
 		U_perm[i] = i;
-		row_perm[i] = -1;
 		norm2[i] = 1;
 		U_rows[i].clear();
 		U_cols[i].clear();
 		L_rows[i].clear();
 		L_cols[i].clear();
+		act_cols[i].clear();
+		act_rows[i].clear();
 	}
 
-	// find singleton columns
+	// load the basis into the active submatrix, column i is basic var rtoc[i]
 
-	int cs = 0;
-	vec<int> non_col_sing;
 	for (int i = 0; i < m; i++) {
 		const int c = rtoc[i];
-		if (AV_nz[c] == 1) {
-			col_perm[i] = cs;
-			const int k = AV[c][0].index();
-			row_perm[k] = cs;
-			row_perm2[cs] = cs;
-			U_diag[cs] = AV[c][0].val();
-			cs++;
-		} else {
-			non_col_sing.push(rtoc[i]);
+		for (int j = 0; j < AV_nz[c]; j++) {
+			act_cols[i].push(AV[c][j]);
+			act_rows[AV[c][j].index()].push(i);
 		}
 	}
-
-	for (int i = 0; i < non_col_sing.size(); i++) {
-		col_perm2[cs + i] = non_col_sing[i];
-	}
-
-	std::sort(col_perm2 + cs, col_perm2 + m, sort_col_nz);
-
-	for (int i = cs; i < m; i++) {
-		row_perm2[i] = -1;
-		col_perm[ctor[col_perm2[i]]] = i;
-	}
-
-	// Do col perms
-	//	int old_rtoc[m];
-	int* old_rtoc = new int[m];
-	for (int i = 0; i < m; i++) {
-		old_rtoc[i] = rtoc[i];
-	}
+	col_counts.init(m);
+	row_counts.init(m);
 	for (int i = 0; i < m; i++) {
-		rtoc[col_perm[i]] = old_rtoc[i];
-		ctor[old_rtoc[i]] = col_perm[i];
+		col_counts.insert(i, act_cols[i].size());
+		row_counts.insert(i, act_rows[i].size());
 	}
 
-	// Initialise R1, R2 (for storing U and L)
-	const int p = m - cs;
-	for (int i = 1; i < p; i++) {
-		R1[i] = R1[0] + static_cast<ptrdiff_t>(i * p);
-		R2[i] = R2[0] + static_cast<ptrdiff_t>(i * p);
-	}
-	memset(R1[0], 0, sizeof(R1[0][0]) * p * p);
-	memset(R2[0], 0, sizeof(R2[0][0]) * p * p);
+	// calculate U and L
 
-	int rows_used = cs;
-	for (int i = cs; i < m; i++) {
-		const int c = col_perm2[i];
-		for (int j = 0; j < AV_nz[c]; j++) {
-			const int k = AV[c][j].index();
-			int& r = row_perm[k];
-			if (r == -1) {
-				r = rows_used++;
-			}
-			if (r < cs) {
-				U_rows[r].push(IndexVal(i, AV[c][j].val()));
-				U_cols[i].push(IndexVal(r, AV[c][j].val()));
-			} else {
-				R1[r - cs][i - cs] = AV[c][j].val();
-			}
-		}
+	for (int k = 0; k < m; k++) {
+		findMarkowitzPivot(pivot_rows[k], pivot_cols[k]);
+		eliminate(k, pivot_rows[k], pivot_cols[k]);
 	}
 
-	//	fprintf(stderr, "R:\n");
-	//	for (int i = 0; i < m; i++) {
-	//		fprintf(stderr, "row %d: ", i);
-	//		for (int j = 0; j < m; j++) fprintf(stderr, "%d:%.3Lf ", j, R[i][j]);
-	//		fprintf(stderr, "\n");
-	//	}
+	// pivot k becomes row and column k
 
-	// calculate U and L
-	for (int i = 0; i < p; i++) {
-		int nr = -1;
-		for (int j = 0; j < p; j++) {
-			checkZero13(R1[j][i]);
-			if (R1[j][i] != 0 && row_perm2[j + cs] == -1) {
-				nr = j;
-				break;
-			}
-		}
-		assert(nr != -1);
-		assert(R1[nr][i] != 0);
-		row_perm2[nr + cs] = i + cs;
-		U_diag[i + cs] = R1[nr][i];
-		if (SIMPLEX_DEBUG && -0.0001 < U_diag[i + cs] && U_diag[i + cs] < 0.0001) {
-			fprintf(stderr, "Very small diag %d, %.18Lf\n", i + cs, U_diag[i + cs]);
-		}
-		for (int j = i + 1; j < p; j++) {
-			checkZero13(R1[nr][j]);
-			if (R1[nr][j] != 0) {
-				U_rows[i + cs].push(IndexVal(j + cs, R1[nr][j]));
-				U_cols[j + cs].push(IndexVal(i + cs, R1[nr][j]));
-			}
-		}
-		for (int j = 0; j < i; j++) {
-			checkZero13(R2[nr][j]);
-			if (R2[nr][j] != 0) {
-				L_rows[i + cs].push(IndexVal(j + cs, R2[nr][j]));
-				L_cols[j + cs].push(IndexVal(i + cs, R2[nr][j]));
-			}
+	for (int k = 0; k < m; k++) {
+		row_perm[pivot_rows[k]] = k;
+		col_perm[pivot_cols[k]] = k;
+	}
+	lu_nz = 0;
+	eta_nz = 0;
+	for (int k = 0; k < m; k++) {
+		for (int j = 0; j < U_rows[k].size(); j++) {
+			IndexVal& e = U_rows[k][j];
+			e.index() = col_perm[e.index()];
+			U_cols[e.index()].push(IndexVal(k, e.val()));
 		}
-		for (int j = 0; j < p; j++) {
-			checkZero13(R1[j][i]);
-			if (R1[j][i] == 0 || row_perm2[j + cs] >= 0) {
-				continue;
-			}
-			const long double a = -R1[j][i] / R1[nr][i];
-			for (int k = 0; k < U_rows[i + cs].size(); k++) {
-				R1[j][U_rows[i + cs][k].index() - cs] += a * U_rows[i + cs][k].val();
-			}
-			for (int k = 0; k < L_rows[i + cs].size(); k++) {
-				R2[j][L_rows[i + cs][k].index() - cs] += a * L_rows[i + cs][k].val();
-			}
-			R2[j][i] += a * 1;
+		for (int j = 0; j < L_cols[k].size(); j++) {
+			IndexVal& e = L_cols[k][j];
+			e.index() = row_perm[e.index()];
+			L_rows[e.index()].push(IndexVal(k, e.val()));
 		}
+		lu_nz += U_rows[k].size() + L_cols[k].size();
 	}
 
-	L_cols_zeros = cs;
+	L_cols_zeros = 0;
 	while (L_cols_zeros < m && L_cols[L_cols_zeros].size() == 0) {
 		L_cols_zeros++;
 	}
 
 	U_diag_units = 0;
-	while (U_diag_units < cs && U_diag[U_diag_units] == 1) {
+	while (U_diag_units < m && U_diag[U_diag_units] == 1 && U_cols[U_diag_units].size() == 0) {
 		U_diag_units++;
 	}
 
-	//	fprintf(stderr, "R:\n");
-	//	for (int i = 0; i < m; i++) {
-	//		fprintf(stderr, "row %d: ", i);
-	//		for (int j = 0; j < m; j++) fprintf(stderr, "%d:%.3Lf ", j, R[i][j]);
-	//		fprintf(stderr, "\n");
-	//	}
-
+	// Do col perms
+	int* old_rtoc = new int[m];
+	for (int i = 0; i < m; i++) {
+		old_rtoc[i] = rtoc[i];
+	}
 	for (int i = 0; i < m; i++) {
-		row_perm[i] = row_perm2[row_perm[i]];
+		rtoc[col_perm[i]] = old_rtoc[i];
+		ctor[old_rtoc[i]] = col_perm[i];
 	}
 
 	// Do row perms
@@ -506,6 +831,7 @@ void Simplex::refactorB() {
 	int* old_ub = new int[m];
 	int* old_shift = new int[m];
 	int* old_ctor = new int[m];
+	int* old_row_id = new int[m];
 	// slack var i -> slack var row_perm[i]
 
 	for (int i = 0; i < m; i++) {
@@ -516,6 +842,7 @@ void Simplex::refactorB() {
 		old_ub[i] = ub[n + i];
 		old_shift[i] = shift[n + i];
 		old_ctor[i] = ctor[n + i];
+		old_row_id[i] = row_id[i];
 	}
 
 	for (int i = 0; i < m; i++) {
@@ -529,6 +856,8 @@ void Simplex::refactorB() {
 		if (old_ctor[i] >= 0) {
 			rtoc[old_ctor[i]] = n + row_perm[i];
 		}
+		row_id[row_perm[i]] = old_row_id[i];
+		id_row[old_row_id[i]] = row_perm[i];
 	}
 
 	for (int i = 0; i < A_size; i++) {
@@ -542,9 +871,9 @@ void Simplex::refactorB() {
 	}
 
 	delete[] col_perm;
-	delete[] col_perm2;
 	delete[] row_perm;
-	delete[] row_perm2;
+	delete[] pivot_rows;
+	delete[] pivot_cols;
 	delete[] old_rtoc;
 	delete[] old_AH;
 	delete[] old_AH_nz;
@@ -553,19 +882,20 @@ void Simplex::refactorB() {
 	delete[] old_ub;
 	delete[] old_shift;
 	delete[] old_ctor;
+	delete[] old_row_id;
 
 	//	printB();
 }
 
 void Simplex::saveState(SimplexState& s) const {
 	if (s.rtoc == nullptr) {
-		s.rtoc = new int[m];
+		s.rtoc = new int[max_m];
 	}
 	if (s.ctor == nullptr) {
-		s.ctor = new int[n + m];
+		s.ctor = new int[n + max_m];
 	}
 	if (s.shift == nullptr) {
-		s.shift = new int[n + m + 1];
+		s.shift = new int[n + max_m + 1];
 	}
 
 	for (int i = 0; i < m; i++) {
@@ -582,6 +912,22 @@ void Simplex::saveState(SimplexState& s) const {
 	//	printTableau(true);
 }
 
+// Undo the pivots recorded in basis_trail after pos and refactor the basis they lead back to
+void Simplex::restoreBasis(int pos) {
+	for (int i = basis_trail.size(); i-- > pos;) {
+		const int e = varOf(basis_trail[i].entering);
+		const int l = varOf(basis_trail[i].leaving);
+		const int r = ctor[e];
+		assert(r >= 0 && ctor[l] == -1);
+		ctor[e] = -1;
+		ctor[l] = r;
+		rtoc[r] = l;
+	}
+	basis_trail.resize(pos);
+	refactorB();
+	calcObjBound();
+}
+
 void Simplex::loadState(SimplexState& s) const {
 	for (int i = 0; i < m; i++) {
 		rtoc[i] = s.rtoc[i];
@@ -603,17 +949,17 @@ void Simplex::loadState(SimplexState& s) const {
 void Simplex::printObjective() const {
 	fprintf(stderr, "objective: ");
 	for (int i = 0; i < n + m; i++) {
-		fprintf(stderr, "%d:%.18Lf ", i, obj[i]);
+		fprintf(stderr, "%d:%.18f ", i, obj[i]);
 	}
 	fprintf(stderr, "\n");
-	fprintf(stderr, "obj_bound = %.3Lf\n", obj_bound);
+	fprintf(stderr, "obj_bound = %.3f\n", obj_bound);
 	fflush(stderr);
 }
 
 void Simplex::printTableau(bool full) {
 	calcRHS();
-	//	long double row[n+m];
-	auto* row = new long double[n + m];
+	//	double row[n+m];
+	auto* row = new double[n + m];
 	fprintf(stderr, "Tableau:\n");
 	for (int i = 0; i < n + m; i++) {
 		fprintf(stderr, "%d:%d ", i, shift[i]);
@@ -630,24 +976,24 @@ void Simplex::printTableau(bool full) {
 		fprintf(stderr, "%d: ", rtoc[i]);
 		if (full) {
 			for (int j = 0; j < n + m; j++) {
-				fprintf(stderr, "%d:%.3Lf ", j, row[j]);
+				fprintf(stderr, "%d:%.3f ", j, row[j]);
 			}
 		}
-		fprintf(stderr, "rhs:%.18Lf", rhs[i]);
+		fprintf(stderr, "rhs:%.18f", rhs[i]);
 		fprintf(stderr, "\n");
 		//		row[rtoc[i]] -= 1;
 		//		for (int j = 0; j < m; j++) {
-		//			if (!almostZero6(row[rtoc[j]])) fprintf(stderr, "%d:%d:%.2Lf ", i, j, row[rtoc[j]]);
+		//			if (!almostZero6(row[rtoc[j]])) fprintf(stderr, "%d:%d:%.2f ", i, j, row[rtoc[j]]);
 		//			assert(almostZero6(row[rtoc[j]]));
 		//		}
 	}
 	printObjective();
 	fflush(stderr);
 
-	//	long double T[n+m][m];
-	auto** T = new long double*[n + m];
+	//	double T[n+m][m];
+	auto** T = new double*[n + m];
 	for (int i = 0; i < n + m; i++) {
-		T[i] = new long double[m];
+		T[i] = new double[m];
 	}
 	for (int i = 0; i < n + m; i++) {
 		for (int j = 0; j < m; j++) {
@@ -662,7 +1008,7 @@ void Simplex::printTableau(bool full) {
 	for (int i = 0; i < m; i++) {
 		fprintf(stderr, "%d: ", rtoc[i]);
 		for (int j = 0; j < n + m; j++) {
-			fprintf(stderr, "%d:%.3Lf ", j, T[j][i]);
+			fprintf(stderr, "%d:%.3f ", j, T[j][i]);
 		}
 		fprintf(stderr, "\n");
 	}
@@ -681,7 +1027,7 @@ void Simplex::printL() {
 			fprintf(stderr, "row %d: ", i);
 		}
 		for (int j = 0; j < L_rows[i].size(); j++) {
-			fprintf(stderr, "%d:%.3Lf ", L_rows[i][j].index(), L_rows[i][j].val());
+			fprintf(stderr, "%d:%.3f ", L_rows[i][j].index(), L_rows[i][j].val());
 		}
 		if (L_rows[i].size() != 0) {
 			fprintf(stderr, "\n");
@@ -692,7 +1038,7 @@ void Simplex::printL() {
 			fprintf(stderr, "col %d: ", i);
 		}
 		for (int j = 0; j < L_cols[i].size(); j++) {
-			fprintf(stderr, "%d:%.3Lf ", L_cols[i][j].index(), L_cols[i][j].val());
+			fprintf(stderr, "%d:%.3f ", L_cols[i][j].index(), L_cols[i][j].val());
 		}
 		if (L_cols[i].size() != 0) {
 			fprintf(stderr, "\n");
@@ -707,7 +1053,7 @@ void Simplex::printU() {
 			fprintf(stderr, "row %d: ", i);
 		}
 		for (int j = 0; j < U_rows[i].size(); j++) {
-			fprintf(stderr, "%d:%.3Lf ", U_rows[i][j].index(), U_rows[i][j].val());
+			fprintf(stderr, "%d:%.3f ", U_rows[i][j].index(), U_rows[i][j].val());
 		}
 		if (U_rows[i].size() != 0) {
 			fprintf(stderr, "\n");
@@ -718,7 +1064,7 @@ void Simplex::printU() {
 			fprintf(stderr, "col %d: ", i);
 		}
 		for (int j = 0; j < U_cols[i].size(); j++) {
-			fprintf(stderr, "%d:%.3Lf ", U_cols[i][j].index(), U_cols[i][j].val());
+			fprintf(stderr, "%d:%.3f ", U_cols[i][j].index(), U_cols[i][j].val());
 		}
 		if (U_cols[i].size() != 0) {
 			fprintf(stderr, "\n");
@@ -726,7 +1072,7 @@ void Simplex::printU() {
 	}
 	fprintf(stderr, "diag: ");
 	for (int i = 0; i < m; i++) {
-		fprintf(stderr, "%d:%.3Lf ", i, U_diag[i]);
+		fprintf(stderr, "%d:%.3f ", i, U_diag[i]);
 	}
 	fprintf(stderr, "\n");
 }
@@ -736,7 +1082,7 @@ void Simplex::printLUF() const {
 		LUFactor& f = lu_factors[i];
 		fprintf(stderr, "r = %d: ", f.r);
 		for (int j = 0; j < f.vals.size(); j++) {
-			fprintf(stderr, "%d:%.3Lf ", f.vals[j].index(), f.vals[j].val());
+			fprintf(stderr, "%d:%.3f ", f.vals[j].index(), f.vals[j].val());
 		}
 		fprintf(stderr, "\n");
 	}
@@ -756,7 +1102,7 @@ void Simplex::printB() {
 void Simplex::printRHS() const {
 	fprintf(stderr, "RHS:\n");
 	for (int i = 0; i < m; i++) {
-		fprintf(stderr, "%.3Lf ", rhs[i]);
+		fprintf(stderr, "%.3f ", rhs[i]);
 	}
 	fprintf(stderr, "\n");
 }
@@ -765,12 +1111,12 @@ void Simplex::checkObjective() const {
 	for (int i = 0; i < n + m; i++) {
 		if (shift[i] == 0) {
 			if (obj[i] < 0) {
-				fprintf(stderr, "%d %d %.18Lf %lld\n", i, shift[i], obj[i], simplexs);
+				fprintf(stderr, "%d %d %.18f %lld\n", i, shift[i], obj[i], simplexs);
 			}
 			assert(obj[i] >= 0);
 		} else {
 			if (obj[i] > 0) {
-				fprintf(stderr, "%d %d %.18Lf %lld\n", i, shift[i], obj[i], simplexs);
+				fprintf(stderr, "%d %d %.18f %lld\n", i, shift[i], obj[i], simplexs);
 			}
 			assert(obj[i] <= 0);
 		}
@@ -780,12 +1126,12 @@ void Simplex::checkObjective() const {
 void Simplex::checkBasis() {
 	//	printTableau(true);
 	fprintf(stderr, "Check basis:\n");
-	//	long double temp[m];
-	auto* temp = new long double[m];
+	//	double temp[m];
+	auto* temp = new double[m];
 	for (int i = 0; i < m; i++) {
 		calcBInvRow(temp, i);
 		for (int j = 0; j < m; j++) {
-			long double sum = 0;
+			double sum = 0;
 			for (int k = 0; k < AV_nz[rtoc[j]]; k++) {
 				sum += temp[AV[rtoc[j]][k].index()] * AV[rtoc[j]][k].val();
 			}
@@ -793,7 +1139,7 @@ void Simplex::checkBasis() {
 				sum -= 1;
 			}
 			if (!almostZero6(sum)) {
-				fprintf(stderr, "%d:%d:%.2Lf ", i, j, sum);
+				fprintf(stderr, "%d:%d:%.2f ", i, j, sum);
 			}
 			assert(almostZero6(sum));
 		}
@@ -807,14 +1153,14 @@ void Simplex::unboundedDebug() const {
 	printObjective();
 	//		printTableau(true);
 	fprintf(stderr, "Pivot row = %d\n", pivot_row);
-	fprintf(stderr, "RHS = %.3Lf\n", rhs[pivot_row]);
+	fprintf(stderr, "RHS = %.3f\n", rhs[pivot_row]);
 	fprintf(stderr, "Row: ");
 	for (int i = 0; i < n + m; i++) {
 		if (row[i] == 0) {
 			continue;
 		}
 		fprintf(stderr, "%d:", i);
-		fprintf(stderr, "%.3Lf/%.3Lf, ", obj[i], row[i]);
+		fprintf(stderr, "%.3f/%.3f, ", obj[i], row[i]);
 	}
 	for (int i = 0; i < n; i++) {
 		fprintf(stderr, "%d:%d %d, ", i, (int)lb[i], (int)ub[i]);
@@ -14,6 +14,10 @@
 
 #define REFACTOR_FREQ 100
 #define AVOID_SMALL_PIVOT 0
+// Pivot row entries this small are rounding noise and never taken as pivots
+#define PIVOT_ZERO 1e-9
+// Pivots smaller than this are checked against the pivot column
+#define PIVOT_CHECK 1e-5
 
 // Maximize x_0
 // Ax <= b
@@ -21,12 +25,15 @@
 
 Simplex simplex;
 
-Simplex::Simplex() : sort_col_ratio(ratio), sort_col_nz(AV_nz) {}
+Simplex::Simplex() : sort_col_ratio(ratio) {}
 
 void Simplex::init() {
 	m = mip->ineqs.size();
 	n = mip->vars.size();
 
+	// rows beyond the constraints are room for cuts
+	max_m = m + m / 4 + 10;
+
 	A_size = 0;
 	for (int i = 0; i < m; i++) {
 		A_size += mip->ineqs[i].a.size();
@@ -40,45 +47,56 @@ void Simplex::init() {
 
 	// Allocate memory
 
-	AH = new IndexVal*[m];
-	AV = new IndexVal*[n + m];
+	AH = new IndexVal*[max_m];
+	AV = new IndexVal*[n + max_m];
 	AH_mem = new IndexVal[A_size];
-	AV_mem = new IndexVal[A_size + m];
-	AH_nz = new int[m];
-	AV_nz = new int[n + m];
-
-	Y = new long double[m];
-	BZ = new long double[m];
-	obj = new long double[n + m];
-	rhs = new long double[m];
-	R1 = new2d<long double>(m, m);
-	R2 = new2d<long double>(m, m);
-	tm = new long double[m];
-	BC = new int[m];
-
-	norm2 = new float[m];
+	AV_mem = nullptr;
+	AH_nz = new int[max_m];
+	AV_nz = new int[n + max_m];
+
+	Y = new double[max_m];
+	BZ = new double[max_m];
+	obj = new double[n + max_m];
+	rhs = new double[max_m];
+	tm = new double[max_m];
+	BC = new int[max_m];
+
+	norm2 = new float[max_m];
 	reduced_costs = new double[n];
 
-	L_cols.growTo(m);
-	L_rows.growTo(m);
-	U_cols.growTo(m);
-	U_rows.growTo(m);
+	L_cols.growTo(max_m);
+	L_rows.growTo(max_m);
+	U_cols.growTo(max_m);
+	U_rows.growTo(max_m);
 
-	U_diag = new long double[m];
-	U_perm = new int[m];
+	U_diag = new double[max_m];
+	U_perm = new int[max_m];
+
+	act_cols.growTo(max_m);
+	act_rows.growTo(max_m);
+	act_pos = new int[max_m];
+	reach_mark = new int[max_m];
+	tm_type = new int[max_m];
+	for (int i = 0; i < max_m; i++) {
+		act_pos[i] = -1;
+		reach_mark[i] = 0;
+		tm_type[i] = 0;
+	}
 
 	lu_factors = new LUFactor[REFACTOR_FREQ + 10];
 
-	lb = new Tint[n + m];
-	ub = new Tint[n + m];
+	lb = new Tint[n + max_m];
+	ub = new Tint[n + max_m];
 
-	rtoc = new int[m];
-	ctor = new int[n + m];
-	shift = new int[n + m + 1];
+	rtoc = new int[max_m];
+	ctor = new int[n + max_m];
+	row_id = new int[max_m];
+	id_row = new int[max_m];
+	shift = new int[n + max_m + 1];
 
-	row = new long double[n + m];
-	column = new long double[m];
-	ratio = new long double[n + m];
+	row = new double[n + max_m];
+	column = new double[max_m];
+	ratio = new double[n + max_m];
 	Z = &row[n];
 
 	// Initialise obj
@@ -125,6 +143,10 @@ void Simplex::init() {
 	for (int i = 0; i < m; i++) {
 		ctor[n + i] = i;
 	}
+	for (int i = 0; i < m; i++) {
+		row_id[i] = i;
+		id_row[i] = i;
+	}
 	for (int i = 0; i < n + m; i++) {
 		shift[i] = 0;
 	}
@@ -140,19 +162,17 @@ void Simplex::init() {
 	// Initialise AH
 
 	IndexVal* cur_A = AH_mem;
-	vec<vec<IndexVal> > temp_A(n);
 	for (int i = 0; i < m; i++) {
 		AH[i] = cur_A;
 		LinearIneq& li = mip->ineqs[i];
 		for (int j = 0; j < li.x.size(); j++) {
 			const int c = mip->var_map.find(li.x[j])->second;
 			assert(0 <= c && c < n);
-			long double v = (li.lb_notR ? -li.a[j] : li.a[j]);
+			double v = (li.lb_notR ? -li.a[j] : li.a[j]);
 			if (c == 0 && engine.opt_type == OPT_MAX) {
 				v = -v;
 			}
 			*cur_A++ = IndexVal(c, v);
-			temp_A[c].push(IndexVal(i, v));
 			//			fprintf(stderr, "%d:%.0Lf ", c, v);
 		}
 		//		fprintf(stderr, "%.0Lf %.0Lf\n", mip->ineqs[i].lb, mip->ineqs[i].ub);
@@ -162,31 +182,97 @@ void Simplex::init() {
 		//		for (int j = 0; j < n; j++) fprintf(stderr, "%.0Lf ", A[j][i]); fprintf(stderr, "\n");
 	}
 
-	// Initialise AV
+	buildAV();
 
-	cur_A = AV_mem;
+	for (int i = 0; i < n + m; i++) {
+		boundChange(i, lb[i]);
+	}
+
+	refactorB();
+
+	//	printB();
+
+	pivotObjVar();
+}
+
+// AV from AH, structural columns first and then the unit columns of the slacks
+void Simplex::buildAV() {
+	delete[] AV_mem;
+	AV_mem = new IndexVal[A_size + m];
+
+	vec<int> start(n + 1, 0);
+	for (int i = 0; i < m; i++) {
+		for (int j = 0; j < AH_nz[i]; j++) {
+			start[AH[i][j].index() + 1]++;
+		}
+	}
 	for (int i = 0; i < n; i++) {
-		AV[i] = cur_A;
-		for (int j = 0; j < temp_A[i].size(); j++) {
-			*cur_A++ = temp_A[i][j];
+		start[i + 1] += start[i];
+		AV[i] = AV_mem + start[i];
+		AV_nz[i] = 0;
+	}
+	for (int i = 0; i < m; i++) {
+		for (int j = 0; j < AH_nz[i]; j++) {
+			const int c = AH[i][j].index();
+			AV[c][AV_nz[c]++] = IndexVal(i, AH[i][j].val());
 		}
-		AV_nz[i] = cur_A - AV[i];
 	}
+	IndexVal* cur_A = AV_mem + A_size;
 	for (int i = 0; i < m; i++) {
 		AV[n + i] = cur_A;
 		*cur_A++ = IndexVal(i, 1);
 		AV_nz[n + i] = 1;
 	}
+}
 
-	for (int i = 0; i < n + m; i++) {
-		boundChange(i, lb[i]);
+// Append the cuts as rows with basic slacks s = a.z, which lie in [rhs, ub]
+void Simplex::addRows(vec<Cut>& pool, const vec<int>& ids) {
+	assert(m + ids.size() <= max_m);
+	int added = 0;
+	for (int k = 0; k < ids.size(); k++) {
+		added += pool[ids[k]].x.size();
+	}
+	auto* new_AH_mem = new IndexVal[A_size + added];
+	IndexVal* cur_A = new_AH_mem;
+	for (int i = 0; i < m; i++) {
+		IndexVal* r = cur_A;
+		for (int j = 0; j < AH_nz[i]; j++) {
+			*cur_A++ = AH[i][j];
+		}
+		AH[i] = r;
+	}
+	shift[n + m] = 0;
+	for (int k = 0; k < ids.size(); k++) {
+		Cut& c = pool[ids[k]];
+		const int i = m + k;
+		AH[i] = cur_A;
+		// as boundChange would leave it for these bounds
+		BC[i] = -c.rhs;
+		for (int j = 0; j < c.x.size(); j++) {
+			const int v = c.x[j];
+			*cur_A++ = IndexVal(v, -c.a[j]);
+			BC[i] += c.a[j] * (shift[v] != 0 ? ub[v] : lb[v]);
+		}
+		AH_nz[i] = c.x.size();
+		lb[n + i].v = c.rhs;
+		ub[n + i].v = c.ub;
+		shift[n + i] = 0;
+		obj[n + i] = 0;
+		rtoc[i] = n + i;
+		ctor[n + i] = i;
+		row_id[i] = i;
+		id_row[i] = i;
+		c.active = true;
 	}
+	m += ids.size();
+	A_size += added;
+	shift[n + m] = 2;
+	delete[] AH_mem;
+	AH_mem = new_AH_mem;
 
+	buildAV();
 	refactorB();
-
-	//	printB();
-
-	pivotObjVar();
+	calcObjBound();
 }
 
 void Simplex::pivotObjVar() {
@@ -194,7 +280,7 @@ void Simplex::pivotObjVar() {
 	pivot_row = -1;
 
 	// find a pivot row
-	memset(column, 0, m * sizeof(long double));
+	memset(column, 0, m * sizeof(double));
 	for (int i = 0; i < AV_nz[0]; i++) {
 		column[AV[0][i].index()] = AV[0][i].val();
 	}
@@ -280,6 +366,22 @@ int Simplex::simplex() {
 
 	//	fprintf(stderr, "pivot col = %d\n", pivot_col);
 
+	// Factors too inaccurate to agree on a small pivot are refreshed before trying again. If fresh
+	// ones do not agree either, stop at this basis, whose bound is still valid.
+	const double p = fabs(row[pivot_col]);
+	if (p < PIVOT_CHECK) {
+		const double y = fabs(pivotColumnEntry());
+		if (y < PIVOT_ZERO || fabs(y - p) > 1e-3 * p) {
+			if (num_lu_factors == 0) {
+				calcObjective();
+				calcObjBound();
+				return SIMPLEX_GOOD_ENOUGH;
+			}
+			refactorB();
+			return SIMPLEX_IN_PROGRESS;
+		}
+	}
+
 	pivot();
 
 	simplexs++;
@@ -321,7 +423,7 @@ bool Simplex::findPivotRow() {
 		}
 		float a;
 		const float val = rhs[i] + (shift[v] != 0 ? ub[v] : lb[v]);
-		//		fprintf(stderr, "cr %d: %.3Lf %d %d\n", i, val, (int) lb[v], (int) ub[v]);
+		//		fprintf(stderr, "cr %d: %.3f %d %d\n", i, val, (int) lb[v], (int) ub[v]);
 		// check lower bound
 		a = lb[v] - val;
 		if (a > obj_limit) {
@@ -370,14 +472,15 @@ bool Simplex::findPivotRow() {
 }
 
 void Simplex::regeneratePivotRow() {
-	memset(row, 0, n * sizeof(long double));
+	memset(row, 0, n * sizeof(double));
 	R_nz.clear();
 
-	calcBInvRow(Z, pivot_row);
+	calcBInvRow(Z, pivot_row, Z_nz);
 
 	const int v = rtoc[pivot_row];
 
-	for (int i = 0; i < m; i++) {
+	for (int k = 0; k < Z_nz.size(); k++) {
+		const int i = Z_nz[k];
 		if (ctor[n + i] >= 0) {
 			continue;
 		}
@@ -420,15 +523,15 @@ void Simplex::regeneratePivotRow() {
 }
 
 bool Simplex::findPivotCol() {
-	long double pivot_inc = 1e100;
+	double pivot_inc = 1e100;
 	pivot_col = -1;
 
 	for (int i = 0; i < R_nz.size(); i++) {
 		const int k = R_nz[i];
 		if ((shift[k] == 0 && row[k] < -pivot_limit) || (shift[k] == 1 && row[k] > pivot_limit)) {
-			const long double a = -obj[k] / row[k];
+			const double a = -obj[k] / row[k];
 			if (a < 0) {
-				fprintf(stderr, "%.18Lf %.18Lf\n", obj[k], row[k]);
+				fprintf(stderr, "%.18f %.18f\n", obj[k], row[k]);
 			}
 			assert(a >= 0);
 			if (a < pivot_inc) {
@@ -453,13 +556,13 @@ bool Simplex::findPivotCol() {
 bool Simplex::findPivotCol2() {
 	pivot_col = -1;
 
-	long double leeway = pr_violation;
+	double leeway = pr_violation;
 
 	vec<int> pivot_cands;
 
 	for (int i = 0; i < R_nz.size(); i++) {
 		const int k = R_nz[i];
-		if ((shift[k] == 0 && row[k] < 0) || (shift[k] == 1 && row[k] > 0)) {
+		if ((shift[k] == 0 && row[k] < -PIVOT_ZERO) || (shift[k] == 1 && row[k] > PIVOT_ZERO)) {
 			assert(ctor[k] == -1);
 			pivot_cands.push(k);
 			ratio[k] = -obj[k] / row[k];
@@ -473,11 +576,11 @@ bool Simplex::findPivotCol2() {
 	// sort based on ratio asc, then pivot size asc
 	std::sort((int*)pivot_cands, (int*)pivot_cands + pivot_cands.size(), sort_col_ratio);
 
-	long double best_psize = 0;
+	double best_psize = 0;
 
 	for (int i = 0; i < pivot_cands.size(); i++) {
 		const int k = pivot_cands[i];
-		const long double r = (shift[k] != 0 ? row[k] : -row[k]);
+		const double r = (shift[k] != 0 ? row[k] : -row[k]);
 		if (r > best_psize || (!AVOID_SMALL_PIVOT && r >= 0.001)) {
 			best_psize = r;
 			pivot_col = k;
@@ -495,14 +598,14 @@ bool Simplex::findPivotCol2() {
 	assert(pivot_col != -1);
 
 	if (ctor[pivot_col] != -1) {
-		fprintf(stderr, "%d %d %d %d %d %.18Lf %.18Lf\n", shift[pivot_col], pivot_row, rtoc[pivot_row],
+		fprintf(stderr, "%d %d %d %d %d %.18f %.18f\n", shift[pivot_col], pivot_row, rtoc[pivot_row],
 						pivot_col, ctor[pivot_col], row[pivot_col], obj[pivot_col]);
 	}
 
 	assert(ctor[pivot_col] == -1);
 
 	if (SIMPLEX_DEBUG && best_psize < pivot_limit) {
-		fprintf(stderr, "Very small pivot %d, %.18Lf\n", pivot_col, best_psize);
+		fprintf(stderr, "Very small pivot %d, %.18f\n", pivot_col, best_psize);
 	}
 
 	// do bound swap for all vars with smaller ratio than pivot_col
@@ -516,19 +619,23 @@ bool Simplex::findPivotCol2() {
 
 void Simplex::pivot() {
 	assert(ctor[pivot_col] == -1);
+	if (mip->decisionLevel() > 0) {
+		basis_trail.push(BasisChange(stableId(pivot_col), stableId(rtoc[pivot_row])));
+	}
 	ctor[rtoc[pivot_row]] = -1;
 	ctor[pivot_col] = pivot_row;
 	rtoc[pivot_row] = pivot_col;
 
 	// update objective row
-	const long double a = obj[pivot_col] / row[pivot_col];
+	const double a = obj[pivot_col] / row[pivot_col];
 	for (int i = 0; i < R_nz.size(); i++) {
 		const int k = R_nz[i];
 		obj[k] -= a * row[k];
 		checkZero13(obj[k]);
 	}
 
-	if (num_lu_factors < REFACTOR_FREQ) {
+	// refactor once the row etas outgrow the factors they update
+	if (num_lu_factors < REFACTOR_FREQ && eta_nz <= lu_nz + m) {
 		updateBasis();
 	} else {
 		refactorB();
@@ -18,30 +18,60 @@ public:
 	SimplexState() = default;
 };
 
+// Pivot recorded for backtracking, vars given by stableId
+struct BasisChange {
+	int entering;
+	int leaving;
+	BasisChange(int e, int l) : entering(e), leaving(l) {}
+};
+
+// Valid inequality sum a[i] * z[x[i]] >= rhs over the columns of the simplex, whose lhs is at most
+// ub. Found at the root, so it holds in every node.
+struct Cut {
+	vec<int> x;
+	vec<int> a;
+	int rhs{0};
+	int ub{0};
+	bool active{false};  // whether it is a row of the simplex
+	Cut() = default;
+};
+
 class IndexVal {
 public:
-	union {
-		long double v;
-		int i[4];
-	};
+	double v;
+	int i;
 	IndexVal() {}
-	IndexVal(int _i, long double _v) {
-		v = _v;
-		i[3] = _i;
-	}
-	long double& val() { return v; }
-	int& index() { return i[3]; }
+	IndexVal(int _i, double _v) : v(_v), i(_i) {}
+	double& val() { return v; }
+	int& index() { return i; }
+	double val() const { return v; }
+	int index() const { return i; }
 };
 
-// class to store special form matrices spawned during LU update
-// add diagonal entries are 1 and a single row r has non-zero entries
+// Row eta spawned by a Forrest-Tomlin update of U
+// all diagonal entries are 1 and a single row r has non-zero entries
 class LUFactor {
 public:
 	int r;               // row which has non-zero entries
 	vec<IndexVal> vals;  // values in rth row
 	LUFactor() = default;
-	void multiply(long double* a);
-	void Tmultiply(long double* a);
+	void multiply(double* a);
+	void Tmultiply(double* a);
+};
+
+// Items 0 .. n-1 kept in doubly linked lists by count, for the Markowitz pivot search
+class CountLists {
+	vec<int> head;
+	vec<int> next;
+	vec<int> prev;
+	vec<int> count;
+
+public:
+	void init(int n);
+	void insert(int i, int c);
+	void remove(int i);
+	int first(int c) const { return head[c]; }
+	int after(int i) const { return next[i]; }
 };
 
 #define bound_weaken (1e-3)
@@ -49,14 +79,15 @@ public:
 #define pivot_limit (1e-3)
 
 class Simplex {
-	//	static const long double bound_weaken = 1e-3;          // bound given by simplex is weakened
-	// by this much 	static const long double obj_limit    = 1e-3;          // minimum violation of
-	// RHS before pivoting row 	static const long double pivot_limit  = 1e-3;          // minimum size
+	//	static const double bound_weaken = 1e-3;          // bound given by simplex is weakened
+	// by this much 	static const double obj_limit    = 1e-3;          // minimum violation of
+	// RHS before pivoting row 	static const double pivot_limit  = 1e-3;          // minimum size
 	// of pivot (otherwise, small ignore dual infeasibility)
 
 public:
 	int n;       // number of variables
 	int m;       // number of constraints
+	int max_m;   // number of rows allocated, cuts take the rows after the constraints
 	int A_size;  // number of coefficients
 
 	IndexVal** AH;     // original constraints horizontally
@@ -66,31 +97,54 @@ public:
 	int* AH_nz;        // number of non-zeros in AH
 	int* AV_nz;        // number of non-zeros in AV
 
-	long double* Z;    // pivot row of B^-1
-	long double* Y;    // pivot column
-	long double* BZ;   // B^-1 . Z
-	long double* obj;  // objective function
-	long double* rhs;  // right hand side of constraints
-	long double** R1;  // memory for refactorising B
-	long double** R2;  // memory for refactorising B
-	long double* tm;   // temp memory for various things
-	int* BC;           // values of linear expressions at current bounds
-	long double obj_bound;
+	double* Z;    // pivot row of B^-1
+	double* Y;    // pivot column
+	double* BZ;   // B^-1 . Z
+	double* obj;  // objective function
+	double* rhs;  // right hand side of constraints
+	double* tm;   // temp memory for various things
+	int* BC;      // values of linear expressions at current bounds
+	double obj_bound;
 
 	float* norm2;  // norm^2 of ith row of M
 	double* reduced_costs;
 
+	// B = L.U where L^-1 is a product of column etas, L_cols[i] holding the multipliers of the rows
+	// eliminated by pivot i, and U is upper triangular up to the permutation U_perm
 	vec<vec<IndexVal> > L_cols;
 	vec<vec<IndexVal> > L_rows;
 	vec<vec<IndexVal> > U_cols;
 	vec<vec<IndexVal> > U_rows;
-	long double* U_diag;
+	double* U_diag;
 	int* U_perm;          // U' -> U where U' is upper triangular
 	int L_cols_zeros{0};  // number of empty columns from start
-	int U_diag_units{0};  // number of unit U_diag from start
+	int U_diag_units{0};  // number of unit U_diag with empty U_cols from start
 
-	LUFactor* lu_factors;
+	LUFactor* lu_factors;  // row etas of the Forrest-Tomlin updates since the last refactor
 	int num_lu_factors;
+	int lu_nz{0};   // number of non-zeros in L and U after the last refactor
+	int eta_nz{0};  // number of non-zeros in lu_factors
+
+	// Active submatrix while refactoring, values by column and pattern by row
+	vec<vec<IndexVal> > act_cols;
+	vec<vec<int> > act_rows;
+	CountLists col_counts;
+	CountLists row_counts;
+	int* act_pos;  // position of a row in the column being updated, -1 if none
+
+	// Hypersparse solves, positions are marked when they are in the current pattern
+	int* reach_mark;
+	int reach_stamp{0};
+	vec<int> dfs_node;
+	vec<int> dfs_child;
+	vec<int> reach_order;
+	vec<int> Z_nz;    // pattern of Z
+	vec<int> col_nz;  // pattern of column
+	vec<int> Y_nz;    // pattern of Y
+	vec<int> BZ_nz;   // pattern of BZ
+	vec<int> tm_nz;   // pattern of tm
+	int* tm_type;     // temp memory for updateBasis
+	vec<int> touched;
 
 	Tint* lb;
 	Tint* ub;
@@ -101,37 +155,40 @@ public:
 	int* ctor;   // var to row, -1 if non-basic
 	int* shift;  // whether we're using upper or lower bound offset
 
+	// Rows are permuted by refactorB, these give the original constraint of each row and back
+	int* row_id;
+	int* id_row;
+
+	vec<BasisChange> basis_trail;  // pivots made below the root
+
 	int pivot_col;
 	int pivot_row;
-	long double pr_violation;
+	double pr_violation;
 
-	long double* row;
-	long double* column;
-	long double* ratio;
+	double* row;
+	double* column;
+	double* ratio;
 
 	SimplexState root;
 
-	long double recalc_time{0};
+	double recalc_time{0};
 	long long simplexs{0};
 	long long refactors{0};
+	long long hyper_solves{0};
 
 	struct SortColRatio {
-		long double*& ratio;
+		double*& ratio;
 		bool operator()(int i, int j) const { return (ratio[i] < ratio[j]); }
-		SortColRatio(long double*& r) : ratio(r) {}
+		SortColRatio(double*& r) : ratio(r) {}
 	} sort_col_ratio;
 
-	struct SortColNz {
-		int*& nz;
-		bool operator()(int i, int j) const { return (nz[i] < nz[j]); }
-		SortColNz(int*& _nz) : nz(_nz) {}
-	} sort_col_nz;
-
 	Simplex();
 
 	// Simplex methods
 
 	void init();
+	void buildAV();
+	void addRows(vec<Cut>& pool, const vec<int>& ids);
 	void pivotObjVar();
 	void boundChange(int v, int d) const;
 	void boundSwap(int v) const;
@@ -144,21 +201,39 @@ public:
 
 	// Recalculation methods
 
-	void Lmultiply(long double* a);
-	void LTmultiply(long double* a);
-	void Umultiply(long double* a);
-	void UTmultiply(long double* a);
-	void Bmultiply(long double* a);
+	void Lmultiply(double* a);
+	void LTmultiply(double* a);
+	void Umultiply(double* a);
+	void UTmultiply(double* a);
+	void Bmultiply(double* a);
 	void calcRHS();
+	void calcPrimal(double* x);
 	void calcObjective();
 	void calcObjBound();
-	void calcBInvRow(long double* a, int r);
+	void calcBInvRow(double* a, int r);
 	void updateBasis();
 	void updateNorms() const;
 	void refactorB();
+	void findMarkowitzPivot(int& pr, int& pc);
+	void eliminate(int k, int pr, int pc);
+
+	// Hypersparse versions, nz holds the positions of a which may be non-zero before and after
+
+	bool sparseReach(const vec<vec<IndexVal> >& adj, vec<int>& nz);
+	void setDense(vec<int>& nz) const;
+	void Lmultiply(double* a, vec<int>& nz);
+	void LTmultiply(double* a, vec<int>& nz);
+	void Umultiply(double* a, vec<int>& nz);
+	void UTmultiply(double* a, vec<int>& nz);
+	void Fmultiply(double* a, vec<int>& nz);
+	void FTmultiply(double* a, vec<int>& nz);
+	void Bmultiply(double* a, vec<int>& nz);
+	void calcBInvRow(double* a, int r, vec<int>& nz);
+	double pivotColumnEntry();
 
 	void saveState(SimplexState& s) const;
 	void loadState(SimplexState& s) const;
+	void restoreBasis(int pos);
 
 	// Debug methods
 
@@ -176,24 +251,27 @@ public:
 
 	// inline methods
 
-	static void checkZero13(long double& a);
-	static bool almostZero6(long double a);
-	long double optimum() const;
+	static void checkZero13(double& a);
+	static bool almostZero6(double a);
+	double optimum() const;
 	int gap(int i) const;
+	int stableId(int v) const;
+	int varOf(int id) const;
 };
 
 extern Simplex simplex;
 
-inline void Simplex::checkZero13(long double& a) {
-	//	if ((((int*) &a)[2] & 0x7fff) <= 16339)           // 16382 + log_2(precision)
+inline void Simplex::checkZero13(double& a) {
 	if (-1e-13 < a && a < 1e-13) {
 		a = 0;
 	}
 }
 
-inline bool Simplex::almostZero6(long double a) { return (-0.000001 < a && a < 0.000001); }
+inline bool Simplex::almostZero6(double a) { return (-0.000001 < a && a < 0.000001); }
 
-inline long double Simplex::optimum() const { return -obj_bound - bound_weaken; }
+inline double Simplex::optimum() const { return -obj_bound - bound_weaken; }
 inline int Simplex::gap(int i) const { return ub[i] - lb[i]; }
+inline int Simplex::stableId(int v) const { return v < n ? v : n + row_id[v - n]; }
+inline int Simplex::varOf(int id) const { return id < n ? id : n + id_row[id - n]; }
 
 #endif
@@ -9,6 +9,7 @@
 #include "chuffed/vars/int-view.h"
 #include "chuffed/vars/vars.h"
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 #include <cstdint>
@@ -42,6 +43,249 @@ void array_bool_element(IntVar* _x, vec<bool>& a, BoolView y, int offset) {
 
 //-----
 
+// y = a[x], a constant
+// Indices of a are grouped by value (an inverted index), and every value keeps a residual support.
+// When y has a lazy encoding only its bounds are propagated, so no value literals are created for
+// it. Otherwise the propagator is domain consistent.
+
+template <int V = 0>
+class IntElemConst : public Propagator {
+	const IntView<> y;
+	const IntView<V> x;
+
+	// Distinct values of a in increasing order, the indices taking vals[k] are
+	// index[start[k]] ... index[start[k+1]-1]
+	vec<int> vals;
+	vec<int> start;
+	vec<int> index;
+
+	// Position in index of the last support found for each value, not trailed
+	vec<int> residue;
+
+	// Values in live[0..n_live-1] may still be taken by y (domain mode)
+	vec<int> live;
+
+	bool bounds_only{false};
+	bool initialised{false};
+
+	// persistent state
+
+	Tint n_live;
+	// Values outside vals[lo..hi] have been removed (bounds mode)
+	Tint lo;
+	Tint hi;
+
+	// intermediate state
+
+	bool x_changed{true};
+	bool y_changed{true};
+
+public:
+	IntElemConst(IntView<> _y, IntView<V> _x, vec<int>& a) : y(_y), x(_x) {
+		vec<std::pair<int, int> > pairs;
+		for (int i = 0; i < a.size(); i++) {
+			if (x.indomain(i)) {
+				pairs.push(std::pair<int, int>(a[i], i));
+			}
+		}
+		std::sort((std::pair<int, int>*)pairs, (std::pair<int, int>*)pairs + pairs.size());
+		for (int j = 0; j < pairs.size(); j++) {
+			if (j == 0 || pairs[j].first != pairs[j - 1].first) {
+				vals.push(pairs[j].first);
+				start.push(j);
+				residue.push(j);
+				live.push(live.size());
+			}
+			index.push(pairs[j].second);
+		}
+		start.push(index.size());
+
+		n_live = vals.size();
+		lo = 0;
+		hi = vals.size() - 1;
+
+		y.attach(this, 0, EVENT_C);
+		x.attach(this, 1, EVENT_C);
+	}
+
+	void wakeup(int i, int /*c*/) override {
+		if (i == 0) {
+			y_changed = true;
+		} else {
+			x_changed = true;
+		}
+		pushInQueue();
+	}
+
+	bool hasSupport(int k) {
+		if (x.indomain(index[residue[k]])) {
+			return true;
+		}
+		for (int j = start[k]; j < start[k + 1]; j++) {
+			if (x.indomain(index[j])) {
+				residue[k] = j;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Remove all indices taking value vals[k] from x
+	bool removeIndices(int k, Lit p) {
+		for (int j = start[k]; j < start[k + 1]; j++) {
+			setDom(x, remVal, index[j], p);
+		}
+		return true;
+	}
+
+	// Explain a bound on y by the indices index[from..to-1] having been removed from x
+	Clause* explainBound(int from, int to) {
+		vec<Lit> ps;
+		ps.push();
+		ps.push(x.getMinLit());
+		ps.push(x.getMaxLit());
+		for (int j = from; j < to; j++) {
+			if (index[j] > x.getMin() && index[j] < x.getMax()) {
+				ps.push(x.getLit(index[j], LR_EQ));
+			}
+		}
+		return Reason_new(ps);
+	}
+
+	bool init() {
+		initialised = true;
+		bounds_only = (y.getVar()->getType() == INT_VAR_LL);
+		if (bounds_only || y.getVar()->getType() == INT_VAR_SL) {
+			return true;
+		}
+		// Values of y not occurring in a can be removed at the root
+		int k = 0;
+		for (int64_t v = y.getMin(); v <= y.getMax(); v++) {
+			while (k < vals.size() && vals[k] < v) {
+				k++;
+			}
+			if ((k == vals.size() || vals[k] != v) && y.indomain(v)) {
+				if (!y.remVal(v)) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool propagateBounds() {
+		int l = lo;
+		int h = hi;
+
+		// remove indices whose value is outside the bounds of y
+		while (l <= h && vals[l] < y.getMin()) {
+			if (!removeIndices(l++, y.getMinLit())) {
+				return false;
+			}
+		}
+		while (h >= l && vals[h] > y.getMax()) {
+			if (!removeIndices(h--, y.getMaxLit())) {
+				return false;
+			}
+		}
+
+		// tighten y to the supported values
+		while (l <= h && !hasSupport(l)) {
+			l++;
+		}
+		while (h >= l && !hasSupport(h)) {
+			h--;
+		}
+		assert(l <= h);
+
+		if (y.setMinNotR(vals[l])) {
+			Clause* r = nullptr;
+			if (so.lazy) {
+				r = explainBound(0, start[l]);
+			}
+			if (!y.setMin(vals[l], r)) {
+				return false;
+			}
+		}
+		if (y.setMaxNotR(vals[h])) {
+			Clause* r = nullptr;
+			if (so.lazy) {
+				r = explainBound(start[h + 1], index.size());
+			}
+			if (!y.setMax(vals[h], r)) {
+				return false;
+			}
+		}
+
+		if (l != lo) {
+			lo = l;
+		}
+		if (h != hi) {
+			hi = h;
+		}
+		return true;
+	}
+
+	bool propagateDomain() {
+		int n = n_live;
+		for (int j = 0; j < n;) {
+			const int k = live[j];
+			const int v = vals[k];
+			if (y_changed && !y.indomain(v)) {
+				if (!removeIndices(k, y.getLit(v, LR_EQ))) {
+					return false;
+				}
+			} else if (x_changed && !hasSupport(k)) {
+				// v has no support, remove from y
+				Clause* r = nullptr;
+				if (so.lazy) {
+					r = Reason_new(start[k + 1] - start[k] + 1);
+					for (int i = start[k]; i < start[k + 1]; i++) {
+						(*r)[i - start[k] + 1] = x.getLit(index[i], LR_EQ);
+					}
+				}
+				if (!y.remVal(v, r)) {
+					return false;
+				}
+			} else {
+				j++;
+				continue;
+			}
+			live[j] = live[--n];
+			live[n] = k;
+		}
+		if (n != n_live) {
+			n_live = n;
+		}
+		return true;
+	}
+
+	bool propagate() override {
+		if (!initialised && !init()) {
+			return false;
+		}
+
+		if (bounds_only) {
+			if (!propagateBounds()) {
+				return false;
+			}
+		} else if (!propagateDomain()) {
+			return false;
+		}
+
+		if (x.isFixed() && y.isFixed()) {
+			satisfied = 1;
+		}
+		return true;
+	}
+
+	void clearPropState() override {
+		in_queue = false;
+		x_changed = false;
+		y_changed = false;
+	}
+};
+
 // y = a[x-offset]
 
 void array_int_element(IntVar* _x, vec<int>& a, IntVar* _y, int offset) {
@@ -59,6 +303,28 @@ void array_int_element(IntVar* _x, vec<int>& a, IntVar* _y, int offset) {
 		z.push(a[i]);
 	}
 
+	if (a.size() > so.element_clause_limit) {
+		if (z.size() == 0) {
+			TL_FAIL();
+		}
+		std::sort((int*)z, (int*)z + z.size());
+		z.resize(std::unique((int*)z, (int*)z + z.size()) - (int*)z);
+		TL_SET(_y, setMin, z[0]);
+		TL_SET(_y, setMax, z.last());
+		// Only give y value literals if it has few distinct values, otherwise it keeps the lazy
+		// encoding and the propagator reasons about its bounds
+		if (z.last() - z[0] <= so.eager_limit || z.size() <= so.eager_limit) {
+			_y->specialiseToSL(z);
+		}
+		_x->specialiseToEL();
+		if (offset != 0) {
+			new IntElemConst<4>(IntView<>(_y), IntView<4>(_x, 1, -offset), a);
+		} else {
+			new IntElemConst<0>(IntView<>(_y), IntView<>(_x), a);
+		}
+		return;
+	}
+
 	_y->specialiseToSL(z);
 	_x->specialiseToEL();
 
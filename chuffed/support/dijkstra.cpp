@@ -11,85 +11,86 @@
 // The label on each node counts the cost of its duration! (i.e. Duration included)
 //  i.e. the label on each node says when will you be done with it.
 
-Dijkstra::Dijkstra(int _s, vvi_t _en, const vvi_t& _in, vvi_t _ou, std::vector<int>& _ws)
-		: source(_s),
-			nb_nodes(_in.size()),
-			en(std::move(_en)),
-			in(_in),
-			out(std::move(_ou)),
-			ws(_ws),
-			verbose(false) {}
-Dijkstra::Dijkstra(int _s, vvi_t _en, const vvi_t& _in, vvi_t _ou,
+Dijkstra::Dijkstra(int _s, const vvi_t& _en, const vvi_t& _in, const vvi_t& _ou,
+									 std::vector<int>& _ws)
+		: source(_s), nb_nodes(_in.size()), ws(_ws), verbose(false) {
+	out.build(_ou, _en);
+	in.build(_in, _en);
+}
+Dijkstra::Dijkstra(int _s, const vvi_t& _en, const vvi_t& _in, const vvi_t& _ou,
 									 std::vector<std::vector<int> >& _wst, std::vector<int> d)
-		: source(_s),
-			nb_nodes(_in.size()),
-			en(std::move(_en)),
-			in(_in),
-			out(std::move(_ou)),
-			wst(_wst),
-			job(std::move(d)),
-			verbose(false) {}
+		: source(_s), nb_nodes(_in.size()), wst(_wst), job(std::move(d)), verbose(false) {
+	out.build(_ou, _en);
+	in.build(_in, _en);
+}
 
 void Dijkstra::run() {
-	q = std::priority_queue<tuple, std::vector<tuple>, Dijkstra::Priority>();
-	std::vector<bool> vis = std::vector<bool>(nb_nodes, false);
-
-	int count = 0;
-
-	pred = std::vector<int>(nb_nodes, -1);
-	has_kids = std::vector<bool>(nb_nodes, false);
-	cost = std::vector<int>(nb_nodes, -1);
+	q.clear();
+	pred.assign(nb_nodes, -1);
+	pred_edge.assign(nb_nodes, -1);
+	has_kids.assign(nb_nodes, false);
+	cost.assign(nb_nodes, -1);
+	vis.assign(nb_nodes, 0);
+	affected.assign(nb_nodes, 0);
+	order.clear();
 
 	pred[source] = source;
 	cost[source] = duration(source);
-	const tuple initial(source, cost[source]);
-	q.push(initial);
+	q.push(cost[source], tuple(source, cost[source]));
 
 	if (verbose) {
 		std::cout << "START" << '\n';
 	}
 
-	while (!q.empty() && count < nb_nodes) {
-		const tuple top = q.top();
-		q.pop();
+	settle();
+}
+
+// Pop nodes in order of distance and relax their out-arcs until the queue runs out
+void Dijkstra::settle() {
+	while (!q.empty() && static_cast<int>(order.size()) < nb_nodes) {
+		const tuple top = q.pop();
 		const int curr = top.node;
 
-		if (vis[curr]) {
+		if (vis[curr] != 0) {
 			continue;
 		}
 
 		on_visiting_node(curr);
-		vis[curr] = true;
-		count++;
+		vis[curr] = 1;
+		order.push_back(curr);
 
 		if (verbose) {
 			std::cout << "Visiting " << curr << " from " << pred[curr] << "(cost: " << cost[curr] << ")"
 								<< '\n';
 		}
 
-		for (unsigned int i = 0; i < out[curr].size(); i++) {
-			const int e = out[curr][i];
-			assert(en[e][0] == curr);
+		for (const CSRGraph::Arc& a : out[curr]) {
+			const int e = a.edge;
 			if (ignore_edge(e) || weight(e) < 0) {
 				if (verbose) {
-					std::cout << "Ignoring edge " << e << " from " << en[e][0] << " to " << en[e][1] << '\n';
+					std::cout << "Ignoring edge " << e << " from " << curr << " to " << a.node << '\n';
 				}
 				on_ignore_edge(e);
 				continue;
 			}
-			const int other = en[e][1];  // Head of e
+			const int other = a.node;  // Head of e
 
 			if (ignore_node(other)) {
 				continue;
 			}
-			if (vis[other]) {
+			if (vis[other] != 0) {
+				continue;
+			}
+			const int w = weight(e, cost[curr]);
+			if (w < 0) {
 				continue;
 			}
 
-			if (cost[other] == -1 || cost[other] > cost[curr] + weight(e, cost[curr]) + duration(other)) {
-				cost[other] = cost[curr] + weight(e, cost[curr]) + duration(other);
+			if (cost[other] == -1 || cost[other] > cost[curr] + w + duration(other)) {
+				cost[other] = cost[curr] + w + duration(other);
 				assert(cost[other] != -1);
 				pred[other] = curr;
+				pred_edge[other] = e;
 				has_kids[curr] = true;
 				if (verbose) {
 					std::cout << "Marked " << other << " from " << curr << " of cost " << cost[other] << '\n';
@@ -101,6 +102,84 @@ void Dijkstra::run() {
 	}
 }
 
+// Nothing was added or got cheaper since the last run, so a node keeps its distance unless the
+// tree path to it lost an edge or a node, or went up in weight. Those nodes are relabelled from
+// their unaffected predecessors and the search goes on from them, as in Ramalingam and Reps.
+void Dijkstra::update() {
+	assert(static_cast<int>(cost.size()) == nb_nodes && cost[source] != -1);
+	affected_list.clear();
+	// Parents come before their children in order, and only nodes in order are parents
+	auto check = [&](int v) {
+		const int u = pred[v];
+		const int e = pred_edge[v];
+		if (affected[u] != 0 || ignore_node(v) || ignore_edge(e) || weight(e) < 0 ||
+				cost[v] != cost[u] + weight(e, cost[u]) + duration(v)) {
+			affected[v] = 1;
+			affected_list.push_back(v);
+		}
+	};
+	for (const int v : order) {
+		if (v != source) {
+			check(v);
+		}
+	}
+	for (int v = 0; v < nb_nodes; v++) {
+		if (cost[v] != -1 && vis[v] == 0) {
+			check(v);
+		}
+	}
+	if (affected_list.empty()) {
+		return;
+	}
+
+	int k = 0;
+	for (const int v : order) {
+		if (affected[v] == 0) {
+			order[k++] = v;
+		}
+	}
+	order.resize(k);
+	for (const int v : affected_list) {
+		cost[v] = -1;
+		pred[v] = -1;
+		pred_edge[v] = -1;
+		vis[v] = 0;
+		has_kids[v] = false;
+	}
+
+	q.clear();
+	for (const int v : affected_list) {
+		if (ignore_node(v)) {
+			continue;
+		}
+		for (const CSRGraph::Arc& a : in[v]) {
+			const int u = a.node;
+			const int e = a.edge;
+			if (affected[u] != 0 || vis[u] == 0 || ignore_edge(e) || weight(e) < 0) {
+				continue;
+			}
+			const int w = weight(e, cost[u]);
+			if (w < 0) {
+				continue;
+			}
+			if (cost[v] == -1 || cost[v] > cost[u] + w + duration(v)) {
+				cost[v] = cost[u] + w + duration(v);
+				pred[v] = u;
+				pred_edge[v] = e;
+				has_kids[u] = true;
+			}
+		}
+		if (cost[v] != -1) {
+			enqueue(tuple(v, cost[v]));
+		}
+	}
+	settle();
+
+	for (const int v : affected_list) {
+		affected[v] = 0;
+	}
+}
+
 /*
 int main(int argc, char* argv[]) {
 		int n = 13;
@@ -301,7 +380,7 @@ int DijkstraMandatory::run(bool* ok, bool use_set_target) {
 
 	if (!use_set_target) {  // Create the target bitset here
 
-		target = std::vector<bool>(target.size(), false);
+		target.assign(nb_nodes, false);
 		const std::vector<int>& mands = mandatory_nodes();
 
 #ifdef CLUSTERING
@@ -2,7 +2,9 @@
 #define DIJKSTRA_H
 #include "chuffed/core/propagator.h"  //For Tint
 #include "chuffed/support/dynamic_kmeans.h"
+#include "chuffed/support/graph_kernel.h"
 #include "chuffed/support/kosaraju_scc.h"
+#include "chuffed/support/radix_heap.h"
 
 #include <bitset>
 #include <cassert>
@@ -18,18 +20,26 @@ protected:
 	using vvi_t = std::vector<std::vector<int>>;
 	int source;
 	int nb_nodes;
-	vvi_t en;
-	vvi_t in;
-	vvi_t out;
+	// Arcs out of and into each node
+	CSRGraph out;
+	CSRGraph in;
 
 private:
 	std::vector<int> pred;
+	std::vector<int> pred_edge;
 	std::vector<bool> has_kids;
 	std::vector<int> cost;
 	std::vector<int> ws;
 	std::vector<std::vector<int>> wst;
 	std::vector<int> job;
 
+	// Nodes whose out-arcs were followed, in the order they were
+	std::vector<char> vis;
+	std::vector<int> order;
+	// Nodes whose distance must be recomputed by update()
+	std::vector<char> affected;
+	std::vector<int> affected_list;
+
 public:
 	bool verbose;
 	struct tuple {
@@ -44,14 +54,20 @@ public:
 	};
 
 private:
-	std::priority_queue<tuple, std::vector<tuple>, Dijkstra::Priority> q;
+	RadixHeap<tuple> q;
+	void settle();
+	bool unavailable(int e, int hd);
 
 public:
-	Dijkstra(int _s, vvi_t _en, const vvi_t& _in, vvi_t _ou, std::vector<int>& _ws);
-	Dijkstra(int _s, vvi_t _en, const vvi_t& _in, vvi_t _ou, std::vector<std::vector<int>>& _wst,
-					 std::vector<int> d = std::vector<int>());
+	Dijkstra(int _s, const vvi_t& _en, const vvi_t& _in, const vvi_t& _ou, std::vector<int>& _ws);
+	Dijkstra(int _s, const vvi_t& _en, const vvi_t& _in, const vvi_t& _ou,
+					 std::vector<std::vector<int>>& _wst, std::vector<int> d = std::vector<int>());
 	virtual ~Dijkstra() = default;
 	void run();
+	// Bring the distances of the last run() up to date after edges and nodes became ignored or
+	// weights increased, redoing only the nodes whose shortest path went through a change. The
+	// source must be the same.
+	void update();
 
 	virtual void set_source(int s) { source = s; }
 	inline int parentOf(int n) { return pred[n]; }
@@ -62,7 +78,7 @@ public:
 	virtual bool ignore_edge(int /*e*/) { return false; }
 	virtual void on_ignore_edge(int e) {}
 	virtual bool ignore_node(int /*n*/) { return false; }
-	virtual void enqueue(tuple node) { q.push(node); }
+	virtual void enqueue(tuple node) { q.push(node.cost, node); }
 	void set_verbose(bool v) { verbose = v; }
 	void print_pred() const;
 	bool is_leaf(int n) const { return !has_kids[n]; }
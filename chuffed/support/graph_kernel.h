@@ -0,0 +1,143 @@
+#ifndef GRAPH_KERNEL_H
+#define GRAPH_KERNEL_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/**
+ * Building blocks for the searches done by the graph propagators. They are sized once, when the
+ * propagator is built, so that a search allocates nothing.
+ */
+
+// Adjacency in compressed sparse row form. The arcs of node u are stored contiguously, each one
+// gives the edge and the node at its other end.
+class CSRGraph {
+public:
+	struct Arc {
+		int edge;
+		int node;
+	};
+
+	class Range {
+		const Arc* b;
+		const Arc* e;
+
+	public:
+		Range(const Arc* _b, const Arc* _e) : b(_b), e(_e) {}
+		const Arc* begin() const { return b; }
+		const Arc* end() const { return e; }
+	};
+
+	CSRGraph() = default;
+
+	// adj[u] lists the edges of u, en[e] the two endnodes of e
+	void build(const std::vector<std::vector<int> >& adj, const std::vector<std::vector<int> >& en) {
+		const int n = static_cast<int>(adj.size());
+		start.assign(n + 1, 0);
+		for (int u = 0; u < n; u++) {
+			start[u + 1] = start[u] + static_cast<int>(adj[u].size());
+		}
+		arcs.resize(start[n]);
+		for (int u = 0; u < n; u++) {
+			Arc* a = arcs.data() + start[u];
+			for (const int e : adj[u]) {
+				a->edge = e;
+				a->node = en[e][0] == u ? en[e][1] : en[e][0];
+				a++;
+			}
+		}
+	}
+
+	int nbNodes() const { return static_cast<int>(start.size()) - 1; }
+	int degree(int u) const { return start[u + 1] - start[u]; }
+	Range operator[](int u) const {
+		assert(u >= 0 && u < nbNodes());
+		return {arcs.data() + start[u], arcs.data() + start[u + 1]};
+	}
+	const Arc& arc(int u, int i) const { return arcs[start[u] + i]; }
+
+private:
+	std::vector<int> start;
+	std::vector<Arc> arcs;
+};
+
+// Visited flags. Clearing them moves to a new epoch instead of touching every node.
+class EpochMarks {
+	std::vector<unsigned int> stamp;
+	unsigned int epoch{1};
+
+public:
+	EpochMarks() = default;
+	EpochMarks(int n) : stamp(n, 0) {}
+
+	void resize(int n) {
+		stamp.assign(n, 0);
+		epoch = 1;
+	}
+	int size() const { return static_cast<int>(stamp.size()); }
+
+	void clear() {
+		if (++epoch == 0) {
+			std::fill(stamp.begin(), stamp.end(), 0);
+			epoch = 1;
+		}
+	}
+	bool operator[](int u) const { return stamp[u] == epoch; }
+	void mark(int u) { stamp[u] = epoch; }
+	// Mark u, returns false if it already was
+	bool visit(int u) {
+		if (stamp[u] == epoch) {
+			return false;
+		}
+		stamp[u] = epoch;
+		return true;
+	}
+};
+
+// Search from r through the arcs a out of u for which follow(u, a) holds. follow is asked about
+// every arc of every node reached, also those leading to nodes already marked in seen. Every new
+// node reached is marked and passed to reach. The stack is only scratch space.
+template <typename Follow, typename Reach>
+void graph_dfs(const CSRGraph& g, int r, EpochMarks& seen, std::vector<int>& stack, Follow follow,
+							 Reach reach) {
+	stack.clear();
+	if (!seen.visit(r)) {
+		return;
+	}
+	reach(r);
+	stack.push_back(r);
+	while (!stack.empty()) {
+		const int u = stack.back();
+		stack.pop_back();
+		for (const CSRGraph::Arc& a : g[u]) {
+			if (follow(u, a) && seen.visit(a.node)) {
+				reach(a.node);
+				stack.push_back(a.node);
+			}
+		}
+	}
+}
+
+// Breadth first search, as graph_dfs but nodes are reached by increasing number of arcs from r
+template <typename Follow, typename Reach>
+void graph_bfs(const CSRGraph& g, int r, EpochMarks& seen, std::vector<int>& queue, Follow follow,
+							 Reach reach) {
+	queue.clear();
+	if (!seen.visit(r)) {
+		return;
+	}
+	reach(r);
+	queue.push_back(r);
+	for (int head = 0; head < static_cast<int>(queue.size()); head++) {
+		const int u = queue[head];
+		for (const CSRGraph::Arc& a : g[u]) {
+			if (follow(u, a) && seen.visit(a.node)) {
+				reach(a.node);
+				queue.push_back(a.node);
+			}
+		}
+	}
+}
+
+#endif
@@ -4,12 +4,6 @@
 #include <utility>
 #include <vector>
 
-std::vector<int> child;
-std::vector<int> size_;
-
-std::vector<std::vector<int> > preds;
-std::vector<std::vector<int> > succs;
-
 void LengauerTarjan::LINK(int v, int w) { ancestor[w] = v; }
 
 int LengauerTarjan::EVAL(int v) {
@@ -35,59 +29,56 @@ void LengauerTarjan::COMPRESS(int v) {
 
 void LengauerTarjan::init() {
 	const int n = in.size();
-	preds = std::vector<std::vector<int> >(n, std::vector<int>());
-	succs = std::vector<std::vector<int> >(n, std::vector<int>());
-	for (int i = 0; i < n; i++) {
-		// succs.push_back(vector<int>());
-		// cout <<"Succs of "<<i<<": ";
-		for (int j = 0; j < ou[i].size(); j++) {
-			const int e = ou[i][j];
-			if (ignore_edge(e)) {
-				continue;
-			}
-			const int o = en[e][1];
-			if (ignore_node(o)) {
-				continue;
-			}
-			if (i != en[ou[i][j]][1]) {
-				succs[i].push_back(en[ou[i][j]][1]);
-				// cout <<en[ou[i][j]][1]<<", ";
-			}
-		}
-		// cout<<endl;
-	}
 
-	parent = std::vector<int>(n, -1);
-	vertex = std::vector<int>(n, -1);
-	semi = std::vector<int>(n, -1);
-	idom = std::vector<int>(n, -1);
+	parent.assign(n, -1);
+	pre.assign(n, -1);
+	vertex.assign(n, -1);
+	semi.assign(n, -1);
+	idom.assign(n, -1);
 
 	count = -1;
 
-	ancestor = std::vector<int>(n, -1);
-	label = std::vector<int>(n, -1);
+	ancestor.assign(n, -1);
+	label.assign(n, -1);
 
-	child = std::vector<int>(n, root);
-	size_ = std::vector<int>(n, 0);
+	next_arc.resize(n);
+	bucket_head.assign(n, -1);
+	bucket_next.resize(n);
 }
 
-//*
-void LengauerTarjan::DFS(int v) {
-	// cout <<"DFS at "<<v<<endl;
+void LengauerTarjan::number(int v) {
 	count = count + 1;
+	pre[v] = count;
 	semi[v] = count;
 	vertex[count] = v;
 	// Init vars for step 3 and 4
 	label[v] = v;
 	ancestor[v] = -1;
-	std::vector<int>::iterator it;
-	for (it = succs[v].begin(); it != succs[v].end(); it++) {
-		const int w = *it;
+	next_arc[v] = 0;
+	visit(v);
+}
+
+//*
+void LengauerTarjan::DFS(int r) {
+	stack.clear();
+	number(r);
+	stack.push_back(r);
+	while (!stack.empty()) {
+		const int v = stack.back();
+		if (next_arc[v] == succ.degree(v)) {
+			stack.pop_back();
+			continue;
+		}
+		const CSRGraph::Arc& a = succ.arc(v, next_arc[v]++);
+		const int w = a.node;
+		if (w == v || ignore_edge(a.edge) || ignore_node(w)) {
+			continue;
+		}
 		if (semi[w] == -1) {
 			parent[w] = v;
-			DFS(w);
+			number(w);
+			stack.push_back(w);
 		}
-		preds[w].push_back(v);
 	}
 }
 
@@ -121,27 +112,28 @@ void LengauerTarjan::find_doms() {
 	// cout<<endl;
 	// cout <<"count "<<count<<endl;
 
-	std::vector<std::vector<int> > buckets =
-			std::vector<std::vector<int> >(in.size(), std::vector<int>());
-
 	for (int i = count; i >= 1; i--) {
 		const int w = vertex[i];
-		std::vector<int>::iterator it;
-		for (it = preds[w].begin(); it != preds[w].end(); it++) {
-			const int v = *it;
+		// Predecessors of w in the DFS graph
+		for (const CSRGraph::Arc& a : pred[w]) {
+			const int v = a.node;
+			if (v == w || pre[v] == -1 || ignore_edge(a.edge)) {
+				continue;
+			}
 			const int u = EVAL(v);
 			if (semi[u] < semi[w]) {
 				semi[w] = semi[u];
 			}
 		}
-		buckets[vertex[semi[w]]].push_back(w);
+		const int b = vertex[semi[w]];
+		bucket_next[w] = bucket_head[b];
+		bucket_head[b] = w;
 		LINK(parent[w], w);
-		for (it = buckets[parent[w]].begin(); it != buckets[parent[w]].end(); it++) {
-			const int v = *it;
+		for (int v = bucket_head[parent[w]]; v != -1; v = bucket_next[v]) {
 			const int u = EVAL(v);
 			idom[v] = (semi[u] < semi[v]) ? u : parent[w];
 		}
-		buckets[parent[w]].clear();
+		bucket_head[parent[w]] = -1;
 	}
 
 	for (int i = 1; i <= count; i++) {
@@ -216,6 +208,8 @@ void LengauerTarjan::find_doms() {
 
 LengauerTarjan::LengauerTarjan(int r, vvi_t _en, vvi_t _in, vvi_t _ou)
 		: root(r), en(std::move(_en)), in(std::move(_in)), ou(std::move(_ou)) {
+	succ.build(ou, en);
+	pred.build(in, en);
 	// init();
 }
 
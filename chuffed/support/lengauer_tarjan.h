@@ -1,6 +1,8 @@
 #ifndef LENGAUER_TARJAN_H
 #define LENGAUER_TARJAN_H
 
+#include "chuffed/support/graph_kernel.h"
+
 #include <vector>
 
 class LengauerTarjan {
@@ -16,29 +18,47 @@ class LengauerTarjan {
 		 }
 	 */
 
-private:
+protected:
 	int root;
 	using vvi_t = std::vector<std::vector<int>>;
 	vvi_t en;
 	vvi_t in;
 	vvi_t ou;
+	// Successors and predecessors through ou and in
+	CSRGraph succ;
+	CSRGraph pred;
 
+	// DFS tree parent and preorder number, semidominator (as a preorder number) and immediate
+	// dominator of every visited node
 	std::vector<int> parent;
+	std::vector<int> pre;
 	std::vector<int> vertex;
 	std::vector<int> semi;
 	std::vector<int> idom;
 
 	int count;
 
+private:
 	std::vector<int> ancestor;
 	std::vector<int> label;
 
+	// DFS stack with the next arc to follow of every node on it, and the buckets of nodes by
+	// semidominator as linked lists
+	std::vector<int> stack;
+	std::vector<int> next_arc;
+	std::vector<int> bucket_head;
+	std::vector<int> bucket_next;
+
+	void number(int v);
+
 	void LINK(int v, int w);
 	int EVAL(int v);
 	void COMPRESS(int v);
 
 protected:
 	virtual void DFS(int v);
+	// Called for every node reached by the DFS
+	virtual void visit(int /*v*/) {}
 
 public:
 	virtual void init();
@@ -0,0 +1,86 @@
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+// Monotone priority queue on unsigned keys: no key pushed may be smaller than the last key
+// popped, which holds for Dijkstra with non-negative weights. Entries live in the bucket given by
+// the highest bit in which their key differs from the last key popped, so every entry is moved
+// at most once per bit of the key and small integer weights keep most entries in the low buckets.
+template <typename T>
+class RadixHeap {
+	static constexpr int NB_BUCKETS = 33;
+
+	std::vector<std::pair<unsigned int, T> > buckets[NB_BUCKETS];
+	unsigned int last{0};
+	int count{0};
+
+	// 0 if key == last, otherwise one more than the highest bit in which they differ
+	static int bucketOf(unsigned int key, unsigned int last) {
+		unsigned int x = key ^ last;
+		int b = 0;
+		while (x != 0) {
+			x >>= 1;
+			b++;
+		}
+		return b;
+	}
+
+public:
+	bool empty() const { return count == 0; }
+	int size() const { return count; }
+
+	void clear() {
+		for (auto& b : buckets) {
+			b.clear();
+		}
+		last = 0;
+		count = 0;
+	}
+
+	void push(unsigned int key, const T& v) {
+		assert(key >= last);
+		buckets[bucketOf(key, last)].emplace_back(key, v);
+		count++;
+	}
+
+	unsigned int topKey() {
+		pull();
+		return last;
+	}
+
+	// Remove and return an entry of smallest key
+	T pop() {
+		pull();
+		T v = buckets[0].back().second;
+		buckets[0].pop_back();
+		count--;
+		return v;
+	}
+
+private:
+	// Make sure bucket 0 holds the entries of smallest key
+	void pull() {
+		assert(count > 0);
+		if (!buckets[0].empty()) {
+			return;
+		}
+		int i = 1;
+		while (buckets[i].empty()) {
+			i++;
+		}
+		unsigned int m = buckets[i][0].first;
+		for (const auto& kv : buckets[i]) {
+			m = kv.first < m ? kv.first : m;
+		}
+		last = m;
+		for (const auto& kv : buckets[i]) {
+			buckets[bucketOf(kv.first, last)].push_back(kv);
+		}
+		buckets[i].clear();
+	}
+};
+
+#endif
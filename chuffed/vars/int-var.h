@@ -61,6 +61,8 @@ public:
 
 	bool should_be_learnable{true};
 	bool should_be_decidable{true};
+	// Only bound literals are needed, so create them lazily whatever the domain size
+	bool prefer_lazy{false};
 
 	Tchar* vals{nullptr};
 #if INT_DOMAIN_LIST